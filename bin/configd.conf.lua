@@ -1,2 +1,24 @@
 ShardNum = 4096
 ShardControllerEndpoint = "*:19997"
+
+-- How the shards are placed to the nodes:
+-- "assigned": The shards are distributed evenly by the controller.
+-- "rendezvous": The owner of shard is computed by rendezvous hashing of
+--   the node ids, the clients compute it from the node list, thus the
+--   configuration published by configd doesn't contain the shards.
+--   Only the shards of the joining(or leaving) node are moved, but the
+--   number of shards per node is not exactly even.
+--   The nodes own the shards in proportion to their NodeWeight(see mmkvconf.lua).
+-- NOTICE: The rebalancing is disabled if "rendezvous" is used
+ShardPlacement = "assigned"
+
+-- The shards of the hottest node are moved to the coldest node
+-- if the difference of their loads(requests/sec) exceeds the
+-- threshold(percentage of the mean load).
+-- NOTICE: 0 indicates disabling the rebalancing
+RebalanceThreshold = 0
+-- The interval(ms) between two rebalancings at least, avoid thrashing
+RebalanceInterval = 60000
+-- The limits of the shards moved by a rebalancing
+RebalanceMaxShardNum = 8
+RebalanceMaxBytes = 268435456
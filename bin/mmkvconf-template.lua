@@ -67,6 +67,64 @@ end
 -----------------------------------------
 ThreadNum = 1
 
+-----------------------------------------
+-- RESP(Redis protocol)
+-----------------------------------------
+
+-- The endpoint accepts the redis clients(e.g. redis-cli, redis-benchmark).
+-- To disable RESP, you can set this to empty string
+-- default: empty
+-- RespEndpoint = "*:6380"
+RespEndpoint = ""
+
+-----------------------------------------
+-- Slowlog
+-----------------------------------------
+
+-- The commands and internal tasks(e.g. expiration check cycle, shard pull)
+-- whose duration reaches this are recorded in slowlog(see SLOWLOG command).
+-- The unit is microsecond, 0 records all, negative disables the slowlog.
+-- default: 10000
+SlowlogThreshold = 10000
+
+-- The maximum number of entries in slowlog, the oldest is overwritten when full.
+-- default: 128
+SlowlogMaxLen = 128
+
+-- If an event loop iteration exceeds this, the stall and the operation
+-- running in the loop are recorded in slowlog and warned in log.
+-- The unit is millisecond, 0 disables the watchdog.
+-- default: 100
+StallBudget = 100
+
+-- The script(see EVAL) running longer than this is aborted with an error,
+-- the writes executed before aborting are kept.
+-- The unit is millisecond, 0 is unlimited.
+-- default: 5000
+ScriptTimeLimit = 5000
+
+-----------------------------------------
+-- Replication
+-----------------------------------------
+
+-- The endpoint accepts the replicas, the write requests(i.e. the records
+-- of request log) are shipped to them asynchronously.
+-- To disable replication, you can set this to empty string
+-- default: empty
+-- ReplicationEndpoint = "*:19996"
+ReplicationEndpoint = ""
+
+-- The replication endpoint of primary, if it is set, this server is a replica,
+-- which follows the primary and only serves the read commands.
+-- default: empty
+-- ReplicaOf = "127.0.0.1:19996"
+ReplicaOf = ""
+
+-- The recent records kept by primary, a disconnected replica can continue
+-- from its offset if the records are still kept, otherwise it syncs fully.
+-- default: 16MB
+ReplicationBacklogSize = "16MB"
+
 ------------------------------------------
 -- Shard Configuration
 ------------------------------------------
@@ -79,6 +137,24 @@ ShardControllerEndpoint = ""
 -- default: ShardControllerPort + 1
 SharderEndpoint = "*:19998"
 
+-- The maximum number of shards migrated concurrently when this node
+-- joins or leaves the cluster, each one is migrated over its own connection.
+-- default: 8
+ShardMigrationConcurrency = 8
+
+-- The bytes per second of all migrating shards, it protects the latency
+-- of foreground requests from the rebalancing.
+-- NOTICE: 0 bytes indicates unlimited
+-- default: 0B
+-- ShardMigrationRate = "64MB"
+ShardMigrationRate = "0B"
+
+-- The interval(ms) of reporting the load(requests/sec and memory)
+-- of each shard to the controller, which rebalances the shards by it.
+-- NOTICE: 0 indicates disabling the report
+-- default: 1000
+LoadReportInterval = 1000
+
 -- default: empty
 DataNodes = {
 }
@@ -5,6 +5,8 @@
 #include <string>
 #include <string.h>
 
+#include <kanon/string/string_view.h>
+
 namespace mmkv {
 namespace algo {
 
@@ -53,6 +55,18 @@ struct Comparator<std::basic_string<char, std::char_traits<char>, Alloc>> {
   {
     return ::strcmp(x.c_str(), y.c_str());
   }
+
+  /* Heterogeneous lookup, see TreeHashTable::FindLike()
+   * The view isn't null-terminated, but the order must be same with strcmp() */
+  inline int operator()(StrType const &x, kanon::StringView y) const noexcept
+  {
+    for (size_t i = 0;; ++i) {
+      const unsigned char cx = x.c_str()[i];
+      const unsigned char cy = i < y.size() ? y.data()[i] : '\0';
+      if (cx != cy) return cx - cy;
+      if (cx == '\0') return 0;
+    }
+  }
 };
 
 template <typename T>
@@ -17,6 +17,7 @@
 #include "mmkv/algo/slist.h"
 
 #include "internal/hash_table_iterator.h"
+#include "internal/scan_util.h"
 
 namespace mmkv {
 namespace algo {
@@ -154,7 +155,33 @@ class HashTable
    *   pointer to slot where satisfied entry in
    *   Because MTF policy, this must be the header of a list
    */
-  Node **FindSlot(K const &key);
+  Node **FindSlot(K const &key) { return FindSlotLike(key); }
+
+  /**
+   * \brief Heterogeneous version of Find()
+   * \p key can be any type accepted by the hash function and the EqualKey,
+   * e.g. StringView to String, no temporary K is constructed.
+   * \note
+   *   The hash value of \p key must be same with the equivalent K.
+   */
+  template <typename KeyLike>
+  value_type *FindLike(KeyLike const &key)
+  {
+    auto slot = FindSlotLike(key);
+    return slot ? std::addressof((*slot)->value) : nullptr;
+  }
+
+  template <typename KeyLike>
+  value_type const *FindLike(KeyLike const &key) const
+  {
+    return const_cast<HashTable *>(this)->FindLike(key);
+  }
+
+  /**
+   * \brief Heterogeneous version of FindSlot()
+   */
+  template <typename KeyLike>
+  Node **FindSlotLike(KeyLike const &key);
 
   /************************************************************/
   /* Delete interface                                         */
@@ -245,6 +272,29 @@ class HashTable
    */
   double load_factor() const noexcept { return ((double)tables_[0].used) / tables_[0].size; }
 
+  /**
+   * \brief Get the memory footprint of the bucket arrays
+   * \note
+   *   The nodes are not included
+   */
+  size_type GetBucketsFootprint() const noexcept
+  {
+    return (table1().size() + table2().size()) * sizeof(Bucket);
+  }
+
+  /**
+   * \brief Visit the entries in the bucket(s) indicated by \p cursor
+   * The cursor is increased in the reversed binary order, so the entries
+   * exist during the whole scan are visited at least once even if the table
+   * is rehashed between two calls(but an entry may be visited more than once).
+   * Start with 0 and pass the returned cursor to the next call.
+   * \param cb void(value_type const&)
+   * \return
+   *   The next cursor, 0 indicates the scan is completed
+   */
+  template <typename Cb>
+  size_type Scan(size_type cursor, Cb cb) const;
+
   iterator       begin() noexcept { return iterator(this); }
   const_iterator begin() const noexcept { return const_iterator(this); }
   iterator       end() noexcept { return iterator(this, 1, table2().size()); }
@@ -3,8 +3,11 @@
 #define _MMKV_ALGO_HASH_UTIL_H
 
 #include <stdint.h>
+#include <string.h>
 #include "string.h"
 
+#include <kanon/string/string_view.h>
+
 #include "xxhash.h"
 #include "key_value.h"
 
@@ -23,6 +26,9 @@ struct Hash<std::basic_string<char, std::char_traits<char>, Alloc>> {
   {
     return XXH64(x.c_str(), x.size(), 0);
   }
+
+  /* Heterogeneous lookup, see TreeHashTable::FindLike() */
+  uint64_t operator()(kanon::StringView x) const noexcept { return XXH64(x.data(), x.size(), 0); }
 };
 
 template <typename T>
@@ -58,4 +64,23 @@ BASIC_TYPE_SPECILIZATION(long double)
 
 #include "internal/func_util.h"
 
+namespace mmkv {
+namespace algo {
+
+template <typename Alloc>
+struct EqualKey<std::basic_string<char, std::char_traits<char>, Alloc>> {
+  using StrType = std::basic_string<char, std::char_traits<char>, Alloc>;
+
+  bool operator()(StrType const &k1, StrType const &k2) const noexcept { return k1 == k2; }
+
+  /* Heterogeneous lookup, see HashTable::FindLike() */
+  bool operator()(StrType const &k1, kanon::StringView k2) const noexcept
+  {
+    return k1.size() == k2.size() && ::memcmp(k1.data(), k2.data(), k1.size()) == 0;
+  }
+};
+
+} // namespace algo
+} // namespace mmkv
+
 #endif // _MMKV_ALGO_HASH_UTIL_H
@@ -209,7 +209,15 @@ class AvlTreeBase
 
   V const *Find(K const &key) const { return const_cast<AvlTreeBase *>(this)->Find(key); }
 
-  Node *FindNode(K const &key)
+  Node *FindNode(K const &key) { return FindNodeLike(key); }
+
+  /**
+   * \brief Heterogeneous version of FindNode()
+   * \p key can be any type that can be compared with K by the comparator,
+   * e.g. StringView to String, no temporary K is constructed.
+   */
+  template <typename KeyLike>
+  Node *FindNodeLike(KeyLike const &key)
   {
     BaseNode *node = root_;
     int       res;
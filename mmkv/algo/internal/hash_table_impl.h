@@ -166,7 +166,8 @@ typename HASH_TABLE_CLASS::value_type *HASH_TABLE_CLASS::Find(K const &key)
 }
 
 HASH_TABLE_TEMPLATE
-typename HASH_TABLE_CLASS::Slot **HASH_TABLE_CLASS::FindSlot(K const &key)
+template <typename KeyLike>
+typename HASH_TABLE_CLASS::Slot **HASH_TABLE_CLASS::FindSlotLike(KeyLike const &key)
 {
   // No need to call Rehash()
   IncrementalRehash();
@@ -304,6 +305,35 @@ void HASH_TABLE_CLASS::IncrementalRehash()
   }
 }
 
+HASH_TABLE_TEMPLATE
+template <typename Cb>
+inline typename HASH_TABLE_CLASS::size_type HASH_TABLE_CLASS::Scan(size_type cursor, Cb cb) const
+{
+  if (table1().empty()) return 0;
+
+  auto const &tb1   = table1();
+  const auto  mask1 = tb1.size_mask;
+  for (auto const &entry : tb1[cursor & mask1]) {
+    cb(entry);
+  }
+
+  if (!InRehashing()) return NextScanCursor(cursor, mask1);
+
+  // The table2 is larger than table1,
+  // visit all buckets of table2 that the bucket of table1 expands to.
+  // The moved buckets of table1 are empty.
+  auto const &tb2   = table2();
+  const auto  mask2 = tb2.size_mask;
+  do {
+    for (auto const &entry : tb2[cursor & mask2]) {
+      cb(entry);
+    }
+    cursor = NextScanCursor(cursor, mask2);
+  } while (cursor & (mask1 ^ mask2));
+
+  return cursor;
+}
+
 HASH_TABLE_TEMPLATE
 void HASH_TABLE_CLASS::DebugPrint()
 {
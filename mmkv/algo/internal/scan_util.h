@@ -0,0 +1,42 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_ALGO_INTERNAL_SCAN_UTIL_H_
+#define _MMKV_ALGO_INTERNAL_SCAN_UTIL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace mmkv {
+namespace algo {
+
+inline uint64_t ReverseBits(uint64_t v) noexcept
+{
+  v = ((v >> 1) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1);
+  v = ((v >> 2) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2);
+  v = ((v >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((v & 0x0F0F0F0F0F0F0F0FULL) << 4);
+  v = ((v >> 8) & 0x00FF00FF00FF00FFULL) | ((v & 0x00FF00FF00FF00FFULL) << 8);
+  v = ((v >> 16) & 0x0000FFFF0000FFFFULL) | ((v & 0x0000FFFF0000FFFFULL) << 16);
+  return (v >> 32) | (v << 32);
+}
+
+/**
+ * \brief Increase the high bits of the scan cursor instead of the low bits
+ *
+ * 桶的个数总是2的幂，表扩大一倍时，桶i中的元素只会移动到桶i或桶i+size中，
+ * 即新增的是高位。按反转的二进制顺序递增游标，那么已经访问的桶在扩大后
+ * 对应的桶也一定已经访问过了，因此rehash不会导致遗漏（但可能重复）。
+ *
+ * \param mask The size mask of the bucket array
+ * \return 0 indicates all buckets have been visited
+ */
+inline uint64_t NextScanCursor(uint64_t cursor, uint64_t mask) noexcept
+{
+  cursor |= ~mask;
+  cursor = ReverseBits(cursor);
+  cursor++;
+  return ReverseBits(cursor);
+}
+
+} // namespace algo
+} // namespace mmkv
+
+#endif // _MMKV_ALGO_INTERNAL_SCAN_UTIL_H_
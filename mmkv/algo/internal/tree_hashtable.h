@@ -8,6 +8,7 @@
 #endif
 
 #include "mmkv/algo/reserved_array.h"
+#include "scan_util.h"
 #include "tree_hash_table_iterator.h"
 
 namespace mmkv {
@@ -149,12 +150,38 @@ class TreeHashTable
    *   If you want do something to the bucket, for example, do something then delete it,
    *   get the bucket can decrease calculate the hash value again
    */
-  Node       *FindNode(K const &key, Bucket **bucket);
+  Node       *FindNode(K const &key, Bucket **bucket) { return FindNodeLike(key, bucket); }
   Node const *FindNode(K const &key) const
   {
     return const_cast<TreeHashTable *>(this)->FindNode(key, nullptr);
   }
 
+  /**
+   * \brief Heterogeneous version of Find()
+   * \p key can be any type accepted by the hash function and the comparator,
+   * e.g. StringView to String, no temporary K is constructed.
+   * \note
+   *   The hash value of \p key must be same with the equivalent K.
+   */
+  template <typename KeyLike>
+  value_type *FindLike(KeyLike const &key)
+  {
+    auto node = FindNodeLike(key, nullptr);
+    return node ? std::addressof(node->value) : nullptr;
+  }
+
+  template <typename KeyLike>
+  value_type const *FindLike(KeyLike const &key) const
+  {
+    return const_cast<TreeHashTable *>(this)->FindLike(key);
+  }
+
+  /**
+   * \brief Heterogeneous version of FindNode()
+   */
+  template <typename KeyLike>
+  Node *FindNodeLike(KeyLike const &key, Bucket **bucket);
+
   /************************************************************/
   /* Delete interface                                         */
   /************************************************************/
@@ -228,6 +255,57 @@ class TreeHashTable
    */
   double load_factor() const noexcept { return ((double)tables_[0].used) / tables_[0].size; }
 
+  /**
+   * \brief Get the memory footprint of the bucket arrays
+   * \note
+   *   The nodes are not included
+   */
+  size_type GetBucketsFootprint() const noexcept
+  {
+    return (table1().size() + table2().size()) * sizeof(Bucket);
+  }
+
+  /**
+   * \brief Visit some entries start from the bucket \p start
+   * The buckets are walked in cycle until \p count entries are visited,
+   * or all buckets have been walked once, or too many empty buckets are walked.
+   * Therefore, a random \p start can be used to sample the entries
+   * and the cost is bounded by \p count.
+   * \param cb void(value_type const&)
+   * \return
+   *   The number of visited entries
+   */
+  template <typename Cb>
+  size_type SampleEntries(size_type start, size_type count, Cb cb) const;
+
+  /**
+   * \brief Visit the entries in the bucket(s) indicated by \p cursor
+   * The cursor is increased in the reversed binary order, so the entries
+   * exist during the whole scan are visited at least once even if the table
+   * is rehashed between two calls(but an entry may be visited more than once).
+   * Start with 0 and pass the returned cursor to the next call.
+   * \param cb void(value_type const&)
+   * \return
+   *   The next cursor, 0 indicates the scan is completed
+   */
+  template <typename Cb>
+  size_type Scan(size_type cursor, Cb cb) const;
+
+  /**
+   * \brief Get the progress of the incremental rehash
+   * \param[out] moved_num The number of buckets moved from the old table
+   * \param[out] total_num The number of buckets of the old table
+   * \return
+   *   false if not in rehashing
+   */
+  bool GetRehashProgress(size_type *moved_num, size_type *total_num) const noexcept
+  {
+    if (!InRehashing()) return false;
+    *moved_num = rehash_move_bucket_index_;
+    *total_num = table1().size();
+    return true;
+  }
+
   iterator       begin() noexcept { return iterator(this); }
   const_iterator begin() const noexcept { return const_iterator(this); }
   iterator       end() noexcept { return iterator(this, 1, table2().size()); }
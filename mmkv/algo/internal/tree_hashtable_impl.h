@@ -223,9 +223,10 @@ inline typename TREE_HASH_TABLE_CLASS::value_type *TREE_HASH_TABLE_CLASS::Find(K
 }
 
 TREE_HASH_TABLE_TEMPLATE
-inline typename TREE_HASH_TABLE_CLASS::Node *TREE_HASH_TABLE_CLASS::FindNode(
-    K const &key,
-    Bucket **bck
+template <typename KeyLike>
+inline typename TREE_HASH_TABLE_CLASS::Node *TREE_HASH_TABLE_CLASS::FindNodeLike(
+    KeyLike const &key,
+    Bucket       **bck
 )
 {
   // No need to call Rehash()
@@ -241,7 +242,7 @@ inline typename TREE_HASH_TABLE_CLASS::Node *TREE_HASH_TABLE_CLASS::FindNode(
   const auto hash_val = HASH_FUNC(key);
   for (int i = 0; i < table_num; ++i) {
     bucket = &table(i)[bucket_index(i, hash_val)];
-    node   = bucket->FindNode(key);
+    node   = bucket->FindNodeLike(key);
 
     if (node) {
       if (bck) *bck = bucket;
@@ -334,6 +335,72 @@ inline void TREE_HASH_TABLE_CLASS::ClearApply(ValueCb cb)
   rehash_move_bucket_index_ = ~0;
 }
 
+TREE_HASH_TABLE_TEMPLATE
+template <typename Cb>
+inline typename TREE_HASH_TABLE_CLASS::size_type TREE_HASH_TABLE_CLASS::SampleEntries(
+    size_type start,
+    size_type count,
+    Cb        cb
+) const
+{
+  size_type visited_num = 0;
+  // Avoid walking all buckets when the table is sparse
+  size_type max_steps   = count * 10;
+
+  // In rehashing, the buckets before rehash_move_bucket_index_ are empty,
+  // entries in them have been moved to table2
+  const int table_num = (InRehashing()) ? 2 : 1;
+  for (int i = 0; i < table_num && visited_num < count; ++i) {
+    auto const     &tb         = table(i);
+    const size_type bucket_num = tb.size();
+
+    for (size_type j = 0; j < bucket_num && visited_num < count && max_steps > 0; ++j) {
+      auto const &bucket = tb[(start + j) & tb.size_mask];
+      if (bucket.empty()) {
+        --max_steps;
+        continue;
+      }
+
+      for (auto const &entry : bucket) {
+        cb(entry);
+        if (++visited_num == count) break;
+      }
+    }
+  }
+
+  return visited_num;
+}
+
+TREE_HASH_TABLE_TEMPLATE
+template <typename Cb>
+inline typename TREE_HASH_TABLE_CLASS::size_type
+TREE_HASH_TABLE_CLASS::Scan(size_type cursor, Cb cb) const
+{
+  if (table1().empty()) return 0;
+
+  auto const &tb1   = table1();
+  const auto  mask1 = tb1.size_mask;
+  for (auto const &entry : tb1[cursor & mask1]) {
+    cb(entry);
+  }
+
+  if (!InRehashing()) return NextScanCursor(cursor, mask1);
+
+  // The table2 is larger than table1,
+  // visit all buckets of table2 that the bucket of table1 expands to.
+  // The moved buckets of table1 are empty.
+  auto const &tb2   = table2();
+  const auto  mask2 = tb2.size_mask;
+  do {
+    for (auto const &entry : tb2[cursor & mask2]) {
+      cb(entry);
+    }
+    cursor = NextScanCursor(cursor, mask2);
+  } while (cursor & (mask1 ^ mask2));
+
+  return cursor;
+}
+
 TREE_HASH_TABLE_TEMPLATE
 void TREE_HASH_TABLE_CLASS::DebugPrint()
 {
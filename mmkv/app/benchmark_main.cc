@@ -0,0 +1,278 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "mmkv/benchmark/bench_client.h"
+#include "mmkv/benchmark/key_generator.h"
+#include "mmkv/benchmark/option.h"
+#include "mmkv/benchmark/workload.h"
+#include "mmkv/client/routing_client.h"
+#include "mmkv/protocol/status_code.h"
+#include "mmkv/util/latency_histogram.h"
+#include "mmkv/util/time_util.h"
+#include "mmkv/version.h"
+
+#include <algorithm>
+#include <inttypes.h>
+#include <memory>
+#include <vector>
+
+#include <kanon/init.h>
+#include <kanon/net/user_client.h>
+#include <takina.h>
+
+using namespace mmkv::benchmark;
+using namespace mmkv::client;
+using namespace mmkv::protocol;
+using namespace mmkv::util;
+using namespace kanon;
+
+static void PrintLatencyRow(char const *name, LatencyHistogram const &hist)
+{
+  ::printf(
+      "%-12s %10" PRIu64 " %8" PRIu64 " %10.1lf %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64
+      " %8" PRIu64 " %10" PRIu64 "\n",
+      name,
+      hist.count(),
+      hist.min(),
+      hist.mean(),
+      hist.GetPercentile(50),
+      hist.GetPercentile(90),
+      hist.GetPercentile(99),
+      hist.GetPercentile(99.9),
+      hist.GetPercentile(99.99),
+      hist.max()
+  );
+}
+
+static void Report(
+    Workload const                                  &workload,
+    std::vector<std::unique_ptr<BenchClient>> const &clients,
+    double                                           elapsed_sec
+)
+{
+  auto const &option = bench_option();
+
+  ::printf("\n====== mmkv-benchmark ======\n");
+  if (option.is_cluster())
+    ::printf("cluster: %s, connections: %zu\n", option.configd.c_str(), clients.size());
+  else
+    ::printf(
+        "server: %s:%d, connections: %zu, threads: %d\n",
+        option.host.c_str(),
+        option.port,
+        clients.size(),
+        option.threads
+    );
+  if (option.is_open_loop())
+    ::printf("mode: open loop, target rate: %d requests/sec\n", option.rate);
+  else
+    ::printf("mode: closed loop, pipeline: %d\n", option.pipeline);
+  ::printf(
+      "keyspace: %d(%s), value size: %d bytes, mix: %s\n",
+      option.keyspace,
+      option.distribution.c_str(),
+      option.value_size,
+      option.mix.c_str()
+  );
+
+  uint64_t received_num                 = 0;
+  uint64_t failed_num                   = 0;
+  uint64_t status_count[UINT8_MAX + 1] = {0};
+  for (auto const &client : clients) {
+    received_num += client->received_num();
+    failed_num   += client->failed_num();
+    for (size_t i = 0; i <= UINT8_MAX; ++i)
+      status_count[i] += client->status_count()[i];
+  }
+
+  ::printf(
+      "\n%" PRIu64 " requests completed in %.3lf sec, throughput: %.0lf requests/sec\n",
+      received_num,
+      elapsed_sec,
+      elapsed_sec > 0 ? received_num / elapsed_sec : 0.
+  );
+  for (size_t i = 0; i <= UINT8_MAX; ++i) {
+    if (status_count[i] == 0) continue;
+    ::printf("  %s: %" PRIu64 "\n", StatusCode2Str((StatusCode)i), status_count[i]);
+  }
+  if (failed_num > 0) ::printf("  not routed: %" PRIu64 "\n", failed_num);
+
+  ::printf(
+      "\nlatency(us)\n%-12s %10s %8s %10s %8s %8s %8s %8s %8s %10s\n",
+      "command",
+      "count",
+      "min",
+      "avg",
+      "p50",
+      "p90",
+      "p99",
+      "p99.9",
+      "p99.99",
+      "max"
+  );
+
+  // The histogram is large, avoid placing it in stack
+  std::unique_ptr<LatencyHistogram> total(new LatencyHistogram);
+  std::unique_ptr<LatencyHistogram> hist(new LatencyHistogram);
+  for (size_t mix_idx = 0; mix_idx < workload.GetCommandNum(); ++mix_idx) {
+    hist->Reset();
+    for (auto const &client : clients)
+      hist->Merge(client->GetHistogram(mix_idx));
+    total->Merge(*hist);
+    PrintLatencyRow(GetCommandString(workload.GetCommand(mix_idx)).c_str(), *hist);
+  }
+
+  if (workload.GetCommandNum() > 1) PrintLatencyRow("ALL", *total);
+}
+
+/* Print the throughput and latency of the last interval, i.e. a time series
+ * which shows the impact of events(e.g. rebalancing) during the load */
+static void ReportInterval(
+    std::vector<std::unique_ptr<BenchClient>> const &clients,
+    LatencyHistogram                                *hist,
+    int64_t                                          start_us,
+    int64_t                                         *p_last_us
+)
+{
+  const auto now_us         = GetMonotonicTimeUs();
+  const auto elapsed_us     = now_us - *p_last_us;
+  uint64_t   unavailable_num = 0;
+
+  hist->Reset();
+  for (auto const &client : clients)
+    client->TakeIntervalStats(hist, &unavailable_num);
+  *p_last_us = now_us;
+
+  ::printf(
+      "[%6.1lfs] %10.0lf requests/sec, p50: %6" PRIu64 "us, p99: %8" PRIu64 "us, max: %8" PRIu64
+      "us, unavailable: %" PRIu64 "\n",
+      (double)(now_us - start_us) / 1000000,
+      elapsed_us > 0 ? hist->count() * 1000000. / elapsed_us : 0.,
+      hist->GetPercentile(50),
+      hist->GetPercentile(99),
+      hist->max(),
+      unavailable_num
+  );
+  ::fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+  std::string errmsg;
+  RegisterOptions();
+  if (!takina::Parse(argc, argv, &errmsg)) {
+    ::fprintf(stderr, "Failed to parse option: %s\n", errmsg.c_str());
+    return 0;
+  }
+
+  auto const &option = bench_option();
+
+  if (option.version) {
+    printf("mmkv v%s\n", MMKV_VERSION_STR);
+    return 0;
+  }
+
+  if (MmbpCodec::GetChecksumAlgo(option.checksum) == MmbpCodec::CA_NUM) {
+    ::fprintf(stderr, "Invalid checksum algorithm: %s\n", option.checksum.c_str());
+    return 0;
+  }
+
+  const auto dist = KeyGenerator::GetDistribution(option.distribution);
+  if (dist == KeyGenerator::D_NUM) {
+    ::fprintf(stderr, "Invalid distribution: %s\n", option.distribution.c_str());
+    return 0;
+  }
+
+  if (dist == KeyGenerator::D_ZIPFIAN && (option.zipf_theta <= 0 || option.zipf_theta >= 1)) {
+    ::fprintf(stderr, "Invalid zipf theta: %lf, must be in (0, 1)\n", option.zipf_theta);
+    return 0;
+  }
+
+  if (option.connections <= 0 || option.threads <= 0 || option.requests <= 0 ||
+      option.pipeline <= 0 || option.rate < 0 || option.keyspace <= 0 || option.value_size < 0 ||
+      option.interval < 0)
+  {
+    ::fprintf(stderr, "Invalid option: the numbers must be positive\n");
+    return 0;
+  }
+
+  Workload workload;
+  if (!workload.Parse(option.mix, &errmsg)) {
+    ::fprintf(stderr, "Invalid mix: %s\n", errmsg.c_str());
+    return 0;
+  }
+  workload.SetValueSize(option.value_size);
+
+  kanon::KanonInitialize();
+  kanon::SetKanonLog(option.log);
+  if (!option.log) {
+    kanon::Logger::SetLogLevel(kanon::Logger::KANON_LL_ERROR);
+  }
+
+  // The zeta of zipfian is computed once, then copied to each connection
+  const KeyGenerator key_gen(dist, option.keyspace, option.zipf_theta);
+
+  // The clients are driven by the loop of routing client in cluster mode
+  const int conn_num   = std::min(option.connections, option.requests);
+  const int thread_num = option.is_cluster() ? 1 : std::min(option.threads, conn_num);
+
+  std::vector<std::unique_ptr<EventLoopThread>> loop_threads;
+  std::vector<EventLoop *>                      loops;
+  for (int i = 0; i < thread_num; ++i) {
+    loop_threads.emplace_back(new EventLoopThread);
+    loops.push_back(loop_threads.back()->StartRun());
+  }
+
+  std::unique_ptr<RoutingClient> router;
+  if (option.is_cluster()) {
+    router.reset(new RoutingClient(loops[0], InetAddr(option.configd)));
+    if (!router->Start()) {
+      ::fprintf(stderr, "Failed to fetch the shard map from configd %s\n", option.configd.c_str());
+      return 0;
+    }
+  }
+
+  CountDownLatch latch(conn_num);
+  InetAddr       server_addr(option.host, option.port);
+
+  // The requests and rate are split evenly
+  std::vector<std::unique_ptr<BenchClient>> clients;
+  for (int i = 0; i < conn_num; ++i) {
+    BenchClient::Config config;
+    config.requests = option.requests / conn_num + (i < option.requests % conn_num ? 1 : 0);
+    config.pipeline = option.pipeline;
+    config.rate     = (double)option.rate / conn_num;
+    config.keyspace = option.keyspace;
+    config.seed     = i + 1;
+
+    if (router)
+      clients.emplace_back(new BenchClient(router.get(), loops[0], config, key_gen, workload, &latch));
+    else
+      clients.emplace_back(
+          new BenchClient(loops[i % thread_num], server_addr, config, key_gen, workload, &latch)
+      );
+  }
+
+  const auto start_us = GetMonotonicTimeUs();
+  for (auto &client : clients)
+    client->Start();
+
+  // The histogram is large, avoid placing it in stack
+  std::unique_ptr<LatencyHistogram> interval_hist(new LatencyHistogram);
+  int64_t                           last_us = start_us;
+  TimerId                           report_timer;
+  if (option.interval > 0) {
+    report_timer = loops[0]->RunEvery(
+        [&clients, &interval_hist, start_us, &last_us]() {
+          ReportInterval(clients, interval_hist.get(), start_us, &last_us);
+        },
+        option.interval
+    );
+  }
+
+  latch.Wait();
+  const auto elapsed_sec = (double)(GetMonotonicTimeUs() - start_us) / 1000000;
+  if (option.interval > 0) loops[0]->CancelTimer(report_timer);
+  if (router) router->Stop();
+
+  Report(workload, clients, elapsed_sec);
+  return 0;
+}
@@ -1,4 +1,5 @@
 // SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "mmkv/client/bulk_loader.h"
 #include "mmkv/client/information.h"
 #include "mmkv/client/mmkv_client.h"
 #include "mmkv/client/option.h"
@@ -23,6 +24,13 @@ int main(int argc, char *argv[])
     return 0;
   }
 
+  if (mmkv::protocol::MmbpCodec::GetChecksumAlgo(cli_option().checksum) ==
+      mmkv::protocol::MmbpCodec::CA_NUM)
+  {
+    ::fprintf(stderr, "Invalid checksum algorithm: %s\n", cli_option().checksum.c_str());
+    return 0;
+  }
+
   InstallInformation();
 
   kanon::KanonInitialize();
@@ -35,10 +43,32 @@ int main(int argc, char *argv[])
     kanon::Logger::SetLogLevel(kanon::Logger::KANON_LL_ERROR);
   }
 
+  if (cli_option().pipe && cli_option().pipe_window <= 0) {
+    ::fprintf(stderr, "Invalid pipe window: %d\n", cli_option().pipe_window);
+    return 0;
+  }
+
   EventLoopThread loop_thread;
   auto            loop = loop_thread.StartRun();
 
-  InetAddr   server_addr(cli_option().host, cli_option().port);
+  InetAddr server_addr(cli_option().host, cli_option().port);
+
+  if (cli_option().pipe) {
+    FILE *input = stdin;
+    if (!cli_option().pipe_file.empty()) {
+      input = ::fopen(cli_option().pipe_file.c_str(), cli_option().pipe_raw ? "rb" : "r");
+      if (!input) {
+        ::fprintf(stderr, "Failed to open file: %s\n", cli_option().pipe_file.c_str());
+        return EXIT_FAILURE;
+      }
+    }
+
+    BulkLoader loader(loop, server_addr);
+    const auto ok = loader.Run(input);
+    if (input != stdin) ::fclose(input);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
   MmkvClient client(loop, server_addr);
   client.Start();
 
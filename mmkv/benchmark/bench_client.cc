@@ -0,0 +1,240 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "bench_client.h"
+
+#include "mmkv/protocol/mmbp_response.h"
+#include "mmkv/protocol/mmbp_util.h"
+#include "mmkv/protocol/status_code.h"
+#include "mmkv/util/time_util.h"
+
+#include <kanon/net/tcp_client.h>
+
+#include "option.h"
+
+using namespace mmkv::benchmark;
+using namespace mmkv::protocol;
+using namespace mmkv::util;
+using namespace kanon;
+
+/* The schedule of open loop is checked every tick */
+static constexpr double TICK_INTERVAL = 0.001;
+
+/* The closed loop waits this after the request is failed */
+static constexpr double FAILURE_BACKOFF = 0.001;
+
+BenchClient::BenchClient(
+    EventLoop          *loop,
+    InetAddr const     &server_addr,
+    Config const       &config,
+    KeyGenerator const &key_gen,
+    Workload const     &workload,
+    CountDownLatch     *latch
+)
+  : loop_(loop)
+  , cli_(NewTcpClient(loop, server_addr, "Mmkv benchmark"))
+  , codec_(MmbpResponse::GetPrototype())
+  , config_(config)
+  , key_gen_(key_gen)
+  , workload_(workload)
+  , rng_(config.seed)
+  , latch_(latch)
+  , hists_(workload.GetCommandNum())
+{
+  key_gen_.Seed(config.seed);
+  codec_.SetChecksumAlgo(MmbpCodec::GetChecksumAlgo(bench_option().checksum));
+
+  codec_.SetErrorCallback([](TcpConnectionPtr const &conn, MmbpCodec::ErrorCode code) {
+    ::fprintf(stderr, "ERROR occurred: %s\n", MmbpCodec::GetErrorString(code));
+    conn->ShutdownWrite();
+  });
+
+  codec_.SetMessageCallback([this](
+                                TcpConnectionPtr const &,
+                                Buffer                 &buffer,
+                                uint32_t                response_len,
+                                MmbpCodec::ChecksumAlgo,
+                                TimeStamp
+                            ) { OnResponse(buffer, response_len); });
+
+  cli_->SetConnectionCallback([this](TcpConnectionPtr const &conn) { OnConnection(conn); });
+}
+
+BenchClient::BenchClient(
+    client::RoutingClient *router,
+    EventLoop             *loop,
+    Config const          &config,
+    KeyGenerator const    &key_gen,
+    Workload const        &workload,
+    CountDownLatch        *latch
+)
+  : loop_(loop)
+  , codec_(MmbpResponse::GetPrototype())
+  , router_(router)
+  , config_(config)
+  , key_gen_(key_gen)
+  , workload_(workload)
+  , rng_(config.seed)
+  , latch_(latch)
+  , hists_(workload.GetCommandNum())
+{
+  key_gen_.Seed(config.seed);
+}
+
+BenchClient::~BenchClient() noexcept {}
+
+void BenchClient::Start()
+{
+  if (router_)
+    loop_->RunInLoop([this]() { OnStart(); });
+  else
+    cli_->Connect();
+}
+
+void BenchClient::TakeIntervalStats(LatencyHistogram *hist, uint64_t *p_unavailable_num)
+{
+  MutexGuard guard(interval_lock_);
+  hist->Merge(interval_hist_);
+  *p_unavailable_num += interval_unavailable_num_;
+  interval_hist_.Reset();
+  interval_unavailable_num_ = 0;
+}
+
+void BenchClient::OnConnection(TcpConnectionPtr const &conn)
+{
+  if (!conn->IsConnected()) {
+    conn_ = nullptr;
+    if (!finished_) {
+      ::fprintf(stderr, "ERROR: The connection is closed before all responses are received\n");
+      Finish();
+    }
+    return;
+  }
+
+  codec_.SetUpConnection(conn);
+  conn_ = conn.get();
+  OnStart();
+}
+
+void BenchClient::OnStart()
+{
+  start_us_ = GetMonotonicTimeUs();
+
+  if (config_.requests == 0) {
+    Finish();
+    return;
+  }
+
+  if (config_.rate > 0) {
+    tick_timer_     = loop_->RunEvery([this]() { OnTick(); }, TICK_INTERVAL);
+    has_tick_timer_ = true;
+    OnTick();
+  } else {
+    for (int i = 0; i < config_.pipeline && sent_num_ < config_.requests; ++i)
+      SendRequest(GetMonotonicTimeUs());
+  }
+}
+
+void BenchClient::OnTick()
+{
+  if (finished_) return;
+
+  const double interval_us = 1000000. / config_.rate;
+  const auto   now         = GetMonotonicTimeUs();
+
+  // Send all requests whose scheduled time is due,
+  // the requests delayed by the tick are also measured from the schedule
+  while (sent_num_ < config_.requests) {
+    const auto scheduled_us = start_us_ + (int64_t)(sent_num_ * interval_us);
+    if (scheduled_us > now) break;
+    SendRequest(scheduled_us);
+  }
+
+  if (sent_num_ == config_.requests && has_tick_timer_) {
+    loop_->CancelTimer(tick_timer_);
+    has_tick_timer_ = false;
+  }
+}
+
+void BenchClient::SendRequest(int64_t start_us)
+{
+  const auto mix_idx = workload_.Pick(rng_());
+  workload_.FillRequest(mix_idx, key_gen_.Next(), rng_() % config_.keyspace, request_);
+  ++sent_num_;
+
+  // The responses from different nodes are out of order
+  if (router_) {
+    router_->Send(request_, [this, mix_idx, start_us](MmbpResponse *response) {
+      OnComplete(mix_idx, start_us, response ? response->status_code : -1);
+    });
+    return;
+  }
+
+  pendings_.push_back({mix_idx, start_us});
+  codec_.Send(conn_, &request_);
+}
+
+void BenchClient::OnResponse(Buffer &buffer, uint32_t response_len)
+{
+  // Only the status code is required, which is the first field of MmbpResponse
+  const auto readable_size = buffer.GetReadableSize();
+  uint8_t    status_code   = -1;
+  ParseComponent(status_code, buffer);
+  buffer.AdvanceRead(response_len - (readable_size - buffer.GetReadableSize()));
+
+  if (pendings_.empty()) return;
+
+  const auto pending = pendings_.front();
+  pendings_.pop_front();
+  OnComplete(pending.mix_idx, pending.start_us, status_code);
+}
+
+void BenchClient::OnComplete(size_t mix_idx, int64_t start_us, int status_code)
+{
+  if (finished_) return;
+
+  const auto latency_us = GetMonotonicTimeUs() - start_us;
+  hists_[mix_idx].Record(latency_us);
+  if (status_code >= 0)
+    ++status_count_[status_code];
+  else
+    ++failed_num_;
+  ++received_num_;
+
+  {
+    MutexGuard guard(interval_lock_);
+    interval_hist_.Record(latency_us);
+    if (status_code < 0 || status_code == S_SHARD_LOCKED || status_code == S_SHARD_NONEXISTS ||
+        status_code == S_MOVED || status_code == S_ASK)
+    {
+      ++interval_unavailable_num_;
+    }
+  }
+
+  if (received_num_ == config_.requests) {
+    Finish();
+    return;
+  }
+
+  if (config_.rate <= 0 && sent_num_ < config_.requests) {
+    // The request isn't routed(e.g. the shard map isn't fetched),
+    // back off instead of failing all requests in a busy loop
+    if (status_code < 0) {
+      loop_->RunAfter([this]() { SendRequest(GetMonotonicTimeUs()); }, FAILURE_BACKOFF);
+      return;
+    }
+    SendRequest(GetMonotonicTimeUs());
+  }
+}
+
+void BenchClient::Finish()
+{
+  if (finished_) return;
+  finished_ = true;
+
+  if (has_tick_timer_) {
+    loop_->CancelTimer(tick_timer_);
+    has_tick_timer_ = false;
+  }
+
+  if (cli_ && conn_) cli_->Disconnect();
+  latch_->Countdown();
+}
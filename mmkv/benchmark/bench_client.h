@@ -0,0 +1,147 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_BENCHMARK_BENCH_CLIENT_H_
+#define _MMKV_BENCHMARK_BENCH_CLIENT_H_
+
+#include <stdint.h>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "mmkv/client/routing_client.h"
+#include "mmkv/protocol/mmbp_codec.h"
+#include "mmkv/protocol/mmbp_request.h"
+#include "mmkv/util/latency_histogram.h"
+
+#include "key_generator.h"
+#include "workload.h"
+
+#include <kanon/net/user_client.h>
+#include <kanon/thread/count_down_latch.h>
+#include <kanon/thread/mutex_lock.h>
+#include <kanon/util/noncopyable.h>
+
+namespace mmkv {
+namespace benchmark {
+
+/**
+ * \brief A connection of load generator
+ * The client is driven by the IO thread of its loop only.
+ *
+ * - Closed loop: keep pipeline requests in flight, the next request is sent
+ *   once a response is received.
+ * - Open loop: the i-th request is scheduled at start + i / rate regardless of
+ *   the responses, and the latency is measured from the scheduled time
+ *   instead of the actual send time, thus the queueing delay is not omitted
+ *   when the server stalls(i.e. coordinated omission).
+ *
+ * The latch is counted down once when all responses are received or the connection is closed.
+ *
+ * If a routing client is given(i.e. cluster mode), the requests are routed to the nodes
+ * owning their keys instead, and the client must share the loop of routing client.
+ */
+class BenchClient {
+  DISABLE_EVIL_COPYABLE(BenchClient)
+
+  struct Pending {
+    size_t  mix_idx;
+    int64_t start_us;
+  };
+
+ public:
+  struct Config {
+    uint64_t requests;
+    int      pipeline;
+    double   rate; // requests/sec of this connection, 0 means closed loop
+    uint64_t keyspace;
+    uint64_t seed;
+  };
+
+  BenchClient(
+      EventLoop              *loop,
+      InetAddr const         &server_addr,
+      Config const           &config,
+      KeyGenerator const     &key_gen,
+      Workload const         &workload,
+      kanon::CountDownLatch  *latch
+  );
+
+  BenchClient(
+      client::RoutingClient *router,
+      EventLoop             *loop,
+      Config const          &config,
+      KeyGenerator const    &key_gen,
+      Workload const        &workload,
+      kanon::CountDownLatch *latch
+  );
+
+  ~BenchClient() noexcept;
+
+  void Start();
+
+  /* Valid after the latch is counted down */
+  util::LatencyHistogram const &GetHistogram(size_t mix_idx) const noexcept
+  {
+    return hists_[mix_idx];
+  }
+
+  uint64_t        received_num() const noexcept { return received_num_; }
+  uint64_t const *status_count() const noexcept { return status_count_; }
+  uint64_t        failed_num() const noexcept { return failed_num_; }
+
+  /**
+   * \brief Merge the latencies since the last call to \p hist
+   * \param p_unavailable_num Added by the number of requests refused or failed
+   *                          since the shard is migrating(or the node is down)
+   * \note Thread-safe, called by the reporter periodically
+   */
+  void TakeIntervalStats(util::LatencyHistogram *hist, uint64_t *p_unavailable_num);
+
+ private:
+  void OnConnection(TcpConnectionPtr const &conn);
+  void OnResponse(Buffer &buffer, uint32_t response_len);
+  void OnStart();
+  void OnTick();
+
+  /* Record the response, then send the next request if closed loop.
+   * status_code is -1 if the request can't be routed. */
+  void OnComplete(size_t mix_idx, int64_t start_us, int status_code);
+
+  void SendRequest(int64_t start_us);
+  void Finish();
+
+  EventLoop             *loop_;
+  kanon::TcpClientPtr    cli_;
+  kanon::TcpConnection  *conn_ = nullptr;
+  protocol::MmbpCodec    codec_;
+  client::RoutingClient *router_ = nullptr;
+
+  Config                 config_;
+  KeyGenerator           key_gen_;
+  Workload const        &workload_;
+  std::mt19937_64        rng_;
+  protocol::MmbpRequest  request_;
+  kanon::CountDownLatch *latch_;
+
+  std::deque<Pending> pendings_;
+  kanon::TimerId      tick_timer_;
+  bool                has_tick_timer_ = false;
+  int64_t             start_us_       = 0;
+  bool                finished_       = false;
+
+  // Statistics
+  std::vector<util::LatencyHistogram> hists_; // indexed by mix index
+  uint64_t                            sent_num_                    = 0;
+  uint64_t                            received_num_                = 0;
+  uint64_t                            status_count_[UINT8_MAX + 1] = {0};
+  uint64_t                            failed_num_                  = 0;
+
+  // Taken by the reporter in other thread
+  kanon::MutexLock       interval_lock_;
+  util::LatencyHistogram interval_hist_;
+  uint64_t               interval_unavailable_num_ = 0;
+};
+
+} // namespace benchmark
+} // namespace mmkv
+
+#endif // _MMKV_BENCHMARK_BENCH_CLIENT_H_
@@ -0,0 +1,61 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "key_generator.h"
+
+#include <math.h>
+
+using namespace mmkv::benchmark;
+
+static char const *DISTRIBUTION_STRS[] = {"uniform", "zipfian"};
+
+static double Zeta(uint64_t n, double theta) noexcept
+{
+  double sum = 0;
+  for (uint64_t i = 1; i <= n; ++i)
+    sum += 1. / pow((double)i, theta);
+  return sum;
+}
+
+KeyGenerator::KeyGenerator(Distribution dist, uint64_t n, double theta)
+  : dist_(dist)
+  , n_(n)
+  , real_dist_(0., 1.)
+  , theta_(theta)
+  , zetan_(0)
+  , alpha_(0)
+  , eta_(0)
+  , half_pow_theta_(0)
+{
+  if (dist_ == D_ZIPFIAN) {
+    const double zeta2 = Zeta(2, theta_);
+    zetan_             = Zeta(n_, theta_);
+    alpha_             = 1. / (1. - theta_);
+    eta_               = (1. - pow(2. / n_, 1. - theta_)) / (1. - zeta2 / zetan_);
+    half_pow_theta_    = pow(0.5, theta_);
+  }
+}
+
+uint64_t KeyGenerator::Next() noexcept
+{
+  const double u = real_dist_(rng_);
+  if (dist_ == D_UNIFORM) return (uint64_t)(u * n_);
+
+  const double uz = u * zetan_;
+  if (uz < 1.) return 0;
+  if (uz < 1. + half_pow_theta_) return 1;
+
+  const auto ret = (uint64_t)(n_ * pow(eta_ * u - eta_ + 1., alpha_));
+  return ret < n_ ? ret : n_ - 1;
+}
+
+auto KeyGenerator::GetDistribution(kanon::StringView name) noexcept -> Distribution
+{
+  for (int i = 0; i < D_NUM; ++i) {
+    if (name == DISTRIBUTION_STRS[i]) return (Distribution)i;
+  }
+  return D_NUM;
+}
+
+char const *KeyGenerator::GetDistributionString(Distribution dist) noexcept
+{
+  return dist < D_NUM ? DISTRIBUTION_STRS[dist] : "unknown";
+}
@@ -0,0 +1,58 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_BENCHMARK_KEY_GENERATOR_H_
+#define _MMKV_BENCHMARK_KEY_GENERATOR_H_
+
+#include <stdint.h>
+#include <random>
+
+#include <kanon/string/string_view.h>
+
+namespace mmkv {
+namespace benchmark {
+
+/**
+ * \brief Generate the key index in [0, n) in the given distribution
+ * The zipfian generator follows the algorithm of YCSB(Gray et al.),
+ * the index 0 is the hottest.
+ *
+ * Computing zeta(n) is O(n), thus construct a prototype once
+ * and copy it to each connection with different seed.
+ */
+class KeyGenerator {
+ public:
+  enum Distribution : uint8_t {
+    D_UNIFORM = 0,
+    D_ZIPFIAN,
+    D_NUM,
+  };
+
+  KeyGenerator(Distribution dist, uint64_t n, double theta = 0.99);
+
+  void Seed(uint64_t seed) { rng_.seed(seed); }
+
+  uint64_t Next() noexcept;
+
+  Distribution distribution() const noexcept { return dist_; }
+
+  /* \return D_NUM if invalid */
+  static Distribution GetDistribution(kanon::StringView name) noexcept;
+  static char const  *GetDistributionString(Distribution dist) noexcept;
+
+ private:
+  Distribution                           dist_;
+  uint64_t                               n_;
+  std::mt19937_64                        rng_;
+  std::uniform_real_distribution<double> real_dist_;
+
+  // Zipfian parameters
+  double theta_;
+  double zetan_;
+  double alpha_;
+  double eta_;
+  double half_pow_theta_;
+};
+
+} // namespace benchmark
+} // namespace mmkv
+
+#endif // _MMKV_BENCHMARK_KEY_GENERATOR_H_
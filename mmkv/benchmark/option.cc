@@ -0,0 +1,119 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "option.h"
+
+#include <takina.h>
+
+namespace mmkv {
+namespace benchmark {
+
+Option &bench_option()
+{
+  static Option option;
+  return option;
+}
+
+void RegisterOptions()
+{
+  takina::AddUsage("./mmkv-benchmark [OPTIONS]");
+  takina::AddDescription("Load generator of mmkv");
+
+  takina::AddSection("Connect control");
+  takina::AddOption({"h", "host", "Hostname of mmkv server", "HOST"}, &bench_option().host);
+  takina::AddOption(
+      {"p", "port", "Port of mmkv server(default: 9998)", "PORT"},
+      &bench_option().port
+  );
+  takina::AddOption(
+      {"",
+       "configd",
+       "Endpoint(host:port) of configd, the requests are routed to the nodes of cluster. "
+       "All connections share one IO thread",
+       "ENDPOINT"},
+      &bench_option().configd
+  );
+  takina::AddOption(
+      {"cs",
+       "checksum",
+       "Checksum algorithm of the frame: xxhash, crc32c, none(only for loopback)",
+       "ALGO"},
+      &bench_option().checksum
+  );
+  takina::AddOption(
+      {"c", "connections", "Number of connections(default: 50)", "NUM"},
+      &bench_option().connections
+  );
+  takina::AddOption(
+      {"t",
+       "threads",
+       "Number of IO threads, the connections are distributed evenly(default: 1)",
+       "NUM"},
+      &bench_option().threads
+  );
+
+  takina::AddSection("Load control");
+  takina::AddOption(
+      {"n", "requests", "Total number of requests(default: 100000)", "NUM"},
+      &bench_option().requests
+  );
+  takina::AddOption(
+      {"P",
+       "pipeline",
+       "Number of in-flight requests per connection in closed loop(default: 1)",
+       "NUM"},
+      &bench_option().pipeline
+  );
+  takina::AddOption(
+      {"R",
+       "rate",
+       "Target requests/sec of all connections, i.e. open loop. "
+       "The latency is measured from the scheduled time(default: 0, closed loop)",
+       "NUM"},
+      &bench_option().rate
+  );
+
+  takina::AddSection("Workload");
+  takina::AddOption(
+      {"m",
+       "mix",
+       "Weighted commands separated by comma(default: strset:1,strget:1). "
+       "Supported: stradd, strset, strget, strdel, lappend, lprepend, lpopfront, lpopback, "
+       "sadd, sexists, mset, mget, vadd, del",
+       "MIX"},
+      &bench_option().mix
+  );
+  takina::AddOption(
+      {"r", "keyspace", "Number of distinct keys(default: 100000)", "NUM"},
+      &bench_option().keyspace
+  );
+  takina::AddOption(
+      {"dist", "distribution", "Distribution of keys: uniform, zipfian(default: uniform)", "DIST"},
+      &bench_option().distribution
+  );
+  takina::AddOption(
+      {"", "zipf-theta", "Skewness of zipfian distribution in (0, 1)(default: 0.99)", "THETA"},
+      &bench_option().zipf_theta
+  );
+  takina::AddOption(
+      {"d", "value-size", "Size of value in bytes(default: 64)", "SIZE"},
+      &bench_option().value_size
+  );
+
+  takina::AddSection("Report control");
+  takina::AddOption(
+      {"i",
+       "interval",
+       "Report the throughput and latency every NUM seconds, "
+       "e.g. watch the cluster when rebalancing(default: 0, only the summary)",
+       "NUM"},
+      &bench_option().interval
+  );
+
+  takina::AddSection("Log control");
+  takina::AddOption({"l", "log", "Enable log trace/debug/... message"}, &bench_option().log);
+
+  takina::AddSection("Version information");
+  takina::AddOption({"v", "version", "Show the current version of mmkv"}, &bench_option().version);
+}
+
+} // namespace benchmark
+} // namespace mmkv
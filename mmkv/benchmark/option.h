@@ -0,0 +1,40 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_BENCHMARK_OPTION_H_
+#define _MMKV_BENCHMARK_OPTION_H_
+
+#include <string>
+
+namespace mmkv {
+namespace benchmark {
+
+struct Option {
+  std::string host         = "127.0.0.1";
+  int         port         = 9998;
+  std::string configd; // host:port, route to the nodes of cluster if not empty
+  std::string checksum     = "xxhash";
+  int         connections  = 50;
+  int         threads      = 1;
+  int         requests     = 100000;
+  int         pipeline     = 1;
+  int         rate         = 0; // requests/sec, 0 means closed loop
+  int         keyspace     = 100000;
+  std::string distribution = "uniform";
+  double      zipf_theta   = 0.99;
+  int         value_size   = 64;
+  std::string mix          = "strset:1,strget:1";
+  int         interval     = 0; // seconds, 0 means only the summary
+  bool        log          = false;
+  bool        version      = false;
+
+  bool is_open_loop() const noexcept { return rate > 0; }
+  bool is_cluster() const noexcept { return !configd.empty(); }
+};
+
+Option &bench_option();
+
+void RegisterOptions();
+
+} // namespace benchmark
+} // namespace mmkv
+
+#endif // _MMKV_BENCHMARK_OPTION_H_
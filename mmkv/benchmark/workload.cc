@@ -0,0 +1,170 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "workload.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace mmkv::benchmark;
+using namespace mmkv::protocol;
+using namespace kanon;
+
+static constexpr int KEY_BUF_SIZE = 32;
+
+static inline void FormatIndex(char const *prefix, uint64_t idx, String &out)
+{
+  char buf[KEY_BUF_SIZE];
+  const int n = ::snprintf(buf, sizeof buf, "%s%010" PRIu64, prefix, idx);
+  out.assign(buf, n);
+}
+
+/* The command table is small, linear search is enough */
+static Command GetCommandByName(std::string const &name) noexcept
+{
+  for (int i = 0; i < COMMAND_NUM; ++i) {
+    if (GetCommandString((Command)i) == name) return (Command)i;
+  }
+  return COMMAND_NUM;
+}
+
+bool Workload::IsSupported(Command cmd) noexcept
+{
+  switch (cmd) {
+    case STR_ADD:
+    case STR_SET:
+    case STR_GET:
+    case STR_DEL:
+    case LAPPEND:
+    case LPREPEND:
+    case LPOPFRONT:
+    case LPOPBACK:
+    case SADD:
+    case SEXISTS:
+    case MSET:
+    case MGET:
+    case VADD:
+    case DEL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool Workload::Parse(StringView mix, std::string *errmsg)
+{
+  entries_.clear();
+  weight_sum_ = 0;
+
+  while (!mix.empty()) {
+    auto comma_pos = mix.find(',');
+    auto item      = mix.substr(0, comma_pos);
+    mix.remove_prefix(comma_pos == StringView::npos ? mix.size() : comma_pos + 1);
+
+    if (item.empty()) continue;
+
+    auto     colon_pos = item.find(':');
+    auto     cmd_view  = item.substr(0, colon_pos);
+    uint32_t weight    = 1;
+    if (colon_pos != StringView::npos) {
+      auto  weight_str = item.substr(colon_pos + 1).ToString();
+      char *end        = nullptr;
+      auto  w          = ::strtoul(weight_str.c_str(), &end, 10);
+      if (weight_str.empty() || *end != '\0' || w == 0 || w > UINT32_MAX) {
+        *errmsg = "invalid weight: " + item.ToString();
+        return false;
+      }
+      weight = (uint32_t)w;
+    }
+
+    const auto cmd = GetCommandByName(cmd_view.ToUpperString());
+    if (!IsSupported(cmd)) {
+      *errmsg = "unsupported command: " + cmd_view.ToString();
+      return false;
+    }
+
+    entries_.push_back({cmd, weight});
+    weight_sum_ += weight;
+  }
+
+  if (entries_.empty()) {
+    *errmsg = "empty mix";
+    return false;
+  }
+  return true;
+}
+
+size_t Workload::Pick(uint64_t r) const noexcept
+{
+  if (entries_.size() == 1) return 0;
+
+  r %= weight_sum_;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    if (r < entries_[i].weight) return i;
+    r -= entries_[i].weight;
+  }
+  return entries_.size() - 1;
+}
+
+void Workload::FillRequest(
+    size_t       mix_idx,
+    uint64_t     key_idx,
+    uint64_t     member_idx,
+    MmbpRequest &request
+) const
+{
+  request.Reset();
+  request.command = entries_[mix_idx].cmd;
+  request.SetKey();
+  FormatIndex("key:", key_idx, request.key);
+
+  switch (request.command) {
+    case STR_ADD:
+    case STR_SET:
+      request.SetValue();
+      request.value.assign(value_.data(), value_.size());
+      break;
+
+    case LAPPEND:
+    case LPREPEND:
+      request.SetValues();
+      request.values.resize(1);
+      request.values[0].assign(value_.data(), value_.size());
+      break;
+
+    case LPOPFRONT:
+    case LPOPBACK:
+      request.SetCount();
+      request.count = 1;
+      break;
+
+    case SADD:
+      request.SetValues();
+      request.values.resize(1);
+      FormatIndex("member:", member_idx, request.values[0]);
+      break;
+
+    case SEXISTS:
+    case MGET:
+      request.SetValue();
+      FormatIndex(request.command == MGET ? "field:" : "member:", member_idx, request.value);
+      break;
+
+    case MSET:
+      request.SetValues();
+      request.values.resize(2);
+      FormatIndex("field:", member_idx, request.values[0]);
+      request.values[1].assign(value_.data(), value_.size());
+      break;
+
+    case VADD:
+      request.SetVmembers();
+      request.vmembers.resize(1);
+      request.vmembers[0].key = (double)member_idx;
+      FormatIndex("member:", member_idx, request.vmembers[0].value);
+      break;
+
+    default:
+      // STR_GET, STR_DEL, DEL: key only
+      break;
+  }
+}
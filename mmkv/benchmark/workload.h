@@ -0,0 +1,73 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_BENCHMARK_WORKLOAD_H_
+#define _MMKV_BENCHMARK_WORKLOAD_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "mmkv/protocol/command.h"
+#include "mmkv/protocol/mmbp_request.h"
+
+#include <kanon/string/string_view.h>
+
+namespace mmkv {
+namespace benchmark {
+
+/**
+ * \brief The weighted command mix, e.g. "strset:1,strget:9"
+ * The command name is case-insensitive, the weight is optional(default: 1).
+ */
+class Workload {
+  struct Entry {
+    protocol::Command cmd;
+    uint32_t          weight;
+  };
+
+ public:
+  Workload() = default;
+
+  /**
+   * \brief Parse the mix
+   * \param[out] errmsg The reason if failed
+   * \return true if success
+   */
+  bool Parse(kanon::StringView mix, std::string *errmsg);
+
+  void SetValueSize(size_t value_size) { value_.assign(value_size, 'x'); }
+
+  /**
+   * \brief Pick the index of command by the weights
+   * \param r Random number
+   */
+  size_t Pick(uint64_t r) const noexcept;
+
+  /**
+   * \brief Fill the request of the mix_idx-th command
+   * \param key_idx Index of key from the key generator
+   * \param member_idx Index of member, field or element in the container
+   */
+  void FillRequest(
+      size_t                 mix_idx,
+      uint64_t               key_idx,
+      uint64_t               member_idx,
+      protocol::MmbpRequest &request
+  ) const;
+
+  size_t            GetCommandNum() const noexcept { return entries_.size(); }
+  protocol::Command GetCommand(size_t idx) const noexcept { return entries_[idx].cmd; }
+  uint32_t          GetWeight(size_t idx) const noexcept { return entries_[idx].weight; }
+
+  /* \brief Whether the command is supported by the benchmark */
+  static bool IsSupported(protocol::Command cmd) noexcept;
+
+ private:
+  std::vector<Entry> entries_;
+  uint64_t           weight_sum_ = 0;
+  std::string        value_;
+};
+
+} // namespace benchmark
+} // namespace mmkv
+
+#endif // _MMKV_BENCHMARK_WORKLOAD_H_
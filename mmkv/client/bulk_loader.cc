@@ -0,0 +1,381 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "bulk_loader.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <unordered_map>
+
+#include "mmkv/protocol/command.h"
+#include "mmkv/protocol/mmbp_response.h"
+#include "mmkv/util/print_util.h"
+#include "mmkv/util/shard_util.h"
+#include "mmkv/util/time_util.h"
+
+#include "information.h"
+#include "option.h"
+#include "response_printer.h"
+#include "translator.h"
+
+#include <kanon/net/tcp_client.h>
+
+using namespace mmkv::protocol;
+using namespace mmkv::client;
+using namespace mmkv::util;
+using namespace kanon;
+
+static constexpr size_t BUFFER_SIZE = 1 << 16;
+static constexpr size_t INVALID_IDX = -1;
+
+BulkLoader::BulkLoader(EventLoop *loop, InetAddr const &server_addr)
+  : loop_(loop)
+  , server_addr_(server_addr)
+  , codec_(MmbpResponse::GetPrototype())
+  , cond_(mutex_)
+{
+  codec_.SetChecksumAlgo(MmbpCodec::GetChecksumAlgo(cli_option().checksum));
+
+  codec_.SetErrorCallback([this](TcpConnectionPtr const &conn, MmbpCodec::ErrorCode code) {
+    util::ErrorPrintf("ERROR occurred: %s\n", MmbpCodec::GetErrorString(code));
+    conn->ShutdownWrite();
+  });
+
+  codec_.SetMessageCallback([this](
+                                TcpConnectionPtr const &,
+                                Buffer                 &buffer,
+                                uint32_t                response_len,
+                                MmbpCodec::ChecksumAlgo,
+                                TimeStamp
+                            ) {
+    // Only the status code is required,
+    // which is the first field of both MmbpResponse and MmbpBatchResponse
+    const auto readable_size = buffer.GetReadableSize();
+    uint8_t    status_code   = -1;
+    ParseComponent(status_code, buffer);
+    buffer.AdvanceRead(response_len - (readable_size - buffer.GetReadableSize()));
+    ++status_count_[status_code];
+
+    MutexGuard guard(mutex_);
+    --inflight_num_;
+    cond_.Notify();
+  });
+
+  if (cli_option().is_conn_configd()) {
+    p_conf_cli_.reset(new ConfigdClient(loop_, InetAddr(cli_option().configd_endpoint)));
+  }
+}
+
+BulkLoader::~BulkLoader() noexcept {}
+
+bool BulkLoader::Run(FILE *input)
+{
+  if (p_conf_cli_ && !ConnectConfigd()) return false;
+  if (!ConnectNodes()) return false;
+
+  const auto start_time = util::GetTimeUs();
+
+  if (cli_option().pipe_raw)
+    LoadRaw(input);
+  else
+    LoadText(input);
+
+  {
+    MutexGuard guard(mutex_);
+    while (inflight_num_ > 0 && !closed_)
+      cond_.Wait();
+  }
+
+  Report((double)(util::GetTimeUs() - start_time) / 1000000);
+
+  for (auto &node : nodes_)
+    node.cli->Disconnect();
+
+  if (parse_error_num_ > 0 || route_error_num_ > 0) return false;
+  return status_count_[S_OK] == sent_num_;
+}
+
+bool BulkLoader::ConnectConfigd()
+{
+  p_conf_cli_->codec_.SetMessageCallback([this](
+                                             TcpConnectionPtr const &conn,
+                                             Buffer                 &buffer,
+                                             size_t                  payload_size,
+                                             TimeStamp               recv_time
+                                         ) {
+    p_conf_cli_->OnMessage(conn, buffer, payload_size, recv_time);
+
+    MutexGuard guard(mutex_);
+    conf_fetched_ = true;
+    cond_.Notify();
+  });
+
+  p_conf_cli_->cli_->SetConnectionCallback([this](TcpConnectionPtr const &conn) {
+    p_conf_cli_->OnConnection(conn);
+
+    // The configuration is fetched once connected
+    if (conn->IsConnected()) {
+      p_conf_cli_->FetchConfig();
+    } else {
+      MutexGuard guard(mutex_);
+      closed_ = true;
+      cond_.Notify();
+    }
+  });
+
+  PrintfAndFlush("Fetching the shard map from configd...\n");
+  p_conf_cli_->Connect();
+
+  {
+    MutexGuard guard(mutex_);
+    while (!conf_fetched_ && !closed_)
+      cond_.Wait();
+  }
+
+  if (!conf_fetched_) {
+    util::ErrorPrintf("ERROR: Failed to fetch the configuration from configd\n");
+    return false;
+  }
+
+  if (p_conf_cli_->ShardNum() == 0) {
+    util::ErrorPrintf("ERROR: There are no avaliable nodes can execute command!\n");
+    return false;
+  }
+
+  return true;
+}
+
+bool BulkLoader::ConnectNodes()
+{
+  if (!p_conf_cli_) {
+    nodes_.resize(1);
+    SetupNode(0, server_addr_);
+  } else {
+    // Index the nodes and the shard map locally,
+    // the configd client copies the endpoint per query
+    std::unordered_map<node_id_t, size_t> node_id_idx_map;
+    std::vector<InetAddr>                 node_addrs;
+
+    NodeEndPoint ep;
+    for (node_id_t node_idx = 0; p_conf_cli_->QueryNodeEndpointByNodeIdx(node_idx, &ep);
+         ++node_idx)
+    {
+      node_id_idx_map[ep.node_id] = node_idx;
+      node_addrs.emplace_back(ep.host, ep.port);
+    }
+
+    // The callbacks refer to the nodes by index
+    nodes_.resize(node_addrs.size());
+    for (size_t i = 0; i < node_addrs.size(); ++i)
+      SetupNode(i, node_addrs[i]);
+
+    const auto shard_num = p_conf_cli_->ShardNum();
+    shard_node_idx_map_.resize(shard_num, INVALID_IDX);
+    for (shard_id_t shard_id = 0; shard_id < shard_num; ++shard_id) {
+      if (p_conf_cli_->QueryNodeEndpoint(shard_id, &ep)) {
+        shard_node_idx_map_[shard_id] = node_id_idx_map[ep.node_id];
+      }
+    }
+  }
+
+  for (auto &node : nodes_) {
+    PrintfAndFlush("Connecting mmkvd in %s...\n", node.cli->GetServerAddr().ToIpPort().c_str());
+    node.cli->Connect();
+  }
+
+  MutexGuard guard(mutex_);
+  while (connected_num_ < nodes_.size() && !closed_)
+    cond_.Wait();
+
+  if (closed_) {
+    util::ErrorPrintf("ERROR: Failed to connect all nodes\n");
+    return false;
+  }
+  return true;
+}
+
+void BulkLoader::SetupNode(size_t idx, InetAddr const &addr)
+{
+  auto &node = nodes_[idx];
+  node.cli   = NewTcpClient(loop_, addr, "Mmkv bulk loader");
+
+  node.cli->SetConnectionCallback([this, idx](TcpConnectionPtr const &conn) {
+    MutexGuard guard(mutex_);
+    if (conn->IsConnected()) {
+      codec_.SetUpConnection(conn);
+      nodes_[idx].conn = conn;
+      ++connected_num_;
+    } else {
+      nodes_[idx].conn.reset();
+      closed_ = true;
+    }
+    cond_.Notify();
+  });
+}
+
+bool BulkLoader::SendMessage(StringView key, bool has_key, MmbpMessage const *message)
+{
+  size_t node_idx = 0;
+  if (p_conf_cli_) {
+    if (!has_key) {
+      ++route_error_num_;
+      return true;
+    }
+
+    node_idx = shard_node_idx_map_[MakeShardId(key) % shard_node_idx_map_.size()];
+    if (node_idx == INVALID_IDX) {
+      ++route_error_num_;
+      return true;
+    }
+  }
+
+  // The send is queued to the loop if it isn't called in the loop thread
+  TcpConnectionPtr conn;
+  {
+    MutexGuard guard(mutex_);
+    while (inflight_num_ >= (size_t)cli_option().pipe_window && !closed_)
+      cond_.Wait();
+
+    if (closed_) return false;
+    ++inflight_num_;
+    conn = nodes_[node_idx].conn;
+  }
+
+  codec_.Send(conn, message);
+  ++sent_num_;
+  return true;
+}
+
+void BulkLoader::LoadText(FILE *input)
+{
+  MmbpRequest request;
+  Translator  translator;
+
+  char   *line     = nullptr;
+  size_t  line_cap = 0;
+  ssize_t line_len = 0;
+  size_t  line_no  = 0;
+
+  while ((line_len = ::getline(&line, &line_cap, input)) != -1) {
+    ++line_no;
+
+    StringView line_view(line, line_len);
+    while (!line_view.empty() && (line_view.back() == '\n' || line_view.back() == '\r'))
+      line_view.remove_suffix(1);
+
+    if (line_view.empty() || line_view[0] == '#') continue;
+
+    const auto space_pos = line_view.find(' ');
+    const auto cmd_view  = line_view.substr(0, space_pos);
+    const auto cmd       = GetCommand(cmd_view.ToUpperString());
+
+    if (cmd == COMMAND_NUM) {
+      ++parse_error_num_;
+      util::ErrorPrintf(
+          "ERROR: line %zu: invalid command: %s\n",
+          line_no,
+          cmd_view.ToString().c_str()
+      );
+      continue;
+    }
+
+    request.Reset();
+    line_view.remove_prefix(cmd_view.size());
+    if (translator.Parse(&request, cmd, line_view) != Translator::E_OK) {
+      ++parse_error_num_;
+      util::ErrorPrintf(
+          "SYNTAX ERROR: line %zu: %s%s\n",
+          line_no,
+          GetCommandString(cmd).c_str(),
+          GetCommandHint(cmd).c_str()
+      );
+      continue;
+    }
+
+    if (!SendMessage(request.GetKey(), request.HasKey(), &request)) break;
+  }
+
+  ::free(line);
+}
+
+void BulkLoader::LoadRaw(FILE *input)
+{
+  MmbpRequest      request;
+  MmbpBatchRequest batch;
+  Buffer           buffer;
+
+  for (;;) {
+    buffer.ReserveWriteSpace(BUFFER_SIZE);
+    const auto n = ::fread(buffer.GetWriteBegin(), 1, buffer.GetWritableSize(), input);
+    if (n == 0) break;
+    buffer.AdvanceWrite(n);
+
+    // Same with the format of request log
+    while (buffer.GetReadableSize() >= sizeof(uint32_t)) {
+      const auto size = buffer.GetReadBegin32();
+      if (buffer.GetReadableSize() - sizeof(size) < size) break;
+      buffer.AdvanceRead32();
+
+      const auto   readable_size = buffer.GetReadableSize();
+      MmbpMessage *message       = nullptr;
+      StringView   key;
+      bool         has_key = false;
+
+      if (request.PeekCommand(buffer) == BATCH) {
+        batch.ParseFrom(buffer);
+        message = &batch;
+        // The sub-requests of a batch are expected to be in the same shard
+        if (!batch.requests.empty()) {
+          key     = batch.requests[0].GetKey();
+          has_key = batch.requests[0].HasKey();
+        }
+      } else {
+        request.ParseFrom(buffer);
+        message = &request;
+        key     = request.GetKey();
+        has_key = request.HasKey();
+      }
+
+      if (readable_size - buffer.GetReadableSize() != size) {
+        util::ErrorPrintf("ERROR: The size of record is not matched with the request\n");
+        ++parse_error_num_;
+        return;
+      }
+
+      if (!SendMessage(key, has_key, message)) return;
+    }
+  }
+
+  if (buffer.GetReadableSize() > 0) {
+    util::ErrorPrintf("ERROR: The last record is truncated\n");
+    ++parse_error_num_;
+  }
+}
+
+void BulkLoader::Report(double elapsed_sec)
+{
+  uint64_t reply_num = 0;
+  for (auto count : status_count_)
+    reply_num += count;
+
+  PrintfAndFlush(
+      "\nsent: %" PRIu64 ", replied: %" PRIu64 " in %.3lf sec (%.0lf requests/sec)\n",
+      sent_num_,
+      reply_num,
+      elapsed_sec,
+      elapsed_sec > 0 ? reply_num / elapsed_sec : 0.
+  );
+
+  PrintfAndFlush(
+      "errors: %" PRIu64 " (parse: %" PRIu64 ", route: %" PRIu64 ", no reply: %" PRIu64
+      ", not ok: %" PRIu64 ")\n",
+      parse_error_num_ + route_error_num_ + (sent_num_ - status_count_[S_OK]),
+      parse_error_num_,
+      route_error_num_,
+      sent_num_ - reply_num,
+      reply_num - status_count_[S_OK]
+  );
+
+  for (size_t i = 0; i < sizeof(status_count_) / sizeof(status_count_[0]); ++i) {
+    if (i == S_OK || status_count_[i] == 0) continue;
+    PrintfAndFlush("  %s: %" PRIu64 "\n", StatusCode2Str((StatusCode)i), status_count_[i]);
+  }
+}
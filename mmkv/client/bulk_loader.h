@@ -0,0 +1,105 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_CLIENT_BULK_LOADER_H_
+#define _MMKV_CLIENT_BULK_LOADER_H_
+
+#include "mmkv/protocol/mmbp_codec.h"
+#include "mmkv/protocol/mmbp_request.h"
+#include "mmkv/protocol/mmbp_batch.h"
+#include "mmkv/protocol/status_code.h"
+#include "mmkv/configd/configd_client.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <kanon/net/user_client.h>
+#include <kanon/thread/condition.h>
+#include <kanon/thread/mutex_lock.h>
+#include <kanon/util/noncopyable.h>
+
+namespace mmkv {
+namespace client {
+
+/**
+ * \brief Non-interactive pipe mode of mmkv-cli
+ * The requests are read from a file or stdin and sent without waiting the responses,
+ * at most window requests are in flight.
+ *
+ * The input is one of:
+ * - Text: one command per line, the syntax is same with the console
+ *   (The blank line and line starts with '#' are skipped)
+ * - Raw: the records of request log, i.e. size(uint32, big-endian) | MMBP request
+ *
+ * If the configd endpoint is specified, the request is routed to the node
+ * owning the shard of its key, otherwise all requests are sent to the mmkvd.
+ */
+class BulkLoader {
+  DISABLE_EVIL_COPYABLE(BulkLoader)
+
+  using NodeEndPoint = ConfigdClient::NodeEndPoint;
+
+  // The connection is shared with the loader thread,
+  // thus it is kept alive until the message is sent
+  struct Node {
+    kanon::TcpClientPtr     cli;
+    kanon::TcpConnectionPtr conn;
+  };
+
+ public:
+  BulkLoader(EventLoop *loop, InetAddr const &server_addr);
+  ~BulkLoader() noexcept;
+
+  /**
+   * \brief Connect all nodes, load the requests in \p input and report
+   * \return true if all requests are executed successfully
+   */
+  bool Run(FILE *input);
+
+ private:
+  bool ConnectConfigd();
+  bool ConnectNodes();
+  KANON_INLINE void SetupNode(size_t idx, InetAddr const &addr);
+
+  void LoadText(FILE *input);
+  void LoadRaw(FILE *input);
+
+  /**
+   * \brief Send the message to the node owning the key, wait if the window is full
+   * \return false if the connection is closed
+   */
+  bool SendMessage(kanon::StringView key, bool has_key, protocol::MmbpMessage const *message);
+
+  void Report(double elapsed_sec);
+
+  EventLoop *loop_;
+  InetAddr   server_addr_;
+
+  protocol::MmbpCodec            codec_;
+  std::unique_ptr<ConfigdClient> p_conf_cli_;
+
+  std::vector<Node> nodes_;
+
+  // The loader thread waits the connections, configuration
+  // and in-flight requests by the condition
+  kanon::MutexLock mutex_;
+  kanon::Condition cond_;
+  size_t           connected_num_ = 0;
+  bool             conf_fetched_  = false;
+  size_t           inflight_num_  = 0;
+  bool             closed_        = false;
+
+  // Indexed by shard id
+  std::vector<size_t> shard_node_idx_map_;
+
+  // Statistics
+  // status_count_ is modified in IO thread only
+  // and read after all responses are received
+  uint64_t sent_num_                    = 0;
+  uint64_t parse_error_num_             = 0;
+  uint64_t route_error_num_             = 0;
+  uint64_t status_count_[UINT8_MAX + 1] = {0}; // indexed by status code
+};
+
+} // namespace client
+} // namespace mmkv
+
+#endif // _MMKV_CLIENT_BULK_LOADER_H_
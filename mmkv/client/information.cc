@@ -53,9 +53,11 @@ static KANON_INLINE int GenCommandMetadata() KANON_NOEXCEPT
 
     switch (i) {
       case MEM_STAT:
+      case MEM_REPORT:
       case KEYALL:
       case DELALL:
       case SHARD_LEAVE:
+      case ASKING:
         command_formats[(Command)i] = F_NONE;
         command_hints[i]            += "";
         break;
@@ -130,6 +132,11 @@ static KANON_INLINE int GenCommandMetadata() KANON_NOEXCEPT
         command_hints[i]            += " key";
         break;
 
+      case MEM_USAGE:
+        command_formats[(Command)i] = F_OPT_COUNT;
+        command_hints[i]            += " key [samples]";
+        break;
+
       case LADD:
       case LAPPEND:
       case LPREPEND:
@@ -206,11 +213,58 @@ static KANON_INLINE int GenCommandMetadata() KANON_NOEXCEPT
         command_hints[i]            += " key time_interval";
         break;
 
+      case INFO:
+        command_formats[(Command)i] = F_NONE;
+        command_hints[i]            += " [section]";
+        break;
+
+      case SLOWLOG:
+        command_formats[(Command)i] = F_NONE;
+        command_hints[i]            += " [count]";
+        break;
+
+      case SLOWLOG_RESET:
+        command_formats[(Command)i] = F_NONE;
+        command_hints[i]            += "";
+        break;
+
+      case EVAL:
+        command_formats[(Command)i] = F_SCRIPT;
+        command_hints[i]            += " \"script\" numkeys [key...] [arg...]";
+        break;
+
+      case EVALSHA:
+        command_formats[(Command)i] = F_SCRIPT;
+        command_hints[i]            += " hash numkeys [key...] [arg...]";
+        break;
+
+      case SCRIPT_LOAD:
+        command_formats[(Command)i] = F_SCRIPT;
+        command_hints[i]            += " \"script\"";
+        break;
+
+      case SCRIPT_FLUSH:
+        command_formats[(Command)i] = F_NONE;
+        command_hints[i]            += "";
+        break;
+
       case DELS:
         command_formats[(Command)i] = F_MUL_KEYS;
         command_hints[i]            += " keys...";
         break;
 
+      case SCAN:
+        command_formats[(Command)i] = F_SCAN;
+        command_hints[i]            += " cursor [count]";
+        break;
+
+      case MSCAN:
+      case SSCAN:
+      case VSCAN:
+        command_formats[(Command)i] = F_SCAN;
+        command_hints[i]            += " key cursor [count]";
+        break;
+
       default:
         break;
     }
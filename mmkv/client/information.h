@@ -29,6 +29,9 @@ enum CommandFormat : uint8_t {
   F_EXPIRE,       // expirexxx expiration
   F_NONE,         // command
   F_MUL_KEYS,     // command keys...
+  F_SCAN,         // scan cursor [count] or xscan key cursor [count]
+  F_SCRIPT,       // eval "script" numkeys keys... args... or scriptload "script"
+  F_OPT_COUNT,    // command key [count]
   F_INVALID,      // Invalid command
 };
 
@@ -63,6 +63,8 @@ MmkvClient::MmkvClient(EventLoop *loop, InetAddr const &server_addr)
   , wait_cli_num_(0)
   , p_loop_(loop)
 {
+  codec_.SetChecksumAlgo(MmbpCodec::GetChecksumAlgo(cli_option().checksum));
+
   // If there are two connection need to connection, wait them
   if (!cli_option().is_conn_configd()) {
     SetupMmkvClient(server_addr);
@@ -472,7 +474,13 @@ void MmkvClient::SetupMmkvClient(InetAddr const &server_addr)
   });
 
   codec_.SetMessageCallback(
-      [this](TcpConnectionPtr const &, Buffer &buffer, uint32_t, TimeStamp recv_time) {
+      [this](
+          TcpConnectionPtr const &,
+          Buffer &buffer,
+          uint32_t,
+          MmbpCodec::ChecksumAlgo,
+          TimeStamp recv_time
+      ) {
         MmbpResponse response;
         response.ParseFrom(buffer);
         // std::cout << response->GetContent() << "\n";
@@ -34,6 +34,32 @@ void RegisterOptions()
       &cli_option().reconnect
   );
 
+  takina::AddOption(
+      {"cs",
+       "checksum",
+       "Checksum algorithm of the frame: xxhash, crc32c, none(only for loopback)",
+       "ALGO"},
+      &cli_option().checksum
+  );
+
+  takina::AddSection("Pipe mode");
+  takina::AddOption(
+      {"", "pipe", "Load the requests from stdin or file non-interactively"},
+      &cli_option().pipe
+  );
+  takina::AddOption(
+      {"", "pipe-file", "The file of requests, stdin if not specified", "FILE"},
+      &cli_option().pipe_file
+  );
+  takina::AddOption(
+      {"", "pipe-raw", "The input is the raw MMBP requests in the format of request log"},
+      &cli_option().pipe_raw
+  );
+  takina::AddOption(
+      {"", "pipe-window", "The maximum number of in-flight requests(default: 4096)", "NUM"},
+      &cli_option().pipe_window
+  );
+
   takina::AddSection("Log control");
   takina::AddOption({"l", "log", "Enable log trace/debug/... message"}, &cli_option().log);
 
@@ -14,6 +14,13 @@ struct Option {
   bool        log              = false;
   bool        version          = false;
   std::string configd_endpoint = "";
+  std::string checksum         = "xxhash";
+
+  // Pipe mode(bulk loading)
+  bool        pipe        = false;
+  std::string pipe_file   = "";
+  bool        pipe_raw    = false;
+  int         pipe_window = 4096;
 
   bool is_conn_configd() const noexcept { return !configd_endpoint.empty(); }
 };
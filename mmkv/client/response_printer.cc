@@ -31,12 +31,6 @@ void ResponsePrinter::Printf(Command cmd, MmbpResponse *response)
           }
           std::cout << values[i] << "}" << std::endl;
         }
-      } else if (response->HasCount()) {
-        if (cmd == VWEIGHT) {
-          std::cout << "(double)" << util::int2double(response->count) << std::endl;
-        } else {
-          std::cout << "(integer)" << response->count << std::endl;
-        }
       } else if (response->HasVmembers()) {
         auto  &wms   = response->vmembers;
         size_t order = 0;
@@ -49,9 +43,25 @@ void ResponsePrinter::Printf(Command cmd, MmbpResponse *response)
           std::cout << "[" << i++ << "]: "
                     << "(" << kv.key << ", " << kv.value << ")\n";
         }
+      } else if (response->HasCount()) {
+        if (cmd == VWEIGHT) {
+          std::cout << "(double)" << util::int2double(response->count) << std::endl;
+        } else {
+          std::cout << "(integer)" << response->count << std::endl;
+        }
       } else {
         std::cout << "Success!" << std::endl;
       }
+
+      if (response->HasCursor()) {
+        std::cout << "(cursor)" << response->count << std::endl;
+      }
+    } break;
+
+    case S_SCRIPT_ERROR: {
+      std::cout << GetStatusMessage((StatusCode)response->status_code);
+      if (response->HasValue()) std::cout << ": " << response->value;
+      std::cout << std::endl;
     } break;
 
     default:
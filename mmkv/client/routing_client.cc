@@ -0,0 +1,356 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "routing_client.h"
+
+#include "mmkv/protocol/status_code.h"
+#include "mmkv/util/shard_util.h"
+
+#include <kanon/log/logger.h>
+#include <kanon/net/tcp_client.h>
+#include <kanon/thread/count_down_latch.h>
+
+using namespace mmkv::protocol;
+using namespace mmkv::client;
+using namespace mmkv;
+using namespace kanon;
+
+RoutingClient::Node::Node(EventLoop *loop, InetAddr const &addr)
+  : cli(NewTcpClient(loop, addr, "Mmkv routing client"))
+  , codec(MmbpResponse::GetPrototype())
+{
+}
+
+RoutingClient::RoutingClient(EventLoop *loop, InetAddr const &configd_addr)
+  : loop_(loop)
+  , conf_cli_(loop, configd_addr)
+  , moved_num_(0)
+  , ask_num_(0)
+  , cond_(mutex_)
+{
+  conf_cli_.codec_.SetMessageCallback([this](
+                                          TcpConnectionPtr const &conn,
+                                          Buffer                 &buffer,
+                                          size_t                  payload_size,
+                                          TimeStamp               recv_time
+                                      ) {
+    conf_cli_.OnMessage(conn, buffer, payload_size, recv_time);
+  });
+
+  conf_cli_.resp_cb_ = [this](ConfigResponse const &resp) { OnConfigFetched(resp); };
+
+  conf_cli_.cli_->SetConnectionCallback([this](TcpConnectionPtr const &conn) {
+    conf_cli_.OnConnection(conn);
+
+    // The requests waiting the shard map are routed once fetched,
+    // then the changes of shard map are pushed by configd
+    if (conn->IsConnected()) {
+      conf_cli_.Watch();
+    } else {
+      MutexGuard guard(mutex_);
+      closed_ = true;
+      cond_.Notify();
+    }
+  });
+
+  conf_cli_.cli_->EnableRetry();
+}
+
+RoutingClient::~RoutingClient() noexcept {}
+
+bool RoutingClient::Start()
+{
+  conf_cli_.Connect();
+
+  MutexGuard guard(mutex_);
+  while (!conf_fetched_ && !closed_)
+    cond_.Wait();
+  return conf_fetched_;
+}
+
+void RoutingClient::Stop()
+{
+  conf_cli_.cli_->Disconnect();
+  loop_->RunInLoop([this]() {
+    for (auto &id_node : nodes_)
+      id_node.second->cli->Disconnect();
+    for (auto &ep_node : ask_nodes_)
+      ep_node.second->cli->Disconnect();
+  });
+}
+
+void RoutingClient::Send(MmbpRequest request, ResponseCallback cb)
+{
+  loop_->RunInLoop([this, request, cb]() mutable {
+    PendingRequest pending;
+    pending.request = std::move(request);
+    pending.cb      = std::move(cb);
+    Route(std::move(pending));
+  });
+}
+
+bool RoutingClient::Execute(MmbpRequest request, MmbpResponse &response)
+{
+  CountDownLatch latch(1);
+  bool           is_ok = false;
+
+  Send(std::move(request), [&latch, &is_ok, &response](MmbpResponse *p_response) {
+    if (p_response) {
+      response = std::move(*p_response);
+      is_ok    = true;
+    }
+    latch.Countdown();
+  });
+
+  latch.Wait();
+  return is_ok;
+}
+
+void RoutingClient::RefreshShardMap()
+{
+  loop_->RunInLoop([this]() {
+    if (is_refreshing_) return;
+    is_refreshing_ = true;
+    conf_cli_.Watch();
+  });
+}
+
+void RoutingClient::Route(PendingRequest &&pending)
+{
+  if (is_refreshing_) {
+    routing_queue_.emplace_back(std::move(pending));
+    return;
+  }
+
+  if (shard_node_map_.empty()) {
+    pending.cb(nullptr);
+    return;
+  }
+
+  const shard_id_t shard_id = pending.request.HasKey()
+                                  ? MakeShardId(pending.request.GetKey()) % shard_node_map_.size()
+                                  : 0;
+  const auto       node_id  = shard_node_map_[shard_id];
+  Node            *node     = node_id != INVALID_NODE_ID ? GetNode(node_id) : nullptr;
+
+  if (!node) {
+    LOG_ERROR << "The shard " << shard_id << " isn't owned by any node";
+    pending.cb(nullptr);
+    return;
+  }
+
+  Dispatch(node, std::move(pending));
+}
+
+void RoutingClient::Ask(PendingRequest &&pending, std::string const &endpoint)
+{
+  auto  iter = ask_nodes_.find(endpoint);
+  Node *node = nullptr;
+  if (iter != ask_nodes_.end()) {
+    node = iter->second.get();
+  } else {
+    LOG_INFO << "Connecting the node " << endpoint << " asked";
+    auto p_node = NewNode(InetAddr(endpoint));
+    node        = p_node.get();
+    ask_nodes_.emplace(endpoint, std::move(p_node));
+  }
+
+  // The requests of a connection are executed in order,
+  // thus ASKING only affects the request following it
+  PendingRequest asking;
+  asking.request.command = ASKING;
+  Dispatch(node, std::move(asking));
+  Dispatch(node, std::move(pending));
+}
+
+void RoutingClient::Dispatch(Node *node, PendingRequest &&pending)
+{
+  if (!node->conn) {
+    node->waiting.emplace_back(std::move(pending));
+    return;
+  }
+
+  node->codec.Send(node->conn, &pending.request);
+  node->inflight.emplace_back(std::move(pending));
+}
+
+auto RoutingClient::GetNode(node_id_t node_id) -> Node *
+{
+  auto iter = nodes_.find(node_id);
+  if (iter != nodes_.end()) return iter->second.get();
+
+  auto ep_iter = node_ep_map_.find(node_id);
+  if (ep_iter == node_ep_map_.end()) return nullptr;
+
+  auto const &ep = ep_iter->second;
+  LOG_INFO << "Connecting the node " << node_id << " in " << ep.host << ":" << ep.port;
+  auto p_node = NewNode(InetAddr(ep.host, ep.port));
+  auto node   = p_node.get();
+  nodes_.emplace(node_id, std::move(p_node));
+  return node;
+}
+
+auto RoutingClient::NewNode(InetAddr const &addr) -> std::unique_ptr<Node>
+{
+  // The connection is established lazily and reused by the following requests
+  std::unique_ptr<Node> node(new Node(loop_, addr));
+  auto                  p_node = node.get();
+
+  p_node->codec.SetMessageCallback([this, p_node](
+                                       TcpConnectionPtr const &,
+                                       Buffer &buffer,
+                                       uint32_t,
+                                       MmbpCodec::ChecksumAlgo,
+                                       TimeStamp
+                                   ) {
+    OnNodeMessage(p_node, buffer);
+  });
+
+  p_node->codec.SetErrorCallback([](TcpConnectionPtr const &conn, MmbpCodec::ErrorCode code) {
+    LOG_ERROR << "The response from " << conn->GetPeerAddr().ToIpPort()
+              << " is invalid: " << MmbpCodec::GetErrorString(code);
+    conn->ShutdownWrite();
+  });
+
+  p_node->cli->SetConnectionCallback([this, p_node](TcpConnectionPtr const &conn) {
+    OnNodeConnection(p_node, conn);
+  });
+
+  p_node->cli->EnableRetry();
+  p_node->cli->Connect();
+  return node;
+}
+
+void RoutingClient::OnNodeConnection(Node *node, TcpConnectionPtr const &conn)
+{
+  if (conn->IsConnected()) {
+    node->codec.SetUpConnection(conn);
+    node->conn = conn.get();
+
+    for (auto &pending : node->waiting) {
+      node->codec.Send(node->conn, &pending.request);
+      node->inflight.emplace_back(std::move(pending));
+    }
+    node->waiting.clear();
+  } else {
+    node->conn = nullptr;
+
+    // The in-flight requests may be executed or not, thus they aren't resent
+    auto inflight = std::move(node->inflight);
+    node->inflight.clear();
+    for (auto &pending : inflight)
+      if (pending.cb) pending.cb(nullptr);
+  }
+}
+
+void RoutingClient::OnNodeMessage(Node *node, Buffer &buffer)
+{
+  MmbpResponse response;
+  response.ParseFrom(buffer);
+
+  if (node->inflight.empty()) {
+    LOG_ERROR << "There is no request waiting the response";
+    return;
+  }
+
+  auto pending = std::move(node->inflight.front());
+  node->inflight.pop_front();
+  if (!pending.cb) return;
+
+  // The key is migrated, ask the node in the value
+  if (response.status_code == S_ASK && pending.redirect_num < MAX_REDIRECT_NUM) {
+    ask_num_.fetch_add(1, std::memory_order_relaxed);
+    ++pending.redirect_num;
+    Ask(std::move(pending), std::string(response.value.data(), response.value.size()));
+    return;
+  }
+
+  // The shard map is stale, route it again after refreshing
+  if (response.status_code == S_MOVED && pending.redirect_num < MAX_REDIRECT_NUM) {
+    moved_num_.fetch_add(1, std::memory_order_relaxed);
+    ++pending.redirect_num;
+    routing_queue_.emplace_back(std::move(pending));
+    RefreshShardMap();
+    return;
+  }
+
+  pending.cb(&response);
+}
+
+void RoutingClient::ReloadNodes()
+{
+  ConfigdClient::NodeEndPoint ep;
+
+  node_ep_map_.clear();
+  for (node_id_t node_idx = 0; conf_cli_.QueryNodeEndpointByNodeIdx(node_idx, &ep); ++node_idx)
+  {
+    node_ep_map_[ep.node_id] = ep;
+  }
+
+  // The node is removed, the requests waiting its connection are routed again
+  for (auto &id_node : nodes_) {
+    if (node_ep_map_.count(id_node.first)) continue;
+    auto &waiting = id_node.second->waiting;
+    for (auto &pending : waiting)
+      routing_queue_.emplace_back(std::move(pending));
+    waiting.clear();
+  }
+}
+
+void RoutingClient::ReloadShardMap()
+{
+  ConfigdClient::NodeEndPoint ep;
+  const auto                  shard_num = conf_cli_.ShardNum();
+
+  shard_node_map_.assign(shard_num, INVALID_NODE_ID);
+  for (shard_id_t shard_id = 0; shard_id < shard_num; ++shard_id) {
+    if (conf_cli_.QueryNodeEndpoint(shard_id, &ep)) {
+      shard_node_map_[shard_id] = ep.node_id;
+    }
+  }
+}
+
+void RoutingClient::OnConfigFetched(ConfigResponse const &resp)
+{
+  if (resp.status() == CONF_STATUS_OK) {
+    ReloadNodes();
+    ReloadShardMap();
+
+    LOG_INFO << "The shard map is fetched: " << node_ep_map_.size() << " nodes, "
+             << shard_node_map_.size() << " shards";
+  } else if (resp.status() == CONF_STATUS_DELTA) {
+    // Only the deltas applied by the configd client are applied,
+    // the others are applied once the lost deltas are fetched
+    const auto cur_epoch       = conf_cli_.epoch();
+    bool       is_node_changed = false;
+    for (auto const &delta : resp.deltas()) {
+      if (delta.epoch() <= epoch_ || delta.epoch() > cur_epoch) continue;
+
+      is_node_changed |= delta.added_nodes_size() > 0 || delta.removed_node_ids_size() > 0;
+      for (auto const &move : delta.moved_shards()) {
+        if (move.shard_id() >= shard_node_map_.size())
+          shard_node_map_.resize(move.shard_id() + 1, INVALID_NODE_ID);
+        shard_node_map_[move.shard_id()] = move.node_id();
+      }
+    }
+
+    if (is_node_changed) {
+      ReloadNodes();
+
+      // The owners of shards are computed by the configd client
+      if (conf_cli_.placement() == SHARD_PLACEMENT_RENDEZVOUS) ReloadShardMap();
+    }
+    LOG_DEBUG << "The shard map is updated from epoch " << epoch_ << " to " << cur_epoch;
+  } else {
+    return;
+  }
+
+  epoch_             = conf_cli_.epoch();
+  is_refreshing_     = false;
+  auto routing_queue = std::move(routing_queue_);
+  routing_queue_.clear();
+  for (auto &pending : routing_queue)
+    Route(std::move(pending));
+
+  MutexGuard guard(mutex_);
+  conf_fetched_ = true;
+  cond_.Notify();
+}
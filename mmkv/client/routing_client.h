@@ -0,0 +1,168 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_CLIENT_ROUTING_CLIENT_H_
+#define _MMKV_CLIENT_ROUTING_CLIENT_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mmkv/configd/configd_client.h"
+#include "mmkv/protocol/mmbp_codec.h"
+#include "mmkv/protocol/mmbp_request.h"
+#include "mmkv/protocol/mmbp_response.h"
+
+#include <kanon/net/user_client.h>
+#include <kanon/thread/condition.h>
+#include <kanon/thread/mutex_lock.h>
+#include <kanon/util/noncopyable.h>
+
+namespace mmkv {
+namespace client {
+
+/**
+ * \brief Route the requests to the nodes owning the shards of keys directly
+ * The shard map is fetched from configd and cached, then the request is sent
+ * to the node owning the shard(i.e. MakeShardId(key) % shard_num) without
+ * the proxy hop.
+ *
+ * Each node has a connection which is established in the first time it is
+ * routed to and reused by the following requests. The requests are pipelined,
+ * i.e. sent without waiting the responses of the previous requests, and the
+ * responses of a connection are received in order.
+ *
+ * The client watches the configd, i.e. only the changes of shard map are
+ * pushed and applied. If the node doesn't own the shard(e.g. the shard is
+ * migrated and the change isn't received), it replies S_MOVED, then the
+ * shard map is fetched again and the request is routed again(at most
+ * MAX_REDIRECT_NUM times).
+ *
+ * If the shard is migrating key by key, the node replies S_ASK with the
+ * endpoint of the destination for the keys moved, then ASKING and the request
+ * are sent to the destination without refreshing the shard map.
+ *
+ * \note
+ *  The requests without key are routed to the node owning shard 0.
+ *  The callbacks are called in the loop thread.
+ */
+class RoutingClient {
+  DISABLE_EVIL_COPYABLE(RoutingClient)
+
+ public:
+  /**
+   * \param response nullptr if the request can't be routed or the connection is broken
+   */
+  using ResponseCallback = std::function<void(protocol::MmbpResponse *response)>;
+
+  enum : int {
+    MAX_REDIRECT_NUM = 3,
+  };
+
+  RoutingClient(kanon::EventLoop *loop, kanon::InetAddr const &configd_addr);
+  ~RoutingClient() noexcept;
+
+  /**
+   * \brief Connect to configd and wait until the shard map is fetched
+   * \return false if the configd is disconnected
+   * \warning Don't call this in the loop thread
+   */
+  bool Start();
+
+  /**
+   * \brief Disconnect the configd and all nodes
+   */
+  void Stop();
+
+  /**
+   * \brief Send the request and call \p cb when the response is received
+   * \note Thread-safe
+   */
+  void Send(protocol::MmbpRequest request, ResponseCallback cb);
+
+  /**
+   * \brief Send the request and wait the response
+   * \return false if the request can't be routed or the connection is broken
+   * \warning Don't call this in the loop thread
+   */
+  bool Execute(protocol::MmbpRequest request, protocol::MmbpResponse &response);
+
+  /**
+   * \brief Fetch the changes of shard map from configd
+   * The requests routed before the shard map is fetched wait it.
+   */
+  void RefreshShardMap();
+
+  /** The number of S_MOVED replied by nodes */
+  uint64_t moved_num() const noexcept { return moved_num_.load(std::memory_order_relaxed); }
+
+  /** The number of S_ASK replied by nodes */
+  uint64_t ask_num() const noexcept { return ask_num_.load(std::memory_order_relaxed); }
+
+ private:
+  struct PendingRequest {
+    protocol::MmbpRequest request;
+    ResponseCallback      cb; /** Empty if the response is dropped(e.g. ASKING) */
+    int                   redirect_num = 0;
+  };
+
+  struct Node {
+    Node(kanon::EventLoop *loop, kanon::InetAddr const &addr);
+
+    kanon::TcpClientPtr        cli;
+    kanon::TcpConnection      *conn = nullptr;
+    protocol::MmbpCodec        codec;
+    std::deque<PendingRequest> inflight; /** Sent, wait the responses in order */
+    std::deque<PendingRequest> waiting;  /** Wait the connection established */
+  };
+
+  void Route(PendingRequest &&pending);
+
+  /* Send ASKING and the request to the node migrating the key to */
+  void Ask(PendingRequest &&pending, std::string const &endpoint);
+
+  /* Send the request or wait the connection established */
+  void Dispatch(Node *node, PendingRequest &&pending);
+
+  std::unique_ptr<Node> NewNode(kanon::InetAddr const &addr);
+  Node                 *GetNode(node_id_t node_id);
+
+  void OnNodeConnection(Node *node, kanon::TcpConnectionPtr const &conn);
+  void OnNodeMessage(Node *node, kanon::Buffer &buffer);
+  void ReloadNodes();
+  void ReloadShardMap();
+  void OnConfigFetched(ConfigResponse const &resp);
+
+  kanon::EventLoop *loop_;
+  ConfigdClient     conf_cli_;
+
+  // Indexed by shard id, updated in the loop thread
+  std::vector<node_id_t>                                     shard_node_map_;
+  std::unordered_map<node_id_t, ConfigdClient::NodeEndPoint> node_ep_map_;
+  std::unordered_map<node_id_t, std::unique_ptr<Node>>       nodes_;
+  uint64_t                                                   epoch_ = 0;
+
+  // The nodes asked by S_ASK, indexed by endpoint(host:port).
+  // The destination may not be in the shard map yet, e.g. a joining node.
+  std::unordered_map<std::string, std::unique_ptr<Node>> ask_nodes_;
+
+  // The requests wait the shard map fetched,
+  // the first shard map is fetched once the configd is connected
+  bool                       is_refreshing_ = true;
+  std::deque<PendingRequest> routing_queue_;
+  std::atomic<uint64_t>      moved_num_;
+  std::atomic<uint64_t>      ask_num_;
+
+  // Start() waits the first shard map
+  kanon::MutexLock mutex_;
+  kanon::Condition cond_;
+  bool             conf_fetched_ = false;
+  bool             closed_       = false;
+};
+
+} // namespace client
+} // namespace mmkv
+
+#endif // _MMKV_CLIENT_ROUTING_CLIENT_H_
@@ -31,6 +31,32 @@ using namespace std;
     }                                                                          \
   } while (0)
 
+/* Split the leading script from the statement,
+ * the script must be quoted by " or ' since it contains spaces in general,
+ * the hash of EVALSHA is not required to be quoted.
+ * The statement is set to the remaining part. */
+static bool SplitScript(StringView &statement, StringView &script)
+{
+  while (!statement.empty() && statement[0] == ' ')
+    statement.remove_prefix(1);
+  if (statement.empty()) return false;
+
+  const char quote = statement[0];
+  if (quote != '"' && quote != '\'') {
+    auto end = statement.find(' ');
+    if (end == StringView::npos) end = statement.size();
+    script = statement.substr(0, end);
+    statement.remove_prefix(end);
+    return true;
+  }
+
+  auto end = statement.find(quote, 1);
+  if (end == StringView::npos) return false;
+  script = statement.substr(1, end - 1);
+  statement.remove_prefix(end + 1);
+  return true;
+}
+
 #define TO_MMKV_STRING(token) mmkv::algo::String((token).data(), (token).size())
 
 #define SET_KEY                                                                \
@@ -119,6 +145,15 @@ Translator::ErrorCode Translator::Parse(MmbpRequest *request, Command cmd,
 
   switch (GetCommandFormat(cmd)) {
     case F_NONE: {
+      // info [section]
+      if (cmd == INFO && token_iter != tokenizer.end()) SET_VALUE;
+      // slowlog [count]
+      if (cmd == SLOWLOG && token_iter != tokenizer.end()) {
+        uint32_t count;
+        SET_INTEGER(count, "ERROR: count is invalid");
+        request->SetCount();
+        request->count = count;
+      }
       if (token_iter != tokenizer.end()) {
         return E_SYNTAX_ERROR;
       }
@@ -132,6 +167,16 @@ Translator::ErrorCode Translator::Parse(MmbpRequest *request, Command cmd,
       SET_KEY;
       SYNTAX_ERROR_ROUTINE_END;
     } break;
+    case F_OPT_COUNT: {
+      SET_KEY;
+      if (token_iter != tokenizer.end()) {
+        uint32_t count;
+        SET_INTEGER(count, "ERROR: count is invalid");
+        request->SetCount();
+        request->count = count;
+      }
+      SYNTAX_ERROR_ROUTINE_END;
+    } break;
     case F_VALUES: {
       SET_KEY;
       SET_VALUES;
@@ -226,6 +271,42 @@ Translator::ErrorCode Translator::Parse(MmbpRequest *request, Command cmd,
     case F_MUL_KEYS: {
       SET_VALUES;
     } break;
+    case F_SCAN: {
+      // The cursor and count are carried by the range
+      if (cmd != SCAN) SET_KEY;
+      SET_INTEGER(request->range.left, "ERROR: cursor is invalid");
+      request->range.right = 0;
+      if (token_iter != tokenizer.end()) {
+        SET_INTEGER(request->range.right, "ERROR: count is invalid");
+      }
+      request->SetRange();
+      SYNTAX_ERROR_ROUTINE_END;
+    } break;
+    case F_SCRIPT: {
+      StringView script;
+      if (!SplitScript(statement, script)) return E_SYNTAX_ERROR;
+      request->SetValue();
+      request->value = TO_MMKV_STRING(script);
+      Tokenizer tokenizer(statement);
+      auto      token_iter = tokenizer.begin();
+      if (cmd == SCRIPT_LOAD) {
+        SYNTAX_ERROR_ROUTINE_END;
+        break;
+      }
+
+      // numkeys keys... args...
+      uint32_t  key_num;
+      SET_INTEGER(key_num, "ERROR: numkeys is invalid");
+      request->SetCount();
+      request->count = key_num;
+      request->SetValues();
+      for (; token_iter != tokenizer.end(); ++token_iter)
+        request->values.push_back(TO_MMKV_STRING(*token_iter));
+      if (key_num > request->values.size()) {
+        ErrorPrintf("ERROR: numkeys is greater than the number of arguments");
+        return E_SYNTAX_ERROR;
+      }
+    } break;
     case F_INVALID:
     default:
       assert(false && "This must be a valid command");
@@ -0,0 +1,122 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "config_delta.h"
+
+#include <unordered_map>
+
+#include "mmkv/tracker/type.h"
+
+using namespace mmkv;
+
+static inline bool IsSameEndpoint(NodeConf const &x, NodeConf const &y) noexcept
+{
+  return x.host() == y.host() && x.port() == y.port() && x.mmkvd_port() == y.mmkvd_port() &&
+         x.weight() == y.weight();
+}
+
+void mmkv::MakeConfigDelta(
+    Configuration const &old_conf,
+    Configuration const &new_conf,
+    ConfigDelta         *p_delta
+)
+{
+  auto const &old_node_conf_map = old_conf.node_conf_map();
+  auto const &new_node_conf_map = new_conf.node_conf_map();
+
+  std::unordered_map<uint64_t, uint64_t> old_shard_node_map;
+  for (auto const &id_node_conf : old_node_conf_map) {
+    for (auto const shard_id : id_node_conf.second.shard_ids())
+      old_shard_node_map[shard_id] = id_node_conf.first;
+  }
+
+  for (auto const &id_node_conf : new_node_conf_map) {
+    auto const  node_id   = id_node_conf.first;
+    auto const &node_conf = id_node_conf.second;
+
+    auto old_iter = old_node_conf_map.find(node_id);
+    if (old_iter == old_node_conf_map.end() || !IsSameEndpoint(old_iter->second, node_conf)) {
+      auto &added_node = (*p_delta->mutable_added_nodes())[node_id];
+      added_node.set_host(node_conf.host());
+      if (node_conf.has_port()) added_node.set_port(node_conf.port());
+      if (node_conf.has_mmkvd_port()) added_node.set_mmkvd_port(node_conf.mmkvd_port());
+      if (node_conf.has_weight()) added_node.set_weight(node_conf.weight());
+    }
+
+    for (auto const shard_id : node_conf.shard_ids()) {
+      auto shard_iter = old_shard_node_map.find(shard_id);
+      if (shard_iter != old_shard_node_map.end()) {
+        const bool is_moved = shard_iter->second != node_id;
+        old_shard_node_map.erase(shard_iter);
+        if (!is_moved) continue;
+      }
+
+      auto p_move = p_delta->add_moved_shards();
+      p_move->set_shard_id(shard_id);
+      p_move->set_node_id(node_id);
+    }
+  }
+
+  // The remaining shards aren't owned by any node
+  for (auto const &shard_node : old_shard_node_map) {
+    auto p_move = p_delta->add_moved_shards();
+    p_move->set_shard_id(shard_node.first);
+    p_move->set_node_id(INVALID_NODE_ID);
+  }
+
+  for (auto const &id_node_conf : old_node_conf_map) {
+    if (new_node_conf_map.find(id_node_conf.first) == new_node_conf_map.end()) {
+      p_delta->add_removed_node_ids(id_node_conf.first);
+    }
+  }
+}
+
+void mmkv::ApplyConfigDelta(ConfigDelta const &delta, Configuration *p_conf)
+{
+  auto &node_conf_map = *p_conf->mutable_node_conf_map();
+
+  for (auto const &id_node_conf : delta.added_nodes()) {
+    // The shards of the node whose endpoint is changed are kept
+    auto       &node_conf  = node_conf_map[id_node_conf.first];
+    auto const &added_node = id_node_conf.second;
+    node_conf.set_host(added_node.host());
+    if (added_node.has_port()) node_conf.set_port(added_node.port());
+    if (added_node.has_mmkvd_port()) node_conf.set_mmkvd_port(added_node.mmkvd_port());
+    if (added_node.has_weight()) node_conf.set_weight(added_node.weight());
+  }
+
+  if (delta.moved_shards_size() > 0) {
+    // Locate the shards in the old owners
+    std::unordered_map<uint64_t, std::pair<NodeConf *, int>> shard_pos_map;
+    for (auto &id_node_conf : node_conf_map) {
+      auto &shard_ids = *id_node_conf.second.mutable_shard_ids();
+      for (int i = 0; i < shard_ids.size(); ++i)
+        shard_pos_map[shard_ids.Get(i)] = std::make_pair(&id_node_conf.second, i);
+    }
+
+    for (auto const &move : delta.moved_shards()) {
+      auto pos_iter = shard_pos_map.find(move.shard_id());
+      if (pos_iter != shard_pos_map.end()) {
+        // Remove the shard id by replacing it with the last one
+        auto &shard_ids = *pos_iter->second.first->mutable_shard_ids();
+        auto  idx       = pos_iter->second.second;
+        auto  last_id   = shard_ids.Get(shard_ids.size() - 1);
+        shard_ids.Set(idx, last_id);
+        shard_ids.RemoveLast();
+        shard_pos_map[last_id].second = idx;
+        shard_pos_map.erase(pos_iter);
+      }
+
+      if (move.node_id() == INVALID_NODE_ID) continue;
+      auto node_iter = node_conf_map.find(move.node_id());
+      if (node_iter == node_conf_map.end()) continue;
+
+      auto &shard_ids = *node_iter->second.mutable_shard_ids();
+      shard_pos_map[move.shard_id()] = std::make_pair(&node_iter->second, shard_ids.size());
+      shard_ids.Add(move.shard_id());
+    }
+  }
+
+  for (auto const node_id : delta.removed_node_ids())
+    node_conf_map.erase(node_id);
+
+  p_conf->set_epoch(delta.epoch());
+}
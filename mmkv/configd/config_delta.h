@@ -0,0 +1,30 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_CONFIGD_CONFIG_DELTA_H__
+#define _MMKV_CONFIGD_CONFIG_DELTA_H__
+
+#include "configd.pb.h"
+#include "configuration.pb.h"
+
+namespace mmkv {
+
+/**
+ * \brief Make the delta which transforms \p old_conf to \p new_conf
+ * The nodes added(or whose endpoint is changed) and removed and the shards
+ * whose owner is changed are recorded.
+ * \note The epoch of \p p_delta isn't set
+ */
+void MakeConfigDelta(
+    Configuration const &old_conf,
+    Configuration const &new_conf,
+    ConfigDelta         *p_delta
+);
+
+/**
+ * \brief Apply the \p delta to \p p_conf
+ * The epoch of \p p_conf is set to the epoch of \p delta.
+ */
+void ApplyConfigDelta(ConfigDelta const &delta, Configuration *p_conf);
+
+} // namespace mmkv
+
+#endif
@@ -1,6 +1,9 @@
 // SPDX-LICENSE-IDENTIFIER: Apache-2.0
 #include "configd.h"
 
+#include <algorithm>
+
+#include "config_delta.h"
 #include "configd.pb.h"
 
 using namespace mmkv::server;
@@ -14,6 +17,9 @@ Configd::Configd(EventLoop *loop, InetAddr const &addr, InetAddr const &ctler_ad
   ctler_.Listen();
   ctler_.p_configd_ = this;
 
+  conf_.set_placement(ctler_.GetPlacement());
+  conf_.set_shard_num(ctler_.GetShardNum());
+
   codec_.SetMessageCallback(
       [this](TcpConnectionPtr const &conn, Buffer &buffer, size_t payload_size, TimeStamp) {
         ConfigRequest req;
@@ -22,10 +28,13 @@ Configd::Configd(EventLoop *loop, InetAddr const &addr, InetAddr const &ctler_ad
         ConfigResponse resp;
         switch (req.operation()) {
           case CONF_OP_FETCH: {
-            MutexGuard guard(ctler_.pending_conf_lock_);
-            auto      *p_conf = ctler_.GetCurrentConf();
+            MutexGuard guard(conf_lock_);
             resp.set_status(CONF_STATUS_OK);
-            *resp.mutable_conf()->mutable_node_conf_map() = p_conf->node_conf_map();
+            *resp.mutable_conf() = conf_;
+          } break;
+          case CONF_OP_WATCH: {
+            Watch(conn, req.epoch());
+            return;
           } break;
           default: {
             resp.set_status(CONF_INVALID_REQ);
@@ -40,6 +49,9 @@ Configd::Configd(EventLoop *loop, InetAddr const &addr, InetAddr const &ctler_ad
     if (conn->IsConnected()) {
       codec_.SetUpConnection(conn);
     } else {
+      MutexGuard guard(conf_lock_);
+      auto       iter = std::find(watchers_.begin(), watchers_.end(), conn);
+      if (iter != watchers_.end()) watchers_.erase(iter);
     }
   });
 
@@ -48,17 +60,82 @@ Configd::Configd(EventLoop *loop, InetAddr const &addr, InetAddr const &ctler_ad
 
 Configd::~Configd() noexcept { LOG_INFO << "ConfigServer is removed"; }
 
+void Configd::Watch(TcpConnectionPtr const &conn, uint64_t epoch)
+{
+  ConfigResponse resp;
+
+  MutexGuard guard(conf_lock_);
+  const auto cur_epoch = conf_.epoch();
+
+  // The deltas after the epoch are kept, i.e. the watcher can catch up incrementally
+  if (epoch != 0 && epoch <= cur_epoch &&
+      (epoch == cur_epoch || (!deltas_.empty() && deltas_.front().epoch() <= epoch + 1)))
+  {
+    resp.set_status(CONF_STATUS_DELTA);
+    for (auto const &delta : deltas_) {
+      if (delta.epoch() > epoch) *resp.add_deltas() = delta;
+    }
+  } else {
+    resp.set_status(CONF_STATUS_OK);
+    *resp.mutable_conf() = conf_;
+  }
+
+  if (!IsWatcher(conn.get())) {
+    LOG_INFO << "The client " << conn->GetPeerAddr().ToIpPort() << " watches from epoch "
+             << epoch << ", current epoch is " << cur_epoch;
+    watchers_.push_back(conn);
+  }
+
+  codec_.Send(conn, &resp);
+}
+
+bool Configd::IsWatcher(TcpConnection const *conn) const noexcept
+{
+  for (auto const &watcher : watchers_) {
+    if (watcher.get() == conn) return true;
+  }
+  return false;
+}
+
 void Configd::SyncConfig(Configuration const &conf)
 {
-  auto conf_copy = conf.node_conf_map();
+  MutexGuard guard(conf_lock_);
+
+  Configuration new_conf;
+  *new_conf.mutable_node_conf_map() = conf.node_conf_map();
+  new_conf.set_placement(conf_.placement());
+  new_conf.set_shard_num(conf_.shard_num());
+
+  // The shards are computed from the node ids by the clients
+  if (new_conf.placement() == SHARD_PLACEMENT_RENDEZVOUS) {
+    for (auto &id_node_conf : *new_conf.mutable_node_conf_map())
+      id_node_conf.second.clear_shard_ids();
+  }
+
+  ConfigDelta delta;
+  MakeConfigDelta(conf_, new_conf, &delta);
+  delta.set_epoch(conf_.epoch() + 1);
+
+  new_conf.set_epoch(delta.epoch());
+  conf_.Swap(&new_conf);
+  LOG_INFO << "The configuration is updated to epoch " << delta.epoch() << ": "
+           << delta.added_nodes_size() << " nodes added, " << delta.removed_node_ids_size()
+           << " nodes removed, " << delta.moved_shards_size() << " shards moved";
+
+  deltas_.push_back(delta);
+  if (deltas_.size() > CONF_DELTA_HISTORY_NUM) deltas_.pop_front();
 
   ConfigResponse resp;
+  resp.set_status(CONF_STATUS_DELTA);
+  resp.add_deltas()->Swap(&delta);
+  for (auto const &watcher : watchers_)
+    codec_.Send(watcher, &resp);
 
+  // The clients don't watch are pushed the whole configuration
+  resp.Clear();
   resp.set_status(CONF_STATUS_OK);
-
-  server_.ApplyAllPeers([this, &resp, &conf_copy](TcpConnectionPtr const &conn) {
-    resp.mutable_conf()->mutable_node_conf_map()->swap(conf_copy);
-    codec_.Send(conn, &resp);
-    conf_copy.swap(*resp.mutable_conf()->mutable_node_conf_map());
+  *resp.mutable_conf() = conf_;
+  server_.ApplyAllPeers([this, &resp](TcpConnectionPtr const &conn) {
+    if (!IsWatcher(conn.get())) codec_.Send(conn, &resp);
   });
 }
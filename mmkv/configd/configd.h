@@ -2,22 +2,41 @@
 #ifndef MMKV_CONFIGD_SERVER_H_
 #define MMKV_CONFIGD_SERVER_H_
 
+#include <deque>
+#include <vector>
+
 #include <kanon/util/noncopyable.h>
 #include <kanon/net/user_server.h>
 
 #include "mmkv/tracker/shard_controller_server.h"
 #include "configd_codec.h"
+#include "configd.pb.h"
 
 namespace mmkv {
 namespace server {
 
 /**
+ * \brief Publish the configuration of the cluster to the clients
+ * The configuration is versioned by the epoch which is increased once
+ * the shard controller changes it, and the delta of each epoch is kept.
+ *
+ * CONF_OP_FETCH replies the whole configuration.
+ * CONF_OP_WATCH replies the deltas after the epoch of the watcher(or the
+ * whole configuration if the deltas are discarded), then the following
+ * deltas are pushed to the watcher only.
  *
+ * If the shards are placed by rendezvous hashing, the configuration only
+ * contains the nodes and the clients compute the owner of shard.
  */
 class Configd : kanon::noncopyable {
   friend class ShardControllerServer;
 
  public:
+  enum : size_t {
+    /** The number of recent deltas kept for the watchers lagging behind */
+    CONF_DELTA_HISTORY_NUM = 128,
+  };
+
   Configd(EventLoop *loop, InetAddr const &addr, InetAddr const &clter_addr);
   ~Configd() noexcept;
 
@@ -26,9 +45,19 @@ class Configd : kanon::noncopyable {
  private:
   void SyncConfig(Configuration const &config);
 
+  void Watch(TcpConnectionPtr const &conn, uint64_t epoch);
+  bool IsWatcher(TcpConnection const *conn) const noexcept;
+
   TcpServer    server_;
   ConfigdCodec codec_;
 
+  // The published configuration and deltas, updated in the controller thread.
+  // The response and pushed deltas are sent in the lock to keep them in order.
+  mutable kanon::MutexLock      conf_lock_;
+  Configuration                 conf_;
+  std::deque<ConfigDelta>       deltas_;
+  std::vector<TcpConnectionPtr> watchers_;
+
   EventLoopThread       ctler_loop_thr_;
   ShardControllerServer ctler_;
 };
@@ -1,6 +1,9 @@
 // SPDX-LICENSE-IDENTIFIER: Apache-2.0
 #include "configd_client.h"
 
+#include <unordered_map>
+
+#include "mmkv/configd/config_delta.h"
 #include "mmkv/util/shard_util.h"
 #include "mmkv/util/macro.h"
 #include "configd.pb.h"
@@ -14,6 +17,7 @@ ConfigdClient::ConfigdClient() {}
 ConfigdClient::ConfigdClient(EventLoop *p_loop, InetAddr const &addr)
   : codec_()
   , cli_(kanon::NewTcpClient(p_loop, addr, "Configd Client"))
+  , conn_(nullptr)
 {
   LOG_DEBUG << "Configd Client is created";
 }
@@ -34,6 +38,21 @@ void ConfigdClient::FetchConfig()
   });
 }
 
+void ConfigdClient::Watch()
+{
+  cli_->GetLoop()->RunInLoop([this]() {
+    ConfigRequest req;
+    req.set_operation(CONF_OP_WATCH);
+    req.set_epoch(epoch());
+
+    if (conn_) {
+      codec_.Send(conn_, &req);
+    } else {
+      LOG_DEBUG << "The connectin isn't established, can't watch config!";
+    }
+  });
+}
+
 bool ConfigdClient::QueryNodeEndpoint(shard_id_t shard_id, NodeEndPoint *p_ep)
 {
   LOG_INFO << "query shard_id = " << shard_id;
@@ -79,42 +98,28 @@ void ConfigdClient::OnMessage(
   ConfigResponse resp;
   protobuf::ParseFromBuffer(&resp, payload_size, &buffer);
 
-  LOG_INFO << "ConfigResponse: " << resp.DebugString();
+  LOG_DEBUG << "ConfigResponse: " << resp.DebugString();
   switch (resp.status()) {
     case CONF_STATUS_OK: {
-      auto                                       &conf            = *resp.mutable_conf();
-      auto                                       &node_conf_map   = conf.node_conf_map();
-      decltype(shard_node_idx_dict_)::value_type *p_dep_key_value = nullptr;
-
       MutexGuard guard(conf_lock_);
-      LOG_DEBUG << "Node num = " << node_conf_map.size();
-
-      node_idx_node_ep_map_.clear();
-      node_idx_node_ep_map_.reserve(node_conf_map.size());
-
-      for (auto const &id_node_conf : node_conf_map) {
-        auto const  node_id   = id_node_conf.first;
-        auto const &node_conf = id_node_conf.second;
-        auto const &shard_ids = node_conf.shard_ids();
-
-        LOG_INFO << "peer = (" << node_conf.host() << ":" << node_conf.mmkvd_port() << ")";
-        NodeEndPoint node_end_point{node_id, node_conf.host(), (uint16_t)node_conf.mmkvd_port()};
-        node_idx_node_ep_map_.emplace_back(std::move(node_end_point));
-
-        auto shard_node_idx = node_idx_node_ep_map_.size() - 1;
-        for (auto const shard_id : shard_ids) {
-          auto ok = shard_node_idx_dict_.InsertKvWithDuplicate(
-              (shard_id_t)shard_id,
-              shard_node_idx,
-              p_dep_key_value
-          );
-
-          if (!ok) {
-            p_dep_key_value->value = shard_node_idx;
-          }
+      conf_ = resp.conf();
+      LOG_DEBUG << "Node num = " << conf_.node_conf_map_size();
+      RebuildIndex();
+    } break;
+
+    case CONF_STATUS_DELTA: {
+      bool is_applied = true;
+      {
+        MutexGuard guard(conf_lock_);
+        for (auto const &delta : resp.deltas()) {
+          if (!(is_applied = ApplyDelta(delta))) break;
         }
+      }
 
-        node_conf_map_ = std::move(node_conf_map);
+      // The deltas are lost(It is unexpected), catch up again
+      if (!is_applied) {
+        LOG_WARN << "The deltas of configuration are not continuous, watch again";
+        Watch();
       }
     } break;
 
@@ -129,6 +134,80 @@ void ConfigdClient::OnMessage(
   }
 }
 
+void ConfigdClient::RebuildIndex()
+{
+  auto const &node_conf_map = conf_.node_conf_map();
+
+  shard_node_idx_dict_.Clear();
+  node_idx_node_ep_map_.clear();
+  node_idx_node_ep_map_.reserve(node_conf_map.size());
+
+  for (auto const &id_node_conf : node_conf_map) {
+    auto const  node_id   = id_node_conf.first;
+    auto const &node_conf = id_node_conf.second;
+
+    LOG_INFO << "peer = (" << node_conf.host() << ":" << node_conf.mmkvd_port() << ")";
+    NodeEndPoint node_end_point{node_id, node_conf.host(), (uint16_t)node_conf.mmkvd_port()};
+    node_idx_node_ep_map_.emplace_back(std::move(node_end_point));
+
+    const node_id_t shard_node_idx = node_idx_node_ep_map_.size() - 1;
+    for (auto const shard_id : node_conf.shard_ids())
+      shard_node_idx_dict_[(shard_id_t)shard_id] = shard_node_idx;
+  }
+
+  // The shards aren't contained, compute the owners from the node ids
+  if (conf_.placement() == SHARD_PLACEMENT_RENDEZVOUS) {
+    std::vector<node_id_t>                   node_ids;
+    std::unordered_map<node_id_t, node_id_t> node_idx_map;
+    for (node_id_t node_idx = 0; node_idx < node_idx_node_ep_map_.size(); ++node_idx) {
+      node_ids.push_back(node_idx_node_ep_map_[node_idx].node_id);
+      node_idx_map[node_ids.back()] = node_idx;
+    }
+
+    if (node_ids.empty()) return;
+    auto get_weight = [&node_conf_map](node_id_t node_id) {
+      return node_conf_map.at(node_id).weight();
+    };
+    for (shard_id_t shard_id = 0; shard_id < conf_.shard_num(); ++shard_id) {
+      shard_node_idx_dict_[shard_id] =
+          node_idx_map[SelectRendezvousNode(shard_id, node_ids, get_weight)];
+    }
+  }
+}
+
+bool ConfigdClient::ApplyDelta(ConfigDelta const &delta)
+{
+  const auto epoch = conf_.epoch();
+  if (delta.epoch() <= epoch) return true;
+  if (delta.epoch() != epoch + 1) return false;
+
+  ApplyConfigDelta(delta, &conf_);
+
+  // The node index is changed, the shard map is rebuilt.
+  // Otherwise, only the moved shards are updated.
+  if (delta.added_nodes_size() > 0 || delta.removed_node_ids_size() > 0) {
+    RebuildIndex();
+    return true;
+  }
+
+  for (auto const &move : delta.moved_shards()) {
+    const shard_id_t shard_id = move.shard_id();
+    if (move.node_id() == INVALID_NODE_ID) {
+      shard_node_idx_dict_.Erase(shard_id);
+      continue;
+    }
+
+    for (node_id_t node_idx = 0; node_idx < node_idx_node_ep_map_.size(); ++node_idx) {
+      if (node_idx_node_ep_map_[node_idx].node_id == move.node_id()) {
+        shard_node_idx_dict_[shard_id] = node_idx;
+        break;
+      }
+    }
+  }
+
+  return true;
+}
+
 void ConfigdClient::OnConnection(TcpConnectionPtr const &conn)
 {
   if (conn->IsConnected()) {
@@ -158,8 +237,9 @@ MMKV_INLINE static void AppendShardInterval(
 
 void ConfigdClient::PrintNodeConfiguration()
 {
-  node_id_t node_idx = 0;
-  for (auto &node_id_node_conf : node_conf_map_) {
+  MutexGuard guard(conf_lock_);
+  node_id_t  node_idx = 0;
+  for (auto &node_id_node_conf : *conf_.mutable_node_conf_map()) {
     // auto  node_id   = node_id_node_conf.first;
     auto &node_conf = node_id_node_conf.second;
     auto &shard_ids = *node_conf.mutable_shard_ids();
@@ -33,6 +33,13 @@ class ConfigdClient {
 
   void FetchConfig();
 
+  /**
+   * \brief Fetch the deltas after the epoch of the held configuration
+   * and subscribe the following deltas from configd
+   * The whole configuration is fetched if this has no configuration.
+   */
+  void Watch();
+
   bool QueryNodeEndpoint(shard_id_t shard_id, NodeEndPoint *p_ep);
   bool QueryNodeEndpointByNodeIdx(node_id_t node_idx, NodeEndPoint *p_ep);
 
@@ -46,6 +53,18 @@ class ConfigdClient {
 
   shard_id_t ShardNum() { return shard_node_idx_dict_.size(); }
 
+  ShardPlacement placement() const noexcept
+  {
+    kanon::MutexGuard guard(conf_lock_);
+    return conf_.placement();
+  }
+
+  uint64_t epoch() const noexcept
+  {
+    kanon::MutexGuard guard(conf_lock_);
+    return conf_.epoch();
+  }
+
   void PrintNodeConfiguration();
   void PrintShardMap();
 
@@ -56,10 +75,16 @@ class ConfigdClient {
  private:
   TcpConnection *conn_;
 
-  kanon::MutexLock conf_lock_;
+  /* Rebuild the shard map and node index from conf_ */
+  void RebuildIndex();
+
+  /* \return false if the delta isn't the next epoch */
+  bool ApplyDelta(ConfigDelta const &delta);
+
+  mutable kanon::MutexLock conf_lock_;
 
-  // Used for print shard distribution
-  ::google::protobuf::Map<uint64_t, ::mmkv::NodeConf> node_conf_map_;
+  // The source of the shard map, also used for printing shard distribution
+  Configuration conf_;
 
   algo::AvlDictionary<shard_id_t, node_id_t, algo::Comparator<shard_id_t>> shard_node_idx_dict_;
 
@@ -14,6 +14,11 @@ ConfigdConfig::ConfigdConfig()
 {
   shard_controller_endpoint = "*:19997";
   shard_num                 = 4096;
+  shard_placement           = "assigned";
+  rebalance_threshold       = 0;
+  rebalance_interval        = 60000;
+  rebalance_max_shard_num   = 8;
+  rebalance_max_bytes       = 256 << 20;
 }
 
 ConfigdConfig &configd_config() noexcept
@@ -37,6 +42,11 @@ bool ParseConfigdConfig(char const *filename)
 
   env.GetGlobal("ShardControllerEndpoint", config.shard_controller_endpoint);
   env.GetGlobal("ShardNum", config.shard_num);
+  env.GetGlobal("ShardPlacement", config.shard_placement);
+  env.GetGlobal("RebalanceThreshold", config.rebalance_threshold);
+  env.GetGlobal("RebalanceInterval", config.rebalance_interval);
+  env.GetGlobal("RebalanceMaxShardNum", config.rebalance_max_shard_num);
+  env.GetGlobal("RebalanceMaxBytes", config.rebalance_max_bytes);
 
   return true;
 }
@@ -46,6 +56,11 @@ void DebugPrintConfigdConfig()
   auto const &config = configd_config();
   LOG_DEBUG << "ShardControllerEndpoint = " << config.shard_controller_endpoint;
   LOG_DEBUG << "ShardNum = " << config.shard_num;
+  LOG_DEBUG << "ShardPlacement = " << config.shard_placement;
+  LOG_DEBUG << "RebalanceThreshold = " << config.rebalance_threshold;
+  LOG_DEBUG << "RebalanceInterval = " << config.rebalance_interval;
+  LOG_DEBUG << "RebalanceMaxShardNum = " << config.rebalance_max_shard_num;
+  LOG_DEBUG << "RebalanceMaxBytes = " << config.rebalance_max_bytes;
 }
 
 } // namespace server
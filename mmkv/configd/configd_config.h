@@ -11,6 +11,13 @@ namespace server {
 struct ConfigdConfig {
   std::string shard_controller_endpoint;
   u64         shard_num;
+  std::string shard_placement; /** "assigned" or "rendezvous" */
+
+  /* The shards are rebalanced by the load reported by the nodes */
+  u64 rebalance_threshold;     /** The imbalance(%) of the mean load to rebalance, 0 to disable */
+  u64 rebalance_interval;      /** ms, the interval between two rebalancings at least */
+  u64 rebalance_max_shard_num; /** The max number of shards moved by a rebalancing */
+  u64 rebalance_max_bytes;     /** The max bytes of shards moved by a rebalancing */
 
   ConfigdConfig();
 };
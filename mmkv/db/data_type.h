@@ -13,6 +13,7 @@ enum DataType : uint8_t {
   D_SORTED_SET,
   D_MAP,
   D_SET,
+  D_TYPE_NUM, /** The number of data types, not a valid type */
 };
 
 char const* GetDataTypeString(DataType type) noexcept;
@@ -15,6 +15,7 @@
  */
 #include "kvdb.h"
 #include "mmkv/db/data_type.h"
+#include "mmkv/db/memory_usage.h"
 #include "mmkv/db/mmkv_data.h"
 #include "mmkv/db/vset.h"
 #include "mmkv/protocol/command.h"
@@ -25,7 +26,6 @@
 #include "mmkv/server/config.h"
 #include "mmkv/util/time_util.h"
 
-#include "mmkv/disk/request_log.h"
 
 #include "mmkv/replacement/lru_cache.h"
 #include "mmkv/replacement/mru_cache.h"
@@ -34,18 +34,44 @@
 
 #include <kanon/log/logger.h>
 
+#include <random>
+
 using namespace mmkv::db;
 using namespace mmkv::protocol;
-using namespace mmkv::disk;
 using namespace mmkv::server;
 using namespace mmkv::replacement;
 using namespace mmkv::util;
 using namespace kanon;
 
+static KeyDropCallback g_key_drop_callback;
+
+void mmkv::db::SetKeyDropCallback(KeyDropCallback cb) { g_key_drop_callback = std::move(cb); }
+
+/* Set by LazyExpirationPause */
+static thread_local bool t_is_expiration_paused = false;
+
+LazyExpirationPause::LazyExpirationPause() noexcept
+  : is_paused_(t_is_expiration_paused)
+{
+  t_is_expiration_paused = true;
+}
+
+LazyExpirationPause::~LazyExpirationPause() noexcept { t_is_expiration_paused = is_paused_; }
+
+static inline void DropKey(String key, KeyDropReason reason)
+{
+  if (g_key_drop_callback) g_key_drop_callback(std::move(key), reason);
+}
+
+static inline mmkv::shard_id_t GetShardId(StringView key) noexcept
+{
+  return mmkv::MakeShardId(key) % mmkv_config().shard_num;
+}
+
 #define CHECK_SHARD_IS_LOCKED_KEY(key_)                                                            \
   do {                                                                                             \
     if (mmkv_config().IsSharder()) {                                                               \
-      auto shard_id = MakeShardId(key_) % mmkv_config().shard_num;                                 \
+      auto shard_id = GetShardId(key_);                                                            \
       LOG_INFO << "shard id = " << shard_id;                                                       \
       if (!HasShard(shard_id)) {                                                                   \
         return S_SHARD_NONEXISTS;                                                                  \
@@ -58,8 +84,9 @@ using namespace kanon;
 
 #define CHECK_HAS_SHARD_LOCKED_KEY                                                                 \
   do {                                                                                             \
-    if (mmkv_config().IsSharder() && HasShardLocked() && !is_ignore_locked_shard) {                \
-      return S_SHARD_LOCKED;                                                                       \
+    if (mmkv_config().IsSharder() && !is_ignore_locked_shard) {                                    \
+      /* The migrating shard can't be cleared, the moved keys are in the peer */                   \
+      if (HasShardLocked() || !migrating_shard_dict_.empty()) return S_SHARD_LOCKED;               \
     }                                                                                              \
   } while (0)
 
@@ -100,17 +127,74 @@ void MmkvDb::GetAllKeys(StrValues &keys) const
   // Don't replace any key
   // FIXME 检查Clear()是否需要？
   // keys.clear();
-  keys.reserve(dict_.size());
-  for (auto const &kv : dict_) {
+  keys.reserve(GetKeyNum());
+  ForEachDict([&keys](Dict const &dict) {
+    for (auto const &kv : dict) {
+      keys.emplace_back(kv.key);
+    }
+  });
+}
+
+/* The max number of the visited buckets is (10 * count),
+ * avoid walking too many empty buckets when the table is sparse */
+#define SCAN_MAX_STEP_FACTOR 10
+
+/* Visit the buckets of table from cursor until count entries are visited */
+template <typename Table, typename Cb>
+static inline size_t ScanRoutine(Table const &table, size_t cursor, size_t count, Cb cb)
+{
+  size_t visited_num = 0;
+  size_t max_steps   = count * SCAN_MAX_STEP_FACTOR;
+
+  do {
+    cursor = table.Scan(cursor, [&visited_num, &cb](typename Table::value_type const &entry) {
+      cb(entry);
+      ++visited_num;
+    });
+  } while (cursor != 0 && visited_num < count && --max_steps > 0);
+
+  return cursor;
+}
+
+/* The cursor of sharder is <shard_id, cursor of the sub-keyspace>,
+ * the shards are scanned in the order of id */
+#define SCAN_SHARD_SHIFT       48
+#define SCAN_SUB_CURSOR_MASK   ((1ULL << SCAN_SHARD_SHIFT) - 1)
+
+size_t MmkvDb::Scan(size_t cursor, size_t count, StrValues &keys) const
+{
+  // Same with GetAllKeys(), don't reclaim expired kv
+  size_t     visited_num = 0;
+  const auto cb          = [&keys, &visited_num](Dict::value_type const &kv) {
     keys.emplace_back(kv.key);
+    ++visited_num;
+  };
+
+  if (!mmkv_config().IsSharder()) return ScanRoutine(dict_, cursor, count, cb);
+
+  const shard_id_t shard_num = mmkv_config().shard_num;
+  size_t           sub_cursor = cursor & SCAN_SUB_CURSOR_MASK;
+  for (shard_id_t shard_id = cursor >> SCAN_SHARD_SHIFT; shard_id < shard_num; ++shard_id) {
+    auto shard_dict = sdict_.Find(shard_id);
+    if (shard_dict) {
+      sub_cursor = ScanRoutine(*shard_dict->value, sub_cursor, count - visited_num, cb);
+      if (sub_cursor != 0) return (shard_id << SCAN_SHARD_SHIFT) | sub_cursor;
+    }
+    sub_cursor = 0;
+
+    if (visited_num >= count) {
+      return shard_id + 1 < shard_num ? (shard_id + 1) << SCAN_SHARD_SHIFT : 0;
+    }
   }
+
+  return 0;
 }
 
-bool MmkvDb::Type(String const &key, DataType &type) noexcept
+bool MmkvDb::Type(StringView key, DataType &type) noexcept
 {
   if (CheckExpire(key)) return false;
 
-  auto kv = dict_.Find(key);
+  auto kv = FindEntry(key);
   if (!kv) return false;
 
   type = kv->value.type;
@@ -124,10 +208,9 @@ StatusCode MmkvDb::Delete(String const &k)
   // The 'del key' request has log to file by the MmkvSession
   CHECK_SHARD_IS_LOCKED_KEY(k);
 
-  auto node = dict_.Extract(k);
+  auto node = ExtractNode(k);
   if (!node) return S_NONEXISTS;
   auto &key = node->value.key;
-  RemoveKeyFromShard(&key);
   CacheRemove(&key);
   dict_.DropNode(node);
   // It's ok even though k doesn't exists
@@ -141,11 +224,12 @@ StatusCode MmkvDb::DeleteAll(size_t *p_del_cnt)
   *p_del_cnt = 0;
   CHECK_HAS_SHARD_LOCKED_KEY;
 
-  const auto ret = dict_.size();
+  const auto ret = GetKeyNum();
   dict_.Clear();
   exp_dict_.Clear();
   if (cache_) cache_->Clear();
-  DeleteAllShard();
+  // The shards are still owned, the requests to them aren't redirected
+  ClearAllShard();
 
   *p_del_cnt = ret;
   return S_OK;
@@ -154,18 +238,20 @@ StatusCode MmkvDb::DeleteAll(size_t *p_del_cnt)
 StatusCode MmkvDb::Rename(String const &old_name, String &&new_name)
 {
   CHECK_SHARD_IS_LOCKED_KEY(old_name);
+  CHECK_SHARD_IS_LOCKED_KEY(new_name);
   if (CheckExpire(old_name)) return S_NONEXISTS;
-  auto exists = dict_.Find(new_name);
+  auto exists = FindEntry(new_name);
   if (exists) return S_EXISTS;
 
-  auto node = dict_.Extract(old_name);
+  auto node = ExtractNode(old_name);
   if (!node) return S_NONEXISTS;
 
   auto pkey = &node->value.key;
   TryReplacekey(pkey);
   *pkey        = std::move(new_name);
   // FIXME Efficiently push without check of unique key
-  auto success = dict_.Push(node);
+  // The node is moved to the sub-keyspace of the new name if this is a sharder
+  auto success = GetDict(*pkey).Push(node);
   (void)success;
 
   // The address of the key is not changed,
@@ -173,24 +259,111 @@ StatusCode MmkvDb::Rename(String const &old_name, String &&new_name)
   assert(pkey == &node->value.key);
   CacheUpdate(pkey);
 
-  // To shard, do nothing since address is not changed.
+  assert(success);
+  return S_OK;
+}
+
+StatusCode MmkvDb::Rename(String const &old_name, MmkvDb &new_db, String &&new_name)
+{
+  if (&new_db == this) return Rename(old_name, std::move(new_name));
+
+  // The sharder has only one database, the shards needn't be checked
+  MMKV_ASSERT(!mmkv_config().IsSharder(), "The sharder can't rename across databases");
+  if (CheckExpire(old_name)) return S_NONEXISTS;
+  if (new_db.FindEntry(new_name)) return S_EXISTS;
+
+  auto node = ExtractNode(old_name);
+  if (!node) return S_NONEXISTS;
 
+  auto pkey = &node->value.key;
+  CacheRemove(pkey);
+
+  // The expiration time is moved with the record
+  auto exp_node = exp_dict_.FindLike(old_name);
+  if (exp_node) {
+    const auto expire = exp_node->value;
+    exp_dict_.Erase(old_name);
+    new_db.exp_dict_.InsertKv(new_name, expire);
+  }
+
+  new_db.TryReplacekey(pkey);
+  *pkey        = std::move(new_name);
+  auto success = new_db.GetDict(*pkey).Push(node);
+  (void)success;
   assert(success);
+  new_db.CacheAdd(pkey);
+
   return S_OK;
 }
 
+StatusCode MmkvDb::MemoryUsage(StringView key, size_t sample_num, size_t &usage)
+{
+  // Don't call CheckExpire() and CacheUpdate(),
+  // the introspection isn't regarded as an access
+  auto kv = FindEntry(key);
+  if (!kv) return S_NONEXISTS;
+
+  usage = GetEntryMemoryUsage(kv->key, kv->value, sample_num, nullptr);
+  return S_OK;
+}
+
+/* The random bucket that the sampling starts from(see SampleEntries()).
+ * The sampling only holds the read lock, thus each thread has its own engine. */
+static inline size_t GetSampleStart()
+{
+  thread_local std::default_random_engine dre(std::random_device{}());
+  return std::uniform_int_distribution<size_t>()(dre);
+}
+
+size_t MmkvDb::SampleMemoryUsage(size_t key_num, size_t sample_num, MemoryReport &report) const
+{
+  // The keys are distributed to the shards uniformly,
+  // thus the sub-keyspaces are sampled in order.
+  // The keys sampled in the previous rounds are not counted.
+  size_t sampled_num = 0;
+  ForEachDict([&](Dict const &dict) {
+    if (dict.empty() || sampled_num >= key_num) return;
+    dict.SampleEntries(
+        GetSampleStart(),
+        key_num - sampled_num,
+        [this, sample_num, &report, &sampled_num](Dict::value_type const &kv) {
+          size_t elem_num = 0;
+          auto   usage    = GetEntryMemoryUsage(kv.key, kv.value, sample_num, &elem_num);
+          if (report.Add(kv.key, kv.value.type, usage, elem_num)) ++sampled_num;
+        }
+    );
+  });
+  return sampled_num;
+}
+
+size_t MmkvDb::GetEntryMemoryUsage(
+    String const   &key,
+    MmkvData const &data,
+    size_t          sample_num,
+    size_t         *elem_num
+) const
+{
+  size_t usage = sizeof(Dict::Node) + GetStringFootprint(key) +
+                 EstimateMmkvDataFootprint(data, sample_num, elem_num);
+
+  if (exp_dict_.FindLike(key)) {
+    usage += sizeof(ExDict::Node) + GetStringFootprint(key);
+  }
+
+  return usage;
+}
+
 StatusCode MmkvDb::InsertStr(String &&k, String &&v)
 {
   CHECK_SHARD_IS_LOCKED_KEY(k);
   TryReplacekey(nullptr);
 
   MmkvData dummy_data(D_STRING);
-  auto     kv = dict_.InsertKv(std::move(k), std::move(dummy_data));
+  auto     kv = GetDict(k).InsertKv(std::move(k), std::move(dummy_data));
   if (!kv) return S_EXISTS;
   kv->value.any_data = new String(std::move(v));
 
   CacheAdd(&kv->key);
-  AddKeyToShard(&kv->key);
 
   return S_OK;
 }
@@ -198,17 +371,19 @@ StatusCode MmkvDb::InsertStr(String &&k, String &&v)
 StatusCode MmkvDb::EraseStr(String const &k)
 {
   CHECK_SHARD_IS_LOCKED_KEY(k);
+  auto dict = FindDict(k);
+  if (!dict) return S_NONEXISTS;
+
   typename Dict::Bucket *bucket = nullptr;
-  auto                   slot   = dict_.FindNode(k, &bucket);
+  auto                   slot   = dict->FindNode(k, &bucket);
   auto                  &str    = (slot)->value.value;
 
   if (slot) {
     if (str.type == D_STRING) {
       auto &key = slot->value.key;
       CacheRemove(&key);
-      RemoveKeyFromShard(&key);
       DeleteSpecificMmkvData<String>(&str);
-      dict_.EraseNode(bucket, slot);
+      dict->EraseNode(bucket, slot);
       return S_OK;
     } else {
       return S_EXISTS_DIFF_TYPE;
@@ -219,11 +394,11 @@ StatusCode MmkvDb::EraseStr(String const &k)
   return S_NONEXISTS;
 }
 
-StatusCode MmkvDb::GetStr(String const &k, String *&str) noexcept
+StatusCode MmkvDb::GetStr(StringView k, String *&str) noexcept
 {
   if (CheckExpire(k)) return S_NONEXISTS;
 
-  KeyValue<String, MmkvData> *data = dict_.Find(k);
+  KeyValue<String, MmkvData> *data = FindEntry(k);
   if (data) {
     if (data->value.type == D_STRING) {
       str = (String *)data->value.any_data;
@@ -270,11 +445,11 @@ StatusCode MmkvDb::SetStr(String &&k, String &&v)
   Dict::value_type *duplicate = nullptr;
   MmkvData          dummy_data(D_STRING);
 
-  auto success = dict_.InsertKvWithDuplicate(std::move(k), std::move(dummy_data), duplicate);
+  auto success =
+      GetDict(k).InsertKvWithDuplicate(std::move(k), std::move(dummy_data), duplicate);
   if (success) {
     duplicate->value.any_data = new String(std::move(v));
     CacheAdd(&duplicate->key);
-    AddKeyToShard(&duplicate->key);
   } else {
     if (duplicate->value.type == D_STRING) {
       *((String *)duplicate->value.any_data) = std::move(v);
@@ -289,7 +464,7 @@ StatusCode MmkvDb::SetStr(String &&k, String &&v)
 }
 
 #define LIST_ERROR_ROUTINE                                                                         \
-  auto kv = dict_.Find(k);                                                                         \
+  auto kv = FindEntry(k);                                                                     \
   if (!kv) return S_NONEXISTS;                                                                     \
   if (kv->value.type != D_STRLIST) return S_EXISTS_DIFF_TYPE
 
@@ -301,7 +476,7 @@ StatusCode MmkvDb::ListAdd(String &&k, StrValues &elems)
   CHECK_SHARD_IS_LOCKED_KEY(k);
   MmkvData data(D_STRLIST);
 
-  auto kv = dict_.InsertKv(std::move(k), std::move(data));
+  auto kv = GetDict(k).InsertKv(std::move(k), std::move(data));
   if (!kv) return S_EXISTS;
 
   StrList *lst = new StrList();
@@ -309,7 +484,6 @@ StatusCode MmkvDb::ListAdd(String &&k, StrValues &elems)
     lst->PushBack(std::move(elem));
   }
   CacheAdd(&kv->key);
-  AddKeyToShard(&kv->key);
 
   kv->value.any_data = lst;
 
@@ -326,7 +500,8 @@ StatusCode MmkvDb::ListAppend(String &&k, StrValues &elems)
   MmkvData dummy_data(D_STRLIST);
 
   Dict::value_type *duplicate = nullptr;
-  auto success = dict_.InsertKvWithDuplicate(std::move(k), std::move(dummy_data), duplicate);
+  auto success =
+      GetDict(k).InsertKvWithDuplicate(std::move(k), std::move(dummy_data), duplicate);
 
   if (success || duplicate->value.type == D_STRLIST) {
     StrList *lst = nullptr;
@@ -334,7 +509,6 @@ StatusCode MmkvDb::ListAppend(String &&k, StrValues &elems)
       lst                       = new StrList();
       duplicate->value.any_data = lst;
       CacheAdd(&duplicate->key);
-      AddKeyToShard(&duplicate->key);
     } else {
       lst = (StrList *)duplicate->value.any_data;
     }
@@ -362,7 +536,7 @@ StatusCode MmkvDb::ListPrepend(String const &k, StrValues &elems)
   return S_OK;
 }
 
-StatusCode MmkvDb::ListGetSize(String const &k, size_t &size)
+StatusCode MmkvDb::ListGetSize(StringView k, size_t &size)
 {
   if (CheckExpire(k)) return S_NONEXISTS;
   LIST_ERROR_ROUTINE;
@@ -372,7 +546,7 @@ StatusCode MmkvDb::ListGetSize(String const &k, size_t &size)
   return S_OK;
 }
 
-StatusCode MmkvDb::ListGetAll(String const &k, StrValues &values)
+StatusCode MmkvDb::ListGetAll(StringView k, StrValues &values)
 {
   if (CheckExpire(k)) return S_NONEXISTS;
   LIST_ERROR_ROUTINE;
@@ -388,7 +562,21 @@ StatusCode MmkvDb::ListGetAll(String const &k, StrValues &values)
   return S_OK;
 }
 
-StatusCode MmkvDb::ListGetRange(String const &k, StrValues &values, int64_t l, int64_t r)
+StatusCode MmkvDb::ListGetAll(StringView k, StrRefValues &values)
+{
+  if (CheckExpire(k)) return S_NONEXISTS;
+  LIST_ERROR_ROUTINE;
+  auto lst = (StrList *)kv->value.any_data;
+  values.reserve(lst->size());
+
+  for (auto const &elem : *lst) {
+    values.push_back(&elem);
+  }
+
+  return S_OK;
+}
+
+StatusCode MmkvDb::ListGetRange(StringView k, StrValues &values, int64_t l, int64_t r)
 {
   if (CheckExpire(k)) return S_NONEXISTS;
   LIST_ERROR_ROUTINE;
@@ -472,18 +660,19 @@ StatusCode MmkvDb::ListPopBack(String const &k, uint32_t count)
 StatusCode MmkvDb::ListDel(String const &k)
 {
   CHECK_SHARD_IS_LOCKED_KEY(k);
+  auto dict = FindDict(k);
+  if (!dict) return S_NONEXISTS;
 
   Dict::Bucket *bucket   = nullptr;
-  auto          slot     = dict_.FindNode(k, &bucket);
+  auto          slot     = dict->FindNode(k, &bucket);
   auto         &str_list = (slot)->value.value;
 
   if (slot) {
     if (str_list.type == D_STRLIST) {
       auto &key = slot->value.key;
       CacheRemove(&key);
-      RemoveKeyFromShard(&key);
       DeleteSpecificMmkvData<StrList>(&str_list);
-      dict_.EraseNode(bucket, slot);
+      dict->EraseNode(bucket, slot);
       exp_dict_.Erase(k);
       return S_OK;
     } else {
@@ -503,7 +692,8 @@ StatusCode MmkvDb::VsetAdd(String &&key, WeightValues &&wms, size_t &count)
   MmkvData dummy_data(D_SORTED_SET);
 
   Dict::value_type *duplicate = nullptr;
-  auto success = dict_.InsertKvWithDuplicate(std::move(key), std::move(dummy_data), duplicate);
+  auto success =
+      GetDict(key).InsertKvWithDuplicate(std::move(key), std::move(dummy_data), duplicate);
 
   if (success || duplicate->value.type == D_SORTED_SET) {
     Vset *vset = nullptr;
@@ -511,7 +701,6 @@ StatusCode MmkvDb::VsetAdd(String &&key, WeightValues &&wms, size_t &count)
       vset                      = new Vset();
       duplicate->value.any_data = vset;
       CacheAdd(&duplicate->key);
-      AddKeyToShard(&duplicate->key);
     } else {
       vset = TO_VSET(duplicate);
     }
@@ -532,7 +721,7 @@ StatusCode MmkvDb::VsetAdd(String &&key, WeightValues &&wms, size_t &count)
   if ((_var)->value.type != (_type)) return S_EXISTS_DIFF_TYPE;
 
 #define ERROR_ROUTINE_KV(_type)                                                                    \
-  auto kv = dict_.Find(key);                                                                       \
+  auto kv = FindEntry(key);                                                                   \
   if (!kv) return S_NONEXISTS;                                                                     \
   if (kv->value.type != (_type)) return S_EXISTS_DIFF_TYPE
 
@@ -568,7 +757,7 @@ StatusCode MmkvDb::VsetDelRangeByWeight(String const &key, WeightRange range, si
   return S_OK;
 }
 
-StatusCode MmkvDb::VsetSize(String const &key, size_t &count)
+StatusCode MmkvDb::VsetSize(StringView key, size_t &count)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_SORTED_SET);
@@ -576,7 +765,7 @@ StatusCode MmkvDb::VsetSize(String const &key, size_t &count)
   return S_OK;
 }
 
-StatusCode MmkvDb::VsetSizeByWeight(String const &key, WeightRange range, size_t &count)
+StatusCode MmkvDb::VsetSizeByWeight(StringView key, WeightRange range, size_t &count)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_SORTED_SET);
@@ -584,7 +773,7 @@ StatusCode MmkvDb::VsetSizeByWeight(String const &key, WeightRange range, size_t
   return S_OK;
 }
 
-StatusCode MmkvDb::VsetWeight(String const &key, String const &member, Weight &w)
+StatusCode MmkvDb::VsetWeight(StringView key, StringView member, Weight &w)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_SORTED_SET);
@@ -594,7 +783,7 @@ StatusCode MmkvDb::VsetWeight(String const &key, String const &member, Weight &w
     return S_VMEMBER_NONEXISTS;
 }
 
-StatusCode MmkvDb::VsetOrder(String const &key, String const &member, size_t &order)
+StatusCode MmkvDb::VsetOrder(StringView key, StringView member, size_t &order)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_SORTED_SET);
@@ -604,7 +793,7 @@ StatusCode MmkvDb::VsetOrder(String const &key, String const &member, size_t &or
     return S_VMEMBER_NONEXISTS;
 }
 
-StatusCode MmkvDb::VsetROrder(String const &key, String const &member, size_t &order)
+StatusCode MmkvDb::VsetROrder(StringView key, StringView member, size_t &order)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_SORTED_SET);
@@ -614,7 +803,7 @@ StatusCode MmkvDb::VsetROrder(String const &key, String const &member, size_t &o
     return S_VMEMBER_NONEXISTS;
 }
 
-StatusCode MmkvDb::VsetAll(String const &key, WeightValues &wms)
+StatusCode MmkvDb::VsetAll(StringView key, WeightValues &wms)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_SORTED_SET);
@@ -622,7 +811,32 @@ StatusCode MmkvDb::VsetAll(String const &key, WeightValues &wms)
   return S_OK;
 }
 
-StatusCode MmkvDb::VsetRange(String const &key, OrderRange range, WeightValues &wms)
+StatusCode MmkvDb::VsetAll(StringView key, WeightRefValues &wms)
+{
+  CHECK_EXPIRE_ROUTINE(key);
+  ERROR_ROUTINE_KV(D_SORTED_SET);
+  TO_VSET(kv)->GetAll(wms);
+  return S_OK;
+}
+
+StatusCode MmkvDb::VsetScan(StringView key, size_t &cursor, size_t count, WeightValues &wms)
+{
+  CHECK_EXPIRE_ROUTINE(key);
+  ERROR_ROUTINE_KV(D_SORTED_SET);
+
+  // The tree is ordered by weight, scan the dictionary instead
+  cursor = ScanRoutine(
+      TO_VSET(kv)->dict(),
+      cursor,
+      count,
+      [&wms](Vset::Dict::value_type const &member) {
+        wms.push_back({member.value, member.key});
+      }
+  );
+  return S_OK;
+}
+
+StatusCode MmkvDb::VsetRange(StringView key, OrderRange range, WeightValues &wms)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_SORTED_SET);
@@ -630,7 +844,7 @@ StatusCode MmkvDb::VsetRange(String const &key, OrderRange range, WeightValues &
   return S_OK;
 }
 
-StatusCode MmkvDb::VsetRangeByWeight(String const &key, WeightRange range, WeightValues &wms)
+StatusCode MmkvDb::VsetRangeByWeight(StringView key, WeightRange range, WeightValues &wms)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_SORTED_SET);
@@ -638,7 +852,7 @@ StatusCode MmkvDb::VsetRangeByWeight(String const &key, WeightRange range, Weigh
   return S_OK;
 }
 
-StatusCode MmkvDb::VsetRRange(String const &key, OrderRange range, WeightValues &wms)
+StatusCode MmkvDb::VsetRRange(StringView key, OrderRange range, WeightValues &wms)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_SORTED_SET);
@@ -647,7 +861,7 @@ StatusCode MmkvDb::VsetRRange(String const &key, OrderRange range, WeightValues
   return S_OK;
 }
 
-StatusCode MmkvDb::VsetRRangeByWeight(String const &key, WeightRange range, WeightValues &wms)
+StatusCode MmkvDb::VsetRRangeByWeight(StringView key, WeightRange range, WeightValues &wms)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_SORTED_SET);
@@ -663,14 +877,14 @@ StatusCode MmkvDb::MapAdd(String &&key, StrKvs &&kvs, size_t &count)
 
   Dict::value_type *duplicate = nullptr;
 
-  auto success = dict_.InsertKvWithDuplicate(std::move(key), std::move(dummy_data), duplicate);
+  auto success =
+      GetDict(key).InsertKvWithDuplicate(std::move(key), std::move(dummy_data), duplicate);
   if (success || duplicate->value.type == D_MAP) {
     Map *map = nullptr;
     if (success) {
       map                       = new Map();
       duplicate->value.any_data = map;
       CacheAdd(&duplicate->key);
-      AddKeyToShard(&duplicate->key);
     } else {
       map = (Map *)duplicate->value.any_data;
     }
@@ -687,13 +901,13 @@ StatusCode MmkvDb::MapAdd(String &&key, StrKvs &&kvs, size_t &count)
 
 #define TO_MAP ((Map *)(kv->value.any_data))
 
-StatusCode MmkvDb::MapGet(String const &key, String const &field, String &value)
+StatusCode MmkvDb::MapGet(StringView key, StringView field, String &value)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_MAP);
 
   auto map = TO_MAP;
-  auto fv  = map->Find(field);
+  auto fv  = map->FindLike(field);
 
   if (fv) {
     value = fv->value;
@@ -703,7 +917,18 @@ StatusCode MmkvDb::MapGet(String const &key, String const &field, String &value)
   return S_FIELD_NONEXISTS;
 }
 
-StatusCode MmkvDb::MapGets(String const &key, StrValues const &fields, StrValues &values)
+StatusCode MmkvDb::MapGets(StringView key, StrValues const &fields, StrValues &values)
+{
+  StrViews field_views;
+  field_views.reserve(fields.size());
+  for (auto const &field : fields) {
+    field_views.emplace_back(field.data(), field.size());
+  }
+
+  return MapGets(key, field_views, values);
+}
+
+StatusCode MmkvDb::MapGets(StringView key, StrViews const &fields, StrValues &values)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_MAP);
@@ -711,7 +936,7 @@ StatusCode MmkvDb::MapGets(String const &key, StrValues const &fields, StrValues
   auto map = TO_MAP;
 
   for (auto const &field : fields) {
-    auto fv = map->Find(field);
+    auto fv = map->FindLike(field);
 
     if (fv) {
       values.push_back(fv->value);
@@ -759,7 +984,7 @@ StatusCode MmkvDb::MapDel(String const &key, String const &field)
   return S_FIELD_NONEXISTS;
 }
 
-StatusCode MmkvDb::MapSize(String const &key, size_t &count)
+StatusCode MmkvDb::MapSize(StringView key, size_t &count)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_MAP);
@@ -767,18 +992,18 @@ StatusCode MmkvDb::MapSize(String const &key, size_t &count)
   return S_OK;
 }
 
-StatusCode MmkvDb::MapExists(String const &key, String const &field)
+StatusCode MmkvDb::MapExists(StringView key, StringView field)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_MAP);
-  if (TO_MAP->Find(field)) {
+  if (TO_MAP->FindLike(field)) {
     return S_OK;
   }
 
   return S_FIELD_NONEXISTS;
 }
 
-StatusCode MmkvDb::MapFields(String const &key, StrValues &fields)
+StatusCode MmkvDb::MapFields(StringView key, StrValues &fields)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_MAP);
@@ -791,7 +1016,7 @@ StatusCode MmkvDb::MapFields(String const &key, StrValues &fields)
   return S_OK;
 }
 
-StatusCode MmkvDb::MapValues(String const &key, StrValues &values)
+StatusCode MmkvDb::MapValues(StringView key, StrValues &values)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_MAP);
@@ -804,7 +1029,7 @@ StatusCode MmkvDb::MapValues(String const &key, StrValues &values)
   return S_OK;
 }
 
-StatusCode MmkvDb::MapAll(String const &key, StrKvs &kvs)
+StatusCode MmkvDb::MapAll(StringView key, StrKvs &kvs)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_MAP);
@@ -817,6 +1042,31 @@ StatusCode MmkvDb::MapAll(String const &key, StrKvs &kvs)
   return S_OK;
 }
 
+StatusCode MmkvDb::MapAll(StringView key, StrRefKvs &kvs)
+{
+  CHECK_EXPIRE_ROUTINE(key);
+  ERROR_ROUTINE_KV(D_MAP);
+  auto &m = *TO_MAP;
+  kvs.reserve(m.size());
+
+  for (auto const &kv : m) {
+    kvs.push_back({&kv.key, &kv.value});
+  }
+
+  return S_OK;
+}
+
+StatusCode MmkvDb::MapScan(StringView key, size_t &cursor, size_t count, StrKvs &kvs)
+{
+  CHECK_EXPIRE_ROUTINE(key);
+  ERROR_ROUTINE_KV(D_MAP);
+
+  cursor = ScanRoutine(*TO_MAP, cursor, count, [&kvs](Map::value_type const &field_value) {
+    kvs.push_back({field_value.key, field_value.value});
+  });
+  return S_OK;
+}
+
 StatusCode MmkvDb::SetAdd(String &&key, StrValues &members, size_t &count)
 {
   CHECK_SHARD_IS_LOCKED_KEY(key);
@@ -825,14 +1075,14 @@ StatusCode MmkvDb::SetAdd(String &&key, StrValues &members, size_t &count)
 
   Dict::value_type *duplicate = nullptr;
 
-  auto success = dict_.InsertKvWithDuplicate(std::move(key), std::move(dummy_data), duplicate);
+  auto success =
+      GetDict(key).InsertKvWithDuplicate(std::move(key), std::move(dummy_data), duplicate);
   if (success || duplicate->value.type == D_SET) {
     Set *set = nullptr;
     if (success) {
       set                       = new Set();
       duplicate->value.any_data = set;
       CacheAdd(&duplicate->key);
-      AddKeyToShard(&duplicate->key);
     } else {
       set = (Set *)duplicate->value.any_data;
     }
@@ -869,7 +1119,7 @@ StatusCode MmkvDb::SetRandDelm(String const &key)
   return S_SET_NO_MEMBER;
 }
 
-StatusCode MmkvDb::SetSize(String const &key, size_t &count)
+StatusCode MmkvDb::SetSize(StringView key, size_t &count)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_SET);
@@ -877,17 +1127,17 @@ StatusCode MmkvDb::SetSize(String const &key, size_t &count)
   return S_OK;
 }
 
-StatusCode MmkvDb::SetExists(String const &key, String const &member)
+StatusCode MmkvDb::SetExists(StringView key, StringView member)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_SET);
-  if (TO_SET(kv->value)->Find(member))
+  if (TO_SET(kv->value)->FindLike(member))
     return S_OK;
   else
     return S_SET_MEMBER_NONEXISTS;
 }
 
-StatusCode MmkvDb::SetAll(String const &key, StrValues &members)
+StatusCode MmkvDb::SetAll(StringView key, StrValues &members)
 {
   CHECK_EXPIRE_ROUTINE(key);
   ERROR_ROUTINE_KV(D_SET);
@@ -900,21 +1150,32 @@ StatusCode MmkvDb::SetAll(String const &key, StrValues &members)
   return S_OK;
 }
 
-#define SET_OP_ROUTINE                                                                             \
-  auto kv1 = dict_.Find(key1);                                                                     \
+StatusCode MmkvDb::SetScan(StringView key, size_t &cursor, size_t count, StrValues &members)
+{
+  CHECK_EXPIRE_ROUTINE(key);
+  ERROR_ROUTINE_KV(D_SET);
+
+  cursor = ScanRoutine(*TO_SET(kv->value), cursor, count, [&members](String const &member) {
+    members.push_back(member);
+  });
+  return S_OK;
+}
+
+/* key1 is stored in db1 and key2 is stored in db2,
+ * they are the same database unless the keys are in different instances */
+#define SET_OP_ROUTINE(db1, db2)                                                                   \
+  if ((db1).CheckExpire(key1)) return S_NONEXISTS;                                                 \
+  if ((db2).CheckExpire(key2)) return S_NONEXISTS;                                                 \
+  auto kv1 = (db1).FindEntry(key1);                                                                \
   ERROR_ROUTINE(kv1, D_SET);                                                                       \
-  auto kv2 = dict_.Find(key2);                                                                     \
+  auto kv2 = (db2).FindEntry(key2);                                                                \
   ERROR_ROUTINE(kv2, D_SET);                                                                       \
   auto set1 = TO_SET(kv1->value);                                                                  \
   auto set2 = TO_SET(kv2->value)
 
-StatusCode MmkvDb::SetAnd(String const &key1, String const &key2, StrValues &members)
+StatusCode MmkvDb::SetAnd(StringView key1, MmkvDb &db2, StringView key2, StrValues &members)
 {
-  // FIXME
-  CHECK_EXPIRE_ROUTINE(key1);
-  CHECK_EXPIRE_ROUTINE(key2);
-
-  SET_OP_ROUTINE;
+  SET_OP_ROUTINE(*this, db2);
   set1->Intersection(*set2, [&members](String const &m) {
     members.push_back(m);
   });
@@ -926,26 +1187,30 @@ StatusCode MmkvDb::SetAnd(String const &key1, String const &key2, StrValues &mem
   MmkvData dummy_data(D_SET);                                                                      \
                                                                                                    \
   Dict::value_type *duplicate = nullptr;                                                           \
-  auto success = dict_.InsertKvWithDuplicate(std::move(dest), std::move(dummy_data), duplicate);   \
+  auto success =                                                                                   \
+      GetDict(dest).InsertKvWithDuplicate(std::move(dest), std::move(dummy_data), duplicate);      \
                                                                                                    \
   Set *dest_set = nullptr;                                                                         \
   if (success) {                                                                                   \
     dest_set                  = new Set();                                                         \
     duplicate->value.any_data = dest_set;                                                          \
     CacheAdd(&duplicate->key);                                                                     \
-    AddKeyToShard(&duplicate->key);                                                                \
   } else {                                                                                         \
     if (duplicate->value.type != D_SET) return S_DEST_EXISTS;                                      \
     dest_set = TO_SET(duplicate->value);                                                           \
   }
 
-StatusCode MmkvDb::SetAndTo(String const &key1, String const &key2, String &&dest)
+StatusCode MmkvDb::SetAndTo(
+    MmkvDb       &db1,
+    String const &key1,
+    MmkvDb       &db2,
+    String const &key2,
+    String      &&dest
+)
 {
   CHECK_SHARD_IS_LOCKED_KEY(dest);
 
-  CHECK_EXPIRE_ROUTINE(key1);
-  CHECK_EXPIRE_ROUTINE(key2);
-  SET_OP_ROUTINE;
+  SET_OP_ROUTINE(db1, db2);
   SET_OP_TO_ROUTINE
 
   set1->Intersection(*set2, [&dest_set](String const &m) {
@@ -955,11 +1220,9 @@ StatusCode MmkvDb::SetAndTo(String const &key1, String const &key2, String &&des
   return S_OK;
 }
 
-StatusCode MmkvDb::SetSub(String const &key1, String const &key2, StrValues &members)
+StatusCode MmkvDb::SetSub(StringView key1, MmkvDb &db2, StringView key2, StrValues &members)
 {
-  CHECK_EXPIRE_ROUTINE(key1);
-  CHECK_EXPIRE_ROUTINE(key2);
-  SET_OP_ROUTINE;
+  SET_OP_ROUTINE(*this, db2);
 
   set1->Difference(*set2, [&members](String const &m) {
     members.push_back(m);
@@ -968,13 +1231,17 @@ StatusCode MmkvDb::SetSub(String const &key1, String const &key2, StrValues &mem
   return S_OK;
 }
 
-StatusCode MmkvDb::SetSubTo(String const &key1, String const &key2, String &&dest)
+StatusCode MmkvDb::SetSubTo(
+    MmkvDb       &db1,
+    String const &key1,
+    MmkvDb       &db2,
+    String const &key2,
+    String      &&dest
+)
 {
   CHECK_SHARD_IS_LOCKED_KEY(dest);
 
-  CHECK_EXPIRE_ROUTINE(key1);
-  CHECK_EXPIRE_ROUTINE(key2);
-  SET_OP_ROUTINE;
+  SET_OP_ROUTINE(db1, db2);
   SET_OP_TO_ROUTINE
 
   set1->Difference(*set2, [&dest_set](String const &m) {
@@ -984,11 +1251,9 @@ StatusCode MmkvDb::SetSubTo(String const &key1, String const &key2, String &&des
   return S_OK;
 }
 
-StatusCode MmkvDb::SetOr(String const &key1, String const &key2, StrValues &members)
+StatusCode MmkvDb::SetOr(StringView key1, MmkvDb &db2, StringView key2, StrValues &members)
 {
-  CHECK_EXPIRE_ROUTINE(key1);
-  CHECK_EXPIRE_ROUTINE(key2);
-  SET_OP_ROUTINE;
+  SET_OP_ROUTINE(*this, db2);
 
   set1->Union(*set2, [&members](String const &m) {
     members.push_back(m);
@@ -997,13 +1262,17 @@ StatusCode MmkvDb::SetOr(String const &key1, String const &key2, StrValues &memb
   return S_OK;
 }
 
-StatusCode MmkvDb::SetOrTo(String const &key1, String const &key2, String &&dest)
+StatusCode MmkvDb::SetOrTo(
+    MmkvDb       &db1,
+    String const &key1,
+    MmkvDb       &db2,
+    String const &key2,
+    String      &&dest
+)
 {
   CHECK_SHARD_IS_LOCKED_KEY(dest);
 
-  CHECK_EXPIRE_ROUTINE(key1);
-  CHECK_EXPIRE_ROUTINE(key2);
-  SET_OP_ROUTINE;
+  SET_OP_ROUTINE(db1, db2);
   SET_OP_TO_ROUTINE;
 
   set1->Union(*set2, [&dest_set](String const &m) {
@@ -1013,11 +1282,9 @@ StatusCode MmkvDb::SetOrTo(String const &key1, String const &key2, String &&dest
   return S_OK;
 }
 
-StatusCode MmkvDb::SetAndSize(String const &key1, String const &key2, size_t &count)
+StatusCode MmkvDb::SetAndSize(StringView key1, MmkvDb &db2, StringView key2, size_t &count)
 {
-  CHECK_EXPIRE_ROUTINE(key1);
-  CHECK_EXPIRE_ROUTINE(key2);
-  SET_OP_ROUTINE;
+  SET_OP_ROUTINE(*this, db2);
   count = 0;
   set1->Intersection(*set2, [&count](String const &) {
     count++;
@@ -1026,11 +1293,9 @@ StatusCode MmkvDb::SetAndSize(String const &key1, String const &key2, size_t &co
   return S_OK;
 }
 
-StatusCode MmkvDb::SetOrSize(String const &key1, String const &key2, size_t &count)
+StatusCode MmkvDb::SetOrSize(StringView key1, MmkvDb &db2, StringView key2, size_t &count)
 {
-  CHECK_EXPIRE_ROUTINE(key1);
-  CHECK_EXPIRE_ROUTINE(key2);
-  SET_OP_ROUTINE;
+  SET_OP_ROUTINE(*this, db2);
   count = 0;
   set1->Union(*set2, [&count](String const &) {
     count++;
@@ -1039,11 +1304,9 @@ StatusCode MmkvDb::SetOrSize(String const &key1, String const &key2, size_t &cou
   return S_OK;
 }
 
-StatusCode MmkvDb::SetSubSize(String const &key1, String const &key2, size_t &count)
+StatusCode MmkvDb::SetSubSize(StringView key1, MmkvDb &db2, StringView key2, size_t &count)
 {
-  CHECK_EXPIRE_ROUTINE(key1);
-  CHECK_EXPIRE_ROUTINE(key2);
-  SET_OP_ROUTINE;
+  SET_OP_ROUTINE(*this, db2);
   count = 0;
   set1->Difference(*set2, [&count](String const &) {
     count++;
@@ -1057,7 +1320,7 @@ StatusCode MmkvDb::ExpireAtMs(String &&key, uint64_t expire)
   CHECK_SHARD_IS_LOCKED_KEY(key);
 
   if (mmkv_config().IsExpirationDisable()) return protocol::S_EXPIRE_DISABLE;
-  auto kv = dict_.Find(key);
+  auto kv = FindEntry(key);
   if (!kv) return S_NONEXISTS;
 
   ExDict::value_type *duplicate = nullptr;
@@ -1078,23 +1341,23 @@ StatusCode MmkvDb::Persist(String const &key)
 {
   CHECK_SHARD_IS_LOCKED_KEY(key);
 
-  if (!dict_.Find(key)) return S_NONEXISTS;
+  if (!FindEntry(key)) return S_NONEXISTS;
   // Though there is no key in the exp_dict_, it is also ok.
   exp_dict_.Erase(key);
   return S_OK;
 }
 
-StatusCode MmkvDb::GetExpiration(String const &key, uint64_t &exp)
+StatusCode MmkvDb::GetExpiration(StringView key, uint64_t &exp)
 {
-  auto exp_key = exp_dict_.Find(key);
+  auto exp_key = exp_dict_.FindLike(key);
   if (!exp_key) return protocol::S_NONEXISTS;
   exp = exp_key->value;
   return S_OK;
 }
 
-StatusCode MmkvDb::GetTimeToLive(String const &key, uint64_t &ttl)
+StatusCode MmkvDb::GetTimeToLive(StringView key, uint64_t &ttl)
 {
-  auto exp_key = exp_dict_.Find(key);
+  auto exp_key = exp_dict_.FindLike(key);
   if (!exp_key) return protocol::S_NONEXISTS;
   const uint64_t cur_ms = util::GetTimeMs();
   /* Avoid unsigned integer underflow
@@ -1111,11 +1374,6 @@ void MmkvDb::TryReplacekey(String const *key)
 {
   if (!cache_ || mmkv_config().max_memory_usage > memory_stat().memory_usage) return;
 
-  auto const shard_id = MakeShardId(*key);
-  if (IsShardLocked(shard_id)) {
-    return;
-  }
-
   auto victim = cache_->Victim();
   // If the victim has already in the database,
   // don't remove it from cache to avoid insert twice.
@@ -1123,10 +1381,16 @@ void MmkvDb::TryReplacekey(String const *key)
   assert(*victim);
   LOG_TRACE << "Victim: " << **victim;
 
-  auto node = dict_.Extract(**victim);
+  // The locked or migrating shard keeps unchanged until it is removed
+  if (mmkv_config().IsSharder()) {
+    const auto shard_id = GetShardId(**victim);
+    if (IsShardLocked(shard_id) || IsShardMigrating(shard_id)) return;
+  }
+
+  auto node = ExtractNode(**victim);
   assert(node);
   cache_->DelVictim();
-  if (mmkv_config().log_method == server::LM_REQUEST) rlog().AppendDel(std::move(node->value.key));
+  DropKey(std::move(node->value.key), KDR_EVICTED);
   dict_.DropNode(node);
 }
 
@@ -1159,38 +1423,24 @@ void MmkvDb::CheckExpireCycle()
 
   for (auto const &k_exp : exp_dict_) {
     if (k_exp.value <= cur_ms) {
-      node = dict_.Extract(k_exp.key);
+      node = ExtractNode(k_exp.key);
       dict_.DropNode(node);
 
       expire_keys.emplace_back(k_exp.key);
     }
   }
 
-  for (auto const &key : expire_keys) {
+  for (auto &key : expire_keys) {
     exp_dict_.Erase(key);
-  }
-
-  if (mmkv_config().log_method == LM_REQUEST) {
-    MmbpRequest request;
-    Buffer      buffer;
-    for (auto &key : expire_keys) {
-      request.SetKey();
-      request.key     = std::move(key);
-      request.command = DEL;
-      request.SerializeTo(buffer);
-      buffer.Prepend32(buffer.GetReadableSize());
-      rlog().Append(buffer.GetReadBegin(), buffer.GetReadableSize());
-      buffer.AdvanceAll();
-      request.Reset();
-    }
+    DropKey(std::move(key), KDR_EXPIRED);
   }
 }
 
-bool MmkvDb::CheckExpire(String const &key)
+bool MmkvDb::CheckExpire(StringView key)
 {
-  if (!mmkv_config().lazy_expiration) return false;
+  if (!mmkv_config().lazy_expiration || t_is_expiration_paused) return false;
   ExDict::Bucket *bucket = nullptr;
-  const auto      node   = exp_dict_.FindNode(key, &bucket);
+  const auto      node   = exp_dict_.FindNodeLike(key, &bucket);
   if (!node) return false;
   assert(bucket);
 
@@ -1198,13 +1448,12 @@ bool MmkvDb::CheckExpire(String const &key)
   LOG_DEBUG << "current ms: " << cur_ms;
   if (cur_ms >= node->value.value) {
     exp_dict_.EraseNode(bucket, node);
-    auto node2 = dict_.Extract(key);
+    // The expired key is rare, so it is ok to construct a String
+    String expired_key(key.data(), key.size());
+    auto   node2 = ExtractNode(expired_key);
     MMKV_ASSERT(node2, "Key must in the dict_ ");
     dict_.DropNode(node2);
-
-    if (mmkv_config().log_method == LM_REQUEST) {
-      rlog().AppendDel(std::move(const_cast<String &>(key)));
-    }
+    DropKey(std::move(expired_key), KDR_EXPIRED);
     return true;
   }
 
@@ -1215,55 +1464,108 @@ bool MmkvDb::CheckExpire(String const &key)
 /* Shard Management                                 */
 /*--------------------------------------------------*/
 
-void MmkvDb::AddKeyToShard(String const *key)
+auto MmkvDb::GetDict(StringView key) -> Dict &
 {
-  if (mmkv_config().IsSharder()) {
-    sdict_[MakeShardId(*key)].Insert(key);
-  }
+  if (!mmkv_config().IsSharder()) return dict_;
+
+  auto &shard_dict = sdict_[GetShardId(key)];
+  if (!shard_dict) shard_dict.reset(new Dict());
+  return *shard_dict;
 }
 
-void MmkvDb::RemoveKeyFromShard(String const *key)
+auto MmkvDb::FindDict(StringView key) noexcept -> Dict *
 {
-  if (mmkv_config().IsSharder()) {
-    sdict_[MakeShardId(*key)].Erase(key);
-  }
+  if (!mmkv_config().IsSharder()) return &dict_;
+
+  auto shard_dict = sdict_.Find(GetShardId(key));
+  return shard_dict ? shard_dict->value.get() : nullptr;
+}
+
+size_t MmkvDb::GetKeyNum() const noexcept
+{
+  size_t key_num = 0;
+  ForEachDict([&key_num](Dict const &dict) { key_num += dict.size(); });
+  return key_num;
+}
+
+bool MmkvDb::GetRehashProgress(size_t *moved_num, size_t *total_num) const noexcept
+{
+  bool is_rehashing = false;
+  *moved_num        = 0;
+  *total_num        = 0;
+  ForEachDict([&](Dict const &dict) {
+    size_t moved = 0;
+    size_t total = 0;
+    if (dict.GetRehashProgress(&moved, &total)) {
+      is_rehashing  = true;
+      *moved_num   += moved;
+      *total_num   += total;
+    }
+  });
+  return is_rehashing;
 }
 
 void MmkvDb::AddShard(shard_id_t shard_id)
 {
-  if (mmkv_config().IsSharder()) {
-    sdict_.InsertKv(shard_id, ShardIdSet{});
+  if (mmkv_config().IsSharder() && !sdict_.Find(shard_id)) {
+    sdict_.InsertKv(shard_id, std::unique_ptr<Dict>(new Dict()));
   }
 }
 
 void MmkvDb::RemoveShard(shard_id_t shard_id)
 {
   if (mmkv_config().IsSharder()) {
-    auto *p_shard_key_set = sdict_.Find(shard_id);
-    assert(p_shard_key_set);
-    auto &key_set = p_shard_key_set->value;
-    for (auto const &key : key_set) {
-      // FIXME don't compute again
-      Delete(*key);
+    auto *p_shard_dict = sdict_.Find(shard_id);
+    assert(p_shard_dict);
+
+    // The records are reclaimed with the sub-keyspace,
+    // only the references in cache and exp_dict_ are removed
+    for (auto const &kv : *p_shard_dict->value) {
+      CacheRemove(&kv.key);
+      if (!exp_dict_.empty()) exp_dict_.Erase(kv.key);
     }
     LOG_INFO << "Remove shard id = " << shard_id;
     sdict_.Erase(shard_id);
+    migrating_shard_dict_.Erase(shard_id);
+    importing_shard_id_set_.Erase(shard_id);
   }
 }
 
 bool MmkvDb::HasShard(shard_id_t shard_id) { return sdict_.Find(shard_id); }
 
+size_t MmkvDb::EstimateShardMemoryUsage(
+    shard_id_t shard_id,
+    size_t     key_num,
+    size_t     sample_num
+) const
+{
+  auto p_shard_dict = sdict_.Find(shard_id);
+  if (!p_shard_dict || p_shard_dict->value->empty()) return 0;
+
+  auto const &dict        = *p_shard_dict->value;
+  size_t      usage       = 0;
+  const auto  sampled_num = dict.SampleEntries(
+      GetSampleStart(),
+      key_num,
+      [this, sample_num, &usage](Dict::value_type const &kv) {
+        usage += GetEntryMemoryUsage(kv.key, kv.value, sample_num, nullptr);
+      }
+  );
+
+  return sampled_num ? usage * dict.size() / sampled_num : 0;
+}
+
 ShardCode MmkvDb::GetShardKeys(shard_id_t shard_id, std::vector<String const *> &keys)
 {
   if (!mmkv_config().IsSharder()) return SC_NOT_SHARD_SERVER;
 
-  auto shard_keys = sdict_.Find(shard_id);
-  if (!shard_keys) return SC_NO_SHARD;
+  auto shard_dict = sdict_.Find(shard_id);
+  if (!shard_dict) return SC_NO_SHARD;
 
-  auto &_keys = shard_keys->value;
-  keys.reserve(_keys.size());
-  for (auto &key : _keys) {
-    keys.push_back(key);
+  auto &dict = *shard_dict->value;
+  keys.reserve(keys.size() + dict.size());
+  for (auto const &kv : dict) {
+    keys.push_back(&kv.key);
   }
 
   return SC_OK;
@@ -1273,15 +1575,14 @@ String MmkvDb::GetShardInfo()
 {
   String ret;
   char   buf[64];
-  for (auto &shard_keys : sdict_) {
-    auto  shard = shard_keys.key;
-    auto &keys  = shard_keys.value;
-    ret         += "shard ";
+  for (auto &shard_dict : sdict_) {
+    auto shard = shard_dict.key;
+    ret        += "shard ";
     snprintf(buf, sizeof buf, "%lu", shard);
     ret += buf;
     ret += " :";
-    for (auto key : keys) {
-      ret += *key;
+    for (auto const &kv : *shard_dict.value) {
+      ret += kv.key;
       ret += " ";
     }
     ret += '\n';
@@ -1292,7 +1593,18 @@ String MmkvDb::GetShardInfo()
   return ret;
 }
 
-void MmkvDb::DeleteAllShard() { sdict_.Clear(); }
+void MmkvDb::ClearAllShard()
+{
+  for (auto &shard_dict : sdict_)
+    shard_dict.value->Clear();
+}
+
+void MmkvDb::RemoveAllShard()
+{
+  sdict_.Clear();
+  migrating_shard_dict_.Clear();
+  importing_shard_id_set_.Clear();
+}
 
 void MmkvDb::UnlockAllShard() { locked_shard_id_set_.Clear(); }
 
@@ -1315,22 +1627,129 @@ bool MmkvDb::IsShardLocked(shard_id_t shard_id) const noexcept
 
 bool MmkvDb::HasShardLocked() const noexcept { return !locked_shard_id_set_.empty(); }
 
+void MmkvDb::StartShardMigration(shard_id_t shard_id)
+{
+  if (!migrating_shard_dict_.Find(shard_id)) {
+    migrating_shard_dict_.InsertKv(shard_id, MigratingShard());
+  }
+}
+
+void MmkvDb::SetShardMigrationPeer(shard_id_t shard_id, StringView endpoint)
+{
+  auto p_shard = migrating_shard_dict_.Find(shard_id);
+  if (p_shard) p_shard->value.peer_endpoint.assign(endpoint.data(), endpoint.size());
+}
+
+void MmkvDb::SendShardKeys(shard_id_t shard_id, String const *first, String const *last)
+{
+  auto p_shard = migrating_shard_dict_.Find(shard_id);
+  if (!p_shard) return;
+
+  AckShardKeys(shard_id);
+  auto &sending_keys = p_shard->value.sending_keys;
+  for (; first != last; ++first) {
+    sending_keys.Insert(*first);
+  }
+}
+
+void MmkvDb::AckShardKeys(shard_id_t shard_id)
+{
+  auto p_shard = migrating_shard_dict_.Find(shard_id);
+  if (!p_shard) return;
+
+  auto &shard = p_shard->value;
+  for (auto const &key : shard.sending_keys) {
+    shard.moved_keys.Insert(key);
+  }
+  shard.sending_keys.Clear();
+}
+
+void MmkvDb::StopShardMigration(shard_id_t shard_id) { migrating_shard_dict_.Erase(shard_id); }
+
+void MmkvDb::CancelShardMigration(shard_id_t shard_id)
+{
+  auto p_shard = migrating_shard_dict_.Find(shard_id);
+  if (!p_shard) return;
+
+  // Nothing is asked to the unknown peer
+  if (p_shard->value.peer_endpoint.empty()) {
+    migrating_shard_dict_.Erase(shard_id);
+    return;
+  }
+  p_shard->value.sending_keys.Clear();
+}
+
+bool MmkvDb::IsShardKeyMoved(shard_id_t shard_id, StringView key) const noexcept
+{
+  auto p_shard = migrating_shard_dict_.Find(shard_id);
+  return p_shard && p_shard->value.moved_keys.FindLike(key);
+}
+
+void MmkvDb::StartShardImport(shard_id_t shard_id)
+{
+  if (!importing_shard_id_set_.Find(shard_id)) importing_shard_id_set_.Insert(shard_id);
+}
+
+void MmkvDb::StopShardImport(shard_id_t shard_id) { importing_shard_id_set_.Erase(shard_id); }
+
+StatusCode MmkvDb::CheckShardMigrationSlow(
+    shard_id_t     shard_id,
+    StringView     key,
+    bool           is_write,
+    bool           is_asking,
+    String const **p_endpoint
+) noexcept
+{
+  if (!is_asking && importing_shard_id_set_.Find(shard_id)) return S_MOVED;
+
+  auto p_shard = migrating_shard_dict_.Find(shard_id);
+  if (!p_shard) return S_OK;
+
+  auto const &shard = p_shard->value;
+  if (shard.sending_keys.FindLike(key)) {
+    // The peer may apply it in any time, the value here is still the latest
+    return is_write || !FindEntry(key) ? S_SHARD_LOCKED : S_OK;
+  }
+
+  // The key created in the meantime is stored in the peer also,
+  // since the keys to be migrated are fixed when the migration is started
+  if (shard.moved_keys.FindLike(key) || !FindEntry(key)) {
+    if (shard.peer_endpoint.empty()) return S_SHARD_LOCKED;
+    *p_endpoint = &shard.peer_endpoint;
+    return S_ASK;
+  }
+  return S_OK;
+}
+
 void MmkvDb::DistributeKeysToShard()
 {
   assert(mmkv_config().SupportDistribution());
+  if (!mmkv_config().IsSharder()) return;
+
+  // The nodes are not reclaimed when relinking, thus the keys are valid
+  std::vector<String const *> keys;
+  keys.reserve(dict_.size());
   for (auto const &kv : dict_) {
-    sdict_[MakeShardId(kv.key)].Insert(&kv.key);
+    keys.push_back(&kv.key);
+  }
+
+  for (auto p_key : keys) {
+    auto node = dict_.Extract(*p_key);
+    assert(node);
+    auto success = GetDict(*p_key).Push(node);
+    (void)success;
+    assert(success);
   }
 
 #ifndef NDEBUG
   LOG_DEBUG << "The distribution of shards: ";
-  for (auto const &shardId_shardSet : sdict_) {
+  for (auto const &shard_dict : sdict_) {
     std::string key_msg;
-    for (auto const p_key : shardId_shardSet.value) {
+    for (auto const &kv : *shard_dict.value) {
       key_msg.append(1, ' ');
-      key_msg.append(p_key->data(), p_key->size());
+      key_msg.append(kv.key.data(), kv.key.size());
     }
-    LOG_DEBUG << "(" << shardId_shardSet.key << ")keys:" << key_msg;
+    LOG_DEBUG << "(" << shard_dict.key << ")keys:" << key_msg;
   }
 #endif
 }
@@ -17,6 +17,8 @@
 #include <kanon/util/noncopyable.h>
 #include <kanon/thread/rw_lock.h>
 
+#include <functional>
+
 namespace mmkv {
 namespace db {
 
@@ -29,13 +31,56 @@ using protocol::Shard;
 using protocol::ShardCode;
 using protocol::StatusCode;
 using protocol::StrKvs;
+using protocol::StrRefKvs;
+using protocol::StrRefValues;
 using protocol::StrValues;
+using protocol::StrViews;
 using protocol::WeightRange;
+using protocol::WeightRefValues;
 using protocol::WeightValues;
 using replacement::CacheInterface;
 
 #define DB_MIN(x, y) (((x) < (y)) ? (x) : (y))
 
+class MemoryReport;
+
+/**
+ * \brief The reason why the database drops the key by itself
+ */
+enum KeyDropReason : uint8_t {
+  KDR_EXPIRED = 0,
+  KDR_EVICTED,
+};
+
+/**
+ * \brief Called when the key is expired or evicted
+ * The lock of instance is held, thus the callback must not access the database,
+ * e.g. the DEL is recorded and logged once the lock is released.
+ */
+using KeyDropCallback = std::function<void(String key, KeyDropReason reason)>;
+
+/**
+ * \brief Register the callback of the keys dropped by all instances
+ * \note Not thread-safe, register it before the database is accessed
+ */
+void SetKeyDropCallback(KeyDropCallback cb);
+
+/**
+ * \brief Don't expire the keys lazily in this thread during the lifetime
+ * The expired key is read as is with its expiration, thus the reader
+ * holding the read lock doesn't drop keys, e.g. the dump of replication.
+ */
+class LazyExpirationPause {
+  DISABLE_EVIL_COPYABLE(LazyExpirationPause)
+
+ public:
+  LazyExpirationPause() noexcept;
+  ~LazyExpirationPause() noexcept;
+
+ private:
+  bool is_paused_; /** Whether it is paused already, i.e. nested */
+};
+
 /**
  * \brief Database instance of mmkv
  *
@@ -53,12 +98,15 @@ class MmkvDb {
   using Dict   = AvlDictionary<String, MmkvData, Comparator<String>>;
   using ExDict = AvlDictionary<String, uint64_t, Comparator<String>>;
 
-  using ShardIdSet = HashSet<String const *>;
-  using ShardDict  = AvlDictionary<shard_id_t, ShardIdSet, Comparator<shard_id_t>>;
+  /* The sub-keyspace is allocated individually,
+   * thus it is moved as a whole without touching the records */
+  using ShardDict = AvlDictionary<shard_id_t, std::unique_ptr<Dict>, Comparator<shard_id_t>>;
 
   std::string name_; /* For log */
 
-  /* Store all key-value records. */
+  /* Store all key-value records.
+   * If this is a sharder, the records are stored in the sub-keyspace
+   * of their shard(see sdict_) instead, and this is empty. */
   Dict dict_;
 
   /* Store the expiration time of key.
@@ -73,8 +121,9 @@ class MmkvDb {
 
   std::unique_ptr<CacheInterface<String const *>> cache_;
 
-  /* Record the shard => keys
-   * 保存的是在dict_中key的拷贝 */
+  /* Record the shard => sub-keyspace(i.e. the records of the shard)
+   * Enumerating, migrating or dropping a shard only visits its
+   * sub-keyspace, and the write path has no per-key bookkeeping. */
   ShardDict sdict_;
 
   /**
@@ -87,6 +136,26 @@ class MmkvDb {
    */
   HashSet<shard_id_t> locked_shard_id_set_;
 
+  /* The shard is migrated key by key, both nodes serve it in the meantime:
+   * - The keys not sent are served here
+   * - The keys in flight are readable but the writes are refused until acked
+   * - The keys moved(i.e. acked) or not here are asked to the peer
+   * The moved keys are kept until the shard is removed, thus the canceled
+   * migration keeps asking them and is resumed by the keys not moved. */
+  struct MigratingShard {
+    HashSet<String> moved_keys;
+    HashSet<String> sending_keys;
+    String          peer_endpoint; /** host:port of the peer, empty if unknown */
+  };
+
+  using MigratingShardDict = AvlDictionary<shard_id_t, MigratingShard, Comparator<shard_id_t>>;
+
+  MigratingShardDict migrating_shard_dict_;
+
+  /* The shards being migrated to this node
+   * Only the requests asked by the source(i.e. following ASKING) are served. */
+  HashSet<shard_id_t> importing_shard_id_set_;
+
  public:
   explicit MmkvDb(std::string name);
 
@@ -109,7 +178,7 @@ class MmkvDb {
   /**
    * \brief Determine if the database is empty
    */
-  bool IsEmpty() const noexcept { return dict_.empty(); }
+  bool IsEmpty() const noexcept { return GetKeyNum() == 0; }
 
   /**
    * \brief Get all keys in the database
@@ -117,6 +186,21 @@ class MmkvDb {
    */
   void GetAllKeys(StrValues &keys) const;
 
+  /**
+   * \brief Get some keys in the database incrementally
+   * The number of visited buckets is bounded, thus the caller
+   * can hold the lock only for a batch.
+   * \param cursor 0 indicates starting a new scan
+   * \param count The expected number of keys(may return more or less)
+   * \param[out] keys
+   * \return
+   *  The next cursor, 0 indicates the scan is completed
+   * \note
+   *  The keys exist during the whole scan are returned at least once
+   *  even if the dictionary is rehashed
+   */
+  size_t Scan(size_t cursor, size_t count, StrValues &keys) const;
+
   /**
    * \brief Remove entry from the database
    * \return
@@ -139,7 +223,7 @@ class MmkvDb {
    * \return
    *  true -- exists
    */
-  bool Type(String const &key, DataType &type) noexcept;
+  bool Type(StringView key, DataType &type) noexcept;
 
   /**
    * \brief Rename the existed key to new name
@@ -151,6 +235,51 @@ class MmkvDb {
    */
   StatusCode Rename(String const &old_name, String &&new_name);
 
+  /**
+   * \brief Like Rename() but the new name is stored in \p new_db
+   * The record is moved to \p new_db with its expiration time.
+   * The caller must lock both databases.
+   */
+  StatusCode Rename(String const &old_name, MmkvDb &new_db, String &&new_name);
+
+  /**
+   * \brief Estimate the memory footprint of \p key
+   * The footprint includes the entry node, key, value container
+   * and expiration entry.
+   * \param sample_num The max number of visited elements of container,
+   *                   0 indicates visiting all elements
+   * \param[out] usage The estimated bytes
+   * \return
+   *  S_OK
+   *  S_NONEXISTS
+   */
+  StatusCode MemoryUsage(StringView key, size_t sample_num, size_t &usage);
+
+  /**
+   * \brief Sample some keys start from a random position and add them to \p report
+   * The cost is bounded by \p key_num * \p sample_num, so the caller can
+   * sample a large keyspace in multiple rounds without holding the lock long.
+   * \param key_num The max number of sampled keys
+   * \param sample_num Same with MemoryUsage()
+   * \return The number of sampled keys, the keys sampled in the previous rounds
+   *         of \p report are excluded(see MemoryReport::Add())
+   */
+  size_t SampleMemoryUsage(size_t key_num, size_t sample_num, MemoryReport &report) const;
+
+  /**
+   * \brief Get the number of keys
+   */
+  size_t GetKeyNum() const noexcept;
+
+  size_t GetExpireKeyNum() const noexcept { return exp_dict_.size(); }
+
+  /**
+   * \brief Get the progress of the incremental rehash of the keyspace
+   * \return
+   *   false if the keyspace is not in rehashing
+   */
+  bool GetRehashProgress(size_t *moved_num, size_t *total_num) const noexcept;
+
   /*----------------------------------------------*/
   /* String API                                   */
   /*----------------------------------------------*/
@@ -179,7 +308,7 @@ class MmkvDb {
    *  S_EXISTS_DIFF_TYPE -- key exists but not string type
    *  S_NONEXISTS -- key doesn't exists
    */
-  StatusCode GetStr(String const &k, String *&str) noexcept;
+  StatusCode GetStr(StringView k, String *&str) noexcept;
 
   /**
    * If k doesn't exists, will insert it to dictionary
@@ -241,7 +370,7 @@ class MmkvDb {
    *  S_EXISTS_DIFF_TYPE
    *  S_NONEXISTS
    */
-  StatusCode ListGetSize(String const &k, size_t &size);
+  StatusCode ListGetSize(StringView k, size_t &size);
 
   /**
    * \brief Get all elements of list
@@ -250,7 +379,15 @@ class MmkvDb {
    *  S_EXISTS_DIFF_TYPE
    *  S_NONEXISTS
    */
-  StatusCode ListGetAll(String const &k, StrValues &values);
+  StatusCode ListGetAll(StringView k, StrValues &values);
+
+  /**
+   * \brief Get the references of all elements of list
+   * The references are valid until the list is modified.
+   * \return
+   *  Same with ListGetAll()
+   */
+  StatusCode ListGetAll(StringView k, StrRefValues &values);
 
   /**
    * \brief Get elements in a range
@@ -267,7 +404,7 @@ class MmkvDb {
    *  S_NONEXISTS
    *  S_INVALID_RANGE left > right and l >= size of list
    */
-  StatusCode ListGetRange(String const &k, StrValues &values, int64_t l, int64_t r);
+  StatusCode ListGetRange(StringView k, StrValues &values, int64_t l, int64_t r);
 
   /**
    * \brief Remove the elements in the tail of list
@@ -350,7 +487,7 @@ class MmkvDb {
    *  S_NONEXISTS
    *  S_EXISTS_DIFF_TYPE
    */
-  StatusCode VsetSize(String const &key, size_t &count);
+  StatusCode VsetSize(StringView key, size_t &count);
 
   /**
    * \brief Get the count of members between range in vset
@@ -360,7 +497,7 @@ class MmkvDb {
    *  S_NONEXISTS
    *  S_EXISTS_DIFF_TYPE
    */
-  StatusCode VsetSizeByWeight(String const &key, WeightRange range, size_t &count);
+  StatusCode VsetSizeByWeight(StringView key, WeightRange range, size_t &count);
 
   /**
    * \brief Get the weight of member
@@ -371,7 +508,7 @@ class MmkvDb {
    *  S_EXISTS_DIFF_TYPE
    *  S_VMEMBER_NONEXISTS
    */
-  StatusCode VsetWeight(String const &key, String const &member, Weight &w);
+  StatusCode VsetWeight(StringView key, StringView member, Weight &w);
 
   /**
    * \brief Get the order of member
@@ -382,7 +519,7 @@ class MmkvDb {
    *  S_EXISTS_DIFF_TYPE
    *  S_VMEMBER_NONEXISTS
    */
-  StatusCode VsetOrder(String const &key, String const &member, size_t &order);
+  StatusCode VsetOrder(StringView key, StringView member, size_t &order);
 
   /**
    * \brief Get the reversed order of member
@@ -393,7 +530,7 @@ class MmkvDb {
    *  S_EXISTS_DIFF_TYPE
    *  S_VMEMBER_NONEXISTS
    */
-  StatusCode VsetROrder(String const &key, String const &member, size_t &order);
+  StatusCode VsetROrder(StringView key, StringView member, size_t &order);
 
   /**
    * \brief Get All members in the vset
@@ -403,7 +540,26 @@ class MmkvDb {
    *  S_NONEXISTS
    *  S_EXISTS_DIFF_TYPE
    */
-  StatusCode VsetAll(String const &key, WeightValues &wms);
+  StatusCode VsetAll(StringView key, WeightValues &wms);
+
+  /**
+   * \brief Get the references of all members
+   * The references are valid until the vset is modified.
+   * \return
+   *  Same with VsetAll()
+   */
+  StatusCode VsetAll(StringView key, WeightRefValues &wms);
+
+  /**
+   * \brief Get some members in the vset incrementally(in no particular order)
+   * \param[in,out] cursor The cursor returned by the previous call, 0 for the first call
+   * \param count The expected number of members
+   * \param[out] wms
+   * \return
+   *  Same with VsetAll()
+   * \see Scan()
+   */
+  StatusCode VsetScan(StringView key, size_t &cursor, size_t count, WeightValues &wms);
 
   /**
    * \brief Get the members in the order range
@@ -413,7 +569,7 @@ class MmkvDb {
    *  S_NONEXISTS
    *  S_EXISTS_DIFF_TYPE
    */
-  StatusCode VsetRange(String const &key, OrderRange range, WeightValues &wms);
+  StatusCode VsetRange(StringView key, OrderRange range, WeightValues &wms);
 
   /**
    * \brief Get the members in the weight range
@@ -423,7 +579,7 @@ class MmkvDb {
    *  S_NONEXISTS
    *  S_EXISTS_DIFF_TYPE
    */
-  StatusCode VsetRangeByWeight(String const &key, WeightRange range, WeightValues &wms);
+  StatusCode VsetRangeByWeight(StringView key, WeightRange range, WeightValues &wms);
 
   /**
    * \brief Get the members in the reversed order range
@@ -433,7 +589,7 @@ class MmkvDb {
    *  S_NONEXISTS
    *  S_EXISTS_DIFF_TYPE
    */
-  StatusCode VsetRRange(String const &key, OrderRange range, WeightValues &wms);
+  StatusCode VsetRRange(StringView key, OrderRange range, WeightValues &wms);
 
   /**
    * \brief Get the members in the reversed weight range
@@ -443,7 +599,7 @@ class MmkvDb {
    *  S_NONEXISTS
    *  S_EXISTS_DIFF_TYPE
    */
-  StatusCode VsetRRangeByWeight(String const &key, WeightRange range, WeightValues &wms);
+  StatusCode VsetRRangeByWeight(StringView key, WeightRange range, WeightValues &wms);
 
   /*----------------------------------------------*/
   /* Map API                                      */
@@ -474,14 +630,15 @@ class MmkvDb {
    *  S_EXISTS_DIFF_TYPE
    *  S_FIELD_NONEXISTS
    */
-  StatusCode MapGet(String const &key, String const &field, String &value);
+  StatusCode MapGet(StringView key, StringView field, String &value);
 
   /**
    * \brief Get multiple fields
    * \return
    *  Same with MapGet()
    */
-  StatusCode MapGets(String const &key, StrValues const &fields, StrValues &values);
+  StatusCode MapGets(StringView key, StrValues const &fields, StrValues &values);
+  StatusCode MapGets(StringView key, StrViews const &fields, StrValues &values);
 
   /**
    * \brief Remove field from map
@@ -501,7 +658,26 @@ class MmkvDb {
    *  S_NONEXISTS
    *  S_EXISTS_DIFF_TYPE
    */
-  StatusCode MapAll(String const &key, StrKvs &kvs);
+  StatusCode MapAll(StringView key, StrKvs &kvs);
+
+  /**
+   * \brief Get the references of all field-value pairs
+   * The references are valid until the map is modified.
+   * \return
+   *  Same with MapAll()
+   */
+  StatusCode MapAll(StringView key, StrRefKvs &kvs);
+
+  /**
+   * \brief Get some field-value pairs in the map incrementally
+   * \param[in,out] cursor The cursor returned by the previous call, 0 for the first call
+   * \param count The expected number of pairs
+   * \param[out] kvs
+   * \return
+   *  Same with MapAll()
+   * \see Scan()
+   */
+  StatusCode MapScan(StringView key, size_t &cursor, size_t count, StrKvs &kvs);
 
   /**
    * \brief Get all fields in the map
@@ -509,7 +685,7 @@ class MmkvDb {
    * \return
    *  Same with MapAll()
    */
-  StatusCode MapFields(String const &key, StrValues &fields);
+  StatusCode MapFields(StringView key, StrValues &fields);
 
   /**
    * \brief Get all values in the map
@@ -517,7 +693,7 @@ class MmkvDb {
    * \return
    *  Same with MapAll()
    */
-  StatusCode MapValues(String const &key, StrValues &values);
+  StatusCode MapValues(StringView key, StrValues &values);
 
   /**
    * \brief Get the count of kvs in the map
@@ -525,7 +701,7 @@ class MmkvDb {
    * \return
    *  Same with MapAll()
    */
-  StatusCode MapSize(String const &key, size_t &count);
+  StatusCode MapSize(StringView key, size_t &count);
 
   /**
    * \brief Query if the field does exists
@@ -535,7 +711,7 @@ class MmkvDb {
    *  S_NONEXISTS
    *  S_EXISTS_DIFF_TYPE
    */
-  StatusCode MapExists(String const &key, String const &field);
+  StatusCode MapExists(StringView key, StringView field);
 
   /*----------------------------------------------*/
   /* Set API                                      */
@@ -575,7 +751,7 @@ class MmkvDb {
    * \return
    *  Same with SetDelm()
    */
-  StatusCode SetExists(String const &key, String const &member);
+  StatusCode SetExists(StringView key, StringView member);
 
   /**
    * \brief Get the size of set
@@ -585,7 +761,7 @@ class MmkvDb {
    *  S_EXISTS_DIFF_TYPE
    *  S_NONEXISTS
    */
-  StatusCode SetSize(String const &key, size_t &count);
+  StatusCode SetSize(StringView key, size_t &count);
 
   /**
    * \brief Get all the members in the set
@@ -593,7 +769,18 @@ class MmkvDb {
    * \return
    *  Same with SetSize()
    */
-  StatusCode SetAll(String const &key, StrValues &members);
+  StatusCode SetAll(StringView key, StrValues &members);
+
+  /**
+   * \brief Get some members in the set incrementally
+   * \param[in,out] cursor The cursor returned by the previous call, 0 for the first call
+   * \param count The expected number of members
+   * \param[out] members
+   * \return
+   *  Same with SetSize()
+   * \see Scan()
+   */
+  StatusCode SetScan(StringView key, size_t &cursor, size_t count, StrValues &members);
 
   /*----------------------------------------------*/
   /* Set operator API                             */
@@ -607,7 +794,10 @@ class MmkvDb {
    *  S_NONEXISTS
    *  S_EXISTS_DIFF_TYPE
    */
-  StatusCode SetAnd(String const &key1, String const &key2, StrValues &members);
+  StatusCode SetAnd(StringView key1, StringView key2, StrValues &members)
+  {
+    return SetAnd(key1, *this, key2, members);
+  }
 
   /**
    * \brief Get the union set between key1 and key2(key1 | key2)
@@ -615,7 +805,10 @@ class MmkvDb {
    * \return
    *  Same with SetAnd()
    */
-  StatusCode SetOr(String const &key, String const &key2, StrValues &members);
+  StatusCode SetOr(StringView key1, StringView key2, StrValues &members)
+  {
+    return SetOr(key1, *this, key2, members);
+  }
 
   /**
    * \brief Get the difference set between key1 and key2(key1 - key2)
@@ -623,7 +816,10 @@ class MmkvDb {
    * \return
    *  Same with SetSub()
    */
-  StatusCode SetSub(String const &key1, String const &key2, StrValues &members);
+  StatusCode SetSub(StringView key1, StringView key2, StrValues &members)
+  {
+    return SetSub(key1, *this, key2, members);
+  }
 
   /**
    * \brief Like SetAnd() but store the result to destination set
@@ -633,40 +829,79 @@ class MmkvDb {
    *  S_EXISTS_DIFF_TYPE
    *  S_DEST_EXISTS
    */
-  StatusCode SetAndTo(String const &key1, String const &key2, String &&dest);
+  StatusCode SetAndTo(String const &key1, String const &key2, String &&dest)
+  {
+    return SetAndTo(*this, key1, *this, key2, std::move(dest));
+  }
 
   /**
    * \return
    *  Same with SetAndTo()
    */
-  StatusCode SetOrTo(String const &key1, String const &key2, String &&dest);
+  StatusCode SetOrTo(String const &key1, String const &key2, String &&dest)
+  {
+    return SetOrTo(*this, key1, *this, key2, std::move(dest));
+  }
 
   /**
    * \return
    *  Same with SetAndTo()
    */
-  StatusCode SetSubTo(String const &key1, String const &key2, String &&dest);
+  StatusCode SetSubTo(String const &key1, String const &key2, String &&dest)
+  {
+    return SetSubTo(*this, key1, *this, key2, std::move(dest));
+  }
 
   /**
    * \brief Get the size of the intersection set
    * \return
    *  Same with SetAnd();
    */
-  StatusCode SetAndSize(String const &key1, String const &key2, size_t &count);
+  StatusCode SetAndSize(StringView key1, StringView key2, size_t &count)
+  {
+    return SetAndSize(key1, *this, key2, count);
+  }
 
   /**
    * \brief Get the size of the union set
    * \return
    *  Same with SetAnd();
    */
-  StatusCode SetOrSize(String const &key1, String const &key2, size_t &count);
+  StatusCode SetOrSize(StringView key1, StringView key2, size_t &count)
+  {
+    return SetOrSize(key1, *this, key2, count);
+  }
 
   /**
    * \brief Get the size of the difference set
    * \return
    *  Same with SetAnd();
    */
-  StatusCode SetSubSize(String const &key1, String const &key2, size_t &count);
+  StatusCode SetSubSize(StringView key1, StringView key2, size_t &count)
+  {
+    return SetSubSize(key1, *this, key2, count);
+  }
+
+  /*
+   * The set operations whose keys are stored in different databases,
+   * e.g. the instances of LOCAL_MULTI_THREAD mode.
+   * key1 is stored in this(or db1) and key2 is stored in db2, the destination
+   * is stored in this. The caller must lock all involved databases.
+   */
+  StatusCode SetAnd(StringView key1, MmkvDb &db2, StringView key2, StrValues &members);
+  StatusCode SetOr(StringView key1, MmkvDb &db2, StringView key2, StrValues &members);
+  StatusCode SetSub(StringView key1, MmkvDb &db2, StringView key2, StrValues &members);
+
+  StatusCode
+  SetAndTo(MmkvDb &db1, String const &key1, MmkvDb &db2, String const &key2, String &&dest);
+  StatusCode
+  SetOrTo(MmkvDb &db1, String const &key1, MmkvDb &db2, String const &key2, String &&dest);
+  StatusCode
+  SetSubTo(MmkvDb &db1, String const &key1, MmkvDb &db2, String const &key2, String &&dest);
+
+  StatusCode SetAndSize(StringView key1, MmkvDb &db2, StringView key2, size_t &count);
+  StatusCode SetOrSize(StringView key1, MmkvDb &db2, StringView key2, size_t &count);
+  StatusCode SetSubSize(StringView key1, MmkvDb &db2, StringView key2, size_t &count);
 
   /*----------------------------------------------*/
   /* Expiration management API                    */
@@ -717,7 +952,7 @@ class MmkvDb {
    *  S_OK
    *  S_NONEXISTS -- key is not set expiration time
    */
-  StatusCode GetExpiration(String const &key, uint64_t &exp);
+  StatusCode GetExpiration(StringView key, uint64_t &exp);
 
   /**
    * \brief Get the TTL of \p key
@@ -725,7 +960,7 @@ class MmkvDb {
    *  S_OK
    *  S_NONEXISTS -- key is not set expiration time
    */
-  StatusCode GetTimeToLive(String const &key, uint64_t &ttl);
+  StatusCode GetTimeToLive(StringView key, uint64_t &ttl);
 
   /**
    * \brief Make key persist in the database
@@ -752,6 +987,10 @@ class MmkvDb {
   ShardDict::const_iterator ShardBegin() const noexcept { return sdict_.begin(); }
   ShardDict::const_iterator ShardEnd() const noexcept { return sdict_.end(); }
 
+  /**
+   * \brief Move the records in dict_ to the sub-keyspaces of their shards
+   * The nodes are relinked, the records are not copied.
+   */
   void DistributeKeysToShard();
 
   void UnlockAllShard();
@@ -783,12 +1022,104 @@ class MmkvDb {
 
   /**
    * Remove the shard from database
+   * The sub-keyspace of the shard is dropped as a whole.
    * \param shard_id  id of shard
    */
   void RemoveShard(shard_id_t shard_id);
 
   bool HasShard(shard_id_t shard);
 
+  /**
+   * \brief Remove all shards with their migration and import state
+   * The records must be deleted by DeleteAll() first, e.g. the node leaves the cluster.
+   */
+  void RemoveAllShard();
+
+  /**
+   * \brief Estimate the memory usage of the shard by sampling
+   * The usage of at most \p key_num keys is sampled and scaled by the key number.
+   * \param sample_num Same with MemoryUsage()
+   * \return 0 if the shard doesn't exists or is empty
+   */
+  size_t EstimateShardMemoryUsage(shard_id_t shard_id, size_t key_num, size_t sample_num) const;
+
+  /**
+   * \brief Start migrating the shard key by key
+   * The requests to the keys not here are refused(S_SHARD_LOCKED) until
+   * the peer is known(see SetShardMigrationPeer()).
+   */
+  void StartShardMigration(shard_id_t shard_id);
+
+  /**
+   * \brief Set the mmkvd endpoint(host:port) of the peer the keys asked to
+   */
+  void SetShardMigrationPeer(shard_id_t shard_id, StringView endpoint);
+
+  /**
+   * \brief The keys are sent to the peer, refuse the writes to them
+   * The keys sent before(if any) are acked, i.e. applied by the peer.
+   */
+  void SendShardKeys(shard_id_t shard_id, String const *first, String const *last);
+
+  /**
+   * \brief The keys sent are applied by the peer, ask the requests to them
+   */
+  void AckShardKeys(shard_id_t shard_id);
+
+  /**
+   * \brief Forget the progress, i.e. serve all keys here again
+   */
+  void StopShardMigration(shard_id_t shard_id);
+
+  /**
+   * \brief The peer is down, serve the keys in flight here again
+   * The moved keys and the keys created in the peer are still asked to it,
+   * since the writes to them are only applied by the peer.
+   */
+  void CancelShardMigration(shard_id_t shard_id);
+
+  bool IsShardKeyMoved(shard_id_t shard_id, StringView key) const noexcept;
+
+  bool IsShardMigrating(shard_id_t shard_id) const noexcept
+  {
+    return migrating_shard_dict_.Find(shard_id);
+  }
+
+  /**
+   * \brief The shard is migrated to this node, refuse the requests not asked
+   */
+  void StartShardImport(shard_id_t shard_id);
+  void StopShardImport(shard_id_t shard_id);
+
+  bool IsShardImporting(shard_id_t shard_id) const noexcept
+  {
+    return importing_shard_id_set_.Find(shard_id);
+  }
+
+  /**
+   * \brief Check whether the request to the key is served by this node
+   * \param is_write The request modifies the key
+   * \param is_asking The request is asked by the source of shard
+   * \param p_endpoint Set to the peer endpoint if S_ASK is returned
+   * \return
+   *  S_OK -- Serve it
+   *  S_ASK -- The key is moved or not here, ask the peer
+   *  S_SHARD_LOCKED -- The key is sending or the peer is unknown, retry later
+   *  S_MOVED -- The shard is importing and the request isn't asked
+   */
+  StatusCode CheckShardMigration(
+      shard_id_t     shard_id,
+      StringView     key,
+      bool           is_write,
+      bool           is_asking,
+      String const **p_endpoint
+  ) noexcept
+  {
+    // Fast path: most of time no shard is migrating
+    if (migrating_shard_dict_.empty() && importing_shard_id_set_.empty()) return protocol::S_OK;
+    return CheckShardMigrationSlow(shard_id, key, is_write, is_asking, p_endpoint);
+  }
+
   /**
    * Get all keys in the mapped shard
    */
@@ -809,6 +1140,14 @@ class MmkvDb {
    */
   void TryReplacekey(String const *key);
 
+  StatusCode CheckShardMigrationSlow(
+      shard_id_t     shard_id,
+      StringView     key,
+      bool           is_write,
+      bool           is_asking,
+      String const **p_endpoint
+  ) noexcept;
+
   /**
    * \brief Add a key to the cache
    */
@@ -829,7 +1168,17 @@ class MmkvDb {
    *  true -- Key has expired, indicates also remove key from dict_
    *  false -- Key is not expired, or lazy expiration check is disable
    */
-  bool CheckExpire(String const &key);
+  bool CheckExpire(StringView key);
+
+  /**
+   * \brief Like MemoryUsage() but the entry is known
+   */
+  size_t GetEntryMemoryUsage(
+      String const   &key,
+      MmkvData const &data,
+      size_t          sample_num,
+      size_t         *elem_num
+  ) const;
 
   /*----------------------------------------------*/
   /* Shard management API                         */
@@ -837,18 +1186,49 @@ class MmkvDb {
 
   MMKV_INLINE bool HasShardLocked() const noexcept;
 
+  /* Clear the records of all shards but keep the shards owned */
+  MMKV_INLINE void ClearAllShard();
+
+  /**
+   * \brief Get the keyspace that stores the key
+   * If this is a sharder, the sub-keyspace of the shard is created if it isn't here.
+   */
+  Dict &GetDict(StringView key);
+
+  /**
+   * \brief Like GetDict() but return nullptr if the shard isn't here
+   */
+  Dict *FindDict(StringView key) noexcept;
+
+  /**
+   * \brief Find the record of the key in its keyspace
+   */
+  Dict::value_type *FindEntry(StringView key)
+  {
+    auto dict = FindDict(key);
+    return dict ? dict->FindLike(key) : nullptr;
+  }
+
   /**
-   * Insert the key to the mapped shard.
-   * \param key Exists in the database
+   * \brief Extract the node of the key from its keyspace
+   * The node must be reclaimed by Dict::DropNode()
    */
-  MMKV_INLINE void AddKeyToShard(String const *key);
+  Dict::Node *ExtractNode(String const &key)
+  {
+    auto dict = FindDict(key);
+    return dict ? dict->Extract(key) : nullptr;
+  }
 
   /**
-   * Remove the key record from the mapped shard
-   * \param key Exists in the database
+   * \brief Apply the callback to dict_ and all sub-keyspaces
    */
-  MMKV_INLINE void RemoveKeyFromShard(String const *key);
-  MMKV_INLINE void DeleteAllShard();
+  template <typename Cb>
+  void ForEachDict(Cb cb) const
+  {
+    cb(dict_);
+    for (auto const &shard_dict : sdict_)
+      cb(*shard_dict.value);
+  }
 };
 
 } // namespace db
@@ -0,0 +1,196 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "memory_usage.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+#include "vset.h"
+#include "mmkv/util/conv.h"
+
+using namespace mmkv::db;
+using namespace mmkv::util;
+
+/* The capacity of empty string is the capacity of SSO buffer */
+static const size_t kSsoCapacity = String().capacity();
+
+size_t mmkv::db::GetStringFootprint(String const &str) noexcept
+{
+  return str.capacity() > kSsoCapacity ? str.capacity() + 1 : 0;
+}
+
+/* Extrapolate the bytes of all elements from the sampled elements */
+static inline size_t Extrapolate(size_t sampled_bytes, size_t sampled_num, size_t total_num)
+{
+  if (sampled_num == 0 || sampled_num == total_num) return sampled_bytes;
+  return (size_t)((double)sampled_bytes / sampled_num * total_num);
+}
+
+#define SAMPLE_ELEMENTS_ROUTINE(container, elem_footprint)                                         \
+  do {                                                                                             \
+    for (auto const &elem : (container)) {                                                         \
+      if (sample_num != 0 && sampled_num == sample_num) break;                                     \
+      sampled_bytes += (elem_footprint);                                                           \
+      ++sampled_num;                                                                               \
+    }                                                                                              \
+  } while (0)
+
+size_t mmkv::db::EstimateMmkvDataFootprint(
+    MmkvData const &data,
+    size_t          sample_num,
+    size_t         *elem_num
+)
+{
+  size_t sampled_bytes = 0;
+  size_t sampled_num   = 0;
+  size_t total_num     = 0;
+  size_t ret           = 0;
+
+  switch (data.type) {
+    case D_STRING: {
+      /* The string is regarded as one element */
+      auto const *str = (String const *)data.any_data;
+      total_num       = 1;
+      ret             = sizeof(String) + GetStringFootprint(*str);
+    } break;
+
+    case D_STRLIST: {
+      auto const *list = (StrList const *)data.any_data;
+      total_num        = list->size();
+      SAMPLE_ELEMENTS_ROUTINE(*list, GetStringFootprint(elem));
+      ret = sizeof(StrList) + sizeof(StrList::Node) * total_num +
+            Extrapolate(sampled_bytes, sampled_num, total_num);
+    } break;
+
+    case D_SORTED_SET: {
+      /* The member is stored in the dictionary,
+       * the tree only store the pointer to it */
+      auto const *vset = (Vset const *)data.any_data;
+      total_num        = vset->GetSize();
+      SAMPLE_ELEMENTS_ROUTINE(vset->tree(), GetStringFootprint(*elem.value));
+      ret = sizeof(Vset) + vset->dict().GetBucketsFootprint() +
+            (sizeof(Vset::Tree::Node) + sizeof(Vset::Dict::Node)) * total_num +
+            Extrapolate(sampled_bytes, sampled_num, total_num);
+    } break;
+
+    case D_MAP: {
+      auto const *map = (Map const *)data.any_data;
+      total_num       = map->size();
+      SAMPLE_ELEMENTS_ROUTINE(*map, GetStringFootprint(elem.key) + GetStringFootprint(elem.value));
+      ret = sizeof(Map) + map->GetBucketsFootprint() + sizeof(Map::Node) * total_num +
+            Extrapolate(sampled_bytes, sampled_num, total_num);
+    } break;
+
+    case D_SET: {
+      auto const *set = (Set const *)data.any_data;
+      total_num       = set->size();
+      SAMPLE_ELEMENTS_ROUTINE(*set, GetStringFootprint(elem));
+      ret = sizeof(Set) + set->GetBucketsFootprint() + sizeof(Set::Node) * total_num +
+            Extrapolate(sampled_bytes, sampled_num, total_num);
+    } break;
+
+    default:
+      break;
+  }
+
+  if (elem_num) *elem_num = total_num;
+  return ret;
+}
+
+MemoryReport::MemoryReport(size_t top_num)
+  : top_num_(top_num)
+  , sampled_key_num_(0)
+  , total_key_num_(0)
+{
+  ::memset(type_usage_, 0, sizeof type_usage_);
+  ::memset(type_key_num_, 0, sizeof type_key_num_);
+  ::memset(type_elem_num_, 0, sizeof type_elem_num_);
+  top_keys_.reserve(top_num_ + 1);
+}
+
+bool MemoryReport::Add(String const &key, DataType type, size_t usage, size_t elem_num)
+{
+  /* The key may be sampled in the previous round */
+  if (!sampled_keys_.Insert(key)) return false;
+
+  sampled_key_num_++;
+  type_usage_[type] += usage;
+  type_key_num_[type]++;
+  type_elem_num_[type] += elem_num;
+
+  if (top_num_ == 0) return true;
+  if (top_keys_.size() == top_num_ && top_keys_.back().usage >= usage) return true;
+
+  /* top_num_ is small, insertion sort is enough */
+  auto pos = std::find_if(top_keys_.begin(), top_keys_.end(), [usage](KeyMemoryUsage const &ku) {
+    return ku.usage < usage;
+  });
+  top_keys_.insert(pos, KeyMemoryUsage{key, type, usage, elem_num});
+  if (top_keys_.size() > top_num_) top_keys_.pop_back();
+  return true;
+}
+
+#define MEMORY_REPORT_BUF_SIZE 512
+
+String MemoryReport::ToString() const
+{
+  String ret;
+  char   buf[MEMORY_REPORT_BUF_SIZE];
+
+  ret.append("========== Memory Report ==========\n");
+  ::snprintf(buf, sizeof buf, "Sampled keys = %zu/%zu\n", sampled_key_num_, total_key_num_);
+  ret.append(buf);
+
+  size_t sampled_usage = 0;
+  for (int i = 0; i < DATA_TYPE_NUM; ++i) {
+    sampled_usage += type_usage_[i];
+  }
+
+  auto estimated_usage =
+      format_memory_usage(Extrapolate(sampled_usage, sampled_key_num_, total_key_num_));
+  ::snprintf(
+      buf,
+      sizeof buf,
+      "Estimated usage = %.3f %s\n",
+      estimated_usage.usage,
+      memory_unit2str(estimated_usage.unit)
+  );
+  ret.append(buf);
+
+  ret.append("---------- By type ----------\n");
+  for (int i = 0; i < DATA_TYPE_NUM; ++i) {
+    if (type_key_num_[i] == 0) continue;
+    auto usage = format_memory_usage(type_usage_[i]);
+    ::snprintf(
+        buf,
+        sizeof buf,
+        "[%s]: keys = %zu, usage = %.3f %s, avg element size = %zu B\n",
+        GetDataTypeString((DataType)i),
+        type_key_num_[i],
+        usage.usage,
+        memory_unit2str(usage.unit),
+        type_elem_num_[i] == 0 ? 0 : type_usage_[i] / type_elem_num_[i]
+    );
+    ret.append(buf);
+  }
+
+  ret.append("---------- Top keys ----------\n");
+  for (size_t i = 0; i < top_keys_.size(); ++i) {
+    auto const &ku = top_keys_[i];
+    ::snprintf(
+        buf,
+        sizeof buf,
+        "[%zu]: %.*s (%s, %zu elements) = %zu B\n",
+        i,
+        (int)std::min<size_t>(ku.key.size(), 64),
+        ku.key.data(),
+        GetDataTypeString(ku.type),
+        ku.elem_num,
+        ku.usage
+    );
+    ret.append(buf);
+  }
+  ret.append("===================================\n");
+
+  return ret;
+}
@@ -0,0 +1,100 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_DB_MEMORY_USAGE_H_
+#define _MMKV_DB_MEMORY_USAGE_H_
+
+#include <stddef.h>
+#include <vector>
+
+#include "data_type.h"
+#include "mmkv_data.h"
+#include "type.h"
+
+namespace mmkv {
+namespace db {
+
+#define MEMORY_USAGE_DEFAULT_SAMPLE_NUM 64
+#define MEMORY_REPORT_DEFAULT_KEY_NUM   1024
+#define MEMORY_REPORT_DEFAULT_TOP_NUM   10
+
+/* The number of the data type */
+#define DATA_TYPE_NUM D_TYPE_NUM
+
+/**
+ * \brief Get the heap memory occupied by the string
+ * The short string is stored in the string object itself(SSO),
+ * so it is not counted.
+ */
+size_t GetStringFootprint(String const &str) noexcept;
+
+/**
+ * \brief Estimate the memory footprint of the value container
+ * Only the first \p sample_num elements are visited,
+ * the size of the remaining elements is extrapolated from
+ * the average size of the visited elements.
+ *
+ * \param sample_num The max number of visited elements, 0 indicates visiting all elements
+ * \param[out] elem_num The number of elements in the container
+ * \return The estimated bytes of the container(including the object itself)
+ */
+size_t EstimateMmkvDataFootprint(MmkvData const &data, size_t sample_num, size_t *elem_num);
+
+struct KeyMemoryUsage {
+  String   key;
+  DataType type;
+  size_t   usage;
+  size_t   elem_num;
+};
+
+/**
+ * \brief Memory usage report of the sampled keyspace
+ *
+ * The report is accumulated by multiple rounds of sampling,
+ * the same key may be sampled in different rounds, but it is
+ * only recorded once, i.e. the keys are sampled without replacement.
+ */
+class MemoryReport {
+ public:
+  explicit MemoryReport(size_t top_num = MEMORY_REPORT_DEFAULT_TOP_NUM);
+
+  /**
+   * \brief Add a sampled key to the report
+   * \return
+   *  false if the key has been sampled in the previous round
+   */
+  bool Add(String const &key, DataType type, size_t usage, size_t elem_num);
+
+  /**
+   * \brief Add the total key number of the database that is sampled
+   * It is used for extrapolating the total usage.
+   */
+  void AddTotalKeyNum(size_t key_num) noexcept { total_key_num_ += key_num; }
+
+  size_t sampled_key_num() const noexcept { return sampled_key_num_; }
+  size_t total_key_num() const noexcept { return total_key_num_; }
+  size_t usage(DataType type) const noexcept { return type_usage_[type]; }
+  size_t key_num(DataType type) const noexcept { return type_key_num_[type]; }
+  size_t elem_num(DataType type) const noexcept { return type_elem_num_[type]; }
+
+  /**
+   * \brief The largest keys in descending order of usage
+   */
+  std::vector<KeyMemoryUsage> const &top_keys() const noexcept { return top_keys_; }
+
+  String ToString() const;
+
+ private:
+  size_t top_num_;
+  size_t sampled_key_num_;
+  size_t total_key_num_;
+  size_t type_usage_[DATA_TYPE_NUM];
+  size_t type_key_num_[DATA_TYPE_NUM];
+  size_t type_elem_num_[DATA_TYPE_NUM];
+
+  std::vector<KeyMemoryUsage> top_keys_;
+  algo::HashSet<String>       sampled_keys_;
+};
+
+} // namespace db
+} // namespace mmkv
+
+#endif // _MMKV_DB_MEMORY_USAGE_H_
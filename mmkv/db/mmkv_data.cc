@@ -27,6 +27,8 @@ void DeleteMmkvData(MmkvData &data)
     case D_SET:
       delete (Set *)data.any_data;
       break;
+    default:
+      break;
   }
 }
 
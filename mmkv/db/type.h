@@ -7,6 +7,7 @@
 #include "mmkv/algo/libc_allocator_with_realloc.h"
 #include "mmkv/algo/string.h"
 #include "mmkv/algo/blist.h"
+#include <kanon/string/string_view.h>
 #include "mmkv/protocol/mmbp.h"
 #include "data_type.h"
 
@@ -15,6 +16,7 @@ namespace db {
 
 using protocol::Weight;
 using String = algo::String;
+using kanon::StringView;
 using StrList = algo::Blist<String, algo::LibcAllocatorWithRealloc<String>>;
 using Map = algo::Dictionary<String, String>;
 using Set = algo::HashSet<String>;
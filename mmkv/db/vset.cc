@@ -82,24 +82,25 @@ size_t Vset::EraseRangeByWeight(Weight left, Weight right)
   return ret;
 }
 
-bool Vset::GetWeight(String const &member, Weight &w)
+bool Vset::GetWeight(StringView member, Weight &w)
 {
-  auto kv = dict_.Find(member);
+  auto kv = dict_.FindLike(member);
   if (!kv) return false;
 
   w = kv->value;
   return true;
 }
 
-bool Vset::GetOrder(String const &member, size_t &order)
+bool Vset::GetOrder(StringView member, size_t &order)
 {
-  Weight w;
-  if (!GetWeight(member, w)) return false;
+  auto kv = dict_.FindLike(member);
+  if (!kv) return false;
 
+  // The tree node refers to the member in the dictionary
   auto first = tree_.begin();
   order = 0;
   for (;;) {
-    if (first->key == w && *first->value == member) break;
+    if (first->value == &kv->key) break;
     order++;
     ++first;
   }
@@ -107,15 +108,15 @@ bool Vset::GetOrder(String const &member, size_t &order)
   return true;
 }
 
-bool Vset::GetROrder(String const &member, size_t &order)
+bool Vset::GetROrder(StringView member, size_t &order)
 {
-  Weight w;
-  if (!GetWeight(member, w)) return false;
+  auto kv = dict_.FindLike(member);
+  if (!kv) return false;
 
   auto first = tree_.before_end();
   order = 0;
   for (;;) {
-    if (first->key == w && *first->value == member) break;
+    if (first->value == &kv->key) break;
     order++;
     --first;
   }
@@ -208,3 +209,11 @@ void Vset::GetAll(WeightValues &values)
     values.push_back({wm.key, *(wm.value)});
   });
 }
+
+void Vset::GetAll(WeightRefValues &values)
+{
+  values.reserve(tree_.size());
+  tree_.DoInAll([&values](Tree::value_type const &wm) {
+    values.push_back({wm.key, wm.value});
+  });
+}
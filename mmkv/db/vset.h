@@ -19,6 +19,7 @@ namespace db {
 using algo::AvlTree;
 using algo::Dictionary;
 using algo::KeyValue;
+using protocol::WeightRefValues;
 using protocol::WeightValues;
 
 /*
@@ -31,10 +32,11 @@ class Vset {
       return (x > y) ? 1 : ((x == y) ? 0 : -1);
     }
   };
-  
-  using Tree = AvlTree<double, KeyValue<double, String*>, DoubleComparator>;
 
  public:
+  using Tree = AvlTree<double, KeyValue<double, String*>, DoubleComparator>;
+  using Dict = Dictionary<String, double>;
+
   Vset() = default;
   explicit Vset(WeightValues& values) {
     for (auto& wm : values)
@@ -49,23 +51,26 @@ class Vset {
   size_t EraseRange(int64_t left, int64_t right);
   size_t EraseRangeByWeight(Weight left, Weight right);
 
-  bool GetWeight(String const& member, Weight& w);
-  bool GetOrder(String const& member, size_t& order); 
-  bool GetROrder(String const& member, size_t& order);
+  bool GetWeight(StringView member, Weight& w);
+  bool GetOrder(StringView member, size_t& order); 
+  bool GetROrder(StringView member, size_t& order);
 
   size_t GetSize() const noexcept { assert(tree_.size() == dict_.size()); return tree_.size(); }
 
   size_t GetSizeByWeight(Weight left, Weight right);
   void GetRange(int64_t left, int64_t right, WeightValues& values);
   void GetAll(WeightValues& values);
+  void GetAll(WeightRefValues& values);
   void GetRangeByWeight(Weight left, Weight right, WeightValues& values);
   void GetRRange(int64_t left, int64_t right, WeightValues& values);
   void GetRRangeByWeight(Weight left, Weight right, WeightValues& values);
 
   Tree& tree() noexcept { return tree_; } 
+  Tree const& tree() const noexcept { return tree_; }
+  Dict const& dict() const noexcept { return dict_; }
  private: 
   Tree tree_;
-  Dictionary<String, double> dict_;
+  Dict dict_;
 };
 
 } // db
@@ -50,6 +50,12 @@ int InitCommandType() noexcept
   REGISTER_WRITE_CMD(EXPIREM_AFTER);
   REGISTER_WRITE_CMD(SRANDDELM);
   REGISTER_WRITE_CMD(PERSIST);
+  REGISTER_WRITE_CMD(BATCH);
+  // The scripts are replayed when recovering, thus the loaded scripts are logged also
+  REGISTER_WRITE_CMD(EVAL);
+  REGISTER_WRITE_CMD(EVALSHA);
+  REGISTER_WRITE_CMD(SCRIPT_LOAD);
+  REGISTER_WRITE_CMD(SCRIPT_FLUSH);
 
   return 0;
 }
@@ -3,6 +3,7 @@
 
 #include <assert.h>
 
+#include "mmkv/protocol/mmbp_batch.h"
 #include "mmkv/protocol/mmbp_request.h"
 #include "mmkv/server/config.h"
 #include "mmkv/storage/db.h"
@@ -30,6 +31,7 @@ void Recover::ParseFromRequest()
 
   size_t n = 0;
   MmbpRequest request;
+  MmbpBatchRequest batch;
 
   while ((n = file_.Read(buffer.GetWriteBegin(), buffer.GetWritableSize())) !=
          (size_t)-1)
@@ -38,6 +40,13 @@ void Recover::ParseFromRequest()
     while (buffer.GetReadableSize() >= sizeof(uint32_t)) {
       auto size = buffer.Read32();
       if (buffer.GetReadableSize() >= size - sizeof(size)) {
+        // The batch is a single record
+        if (request.PeekCommand(buffer) == BATCH) {
+          batch.ParseFrom(buffer);
+          database_manager().ExecuteBatch(batch, nullptr);
+          continue;
+        }
+
         request.ParseFrom(buffer);
         database_manager().Execute(request, nullptr);
         assert(GetCommandType((Command)request.command) == CT_WRITE);
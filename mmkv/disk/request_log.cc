@@ -2,13 +2,12 @@
 #include "request_log.h"
 
 #include <unistd.h>
+#include <vector>
 
-#include "mmkv/protocol/mmbp_request.h"
 #include "mmkv/server/config.h"
 
 using namespace mmkv::disk;
 using namespace mmkv::server;
-using namespace mmkv::protocol;
 using namespace kanon;
 
 // RequestLog *mmkv::disk::g_rlog = nullptr;
@@ -67,15 +66,3 @@ void RequestLog::Start()
 
   latch_.Wait();
 }
-
-void RequestLog::AppendDel(String key)
-{
-  MmbpRequest request;
-  Buffer buffer;
-  request.SetKey();
-  request.key = std::move(key);
-  request.command = DEL;
-  request.SerializeTo(buffer);
-  buffer.Prepend32(buffer.GetReadableSize());
-  Append(buffer.GetReadBegin(), buffer.GetReadableSize());
-}
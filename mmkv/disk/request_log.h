@@ -40,17 +40,21 @@ class RequestLog {
   void Append(void const *data, size_t len) noexcept
   {
     MutexGuard g(empty_lock_);
+    AppendUnlocked(data, len);
+  }
 
-    if (len <= cur_blk_.avali()) {
-      cur_blk_.Append((char const *)data, len);
-    } else {
-      const auto writable = cur_blk_.avali();
-      cur_blk_.Append((char const *)data, cur_blk_.avali());
-      blks_.emplace_back(std::move(cur_blk_));
-      empty_cond_.Notify();
-      cur_blk_.reset();
-      cur_blk_.Append((char const *)data + writable, len - writable);
-    }
+  /**
+   * \brief Append the record with its 32-bit length header
+   * The header and record are appended atomically,
+   * thus the records of different threads are not interleaved.
+   */
+  void AppendRecord(void const *data, uint32_t len) noexcept
+  {
+    const auto nlen = kanon::sock::ToNetworkByteOrder32(len);
+
+    MutexGuard g(empty_lock_);
+    AppendUnlocked(&nlen, sizeof nlen);
+    AppendUnlocked(data, len);
   }
 
   void Append16(uint16_t i)
@@ -80,14 +84,22 @@ class RequestLog {
     io_thread_.Join();
   }
 
-  /**
-   * \brief Append MMBP request "Del key" to file
-   * The method can't append mutiple "del key" to file efficiently
-   * since can't reuse the Buffer and MmbpRequest object.
-   */
-  void AppendDel(String key);
-
  private:
+  void AppendUnlocked(void const *data, size_t len) noexcept
+  {
+    // The record may be larger than a block
+    while (len > cur_blk_.avali()) {
+      const auto writable = cur_blk_.avali();
+      cur_blk_.Append((char const *)data, writable);
+      blks_.emplace_back(std::move(cur_blk_));
+      empty_cond_.Notify();
+      cur_blk_.reset();
+      data = (char const *)data + writable;
+      len -= writable;
+    }
+    cur_blk_.Append((char const *)data, len);
+  }
+
   void Flush() noexcept
   {
     file_.Flush();
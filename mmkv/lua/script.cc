@@ -0,0 +1,518 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "script.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <memory>
+
+#include <lua.hpp>
+#include <xxhash.h>
+
+#include "mmkv/protocol/resp_command.h"
+#include "mmkv/protocol/status_code.h"
+#include "mmkv/util/conv.h"
+#include "mmkv/util/time_util.h"
+
+using namespace mmkv::lua;
+using namespace mmkv::protocol;
+using namespace kanon;
+
+/* The compiled scripts of the lua state, indexed by hash */
+#define SCRIPTS_REGISTRY_KEY "mmkv_scripts"
+
+/* The engine owning the lua state, used by the hook */
+#define ENGINE_REGISTRY_KEY "mmkv_engine"
+
+/* The time limit is checked per the instructions */
+#define SCRIPT_HOOK_COUNT 1000
+
+std::string mmkv::lua::GetScriptHash(StringView script)
+{
+  char buf[32];
+  const auto len =
+      ::snprintf(buf, sizeof buf, "%016" PRIx64, (uint64_t)XXH64(script.data(), script.size(), 0));
+  return std::string(buf, len);
+}
+
+std::string ScriptCache::Load(StringView script)
+{
+  auto hash = GetScriptHash(script);
+
+  MutexGuard guard(mutex_);
+  if (scripts_.find(hash) == scripts_.end()) {
+    scripts_.emplace(hash, std::string(script.data(), script.size()));
+  }
+  return hash;
+}
+
+bool ScriptCache::Get(std::string const &hash, std::string &script)
+{
+  MutexGuard guard(mutex_);
+  auto       iter = scripts_.find(hash);
+  if (iter == scripts_.end()) return false;
+  script = iter->second;
+  return true;
+}
+
+void ScriptCache::Flush()
+{
+  MutexGuard guard(mutex_);
+  scripts_.clear();
+  ++generation_;
+}
+
+uint64_t ScriptCache::generation()
+{
+  MutexGuard guard(mutex_);
+  return generation_;
+}
+
+size_t ScriptCache::size()
+{
+  MutexGuard guard(mutex_);
+  return scripts_.size();
+}
+
+namespace mmkv {
+namespace lua {
+
+ScriptCache &script_cache()
+{
+  static ScriptCache cache;
+  return cache;
+}
+
+} // namespace lua
+} // namespace mmkv
+
+namespace {
+
+/* Push the array of strings in [first, last) */
+void PushStrArray(lua_State *L, StrValues const &values, size_t first, size_t last)
+{
+  lua_createtable(L, last - first, 0);
+  for (size_t i = first; i < last; ++i) {
+    lua_pushlstring(L, values[i].data(), values[i].size());
+    lua_rawseti(L, -2, i - first + 1);
+  }
+}
+
+/* The conversion is same with the RESP reply(see SerializeRespResponse())
+ * \return The number of results, -1 if the response is a error and the message is pushed */
+int PushResponse(lua_State *L, MmbpResponse const &response, RespReply reply)
+{
+  const auto code = (StatusCode)response.status_code;
+
+  if (code != S_OK) {
+    const bool is_miss = IsMissStatus(code);
+    switch (reply) {
+      case RR_BOOL:
+      case RR_ZERO_ON_MISS:
+        if (!is_miss) break;
+        lua_pushinteger(L, 0);
+        return 1;
+      case RR_EMPTY_ON_MISS:
+      case RR_EMPTY_MAP_ON_MISS:
+        if (!is_miss && code != S_INVALID_RANGE) break;
+        lua_newtable(L);
+        return 1;
+      case RR_TTL_SECONDS:
+      case RR_TTL_MS:
+        if (!is_miss) break;
+        lua_pushinteger(L, -1);
+        return 1;
+      default:
+        if (!is_miss) break;
+        lua_pushboolean(L, 0);
+        return 1;
+    }
+
+    lua_pushstring(L, GetStatusMessage(code));
+    return -1;
+  }
+
+  switch (reply) {
+    case RR_OK:
+      lua_pushliteral(L, "OK");
+      return 1;
+    case RR_BOOL:
+      lua_pushinteger(L, 1);
+      return 1;
+    case RR_DOUBLE:
+      lua_pushnumber(L, mmkv::util::int2double(response.count));
+      return 1;
+    case RR_TTL_SECONDS:
+      lua_pushinteger(L, (response.count + 500) / 1000);
+      return 1;
+    default:
+      break;
+  }
+
+  // {cursor, batch}
+  if (response.HasCursor()) {
+    char       buf[32];
+    const auto len = ::snprintf(buf, sizeof buf, "%" PRIu64, response.count);
+    lua_createtable(L, 2, 0);
+    lua_pushlstring(L, buf, len);
+    lua_rawseti(L, -2, 1);
+  }
+
+  if (response.HasValue()) {
+    lua_pushlstring(L, response.value.data(), response.value.size());
+  } else if (response.HasValues()) {
+    PushStrArray(L, response.values, 0, response.values.size());
+  } else if (response.HasKvs()) {
+    auto const &kvs = response.kvs;
+    lua_createtable(L, kvs.size() << 1, 0);
+    for (size_t i = 0; i < kvs.size(); ++i) {
+      lua_pushlstring(L, kvs[i].key.data(), kvs[i].key.size());
+      lua_rawseti(L, -2, (i << 1) + 1);
+      lua_pushlstring(L, kvs[i].value.data(), kvs[i].value.size());
+      lua_rawseti(L, -2, (i << 1) + 2);
+    }
+  } else if (response.HasVmembers()) {
+    auto const &wms         = response.vmembers;
+    const bool  member_only = reply == RR_MEMBERS;
+    lua_createtable(L, member_only ? wms.size() : wms.size() << 1, 0);
+    int index = 0;
+    for (auto const &wm : wms) {
+      lua_pushlstring(L, wm.value.data(), wm.value.size());
+      lua_rawseti(L, -2, ++index);
+      if (member_only) continue;
+      lua_pushnumber(L, wm.key);
+      lua_rawseti(L, -2, ++index);
+    }
+  } else if (response.HasCount()) {
+    lua_pushinteger(L, response.count);
+  } else {
+    lua_pushliteral(L, "OK");
+  }
+
+  if (response.HasCursor()) lua_rawseti(L, -2, 2);
+  return 1;
+}
+
+/* Convert the value in the top of stack to response */
+void ToResponse(lua_State *L, MmbpResponse &response)
+{
+  switch (lua_type(L, -1)) {
+    case LUA_TNIL:
+      response.status_code = S_NONEXISTS;
+      break;
+    case LUA_TBOOLEAN:
+      response.status_code = lua_toboolean(L, -1) ? S_OK : S_NONEXISTS;
+      break;
+    case LUA_TNUMBER:
+      response.SetOk();
+      response.SetCount();
+      response.count = (uint64_t)(int64_t)lua_tonumber(L, -1);
+      break;
+    case LUA_TSTRING: {
+      size_t len;
+      auto   str = lua_tolstring(L, -1, &len);
+      response.SetOk();
+      response.SetValue();
+      response.value.assign(str, len);
+    } break;
+    case LUA_TTABLE: {
+      lua_getfield(L, -1, "err");
+      if (lua_type(L, -1) == LUA_TSTRING) {
+        size_t len;
+        auto   str          = lua_tolstring(L, -1, &len);
+        response.status_code = S_SCRIPT_ERROR;
+        response.SetValue();
+        response.value.assign(str, len);
+        lua_pop(L, 1);
+        break;
+      }
+      lua_pop(L, 1);
+
+      response.SetOk();
+      response.SetValues();
+      for (int i = 1;; ++i) {
+        lua_rawgeti(L, -1, i);
+        size_t len;
+        auto   str = lua_type(L, -1) == LUA_TNIL ? nullptr : lua_tolstring(L, -1, &len);
+        if (!str) {
+          lua_pop(L, 1);
+          break;
+        }
+        response.values.emplace_back(str, len);
+        lua_pop(L, 1);
+      }
+    } break;
+    default:
+      response.status_code = S_SCRIPT_ERROR;
+      response.SetValue();
+      response.value = "The return type of script is not supported";
+  }
+}
+
+class ScriptEngine {
+  DISABLE_EVIL_COPYABLE(ScriptEngine)
+
+ public:
+  ScriptEngine();
+  ~ScriptEngine() noexcept { lua_close(state_); }
+
+  void Run(
+      std::string const           &hash,
+      StrValues const             &keys_args,
+      size_t                       key_num,
+      ScriptCommandCallback const &cb,
+      long                         time_limit_ms,
+      MmbpResponse                &response
+  );
+
+ private:
+  /* The lua_error() is called in these without any C++ object alive */
+  static int  LuaCall(lua_State *L);
+  static int  LuaPcall(lua_State *L);
+  static void LuaHook(lua_State *L, lua_Debug *ar);
+
+  int Call(lua_State *L);
+
+  /* Push the compiled script, or set the error to response */
+  bool PushScript(std::string const &hash, MmbpResponse &response);
+
+  lua_State                   *state_;
+  uint64_t                     generation_;
+  ScriptCommandCallback const *cb_;
+  RespArgs                     args_; /** Reused */
+  long                         time_limit_ms_;
+  int64_t                      deadline_us_; /** monotonic */
+};
+
+ScriptEngine::ScriptEngine()
+  : state_(luaL_newstate())
+  , generation_(script_cache().generation())
+  , cb_(nullptr)
+  , time_limit_ms_(0)
+  , deadline_us_(0)
+{
+  auto L = state_;
+
+  // The io and os are not opened since the script must be deterministic
+  static luaL_Reg const libs[] = {
+      {"_G", luaopen_base},
+      {LUA_TABLIBNAME, luaopen_table},
+      {LUA_STRLIBNAME, luaopen_string},
+      {LUA_MATHLIBNAME, luaopen_math},
+      {nullptr, nullptr},
+  };
+  for (auto lib = libs; lib->func; ++lib) {
+    luaL_requiref(L, lib->name, lib->func, 1);
+    lua_pop(L, 1);
+  }
+  lua_pushnil(L);
+  lua_setglobal(L, "dofile");
+  lua_pushnil(L);
+  lua_setglobal(L, "loadfile");
+
+  // mmkv.call() and mmkv.pcall(), redis is an alias for the portability
+  static luaL_Reg const funcs[] = {
+      {"call", &ScriptEngine::LuaCall},
+      {"pcall", &ScriptEngine::LuaPcall},
+      {nullptr, nullptr},
+  };
+  lua_newtable(L);
+  lua_pushlightuserdata(L, this);
+  luaL_setfuncs(L, funcs, 1);
+  lua_pushvalue(L, -1);
+  lua_setglobal(L, "redis");
+  lua_setglobal(L, "mmkv");
+
+  lua_newtable(L);
+  lua_setfield(L, LUA_REGISTRYINDEX, SCRIPTS_REGISTRY_KEY);
+
+  lua_pushlightuserdata(L, this);
+  lua_setfield(L, LUA_REGISTRYINDEX, ENGINE_REGISTRY_KEY);
+}
+
+int ScriptEngine::LuaCall(lua_State *L)
+{
+  auto       engine = (ScriptEngine *)lua_touserdata(L, lua_upvalueindex(1));
+  const auto n      = engine->Call(L);
+  if (n < 0) return lua_error(L);
+  return n;
+}
+
+int ScriptEngine::LuaPcall(lua_State *L)
+{
+  auto       engine = (ScriptEngine *)lua_touserdata(L, lua_upvalueindex(1));
+  const auto n      = engine->Call(L);
+  if (n < 0) {
+    lua_pushnil(L);
+    lua_insert(L, -2);
+    return 2;
+  }
+  return n;
+}
+
+void ScriptEngine::LuaHook(lua_State *L, lua_Debug *)
+{
+  lua_getfield(L, LUA_REGISTRYINDEX, ENGINE_REGISTRY_KEY);
+  auto engine = (ScriptEngine *)lua_touserdata(L, -1);
+  lua_pop(L, 1);
+
+  if (mmkv::util::GetMonotonicTimeUs() < engine->deadline_us_) return;
+
+  // The error may be caught by pcall() in the script,
+  // it is raised again in the next instruction until the script is aborted
+  lua_sethook(L, &ScriptEngine::LuaHook, LUA_MASKCOUNT, 1);
+  luaL_error(L, "ERR the script exceeds the time limit(%d ms)", (int)engine->time_limit_ms_);
+}
+
+int ScriptEngine::Call(lua_State *L)
+{
+  const int argc = lua_gettop(L);
+  if (argc < 1) {
+    lua_pushliteral(L, "ERR wrong number of arguments of mmkv.call()");
+    return -1;
+  }
+
+  // The numbers are converted to strings in place, thus the views are valid in the call
+  args_.clear();
+  for (int i = 1; i <= argc; ++i) {
+    size_t len;
+    auto   str = lua_type(L, i) == LUA_TSTRING || lua_type(L, i) == LUA_TNUMBER
+                     ? lua_tolstring(L, i, &len)
+                     : nullptr;
+    if (!str) {
+      lua_pushliteral(L, "ERR the arguments of mmkv.call() must be strings or numbers");
+      return -1;
+    }
+    args_.emplace_back(str, len);
+  }
+
+  auto cmd = GetRespCommand(args_[0]);
+  if (!cmd || cmd->builtin != RB_NONE) {
+    lua_pushfstring(L, "ERR unknown command '%s' called from script", lua_tostring(L, 1));
+    return -1;
+  }
+
+  MmbpRequest request;
+  RespReply   reply;
+  auto        errmsg = ParseRespRequest(*cmd, args_, request, reply);
+  if (!errmsg) {
+    MmbpResponse response;
+    errmsg = (*cb_)(request, response);
+    if (!errmsg) return PushResponse(L, response, reply);
+  }
+
+  lua_pushstring(L, errmsg);
+  return -1;
+}
+
+bool ScriptEngine::PushScript(std::string const &hash, MmbpResponse &response)
+{
+  auto L = state_;
+
+  // The scripts are flushed by other thread
+  const auto generation = script_cache().generation();
+  if (generation_ != generation) {
+    generation_ = generation;
+    lua_newtable(L);
+    lua_setfield(L, LUA_REGISTRYINDEX, SCRIPTS_REGISTRY_KEY);
+  }
+
+  lua_getfield(L, LUA_REGISTRYINDEX, SCRIPTS_REGISTRY_KEY);
+  lua_getfield(L, -1, hash.c_str());
+  if (lua_isfunction(L, -1)) {
+    lua_remove(L, -2);
+    return true;
+  }
+  lua_pop(L, 1);
+
+  std::string script;
+  if (!script_cache().Get(hash, script)) {
+    response.status_code = S_SCRIPT_NONEXISTS;
+    lua_pop(L, 1);
+    return false;
+  }
+
+  if (luaL_loadbuffer(L, script.data(), script.size(), "@script") != LUA_OK) {
+    response.status_code = S_SCRIPT_ERROR;
+    response.SetValue();
+    response.value = lua_tostring(L, -1);
+    lua_pop(L, 2);
+    return false;
+  }
+
+  lua_pushvalue(L, -1);
+  lua_setfield(L, -3, hash.c_str());
+  lua_remove(L, -2);
+  return true;
+}
+
+void ScriptEngine::Run(
+    std::string const           &hash,
+    StrValues const             &keys_args,
+    size_t                       key_num,
+    ScriptCommandCallback const &cb,
+    long                         time_limit_ms,
+    MmbpResponse                &response
+)
+{
+  auto       L   = state_;
+  const auto top = lua_gettop(L);
+
+  if (!PushScript(hash, response)) return;
+
+  // _ENV = setmetatable({KEYS = ..., ARGV = ...}, {__index = _G})
+  lua_createtable(L, 0, 2);
+  PushStrArray(L, keys_args, 0, key_num);
+  lua_setfield(L, -2, "KEYS");
+  PushStrArray(L, keys_args, key_num, keys_args.size());
+  lua_setfield(L, -2, "ARGV");
+  lua_createtable(L, 0, 1);
+  lua_pushglobaltable(L);
+  lua_setfield(L, -2, "__index");
+  lua_setmetatable(L, -2);
+  // The _ENV is the first upvalue of the main chunk
+  if (!lua_setupvalue(L, -2, 1)) lua_pop(L, 1);
+
+  lua_getglobal(L, "math");
+  lua_getfield(L, -1, "randomseed");
+  lua_pushinteger(L, 0);
+  lua_call(L, 1, 0);
+  lua_pop(L, 1);
+
+  // The instance locks are held by the script, the endless script stalls the others
+  if (time_limit_ms > 0) {
+    time_limit_ms_ = time_limit_ms;
+    deadline_us_   = mmkv::util::GetMonotonicTimeUs() + time_limit_ms * 1000;
+    lua_sethook(L, &ScriptEngine::LuaHook, LUA_MASKCOUNT, SCRIPT_HOOK_COUNT);
+  }
+
+  cb_ = &cb;
+  if (lua_pcall(L, 0, 1, 0) != LUA_OK) {
+    response.status_code = S_SCRIPT_ERROR;
+    response.SetValue();
+    response.value = lua_tostring(L, -1);
+  } else {
+    ToResponse(L, response);
+  }
+  cb_ = nullptr;
+  lua_sethook(L, nullptr, 0, 0);
+
+  lua_settop(L, top);
+}
+
+} // namespace
+
+void mmkv::lua::RunScript(
+    std::string const           &hash,
+    StrValues const             &keys_args,
+    size_t                       key_num,
+    ScriptCommandCallback const &cb,
+    long                         time_limit_ms,
+    MmbpResponse                &response
+)
+{
+  // The lua state is not thread-safe, each thread has its own
+  static thread_local std::unique_ptr<ScriptEngine> engine;
+  if (!engine) engine.reset(new ScriptEngine);
+
+  engine->Run(hash, keys_args, key_num, cb, time_limit_ms, response);
+}
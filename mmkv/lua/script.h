@@ -0,0 +1,112 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_LUA_SCRIPT_H_
+#define _MMKV_LUA_SCRIPT_H_
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include "mmkv/protocol/mmbp_request.h"
+#include "mmkv/protocol/mmbp_response.h"
+
+#include <kanon/string/string_view.h>
+#include <kanon/thread/mutex_lock.h>
+#include <kanon/util/noncopyable.h>
+
+namespace mmkv {
+namespace lua {
+
+using kanon::StringView;
+using protocol::MmbpRequest;
+using protocol::MmbpResponse;
+using protocol::StrValues;
+
+/**
+ * \brief Execute a command called by the script
+ * \return nullptr if success, otherwise the error message raised in the script
+ */
+using ScriptCommandCallback = std::function<char const *(MmbpRequest &, MmbpResponse &)>;
+
+/**
+ * \brief The hash of script(hex of XXH64)
+ */
+std::string GetScriptHash(StringView script);
+
+/**
+ * \brief The scripts loaded by EVAL and SCRIPTLOAD
+ * The scripts are shared by all threads,
+ * but each thread compiles the script in its own lua state.
+ *
+ * \note Thread-safe
+ */
+class ScriptCache {
+  DISABLE_EVIL_COPYABLE(ScriptCache)
+
+ public:
+  ScriptCache() = default;
+
+  /**
+   * \brief Cache the script
+   * \return The hash of script
+   */
+  std::string Load(StringView script);
+
+  bool Get(std::string const &hash, std::string &script);
+
+  /** The compiled scripts of each thread are discarded also */
+  void Flush();
+
+  /** Increased once flushed */
+  uint64_t generation();
+
+  size_t size();
+
+ private:
+  kanon::MutexLock                             mutex_;
+  std::unordered_map<std::string, std::string> scripts_;
+  uint64_t                                     generation_ = 0;
+};
+
+ScriptCache &script_cache();
+
+/**
+ * \brief Run the cached script in the lua state of the calling thread
+ *
+ * The keys and arguments are exposed as KEYS and ARGV(1-based) like redis.
+ * The commands are called by mmkv.call(command, args...), the names and
+ * arguments are same with the RESP commands(e.g. mmkv.call('zadd', KEYS[1], 1, 'a')),
+ * mmkv.pcall() returns nil and the error message instead of raising error.
+ * The return value is converted to the response:
+ *  - nil, false -> S_NONEXISTS
+ *  - true       -> S_OK
+ *  - number     -> count(integer)
+ *  - string     -> value
+ *  - table      -> values(the array part, stop at the first nil),
+ *                  {err = msg} -> S_SCRIPT_ERROR
+ *
+ * The script runs in a fresh environment each time, thus the global variables
+ * are not kept, and the math.random is reseeded, i.e. the script is deterministic
+ * and can be replayed from the request log.
+ *
+ * If the script runs longer than \p time_limit_ms, it is aborted with S_SCRIPT_ERROR.
+ * The writes executed before aborting are kept, i.e. the script isn't rolled back.
+ *
+ * \param keys_args The first \p key_num are keys, the others are arguments
+ * \param cb Execute the command called by the script,
+ *           the caller determines which keys are allowed
+ * \param time_limit_ms 0 is unlimited
+ */
+void RunScript(
+    std::string const           &hash,
+    StrValues const             &keys_args,
+    size_t                       key_num,
+    ScriptCommandCallback const &cb,
+    long                         time_limit_ms,
+    MmbpResponse                &response
+);
+
+} // namespace lua
+} // namespace mmkv
+
+#endif // _MMKV_LUA_SCRIPT_H_
@@ -39,7 +39,14 @@ std::string mmkv::protocol::detail::command_strings[] = {
     "RENAME",      "TYPE",
     "KEYALL",      "DELS",
     "DELALL",      "SHARD_JOIN",
-    "SHARD_LEAVE",
+    "SHARD_LEAVE", "MEMUSAGE",
+    "MEMREPORT",   "SCAN",
+    "MSCAN",       "SSCAN",
+    "VSCAN",       "BATCH",
+    "INFO",        "SLOWLOG",
+    "SLOWLOGRESET", "EVAL",
+    "EVALSHA",     "SCRIPTLOAD",
+    "SCRIPTFLUSH", "ASKING",
 };
 
 static_assert(
@@ -88,6 +88,21 @@ enum Command : uint16_t {
   DELALL,
   SHARD_JOIN,
   SHARD_LEAVE,
+  MEM_USAGE,
+  MEM_REPORT,
+  SCAN,
+  MSCAN,
+  SSCAN,
+  VSCAN,
+  BATCH,
+  INFO,
+  SLOWLOG,
+  SLOWLOG_RESET,
+  EVAL,
+  EVALSHA,
+  SCRIPT_LOAD,
+  SCRIPT_FLUSH,
+  ASKING,
   COMMAND_NUM,
 };
 
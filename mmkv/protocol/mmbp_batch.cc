@@ -0,0 +1,108 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "mmbp_batch.h"
+#include "mmkv/protocol/mmbp_util.h"
+#include "mmkv/protocol/status_code.h"
+
+#include <kanon/log/logger.h>
+
+using namespace mmkv::protocol;
+using namespace kanon;
+
+/* The request or response has the command(status code) and has_bits at least,
+ * each of them is encoded in one byte at least */
+static constexpr size_t MIN_MESSAGE_SIZE = 2;
+
+MmbpBatchRequest::MmbpBatchRequest()
+  : command(BATCH)
+{
+}
+
+MmbpBatchRequest::~MmbpBatchRequest() noexcept {}
+
+void MmbpBatchRequest::SerializeTo(Buffer &buffer) const
+{
+  SerializeComponent(command, buffer);
+  SerializeComponent((uint32_t)requests.size(), buffer);
+  for (auto const &request : requests)
+    request.SerializeTo(buffer);
+}
+
+void MmbpBatchRequest::SerializeTo(ChunkList &buffer) const
+{
+  SerializeComponent(command, buffer);
+  SerializeComponent((uint32_t)requests.size(), buffer);
+  for (auto const &request : requests)
+    request.SerializeTo(buffer);
+}
+
+void MmbpBatchRequest::ParseFrom(Buffer &buffer)
+{
+  uint32_t count = 0;
+  ParseComponent(command, buffer);
+  ParseComponent(count, buffer);
+
+  requests.clear();
+  // The count comes from the peer, it can't exceed the requests in the buffer
+  if (count > buffer.GetReadableSize() / MIN_MESSAGE_SIZE) {
+    LOG_ERROR << "The batch count " << count << " exceeds the readable bytes";
+    return;
+  }
+  requests.resize(count);
+  for (auto &request : requests)
+    request.ParseFrom(buffer);
+}
+
+void MmbpBatchRequest::DebugPrint() const noexcept
+{
+  LOG_DEBUG << "Batch request count: " << requests.size();
+  for (auto const &request : requests)
+    request.DebugPrint();
+}
+
+MmbpBatchResponse::MmbpBatchResponse()
+  : status_code(-1)
+{
+}
+
+MmbpBatchResponse::~MmbpBatchResponse() noexcept {}
+
+void MmbpBatchResponse::SerializeTo(Buffer &buffer) const
+{
+  SerializeComponent(status_code, buffer);
+  SerializeComponent((uint32_t)responses.size(), buffer);
+  for (auto const &response : responses)
+    response.SerializeTo(buffer);
+}
+
+void MmbpBatchResponse::SerializeTo(ChunkList &buffer) const
+{
+  SerializeComponent(status_code, buffer);
+  SerializeComponent((uint32_t)responses.size(), buffer);
+  for (auto const &response : responses)
+    response.SerializeTo(buffer);
+}
+
+void MmbpBatchResponse::ParseFrom(Buffer &buffer)
+{
+  uint32_t count = 0;
+  ParseComponent(status_code, buffer);
+  ParseComponent(count, buffer);
+
+  responses.clear();
+  if (count > buffer.GetReadableSize() / MIN_MESSAGE_SIZE) {
+    LOG_ERROR << "The batch count " << count << " exceeds the readable bytes";
+    status_code = S_INVALID_REQUEST;
+    return;
+  }
+  responses.resize(count);
+  for (auto &response : responses)
+    response.ParseFrom(buffer);
+}
+
+void MmbpBatchResponse::DebugPrint() const noexcept
+{
+  LOG_DEBUG << "Batch StatusCode: " << status_code;
+  LOG_DEBUG << "Batch response count: " << responses.size();
+  for (auto const &response : responses)
+    response.DebugPrint();
+}
@@ -0,0 +1,68 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_PROTOCOL_MMBP_BATCH_H_
+#define _MMKV_PROTOCOL_MMBP_BATCH_H_
+
+#include <vector>
+
+#include "mmbp_request.h"
+#include "mmbp_response.h"
+
+namespace mmkv {
+namespace protocol {
+
+/**
+ * The batch request carries multiple keyed requests which are executed atomically,
+ * i.e. the locks of all touched instances are held until all requests are executed.
+ *
+ * Format: command(BATCH) | count | request1 | request2...
+ * The command field makes it distinguishable from MmbpRequest by PeekCommand().
+ * The count exceeding the readable bytes fails the parse, the requests are empty then.
+ */
+class MmbpBatchRequest : public MmbpMessage {
+ public:
+  MmbpBatchRequest();
+  ~MmbpBatchRequest() noexcept override;
+
+  void SerializeTo(ChunkList &buffer) const override;
+  void SerializeTo(Buffer &buffer) const override;
+
+  void ParseFrom(Buffer &buffer) override;
+
+  MmbpMessage *New() const override { return new MmbpBatchRequest(); }
+
+  void DebugPrint() const noexcept;
+
+  uint16_t                 command; // BATCH
+  std::vector<MmbpRequest> requests;
+};
+
+/**
+ * The responses are in the same order with the requests of the batch.
+ *
+ * Format: status_code | count | response1 | response2...
+ * If the status_code is not S_OK, the batch is rejected and no request is executed.
+ * The count exceeding the readable bytes fails the parse, the status_code is
+ * S_INVALID_REQUEST and the responses are empty then.
+ */
+class MmbpBatchResponse : public MmbpMessage {
+ public:
+  MmbpBatchResponse();
+  ~MmbpBatchResponse() noexcept override;
+
+  void SerializeTo(ChunkList &buffer) const override;
+  void SerializeTo(Buffer &buffer) const override;
+
+  void ParseFrom(Buffer &buffer) override;
+
+  MmbpMessage *New() const override { return new MmbpBatchResponse(); }
+
+  void DebugPrint() const noexcept;
+
+  uint8_t                   status_code;
+  std::vector<MmbpResponse> responses;
+};
+
+} // namespace protocol
+} // namespace mmkv
+
+#endif // _MMKV_PROTOCOL_MMBP_BATCH_H_
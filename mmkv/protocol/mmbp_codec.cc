@@ -3,6 +3,7 @@
 #include "mmbp.h"
 #include "mmbp_response.h"
 #include "status_code.h"
+#include "mmkv/util/crc32c.h"
 
 #include <xxhash.h>
 
@@ -13,13 +14,20 @@ static constexpr uint8_t CHECKSUM_LENGTH = sizeof(MmbpCodec::CheckSumType);
 static constexpr uint32_t MAX_SIZE = 1 << 26; // 64MB
 static constexpr char const MMBP_TAG[] = "MMBP";
 static constexpr uint8_t MMBP_TAG_SIZE = sizeof(MMBP_TAG) - 1;
+
+/* Indexed by ChecksumAlgo, the prefix "MMB" is shared */
+static constexpr char const *CHECKSUM_ALGO_TAGS[] = {"MMBP", "MMBC", "MMBN"};
+static constexpr char const *CHECKSUM_ALGO_STRS[] = {"xxhash", "crc32c", "none"};
 static constexpr uint32_t MIN_SIZE = MMBP_TAG_SIZE + CHECKSUM_LENGTH;
 
 using namespace kanon;
 using namespace mmkv::protocol;
+using mmkv::util::Crc32c;
+using mmkv::util::Crc32cExtend;
 
 MmbpCodec::MmbpCodec(MmbpMessage *prototype)
   : prototype_(prototype)
+  , checksum_algo_(CA_XXHASH32)
 {
   SetErrorCallback([](TcpConnectionPtr const &conn, ErrorCode error_code) {
     String error_msg = GetErrorString(error_code);
@@ -42,9 +50,18 @@ MmbpCodec::MmbpCodec(MmbpMessage *prototype, TcpConnectionPtr const &conn)
   SetUpConnection(conn);
 }
 
+static inline bool IsLoopbackPeer(TcpConnectionPtr const &conn)
+{
+  const auto ip = conn->GetPeerAddr().ToIp();
+  return ip.compare(0, 4, "127.") == 0 || ip == "::1";
+}
+
 void MmbpCodec::SetUpConnection(TcpConnectionPtr const &conn)
 {
-  conn->SetMessageCallback([this](TcpConnectionPtr const &conn, Buffer &buffer,
+  // The frame without checksum is trusted only if it is from loopback
+  const bool is_loopback = IsLoopbackPeer(conn);
+
+  conn->SetMessageCallback([this, is_loopback](TcpConnectionPtr const &conn, Buffer &buffer,
                                   TimeStamp recv_time) {
     if (buffer.GetReadableSize() >= MAX_SIZE) {
       LOG_WARN << "A single message too large, just discard";
@@ -90,25 +107,26 @@ void MmbpCodec::SetUpConnection(TcpConnectionPtr const &conn)
       // buffer.AdvanceRead32();
       buffer.AdvanceRead(size_header_len);
 
+      // The tag indicates the checksum algorithm
+      const auto algo = GetTagChecksumAlgo(buffer.GetReadBegin());
+      if (algo == CA_NUM) {
+        error_cb_(conn, E_INVALID_MESSAGE);
+        break;
+      }
+
       // BUG FIX:
       // If peer send invalid message whose length over size_header and
       // MIN_SIZE, then can reach this. In this case, size_header is a untrusted
       // field. Such message should discard.
-
-      if (!VerifyCheckSum(buffer, size_header)) {
+      if ((algo == CA_NONE && !is_loopback) || !VerifyCheckSum(buffer, size_header, algo)) {
         error_cb_(conn, E_INVALID_CHECKSUM);
         break;
       }
 
-      if (::memcmp(buffer.GetReadBegin(), MMBP_TAG, MMBP_TAG_SIZE) != 0) {
-        error_cb_(conn, E_INVALID_MESSAGE);
-        break;
-      }
-
       buffer.AdvanceRead(MMBP_TAG_SIZE);
 
       message_cb_(conn, buffer, size_header - MMBP_TAG_SIZE - CHECKSUM_LENGTH,
-                  recv_time);
+                  algo, recv_time);
       buffer.AdvanceRead32(); // checksum
     }
   });
@@ -142,10 +160,12 @@ MmbpCodec::ErrorCode MmbpCodec::Parse(Buffer &buffer, MmbpMessage *message)
         return E_INVALID_SIZE_HEADER;
       }
 
-      if (VerifyCheckSum(buffer, size_header)) {
-        if (::memcmp(buffer.GetReadBegin(), MMBP_TAG, MMBP_TAG_SIZE) != 0) {
-          return E_INVALID_MESSAGE;
-        }
+      const auto algo = GetTagChecksumAlgo(buffer.GetReadBegin());
+      if (algo == CA_NUM) {
+        return E_INVALID_MESSAGE;
+      }
+
+      if (VerifyCheckSum(buffer, size_header, algo)) {
 
         buffer.AdvanceRead(MMBP_TAG_SIZE);
         message = prototype_->New();
@@ -171,28 +191,50 @@ void MmbpCodec::Send(TcpConnection *conn, MmbpMessage const *message)
   conn->Send(buffer);
 }
 
-void MmbpCodec::SerializeTo(MmbpMessage const *message, OutputBuffer &buffer)
+static MmbpCodec::CheckSumType CalculateChunksCheckSum(OutputBuffer &buffer, MmbpCodec::ChecksumAlgo algo)
 {
-  buffer.Append(MMBP_TAG, MMBP_TAG_SIZE);
-  message->SerializeTo(buffer);
+  switch (algo) {
+    case MmbpCodec::CA_XXHASH32: {
+      auto state = XXH32_createState();
+
+      auto ok = XXH32_reset(state, 0) != XXH_ERROR;
+      (void)ok;
+      assert(ok && "XXH32_reset() error");
+
+      for (auto const &chunk : buffer) {
+        LOG_DEBUG << "chunk readable size = " << chunk.GetReadableSize();
+        ok = XXH32_update(state, chunk.GetReadBegin(), chunk.GetReadableSize()) !=
+             XXH_ERROR;
+        assert(ok && "XXH32_update");
+      }
 
-  auto state = XXH32_createState();
+      MmbpCodec::CheckSumType checksum = XXH32_digest(state);
+      XXH32_freeState(state);
+      return checksum;
+    }
 
-  auto ok = XXH32_reset(state, 0) != XXH_ERROR;
-  (void)ok;
-  assert(ok && "XXH32_reset() error");
+    case MmbpCodec::CA_CRC32C: {
+      MmbpCodec::CheckSumType checksum = 0;
+      for (auto const &chunk : buffer) {
+        checksum = Crc32cExtend(checksum, chunk.GetReadBegin(), chunk.GetReadableSize());
+      }
+      return checksum;
+    }
 
-  for (auto const &chunk : buffer) {
-    LOG_DEBUG << "chunk readable size = " << chunk.GetReadableSize();
-    ok = XXH32_update(state, chunk.GetReadBegin(), chunk.GetReadableSize()) !=
-         XXH_ERROR;
-    assert(ok && "XXH32_update");
+    default:
+      return 0;
   }
+}
 
-  CheckSumType checksum = XXH32_digest(state);
-  LOG_DEBUG << "checksum = " << checksum;
+void MmbpCodec::SerializeTo(MmbpMessage const *message, OutputBuffer &buffer, ChecksumAlgo algo)
+{
+  buffer.Append(CHECKSUM_ALGO_TAGS[algo], MMBP_TAG_SIZE);
+  message->SerializeTo(buffer);
 
-  XXH32_freeState(state);
+  // The checksum field is reserved even if algo is CA_NONE,
+  // then the frame layout is same.
+  CheckSumType checksum = CalculateChunksCheckSum(buffer, algo);
+  LOG_DEBUG << "checksum = " << checksum;
 
   buffer.Append32(checksum);
 
@@ -201,12 +243,15 @@ void MmbpCodec::SerializeTo(MmbpMessage const *message, OutputBuffer &buffer)
   buffer.Prepend(kvarint_buf.buf, kvarint_buf.len);
 }
 
-bool MmbpCodec::VerifyCheckSum(Buffer &buffer, SizeHeaderType size_header)
+bool MmbpCodec::VerifyCheckSum(Buffer &buffer, SizeHeaderType size_header, ChecksumAlgo algo)
 {
   LOG_DEBUG << "calculated range: " << size_header - CHECKSUM_LENGTH;
 
+  if (algo == CA_NONE) return true;
+
   const auto calculated_check_sum =
-      XXH32(buffer.GetReadBegin(), size_header - CHECKSUM_LENGTH, 0);
+      CalculateCheckSum(buffer.GetReadBegin(), size_header - CHECKSUM_LENGTH, algo);
+
   CheckSumType prepared_checksum = 0;
   ::memcpy(&prepared_checksum,
            buffer.GetReadBegin() + size_header - CHECKSUM_LENGTH,
@@ -219,6 +264,40 @@ bool MmbpCodec::VerifyCheckSum(Buffer &buffer, SizeHeaderType size_header)
   return calculated_check_sum == prepared_checksum;
 }
 
+auto MmbpCodec::CalculateCheckSum(void const *data, size_t len, ChecksumAlgo algo) noexcept
+    -> CheckSumType
+{
+  switch (algo) {
+    case CA_XXHASH32:
+      return XXH32(data, len, 0);
+    case CA_CRC32C:
+      return Crc32c(data, len);
+    default:
+      return 0;
+  }
+}
+
+auto MmbpCodec::GetTagChecksumAlgo(char const *tag) noexcept -> ChecksumAlgo
+{
+  for (int i = 0; i < CA_NUM; ++i) {
+    if (::memcmp(tag, CHECKSUM_ALGO_TAGS[i], MMBP_TAG_SIZE) == 0) return (ChecksumAlgo)i;
+  }
+  return CA_NUM;
+}
+
+auto MmbpCodec::GetChecksumAlgo(StringView str) noexcept -> ChecksumAlgo
+{
+  for (int i = 0; i < CA_NUM; ++i) {
+    if (str == CHECKSUM_ALGO_STRS[i]) return (ChecksumAlgo)i;
+  }
+  return CA_NUM;
+}
+
+char const *MmbpCodec::GetChecksumAlgoString(ChecksumAlgo algo) noexcept
+{
+  return algo < CA_NUM ? CHECKSUM_ALGO_STRS[algo] : "unknown";
+}
+
 char const *MmbpCodec::GetErrorString(ErrorCode code) noexcept
 {
   switch (code) {
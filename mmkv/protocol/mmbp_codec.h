@@ -25,13 +25,26 @@ class MmbpCodec {
     E_NO_COMPLETE_MESSAGE, // This is not a error, just indicator
   };
 
+  /**
+   * The checksum algorithm of the frame is indicated by the tag,
+   * thus it can be negotiated per connection(and even per frame).
+   * The receiver verifies the frame according to the tag and
+   * the server replies with the algorithm used by the request.
+   */
+  enum ChecksumAlgo : uint8_t {
+    CA_XXHASH32 = 0, /** Tag: "MMBP", compatible with the old peer */
+    CA_CRC32C,       /** Tag: "MMBC", SSE4.2 crc32 instruction if supported */
+    CA_NONE,         /** Tag: "MMBN", only accepted from the loopback peer */
+    CA_NUM,
+  };
+
   using SizeHeaderType = uint32_t;
   using CheckSumType = uint32_t;
 
  private:
 
   // using MessageCallback = std::function<void(TcpConnectionPtr const&, std::unique_ptr<MmbpMessage>, TimeStamp)>;
-  using MessageCallback = std::function<void(TcpConnectionPtr const&, Buffer&, uint32_t, TimeStamp)>;
+  using MessageCallback = std::function<void(TcpConnectionPtr const&, Buffer&, uint32_t, ChecksumAlgo, TimeStamp)>;
   using ErrorCallback = std::function<void(TcpConnectionPtr const&, ErrorCode)>;
 
  public:
@@ -50,6 +63,13 @@ class MmbpCodec {
     error_cb_ = std::move(cb);
   }
 
+  /**
+   * \brief Set the checksum algorithm of the sent frames
+   * The default is CA_XXHASH32.
+   */
+  void SetChecksumAlgo(ChecksumAlgo algo) noexcept { checksum_algo_ = algo; }
+  ChecksumAlgo checksum_algo() const noexcept { return checksum_algo_; }
+
   void Send(TcpConnectionPtr const& conn, MmbpMessage const* message) { Send(conn.get(), message); }
   void Send(TcpConnection * conn, MmbpMessage const *message);
 
@@ -59,17 +79,40 @@ class MmbpCodec {
    * Don't call this in mmkv.
    */
   ErrorCode Parse(Buffer &buffer, MmbpMessage *message);
-  void SerializeTo(MmbpMessage const* message, OutputBuffer& buffer);
+  void SerializeTo(MmbpMessage const* message, OutputBuffer& buffer) {
+    SerializeTo(message, buffer, checksum_algo_);
+  }
+
+  /**
+   * \brief Serialize the message to a frame checksummed by \p algo
+   * The server replies with the algorithm of the request frame.
+   */
+  static void SerializeTo(MmbpMessage const *message, OutputBuffer &buffer, ChecksumAlgo algo);
 
   static char const* GetErrorString(ErrorCode code) noexcept;
 
+  /**
+   * \brief Calculate the checksum of the contiguous data
+   * \return 0 if \p algo is CA_NONE
+   */
+  static CheckSumType CalculateCheckSum(void const *data, size_t len, ChecksumAlgo algo) noexcept;
+
+  /**
+   * \brief Parse the checksum algorithm string(xxhash, crc32c, none)
+   * \return CA_NUM if \p str is invalid
+   */
+  static ChecksumAlgo GetChecksumAlgo(StringView str) noexcept;
+  static char const *GetChecksumAlgoString(ChecksumAlgo algo) noexcept;
+
  private:
-  static bool VerifyCheckSum(Buffer& buffer, SizeHeaderType size_header);
+  static ChecksumAlgo GetTagChecksumAlgo(char const *tag) noexcept;
+  static bool VerifyCheckSum(Buffer& buffer, SizeHeaderType size_header, ChecksumAlgo algo);
 
   // Member data:
   MmbpMessage* prototype_;
   MessageCallback message_cb_;
   ErrorCallback error_cb_;
+  ChecksumAlgo checksum_algo_;
 
   // static void(* raw_request_cb_)(void const*, size_t);
 };
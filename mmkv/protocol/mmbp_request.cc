@@ -75,6 +75,7 @@ void MmbpRequest::SerializeTo(ChunkList &buffer) const
 
 void MmbpRequest::ParseFrom(Buffer &buffer)
 {
+  is_view_ = false;
   ParseComponent(command, buffer);
   ParseComponent(has_bits_[0], buffer);
 
@@ -102,8 +103,39 @@ void MmbpRequest::ParseFrom(Buffer &buffer)
   }
 }
 
+void MmbpRequest::ParseViewFrom(Buffer &buffer)
+{
+  is_view_ = true;
+  ParseComponent(command, buffer);
+  ParseComponent(has_bits_[0], buffer);
+
+  if (HasKey()) {
+    ParseComponent(key_view_, buffer, true);
+  }
+
+  if (HasValue()) {
+    ParseComponent(value_view_, buffer);
+  } else if (HasValues()) {
+    ParseComponent(values_view, buffer);
+  } else if (HasKvs()) {
+    ParseComponent(kvs, buffer);
+  } else if (HasCount()) {
+    ParseComponent(count, buffer);
+  } else if (HasRange()) {
+    ParseComponent(range.left, buffer);
+    ParseComponent(range.right, buffer);
+  } else if (HasVmembers()) {
+    ParseComponent(vmembers, buffer);
+  }
+
+  if (HasExpireTime()) {
+    ParseComponent(expire_time, buffer);
+  }
+}
+
 void MmbpRequest::ParseFrom(void const **pp_data, size_t len)
 {
+  is_view_ = false;
   if (len >= sizeof(command))
     ParseComponent(command, pp_data, &len);
   else
@@ -146,15 +178,21 @@ void MmbpRequest::DebugPrint() const noexcept
     return;
 
   if (HasKey()) {
-    LOG_DEBUG << "Key: " << key;
+    LOG_DEBUG << "Key: " << GetKey();
   }
 
   if (HasValue()) {
-    LOG_DEBUG << "Value: " << value;
+    LOG_DEBUG << "Value: " << GetValue();
   } else if (HasValues()) {
     LOG_DEBUG << "Value: ";
-    for (auto const &value : values)
-      LOG_DEBUG << value;
+    // The reused request may keep the stale values
+    if (is_view_) {
+      for (auto const &value : values_view)
+        LOG_DEBUG << value;
+    } else {
+      for (auto const &value : values)
+        LOG_DEBUG << value;
+    }
   } else if (HasKvs()) {
     LOG_DEBUG << "KeyValues: ";
     for (auto const &kv : kvs)
@@ -186,4 +224,7 @@ void MmbpRequest::Reset()
   values.clear();
   value.clear();
   vmembers.clear();
+  values_view.clear();
+  is_view_  = false;
+  is_asking = false;
 }
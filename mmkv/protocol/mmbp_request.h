@@ -12,6 +12,8 @@
 namespace mmkv {
 namespace protocol {
 
+using kanon::StringView;
+
 class MmbpRequest;
 
 namespace detail {
@@ -35,6 +37,32 @@ class MmbpRequest : public MmbpMessage {
   void ParseFrom(void const **pp_data, size_t len) override;
   // using MmbpMessage::ParseFrom;
 
+  /**
+   * \brief Parse the request but refer to the string fields in \p buffer
+   * The key, value and values are parsed into views without allocation,
+   * the other fields are same with ParseFrom().
+   * \warning
+   *   The views are invalid once the \p buffer is modified,
+   *   i.e. only valid in the message callback.
+   *   Only used for the read commands which don't take the ownership of fields.
+   */
+  void ParseViewFrom(Buffer &buffer);
+
+  bool IsView() const noexcept { return is_view_; }
+
+  /**
+   * \brief Get the key whether the request is parsed by ParseFrom() or ParseViewFrom()
+   */
+  StringView GetKey() const noexcept
+  {
+    return is_view_ ? key_view_ : StringView(key.data(), key.size());
+  }
+
+  StringView GetValue() const noexcept
+  {
+    return is_view_ ? value_view_ : StringView(value.data(), value.size());
+  }
+
   void Reset();
 
   MmbpMessage *New() const override { return new MmbpRequest(); }
@@ -102,6 +130,10 @@ class MmbpRequest : public MmbpMessage {
  private:
   uint8_t has_bits_[1];
 
+  bool       is_view_ = false;
+  StringView key_view_;
+  StringView value_view_;
+
  public:
   uint16_t command = Command::COMMAND_NUM; // required
 
@@ -113,6 +145,7 @@ class MmbpRequest : public MmbpMessage {
   StrValues    values; // for lappend, lprepend, sadd, mget(reuse), etc.
   String       value;  // for stradd, strset, etc.
   WeightValues vmembers;
+  StrViews     values_view; // for mgets if IsView()
 
   uint64_t expire_time; // optional
 
@@ -120,6 +153,10 @@ class MmbpRequest : public MmbpMessage {
     uint32_t count;
     Range    range;
   };
+
+  // Not serialized, set by the server if the request follows ASKING,
+  // i.e. it is served even if the shard of key is importing
+  bool is_asking = false;
 };
 
 } // namespace protocol
@@ -11,7 +11,9 @@ using namespace kanon;
 MmbpResponse MmbpResponse::prototype_;
 
 MmbpResponse::MmbpResponse()
-  : status_code(-1)
+  : allow_ref_(false)
+  , status_code(-1)
+  , value_ref(nullptr)
 {
   ::memset(has_bits_, 0, sizeof has_bits_);
 }
@@ -24,15 +26,29 @@ void MmbpResponse::SerializeTo(Buffer &buffer) const
   SerializeComponent(has_bits_[0], buffer);
 
   if (HasValue()) {
-    SerializeComponent(value, buffer);
+    SerializeComponent(value_ref ? *value_ref : value, buffer);
   } else if (HasValues()) {
-    SerializeComponent(values, buffer);
+    if (!values_ref.empty())
+      SerializeComponent(values_ref, buffer);
+    else
+      SerializeComponent(values, buffer);
   } else if (HasKvs()) {
-    SerializeComponent(kvs, buffer);
+    if (!kvs_ref.empty())
+      SerializeComponent(kvs_ref, buffer);
+    else
+      SerializeComponent(kvs, buffer);
+  } else if (HasVmembers()) {
+    if (!vmembers_ref.empty())
+      SerializeComponent(vmembers_ref, buffer);
+    else
+      SerializeComponent(vmembers, buffer);
   } else if (HasCount()) {
     SerializeComponent(count, buffer);
-  } else if (HasVmembers()) {
-    SerializeComponent(vmembers, buffer);
+  }
+
+  // The cursor of scan commands follows the batch
+  if (HasCursor()) {
+    SerializeComponent(count, buffer);
   }
 }
 
@@ -42,18 +58,51 @@ void MmbpResponse::SerializeTo(ChunkList &buffer) const
   SerializeComponent(has_bits_[0], buffer);
 
   if (HasValue()) {
-    SerializeComponent(value, buffer);
+    SerializeComponent(value_ref ? *value_ref : value, buffer);
   } else if (HasValues()) {
-    SerializeComponent(values, buffer);
+    if (!values_ref.empty())
+      SerializeComponent(values_ref, buffer);
+    else
+      SerializeComponent(values, buffer);
   } else if (HasKvs()) {
-    SerializeComponent(kvs, buffer);
+    if (!kvs_ref.empty())
+      SerializeComponent(kvs_ref, buffer);
+    else
+      SerializeComponent(kvs, buffer);
+  } else if (HasVmembers()) {
+    if (!vmembers_ref.empty())
+      SerializeComponent(vmembers_ref, buffer);
+    else
+      SerializeComponent(vmembers, buffer);
   } else if (HasCount()) {
     SerializeComponent(count, buffer);
-  } else if (HasVmembers()) {
-    SerializeComponent(vmembers, buffer);
+  }
+
+  // The cursor of scan commands follows the batch
+  if (HasCursor()) {
+    SerializeComponent(count, buffer);
   }
 }
 
+void MmbpResponse::Reset()
+{
+  ::memset(has_bits_, 0, sizeof has_bits_);
+  allow_ref_  = false;
+  status_code = -1;
+
+  // Don't to call shrink_to_fit()
+  // to reuse the old memory space
+  value.clear();
+  values.clear();
+  kvs.clear();
+  vmembers.clear();
+
+  value_ref = nullptr;
+  values_ref.clear();
+  kvs_ref.clear();
+  vmembers_ref.clear();
+}
+
 void MmbpResponse::ParseFrom(Buffer &buffer)
 {
   ParseComponent(status_code, buffer);
@@ -65,10 +114,14 @@ void MmbpResponse::ParseFrom(Buffer &buffer)
     ParseComponent(values, buffer);
   } else if (HasKvs()) {
     ParseComponent(kvs, buffer);
-  } else if (HasCount()) {
-    ParseComponent(count, buffer);
   } else if (HasVmembers()) {
     ParseComponent(vmembers, buffer);
+  } else if (HasCount()) {
+    ParseComponent(count, buffer);
+  }
+
+  if (HasCursor()) {
+    ParseComponent(count, buffer);
   }
 }
 
@@ -85,20 +138,30 @@ void MmbpResponse::DebugPrint() const noexcept
   LOG_DEBUG << "HasVmember: " << HasVmembers();
 
   if (HasValue()) {
-    LOG_DEBUG << "Value: " << value;
+    LOG_DEBUG << "Value: " << (value_ref ? *value_ref : value);
   } else if (HasValues()) {
     LOG_DEBUG << "Value: ";
     for (auto const &value : values)
       LOG_DEBUG << value;
+    for (auto const *value : values_ref)
+      LOG_DEBUG << *value;
   } else if (HasKvs()) {
     LOG_DEBUG << "KeyValues: ";
     for (auto const &kv : kvs)
       LOG_DEBUG << "<" << kv.key << ", " << kv.value << ">";
-  } else if (HasCount()) {
-    LOG_DEBUG << "Count: " << count;
+    for (auto const &kv : kvs_ref)
+      LOG_DEBUG << "<" << *kv.key << ", " << *kv.value << ">";
   } else if (HasVmembers()) {
     LOG_DEBUG << "<Weight, Member>: ";
     for (auto const &wm : vmembers)
       LOG_DEBUG << "(" << wm.key << "," << wm.value << ")";
+    for (auto const &wm : vmembers_ref)
+      LOG_DEBUG << "(" << wm.key << "," << *wm.value << ")";
+  } else if (HasCount()) {
+    LOG_DEBUG << "Count: " << count;
+  }
+
+  if (HasCursor()) {
+    LOG_DEBUG << "Cursor: " << count;
   }
 }
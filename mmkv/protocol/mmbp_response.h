@@ -69,6 +69,41 @@ class MmbpResponse : public MmbpMessage {
     return TestBit(has_bits_[0], 4);
   }
 
+  /**
+   * \brief The response of scan commands carries a batch and the next cursor
+   * The cursor is stored in the count field and serialized after the batch.
+   */
+  void SetCursor(uint64_t cursor) {
+    SetCount();
+    count = cursor;
+  }
+
+  bool HasCursor() const noexcept {
+    return HasCount() && (HasValues() || HasKvs() || HasVmembers());
+  }
+
+  /**
+   * \brief Allow the handler to reference the stored data
+   * The referenced data is serialized into the output buffer directly,
+   * thus the data is copied only once.
+   * \warning
+   *  The caller must serialize the response before the lock of
+   *  database instance is released, otherwise the references are dangling.
+   */
+  void AllowReference() noexcept {
+    allow_ref_ = true;
+  }
+
+  bool IsReferenceAllowed() const noexcept {
+    return allow_ref_;
+  }
+
+  /**
+   * \brief Reset the response to the initial state to reuse it
+   * The containers are cleared but their capacity is kept.
+   */
+  void Reset();
+
   void DebugPrint() const noexcept;
 
   static MmbpResponse* GetPrototype() noexcept {
@@ -79,6 +114,7 @@ class MmbpResponse : public MmbpMessage {
   static MmbpResponse prototype_;
 
   uint8_t has_bits_[1];
+  bool allow_ref_;
   
  public:
   uint8_t status_code; // required
@@ -89,6 +125,13 @@ class MmbpResponse : public MmbpMessage {
   StrValues values;
   StrKvs kvs;
   WeightValues vmembers;
+
+  // The reference version of the above fields
+  // Serialized in preference to the value version if not empty
+  String const *value_ref;
+  StrRefValues values_ref;
+  StrRefKvs kvs_ref;
+  WeightRefValues vmembers_ref;
 };
 
 } // protocol
@@ -148,6 +148,8 @@ MMKV_INLINE void ParseComponent(
   *pp_data8 += len;
 }
 
+/* The elements are assigned instead of appended,
+ * thus the reused message keeps the capacity of the old elements. */
 template <typename Alloc>
 MMKV_INLINE void ParseComponent(
     std::vector<std::basic_string<char, std::char_traits<char>, Alloc>> &values,
@@ -162,7 +164,7 @@ MMKV_INLINE void ParseComponent(
 
   for (size_t i = 0; i < count; ++i) {
     ParseComponent(value_size, buffer);
-    values[i].append(buffer.GetReadBegin(), value_size);
+    values[i].assign(buffer.GetReadBegin(), value_size);
     buffer.AdvanceRead(value_size);
   }
 }
@@ -183,12 +185,46 @@ MMKV_INLINE void ParseComponent(
 
   for (size_t i = 0; i < count; ++i) {
     ParseComponent(value_size, pp_data, p_size);
-    values[i].append(*pp_data8, value_size);
+    values[i].assign(*pp_data8, value_size);
     *pp_data8 += value_size;
     *p_size   -= value_size;
   }
 }
 
+/* The view version of the above string parsers.
+ * The view refers to the \p buffer and no memory is allocated,
+ * hence it is invalid once the \p buffer is modified. */
+MMKV_INLINE void ParseComponent(kanon::StringView &str, Buffer &buffer, bool is_16 = false)
+{
+  size_t len = 0;
+  if (is_16) {
+    uint16_t out;
+    ParseComponent(out, buffer);
+    len = out;
+  } else {
+    uint32_t out;
+    ParseComponent(out, buffer);
+    len = out;
+  }
+  str = kanon::StringView(buffer.GetReadBegin(), len);
+  buffer.AdvanceRead(len);
+}
+
+MMKV_INLINE void ParseComponent(StrViews &values, Buffer &buffer)
+{
+  uint32_t count = -1;
+  ParseComponent(count, buffer);
+  values.resize(count);
+
+  uint32_t value_size = 0;
+
+  for (size_t i = 0; i < count; ++i) {
+    ParseComponent(value_size, buffer);
+    values[i] = kanon::StringView(buffer.GetReadBegin(), value_size);
+    buffer.AdvanceRead(value_size);
+  }
+}
+
 MMKV_INLINE void ParseComponent(WeightValues &values, Buffer &buffer)
 {
   uint32_t count = -1;
@@ -200,7 +236,7 @@ MMKV_INLINE void ParseComponent(WeightValues &values, Buffer &buffer)
   for (size_t i = 0; i < count; ++i) {
     values[i].key = util::int2double(buffer.Read64());
     ParseComponent(value_size, buffer);
-    values[i].value.append(buffer.GetReadBegin(), value_size);
+    values[i].value.assign(buffer.GetReadBegin(), value_size);
     buffer.AdvanceRead(value_size);
   }
 }
@@ -219,7 +255,7 @@ MMKV_INLINE void ParseComponent(WeightValues &values, void const **pp_data, size
     ParseComponent(weight, pp_data, p_size);
     values[i].key = util::int2double(weight);
     ParseComponent(value_size, pp_data, p_size);
-    values[i].value.append(*pp_data8, value_size);
+    values[i].value.assign(*pp_data8, value_size);
     *pp_data8 += value_size;
     *p_size   -= value_size;
   }
@@ -236,10 +272,10 @@ MMKV_INLINE void ParseComponent(StrKvs &kvs, Buffer &buffer)
 
   for (size_t i = 0; i < count; ++i) {
     ParseComponent(key_size, buffer);
-    kvs[i].key.append(buffer.GetReadBegin(), key_size);
+    kvs[i].key.assign(buffer.GetReadBegin(), key_size);
     buffer.AdvanceRead(key_size);
     ParseComponent(value_size, buffer);
-    kvs[i].value.append(buffer.GetReadBegin(), value_size);
+    kvs[i].value.assign(buffer.GetReadBegin(), value_size);
     buffer.AdvanceRead(value_size);
   }
 }
@@ -256,11 +292,11 @@ MMKV_INLINE void ParseComponent(StrKvs &kvs, void const **pp_data, size_t *p_siz
 
   for (size_t i = 0; i < count; ++i) {
     ParseComponent(key_size, pp_data, p_size);
-    kvs[i].key.append(*pp_data8, key_size);
+    kvs[i].key.assign(*pp_data8, key_size);
     *pp_data8 += key_size;
     *p_size   -= key_size;
     ParseComponent(value_size, pp_data, p_size);
-    kvs[i].value.append(*pp_data8, value_size);
+    kvs[i].value.assign(*pp_data8, value_size);
     *pp_data8 += value_size;
     *p_size   -= value_size;
   }
@@ -493,6 +529,45 @@ MMKV_INLINE void SerializeComponent(WeightValues const &values, BT &buffer)
   }
 }
 
+/* The reference version of the above containers.
+ * The encoding is same with the value version,
+ * but the stored data is appended into buffer directly. */
+template <typename BT>
+MMKV_INLINE void SerializeComponent(StrRefValues const &values, BT &buffer)
+{
+  SerializeComponent((uint32_t)values.size(), buffer);
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    SerializeComponent((uint32_t)values[i]->size(), buffer);
+    buffer.Append(values[i]->data(), values[i]->size());
+  }
+}
+
+template <typename BT>
+MMKV_INLINE void SerializeComponent(StrRefKvs const &values, BT &buffer)
+{
+  SerializeComponent((uint32_t)values.size(), buffer);
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    SerializeComponent((uint16_t)values[i].key->size(), buffer);
+    buffer.Append(values[i].key->data(), values[i].key->size());
+    SerializeComponent((uint32_t)values[i].value->size(), buffer);
+    buffer.Append(values[i].value->data(), values[i].value->size());
+  }
+}
+
+template <typename BT>
+MMKV_INLINE void SerializeComponent(WeightRefValues const &values, BT &buffer)
+{
+  SerializeComponent((uint32_t)values.size(), buffer);
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    buffer.Append64(util::double2u64(values[i].key));
+    SerializeComponent((uint32_t)values[i].value->size(), buffer);
+    buffer.Append(values[i].value->data(), values[i].value->size());
+  }
+}
+
 // bc = bit count
 #define SERIALIZED_FIELD_UVEC(bc)                                                                  \
   MMKV_INLINE void SerializeComponent(                                                             \
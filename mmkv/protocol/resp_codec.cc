@@ -0,0 +1,291 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "resp_codec.h"
+
+#include <kanon/log/logger.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace kanon;
+using namespace mmkv::protocol;
+
+static constexpr size_t MAX_SIZE           = 1 << 26; // 64MB, same with MMBP
+static constexpr size_t MAX_INLINE_SIZE    = 1 << 16; // 64KB
+static constexpr int64_t MAX_MULTIBULK_LEN = 1 << 20;
+static constexpr int64_t MAX_BULK_LEN      = MAX_SIZE;
+
+RespCodec::RespCodec()
+{
+  SetErrorCallback([](TcpConnectionPtr const &conn, ErrorCode error_code) {
+    LOG_DEBUG << "Error message: " << GetErrorString(error_code);
+
+    OutputBuffer buffer;
+    AppendError(buffer, GetErrorString(error_code));
+    conn->Send(buffer);
+    conn->ShutdownWrite();
+  });
+}
+
+void RespCodec::SetUpConnection(TcpConnectionPtr const &conn)
+{
+  // The session and argument array are owned by the connection,
+  // the array is reused to avoid allocation per command
+  conn->SetMessageCallback([this, session = RespSession{}, args = RespArgs{}](
+                               TcpConnectionPtr const &conn,
+                               Buffer                 &buffer,
+                               TimeStamp               recv_time
+                           ) mutable {
+    OutputBuffer output;
+    size_t       reply_num = 0;
+
+    while (!session.closing) {
+      size_t len = 0;
+      auto   err = Parse(buffer, args, &len);
+
+      if (err == E_NO_COMPLETE_MESSAGE) {
+        if (buffer.GetReadableSize() < MAX_SIZE) break;
+        LOG_WARN << "A single message too large, just discard";
+        err = E_TOO_LARGE;
+      }
+
+      if (err != E_NOERROR) {
+        // The replies of the previous commands are sent first
+        if (reply_num > 0) conn->Send(output);
+        buffer.AdvanceAll();
+        buffer.Shrink();
+        error_cb_(conn, err);
+        return;
+      }
+
+      // Empty multibulk(*0\r\n) or blank line is skipped
+      if (!args.empty()) {
+        message_cb_(conn, args, session, output, recv_time);
+        ++reply_num;
+      }
+      buffer.AdvanceRead(len);
+    }
+
+    if (reply_num > 0) conn->Send(output);
+    if (session.closing) conn->ShutdownWrite();
+  });
+}
+
+/* Return the position of \r\n, or nullptr if not found */
+static inline char const *FindCrlf(char const *first, char const *last) noexcept
+{
+  for (;;) {
+    auto cr = (char const *)::memchr(first, '\r', last - first);
+    if (!cr || cr + 1 >= last) return nullptr;
+    if (cr[1] == '\n') return cr;
+    first = cr + 1;
+  }
+}
+
+/* Parse the decimal in [first, last), return false if invalid */
+static inline bool ParseDecimal(char const *first, char const *last, int64_t &i) noexcept
+{
+  bool negative = false;
+  if (first != last && *first == '-') {
+    negative = true;
+    ++first;
+  }
+
+  if (first == last || last - first > 18) return false;
+
+  i = 0;
+  for (; first != last; ++first) {
+    if (*first < '0' || *first > '9') return false;
+    i = i * 10 + (*first - '0');
+  }
+
+  if (negative) i = -i;
+  return true;
+}
+
+static inline RespCodec::ErrorCode ParseInline(Buffer const &buffer, RespArgs &args, size_t *p_len)
+{
+  auto first = buffer.GetReadBegin();
+  auto last  = first + buffer.GetReadableSize();
+  auto lf    = (char const *)::memchr(first, '\n', last - first);
+
+  if (!lf) {
+    return buffer.GetReadableSize() > MAX_INLINE_SIZE ? RespCodec::E_TOO_LARGE
+                                                      : RespCodec::E_NO_COMPLETE_MESSAGE;
+  }
+
+  *p_len   = lf - first + 1;
+  auto end = (lf > first && lf[-1] == '\r') ? lf - 1 : lf;
+
+  for (auto p = first; p != end;) {
+    if (*p == ' ' || *p == '\t') {
+      ++p;
+      continue;
+    }
+
+    auto arg_begin = p;
+    while (p != end && *p != ' ' && *p != '\t')
+      ++p;
+    args.emplace_back(arg_begin, p - arg_begin);
+  }
+
+  return RespCodec::E_NOERROR;
+}
+
+RespCodec::ErrorCode RespCodec::Parse(Buffer const &buffer, RespArgs &args, size_t *p_len)
+{
+  args.clear();
+  if (buffer.GetReadableSize() == 0) return E_NO_COMPLETE_MESSAGE;
+
+  auto first = buffer.GetReadBegin();
+  if (*first != '*') return ParseInline(buffer, args, p_len);
+
+  auto last = first + buffer.GetReadableSize();
+  auto crlf = FindCrlf(first, last);
+  if (!crlf) {
+    return buffer.GetReadableSize() > MAX_INLINE_SIZE ? E_INVALID_MULTIBULK_LENGTH
+                                                      : E_NO_COMPLETE_MESSAGE;
+  }
+
+  int64_t arg_num = 0;
+  if (!ParseDecimal(first + 1, crlf, arg_num) || arg_num > MAX_MULTIBULK_LEN) {
+    return E_INVALID_MULTIBULK_LENGTH;
+  }
+
+  auto p = crlf + 2;
+  // Don't trust the arg_num to reserve
+  if (arg_num > 0) args.reserve(arg_num < 64 ? arg_num : 64);
+
+  for (int64_t i = 0; i < arg_num; ++i) {
+    if (p == last) return E_NO_COMPLETE_MESSAGE;
+    if (*p != '$') return E_INVALID_BULK_LENGTH;
+
+    crlf = FindCrlf(p, last);
+    if (!crlf) return E_NO_COMPLETE_MESSAGE;
+
+    int64_t len = 0;
+    if (!ParseDecimal(p + 1, crlf, len) || len < 0 || len > MAX_BULK_LEN) {
+      return E_INVALID_BULK_LENGTH;
+    }
+
+    p = crlf + 2;
+    if (last - p < len + 2) return E_NO_COMPLETE_MESSAGE;
+    if (p[len] != '\r' || p[len + 1] != '\n') return E_INVALID_MESSAGE;
+
+    args.emplace_back(p, (size_t)len);
+    p += len + 2;
+  }
+
+  *p_len = p - first;
+  return E_NOERROR;
+}
+
+char const *RespCodec::GetErrorString(ErrorCode code) noexcept
+{
+  switch (code) {
+    case E_NOERROR:
+      return "OK";
+    case E_INVALID_MULTIBULK_LENGTH:
+      return "ERR Protocol error: invalid multibulk length";
+    case E_INVALID_BULK_LENGTH:
+      return "ERR Protocol error: invalid bulk length";
+    case E_INVALID_MESSAGE:
+      return "ERR Protocol error: invalid message";
+    case E_TOO_LARGE:
+      return "ERR Protocol error: too big request";
+    case E_NO_COMPLETE_MESSAGE:
+      return "ERR Protocol error: no complete message";
+  }
+  return "ERR Protocol error: unknown error";
+}
+
+/*--------------------------------------------------*/
+/* Reply API                                        */
+/*--------------------------------------------------*/
+
+/* Append "<prefix><i>\r\n" */
+static inline void AppendPrefixInteger(OutputBuffer &buffer, char prefix, int64_t i)
+{
+  char  buf[32];
+  char *end = buf + sizeof buf;
+  char *p   = end;
+
+  *--p = '\n';
+  *--p = '\r';
+
+  uint64_t u = i < 0 ? -(uint64_t)i : (uint64_t)i;
+  do {
+    *--p = '0' + u % 10;
+    u    /= 10;
+  } while (u != 0);
+
+  if (i < 0) *--p = '-';
+  *--p = prefix;
+
+  buffer.Append(p, end - p);
+}
+
+void RespCodec::AppendSimpleString(OutputBuffer &buffer, StringView str)
+{
+  buffer.Append("+", 1);
+  buffer.Append(str.data(), str.size());
+  buffer.Append("\r\n", 2);
+}
+
+void RespCodec::AppendError(OutputBuffer &buffer, StringView msg)
+{
+  buffer.Append("-", 1);
+  buffer.Append(msg.data(), msg.size());
+  buffer.Append("\r\n", 2);
+}
+
+void RespCodec::AppendInteger(OutputBuffer &buffer, int64_t i)
+{
+  AppendPrefixInteger(buffer, ':', i);
+}
+
+void RespCodec::AppendBulkString(OutputBuffer &buffer, StringView str)
+{
+  AppendPrefixInteger(buffer, '$', str.size());
+  buffer.Append(str.data(), str.size());
+  buffer.Append("\r\n", 2);
+}
+
+void RespCodec::AppendNull(OutputBuffer &buffer, uint8_t version)
+{
+  if (version >= 3)
+    buffer.Append("_\r\n", 3);
+  else
+    buffer.Append("$-1\r\n", 5);
+}
+
+void RespCodec::AppendDouble(OutputBuffer &buffer, double d, uint8_t version)
+{
+  char buf[64];
+  int  len;
+  if (isinf(d))
+    len = ::snprintf(buf, sizeof buf, d > 0 ? "inf" : "-inf");
+  else
+    len = ::snprintf(buf, sizeof buf, "%.17g", d);
+
+  if (version >= 3) {
+    buffer.Append(",", 1);
+    buffer.Append(buf, len);
+    buffer.Append("\r\n", 2);
+  } else {
+    AppendBulkString(buffer, StringView(buf, len));
+  }
+}
+
+void RespCodec::AppendArrayHeader(OutputBuffer &buffer, size_t n)
+{
+  AppendPrefixInteger(buffer, '*', n);
+}
+
+void RespCodec::AppendMapHeader(OutputBuffer &buffer, size_t n, uint8_t version)
+{
+  if (version >= 3)
+    AppendPrefixInteger(buffer, '%', n);
+  else
+    AppendPrefixInteger(buffer, '*', n << 1);
+}
@@ -0,0 +1,101 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_PROTOCOL_RESP_CODEC_H_
+#define _MMKV_PROTOCOL_RESP_CODEC_H_
+
+#include <vector>
+
+#include "kanon/util/noncopyable.h"
+#include "kanon/net/user_common.h"
+#include "kanon/net/callback.h"
+
+namespace mmkv {
+namespace protocol {
+
+/** The arguments of a RESP command, refer to the input buffer */
+using RespArgs = std::vector<StringView>;
+
+/**
+ * The state of a RESP connection
+ */
+struct RespSession {
+  uint8_t version = 2;     /** RESP2 or RESP3(switched by HELLO) */
+  bool    closing = false; /** QUIT is received */
+};
+
+/**
+ * RESP(REdis Serialization Protocol) codec
+ *
+ * Both the multibulk(*<n>\r\n$<len>\r\n...) and inline command are accepted,
+ * so the standard redis clients and load tools(e.g. redis-benchmark, memtier)
+ * can talk to mmkv.
+ *
+ * All complete commands in the input buffer are handled in order(i.e. pipelining),
+ * the replies are appended into one output buffer and sent once.
+ */
+class RespCodec {
+  DISABLE_EVIL_COPYABLE(RespCodec)
+
+ public:
+  enum ErrorCode : uint8_t {
+    E_NOERROR = 0,
+    E_INVALID_MULTIBULK_LENGTH,
+    E_INVALID_BULK_LENGTH,
+    E_INVALID_MESSAGE,
+    E_TOO_LARGE,
+    E_NO_COMPLETE_MESSAGE, // This is not a error, just indicator
+  };
+
+ private:
+  /* The args are invalid once the callback returns */
+  using MessageCallback =
+      std::function<void(TcpConnectionPtr const &, RespArgs &, RespSession &, OutputBuffer &, TimeStamp)>;
+  using ErrorCallback = std::function<void(TcpConnectionPtr const &, ErrorCode)>;
+
+ public:
+  RespCodec();
+
+  void SetUpConnection(TcpConnectionPtr const &conn);
+
+  void SetMessageCallback(MessageCallback cb) { message_cb_ = std::move(cb); }
+  void SetErrorCallback(ErrorCallback cb) { error_cb_ = std::move(cb); }
+
+  /**
+   * \brief Parse a command from the readable region of \p buffer
+   * \param p_len The length of the parsed command
+   * \return
+   *  E_NOERROR, the \p args refer to \p buffer and the caller advances \p p_len bytes.
+   *  E_NO_COMPLETE_MESSAGE, waiting more data.
+   *  Otherwise, the message is invalid.
+   */
+  static ErrorCode Parse(Buffer const &buffer, RespArgs &args, size_t *p_len);
+
+  static char const *GetErrorString(ErrorCode code) noexcept;
+
+  /*--------------------------------------------------*/
+  /* Reply API                                        */
+  /*--------------------------------------------------*/
+  static void AppendSimpleString(OutputBuffer &buffer, StringView str);
+  static void AppendError(OutputBuffer &buffer, StringView msg);
+  static void AppendInteger(OutputBuffer &buffer, int64_t i);
+  static void AppendBulkString(OutputBuffer &buffer, StringView str);
+
+  /** $-1 in RESP2, _ in RESP3 */
+  static void AppendNull(OutputBuffer &buffer, uint8_t version);
+
+  /** Bulk string in RESP2, , in RESP3 */
+  static void AppendDouble(OutputBuffer &buffer, double d, uint8_t version);
+
+  static void AppendArrayHeader(OutputBuffer &buffer, size_t n);
+
+  /** *<2n> in RESP2, %<n> in RESP3 */
+  static void AppendMapHeader(OutputBuffer &buffer, size_t n, uint8_t version);
+
+ private:
+  MessageCallback message_cb_;
+  ErrorCallback   error_cb_;
+};
+
+} // namespace protocol
+} // namespace mmkv
+
+#endif // _MMKV_PROTOCOL_RESP_CODEC_H_
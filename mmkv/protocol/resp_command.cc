@@ -0,0 +1,861 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "resp_command.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+
+#include "mmkv/util/conv.h"
+#include "mmkv/version.h"
+
+using namespace mmkv::protocol;
+using namespace kanon;
+
+#define RESP_SYNTAX_ERROR     "ERR syntax error"
+#define RESP_ARG_NUM_ERROR    "ERR wrong number of arguments"
+#define RESP_INTEGER_ERROR    "ERR value is not an integer or out of range"
+#define RESP_FLOAT_ERROR      "ERR value is not a valid float"
+#define RESP_WRONG_TYPE_ERROR "WRONGTYPE Operation against a key holding the wrong kind of value"
+
+#define RESP_COMMAND_NAME_MAX 32
+
+namespace {
+
+using RespCommandMap = std::unordered_map<std::string, RespCommand>;
+
+/* The formats of the mmkv commands, same with the mmkv-cli */
+RespFormat GetNativeFormat(Command cmd) noexcept
+{
+  switch (cmd) {
+    case MEM_STAT:
+    case KEYALL:
+    case DELALL:
+    case INFO:
+    case SLOWLOG_RESET:
+    case SCRIPT_FLUSH:
+      return RF_NONE;
+
+    case EVAL:
+    case EVALSHA:
+    case SCRIPT_LOAD:
+      return RF_SCRIPT;
+
+    case MEM_REPORT:
+    case SLOWLOG:
+      return RF_OPT_COUNT;
+
+    case STR_ADD:
+    case STR_SET:
+    case STRAPPEND:
+    case MEXISTS:
+    case MDEL:
+    case MGET:
+    case VDELM:
+    case VWEIGHT:
+    case VORDER:
+    case VRORDER:
+    case SDELM:
+    case SEXISTS:
+    case RENAME:
+      return RF_KEY_VALUE;
+
+    case MGETS:
+    case SADD:
+    case LADD:
+    case LAPPEND:
+    case LPREPEND:
+      return RF_KEY_VALUES;
+
+    case MSET:
+      return RF_KEY_FIELD_VALUE;
+
+    case SAND:
+    case SOR:
+    case SSUB:
+    case SANDSIZE:
+    case SORSIZE:
+    case SSUBSIZE:
+      return RF_SET_OP;
+
+    case SANDTO:
+    case SORTO:
+    case SSUBTO:
+      return RF_SET_OP_TO;
+
+    case STRPOPBACK:
+    case LPOPBACK:
+    case LPOPFRONT:
+      return RF_KEY_COUNT;
+
+    case LGETRANGE:
+    case VDELMRANGE:
+    case VRANGE:
+    case VRRANGE:
+      return RF_KEY_RANGE;
+
+    case VDELMRANGEBYWEIGHT:
+    case VRANGEBYWEIGHT:
+    case VRRANGEBYWEIGHT:
+    case VSIZEBYWEIGHT:
+      return RF_KEY_DRANGE;
+
+    case VADD:
+      return RF_KEY_VMEMBERS;
+
+    case MADD:
+      return RF_KEY_KVS;
+
+    case EXPIRE_AT:
+    case EXPIREM_AT:
+    case EXPIRE_AFTER:
+    case EXPIREM_AFTER:
+      return RF_KEY_EXPIRE;
+
+    case DELS:
+      return RF_KEYS;
+
+    case SCAN:
+      return RF_SCAN;
+
+    case MSCAN:
+    case SSCAN:
+    case VSCAN:
+      return RF_KEY_SCAN;
+
+    default:
+      return RF_KEY;
+  }
+}
+
+RespReply GetNativeReply(Command cmd) noexcept
+{
+  switch (cmd) {
+    case MEXISTS:
+    case SEXISTS:
+      return RR_BOOL;
+    case VWEIGHT:
+      return RR_DOUBLE;
+    case TTL:
+      return RR_TTL_MS;
+    default:
+      return RR_DEFAULT;
+  }
+}
+
+void AddCommand(
+    RespCommandMap &map,
+    char const     *name,
+    Command         cmd,
+    RespFormat      format,
+    RespReply       reply   = RR_DEFAULT,
+    RespBuiltin     builtin = RB_NONE
+)
+{
+  map[name] = RespCommand{cmd, format, reply, builtin};
+}
+
+void AddBuiltin(RespCommandMap &map, char const *name, RespBuiltin builtin)
+{
+  AddCommand(map, name, COMMAND_NUM, RF_NONE, RR_DEFAULT, builtin);
+}
+
+RespCommandMap GenRespCommandMap()
+{
+  RespCommandMap map;
+
+  for (int i = 0; i < COMMAND_NUM; ++i) {
+    const auto cmd = (Command)i;
+    // Shard management, migration and batch are not exposed to the RESP clients
+    if (cmd == SHARD_JOIN || cmd == SHARD_LEAVE || cmd == ASKING || cmd == BATCH) continue;
+
+    std::string name = GetCommandString(cmd);
+    for (auto &c : name)
+      c = ::tolower(c);
+    AddCommand(map, name.c_str(), cmd, GetNativeFormat(cmd), GetNativeReply(cmd));
+  }
+
+  // The redis aliases, overwrite the native commands if collide.
+  // The key must exist for the commands which can't create key in mmkv(e.g. lpush)
+  AddCommand(map, "get", STR_GET, RF_KEY);
+  AddCommand(map, "set", STR_SET, RF_KEY_VALUE);
+  AddCommand(map, "setnx", STR_ADD, RF_KEY_VALUE, RR_BOOL);
+  AddCommand(map, "append", STRAPPEND, RF_KEY_VALUE);
+  AddCommand(map, "del", DEL, RF_KEYS, RR_BOOL);
+  AddCommand(map, "unlink", DEL, RF_KEYS, RR_BOOL);
+  AddCommand(map, "persist", PERSIST, RF_KEY, RR_BOOL);
+  AddCommand(map, "expire", EXPIRE_AFTER, RF_KEY_EXPIRE, RR_BOOL);
+  AddCommand(map, "pexpire", EXPIREM_AFTER, RF_KEY_EXPIRE, RR_BOOL);
+  AddCommand(map, "expireat", EXPIRE_AT, RF_KEY_EXPIRE, RR_BOOL);
+  AddCommand(map, "pexpireat", EXPIREM_AT, RF_KEY_EXPIRE, RR_BOOL);
+  AddCommand(map, "ttl", TTL, RF_KEY, RR_TTL_SECONDS);
+  AddCommand(map, "pttl", TTL, RF_KEY, RR_TTL_MS);
+  AddCommand(map, "keys", KEYALL, RF_NONE);
+  AddCommand(map, "flushall", DELALL, RF_NONE, RR_OK);
+  AddCommand(map, "flushdb", DELALL, RF_NONE, RR_OK);
+  AddCommand(map, "script", SCRIPT_LOAD, RF_SCRIPT);
+
+  AddCommand(map, "rpush", LAPPEND, RF_KEY_VALUES, RR_OK);
+  AddCommand(map, "lpush", LPREPEND, RF_KEY_VALUES, RR_OK);
+  AddCommand(map, "lpop", LPOPFRONT, RF_KEY_COUNT, RR_OK);
+  AddCommand(map, "rpop", LPOPBACK, RF_KEY_COUNT, RR_OK);
+  AddCommand(map, "llen", LGETSIZE, RF_KEY, RR_ZERO_ON_MISS);
+  AddCommand(map, "lrange", LGETRANGE, RF_KEY_INCLUSIVE_RANGE, RR_EMPTY_ON_MISS);
+
+  AddCommand(map, "hset", MADD, RF_KEY_KVS);
+  AddCommand(map, "hmset", MADD, RF_KEY_KVS, RR_OK);
+  AddCommand(map, "hget", MGET, RF_KEY_VALUE);
+  AddCommand(map, "hmget", MGETS, RF_KEY_VALUES);
+  AddCommand(map, "hdel", MDEL, RF_KEY_VALUE, RR_BOOL);
+  AddCommand(map, "hexists", MEXISTS, RF_KEY_VALUE, RR_BOOL);
+  AddCommand(map, "hgetall", MALL, RF_KEY, RR_EMPTY_MAP_ON_MISS);
+  AddCommand(map, "hkeys", MFIELDS, RF_KEY, RR_EMPTY_ON_MISS);
+  AddCommand(map, "hvals", MVALUES, RF_KEY, RR_EMPTY_ON_MISS);
+  AddCommand(map, "hlen", MSIZE, RF_KEY, RR_ZERO_ON_MISS);
+  AddCommand(map, "hscan", MSCAN, RF_KEY_SCAN, RR_EMPTY_ON_MISS);
+
+  AddCommand(map, "srem", SDELM, RF_KEY_VALUE, RR_BOOL);
+  AddCommand(map, "scard", SSIZE, RF_KEY, RR_ZERO_ON_MISS);
+  AddCommand(map, "smembers", SALL, RF_KEY, RR_EMPTY_ON_MISS);
+  AddCommand(map, "sismember", SEXISTS, RF_KEY_VALUE, RR_BOOL);
+  AddCommand(map, "sinter", SAND, RF_SET_OP, RR_EMPTY_ON_MISS);
+  AddCommand(map, "sunion", SOR, RF_SET_OP, RR_EMPTY_ON_MISS);
+  AddCommand(map, "sdiff", SSUB, RF_SET_OP, RR_EMPTY_ON_MISS);
+  AddCommand(map, "sinterstore", SANDTO, RF_SET_OP_TO, RR_OK);
+  AddCommand(map, "sunionstore", SORTO, RF_SET_OP_TO, RR_OK);
+  AddCommand(map, "sdiffstore", SSUBTO, RF_SET_OP_TO, RR_OK);
+  AddCommand(map, "sscan", SSCAN, RF_KEY_SCAN, RR_EMPTY_ON_MISS);
+
+  AddCommand(map, "zadd", VADD, RF_KEY_VMEMBERS);
+  AddCommand(map, "zrem", VDELM, RF_KEY_VALUE, RR_BOOL);
+  AddCommand(map, "zcard", VSIZE, RF_KEY, RR_ZERO_ON_MISS);
+  AddCommand(map, "zcount", VSIZEBYWEIGHT, RF_KEY_DRANGE, RR_ZERO_ON_MISS);
+  AddCommand(map, "zscore", VWEIGHT, RF_KEY_VALUE, RR_DOUBLE);
+  AddCommand(map, "zrank", VORDER, RF_KEY_VALUE);
+  AddCommand(map, "zrevrank", VRORDER, RF_KEY_VALUE);
+  AddCommand(map, "zrange", VRANGE, RF_KEY_RANGE, RR_MEMBERS);
+  AddCommand(map, "zrevrange", VRRANGE, RF_KEY_RANGE, RR_MEMBERS);
+  AddCommand(map, "zrangebyscore", VRANGEBYWEIGHT, RF_KEY_DRANGE, RR_MEMBERS);
+  AddCommand(map, "zremrangebyrank", VDELMRANGE, RF_KEY_RANGE, RR_ZERO_ON_MISS);
+  AddCommand(map, "zremrangebyscore", VDELMRANGEBYWEIGHT, RF_KEY_DRANGE, RR_ZERO_ON_MISS);
+  AddCommand(map, "zscan", VSCAN, RF_KEY_SCAN, RR_EMPTY_ON_MISS);
+
+  AddBuiltin(map, "ping", RB_PING);
+  AddBuiltin(map, "echo", RB_ECHO);
+  AddBuiltin(map, "hello", RB_HELLO);
+  AddBuiltin(map, "quit", RB_QUIT);
+  AddBuiltin(map, "select", RB_SELECT);
+  AddBuiltin(map, "config", RB_CONFIG);
+  AddBuiltin(map, "command", RB_COMMAND);
+  AddBuiltin(map, "client", RB_CLIENT);
+
+  return map;
+}
+
+RespCommandMap const &resp_command_map()
+{
+  static const RespCommandMap map = GenRespCommandMap();
+  return map;
+}
+
+/* Copy the argument to the NUL-terminated buffer, return false if too long */
+template <size_t N>
+inline bool CopyArg(StringView arg, char (&buf)[N]) noexcept
+{
+  if (arg.size() >= N) return false;
+  ::memcpy(buf, arg.data(), arg.size());
+  buf[arg.size()] = 0;
+  return true;
+}
+
+inline bool ParseInteger(StringView arg, int64_t &i) noexcept
+{
+  char buf[32];
+  if (arg.empty() || !CopyArg(arg, buf)) return false;
+  char *end = nullptr;
+  i         = ::strtoll(buf, &end, 10);
+  return *end == 0;
+}
+
+inline bool ParseDouble(StringView arg, double &d) noexcept
+{
+  char buf[64];
+  if (arg.empty() || !CopyArg(arg, buf)) return false;
+  char *end = nullptr;
+  d         = ::strtod(buf, &end);
+  return *end == 0;
+}
+
+inline bool ArgCaseEqual(StringView arg, char const *str) noexcept
+{
+  const auto len = ::strlen(str);
+  return arg.size() == len && ::strncasecmp(arg.data(), str, len) == 0;
+}
+
+inline String ToString(StringView arg) { return String(arg.data(), arg.size()); }
+
+} // namespace
+
+RespCommand const *mmkv::protocol::GetRespCommand(StringView name)
+{
+  char buf[RESP_COMMAND_NAME_MAX];
+  if (name.size() >= sizeof buf) return nullptr;
+
+  for (size_t i = 0; i < name.size(); ++i)
+    buf[i] = ::tolower(name[i]);
+
+  auto &map  = resp_command_map();
+  auto  iter = map.find(std::string(buf, name.size()));
+  return iter == map.end() ? nullptr : &iter->second;
+}
+
+/* Parse [[COUNT] count] of scan commands, the count is stored in range.right */
+static inline char const *ParseScanCount(RespArgs const &args, size_t i, MmbpRequest &request)
+{
+  int64_t count = 0;
+  if (i + 1 == args.size()) {
+    // Compatible with mmkv-cli: xscan [key] cursor count
+    if (!ParseInteger(args[i], count) || count < 0) return RESP_INTEGER_ERROR;
+  } else if (i + 2 == args.size()) {
+    if (!ArgCaseEqual(args[i], "count")) return "ERR only COUNT option is supported";
+    if (!ParseInteger(args[i + 1], count) || count <= 0) return RESP_INTEGER_ERROR;
+  } else if (i != args.size()) {
+    return RESP_SYNTAX_ERROR;
+  }
+
+  request.range.right = count;
+  return nullptr;
+}
+
+char const *mmkv::protocol::ParseRespRequest(
+    RespCommand const &cmd,
+    RespArgs const    &args,
+    MmbpRequest       &request,
+    RespReply         &reply
+)
+{
+  const auto arg_num = args.size() - 1;
+
+  request.command = cmd.command;
+  reply           = cmd.reply;
+
+  if (cmd.format != RF_NONE && cmd.format != RF_OPT_COUNT && cmd.format != RF_KEYS &&
+      cmd.format != RF_SET_OP_TO && cmd.format != RF_SCAN && cmd.format != RF_SCRIPT)
+  {
+    if (arg_num < 1) return RESP_ARG_NUM_ERROR;
+    request.SetKey();
+    request.key = ToString(args[1]);
+  }
+
+  switch (cmd.format) {
+    case RF_NONE: {
+      // keys * is the only accepted pattern
+      if (cmd.command == KEYALL && arg_num == 1) {
+        if (!ArgCaseEqual(args[1], "*")) return "ERR only * pattern is supported";
+        break;
+      }
+      // info [section]
+      if (cmd.command == INFO && arg_num == 1) {
+        request.SetValue();
+        request.value = ToString(args[1]);
+        break;
+      }
+      if (arg_num != 0) return RESP_ARG_NUM_ERROR;
+    } break;
+
+    case RF_OPT_COUNT: {
+      size_t count_idx = 1;
+      // slowlog get [count] and slowlog reset are accepted also, same with redis
+      if (cmd.command == SLOWLOG && arg_num >= 1) {
+        if (ArgCaseEqual(args[1], "reset")) {
+          if (arg_num != 1) return RESP_ARG_NUM_ERROR;
+          request.command = SLOWLOG_RESET;
+          reply           = RR_OK;
+          break;
+        }
+        if (ArgCaseEqual(args[1], "get")) count_idx = 2;
+      }
+
+      if (arg_num > count_idx) return RESP_ARG_NUM_ERROR;
+      if (arg_num == count_idx) {
+        int64_t count;
+        if (!ParseInteger(args[count_idx], count) || count < 0) return RESP_INTEGER_ERROR;
+        request.SetCount();
+        request.count = count;
+      }
+    } break;
+
+    case RF_SCRIPT: {
+      size_t first = 1;
+      // script load script and script flush, same with redis
+      if (ArgCaseEqual(args[0], "script")) {
+        if (arg_num < 1) return RESP_ARG_NUM_ERROR;
+        if (ArgCaseEqual(args[1], "flush")) {
+          request.command = SCRIPT_FLUSH;
+          reply           = RR_OK;
+          break;
+        }
+        if (!ArgCaseEqual(args[1], "load")) return "ERR only LOAD and FLUSH are supported";
+        first = 2;
+      }
+
+      if (args.size() <= first) return RESP_ARG_NUM_ERROR;
+      request.SetValue();
+      request.value = ToString(args[first]);
+      if (request.command == SCRIPT_LOAD) {
+        if (args.size() != first + 1) return RESP_ARG_NUM_ERROR;
+        break;
+      }
+
+      // eval script numkeys keys... args...
+      if (args.size() < first + 2) return RESP_ARG_NUM_ERROR;
+      int64_t key_num;
+      if (!ParseInteger(args[first + 1], key_num) || key_num < 0) return RESP_INTEGER_ERROR;
+      if ((size_t)key_num > args.size() - first - 2) {
+        return "ERR Number of keys can't be greater than number of args";
+      }
+      request.SetCount();
+      request.count = key_num;
+      request.SetValues();
+      for (size_t i = first + 2; i < args.size(); ++i)
+        request.values.push_back(ToString(args[i]));
+    } break;
+
+    case RF_KEY: {
+      if (arg_num != 1) return RESP_ARG_NUM_ERROR;
+    } break;
+
+    case RF_KEY_VALUE: {
+      if (arg_num != 2) return RESP_ARG_NUM_ERROR;
+      request.SetValue();
+      request.value = ToString(args[2]);
+    } break;
+
+    case RF_KEY_VALUES: {
+      if (arg_num < 2) return RESP_ARG_NUM_ERROR;
+      request.values.reserve(arg_num - 1);
+      for (size_t i = 2; i < args.size(); ++i)
+        request.values.push_back(ToString(args[i]));
+      request.SetValues();
+    } break;
+
+    case RF_KEYS: {
+      if (arg_num < 1) return RESP_ARG_NUM_ERROR;
+      if (cmd.command == DEL && arg_num == 1) {
+        request.SetKey();
+        request.key = ToString(args[1]);
+        break;
+      }
+
+      // del key1 key2... is dels
+      if (cmd.command == DEL) {
+        request.command = DELS;
+        reply           = RR_DEFAULT;
+      }
+      request.values.reserve(arg_num);
+      for (size_t i = 1; i < args.size(); ++i)
+        request.values.push_back(ToString(args[i]));
+      request.SetValues();
+    } break;
+
+    case RF_KEY_COUNT: {
+      if (arg_num > 2) return RESP_ARG_NUM_ERROR;
+      int64_t count = 1;
+      if (arg_num == 2 && (!ParseInteger(args[2], count) || count < 0)) return RESP_INTEGER_ERROR;
+      request.SetCount();
+      request.count = count;
+    } break;
+
+    case RF_KEY_FIELD_VALUE: {
+      if (arg_num != 3) return RESP_ARG_NUM_ERROR;
+      request.values.reserve(2);
+      request.values.push_back(ToString(args[2]));
+      request.values.push_back(ToString(args[3]));
+      request.SetValues();
+    } break;
+
+    case RF_KEY_KVS: {
+      if (arg_num < 3 || (arg_num & 1) == 0) return RESP_ARG_NUM_ERROR;
+      request.kvs.reserve((arg_num - 1) >> 1);
+      for (size_t i = 2; i < args.size(); i += 2) {
+        request.kvs.push_back({ToString(args[i]), ToString(args[i + 1])});
+      }
+      request.SetKvs();
+    } break;
+
+    case RF_KEY_VMEMBERS: {
+      if (arg_num < 3 || (arg_num & 1) == 0) return RESP_ARG_NUM_ERROR;
+      request.vmembers.reserve((arg_num - 1) >> 1);
+      for (size_t i = 2; i < args.size(); i += 2) {
+        double weight;
+        if (!ParseDouble(args[i], weight)) return RESP_FLOAT_ERROR;
+        request.vmembers.push_back({weight, ToString(args[i + 1])});
+      }
+      request.SetVmembers();
+    } break;
+
+    case RF_KEY_RANGE:
+    case RF_KEY_INCLUSIVE_RANGE:
+    case RF_KEY_DRANGE: {
+      if (arg_num == 4 && reply == RR_MEMBERS && ArgCaseEqual(args[4], "withscores")) {
+        reply = RR_DEFAULT;
+      } else if (arg_num != 3) {
+        return arg_num == 4 ? RESP_SYNTAX_ERROR : RESP_ARG_NUM_ERROR;
+      }
+
+      if (cmd.format == RF_KEY_DRANGE) {
+        double left, right;
+        if (!ParseDouble(args[2], left) || !ParseDouble(args[3], right)) return RESP_FLOAT_ERROR;
+        request.SetWeightRange(left, right);
+        break;
+      }
+
+      int64_t left, right;
+      if (!ParseInteger(args[2], left) || !ParseInteger(args[3], right)) {
+        return RESP_INTEGER_ERROR;
+      }
+
+      // The negative right bound is included by ListGetRange()
+      if (cmd.format == RF_KEY_INCLUSIVE_RANGE && right >= 0) ++right;
+      request.range.left  = left;
+      request.range.right = right;
+      request.SetRange();
+    } break;
+
+    case RF_KEY_EXPIRE: {
+      if (arg_num != 2) return RESP_ARG_NUM_ERROR;
+      int64_t expire_time;
+      if (!ParseInteger(args[2], expire_time) || expire_time < 0) return RESP_INTEGER_ERROR;
+      request.expire_time = expire_time;
+      request.SetExpireTime();
+    } break;
+
+    case RF_SET_OP: {
+      if (arg_num != 2) return RESP_ARG_NUM_ERROR;
+      request.SetValue();
+      request.value = ToString(args[2]);
+    } break;
+
+    case RF_SET_OP_TO: {
+      if (arg_num != 3) return RESP_ARG_NUM_ERROR;
+      request.values.reserve(3);
+      for (size_t i = 1; i < args.size(); ++i)
+        request.values.push_back(ToString(args[i]));
+      request.SetValues();
+    } break;
+
+    case RF_SCAN:
+    case RF_KEY_SCAN: {
+      // The cursor and count are carried by the range
+      const size_t cursor_index = cmd.format == RF_SCAN ? 1 : 2;
+      if (args.size() <= cursor_index) return RESP_ARG_NUM_ERROR;
+
+      int64_t cursor;
+      if (!ParseInteger(args[cursor_index], cursor) || cursor < 0) return "ERR invalid cursor";
+      request.range.left = cursor;
+
+      auto errmsg = ParseScanCount(args, cursor_index + 1, request);
+      if (errmsg) return errmsg;
+      request.SetRange();
+    } break;
+  }
+
+  return nullptr;
+}
+
+/*--------------------------------------------------*/
+/* Reply                                            */
+/*--------------------------------------------------*/
+
+static inline void AppendValues(MmbpResponse const &response, OutputBuffer &buffer)
+{
+  if (!response.values_ref.empty()) {
+    RespCodec::AppendArrayHeader(buffer, response.values_ref.size());
+    for (auto const *value : response.values_ref)
+      RespCodec::AppendBulkString(buffer, StringView(value->data(), value->size()));
+  } else {
+    RespCodec::AppendArrayHeader(buffer, response.values.size());
+    for (auto const &value : response.values)
+      RespCodec::AppendBulkString(buffer, StringView(value.data(), value.size()));
+  }
+}
+
+/* The scan batch is always flat as redis does */
+static inline void
+AppendKvs(MmbpResponse const &response, uint8_t version, bool flat, OutputBuffer &buffer)
+{
+  const auto size = response.kvs_ref.empty() ? response.kvs.size() : response.kvs_ref.size();
+  if (flat)
+    RespCodec::AppendArrayHeader(buffer, size << 1);
+  else
+    RespCodec::AppendMapHeader(buffer, size, version);
+
+  if (!response.kvs_ref.empty()) {
+    for (auto const &kv : response.kvs_ref) {
+      RespCodec::AppendBulkString(buffer, StringView(kv.key->data(), kv.key->size()));
+      RespCodec::AppendBulkString(buffer, StringView(kv.value->data(), kv.value->size()));
+    }
+  } else {
+    for (auto const &kv : response.kvs) {
+      RespCodec::AppendBulkString(buffer, StringView(kv.key.data(), kv.key.size()));
+      RespCodec::AppendBulkString(buffer, StringView(kv.value.data(), kv.value.size()));
+    }
+  }
+}
+
+/* RESP2: member1 weight1 member2 weight2...
+ * RESP3: [member1, weight1] [member2, weight2]... */
+template <typename WMS, typename GetMember>
+static inline void AppendVmembersImpl(
+    WMS const   &wms,
+    RespReply    reply,
+    uint8_t      version,
+    bool         flat,
+    GetMember    get_member,
+    OutputBuffer &buffer
+)
+{
+  if (reply == RR_MEMBERS) {
+    RespCodec::AppendArrayHeader(buffer, wms.size());
+    for (auto const &wm : wms)
+      RespCodec::AppendBulkString(buffer, get_member(wm));
+    return;
+  }
+
+  const bool pair = !flat && version >= 3;
+  RespCodec::AppendArrayHeader(buffer, pair ? wms.size() : wms.size() << 1);
+  for (auto const &wm : wms) {
+    if (pair) RespCodec::AppendArrayHeader(buffer, 2);
+    RespCodec::AppendBulkString(buffer, get_member(wm));
+    RespCodec::AppendDouble(buffer, wm.key, flat ? 2 : version);
+  }
+}
+
+static inline void
+AppendVmembers(MmbpResponse const &response, RespReply reply, uint8_t version, bool flat, OutputBuffer &buffer)
+{
+  if (!response.vmembers_ref.empty()) {
+    AppendVmembersImpl(
+        response.vmembers_ref,
+        reply,
+        version,
+        flat,
+        [](WeightRefValue const &wm) { return StringView(wm.value->data(), wm.value->size()); },
+        buffer
+    );
+  } else {
+    AppendVmembersImpl(
+        response.vmembers,
+        reply,
+        version,
+        flat,
+        [](WeightValue const &wm) { return StringView(wm.value.data(), wm.value.size()); },
+        buffer
+    );
+  }
+}
+
+static inline void AppendStatusError(StatusCode code, OutputBuffer &buffer)
+{
+  if (code == S_EXISTS_DIFF_TYPE) {
+    RespCodec::AppendError(buffer, RESP_WRONG_TYPE_ERROR);
+    return;
+  }
+
+  // "ERROR: Key already exists" -> "ERR Key already exists"
+  auto msg = GetStatusMessage(code);
+  if (::strncmp(msg, "ERROR: ", 7) == 0) msg += 7;
+
+  buffer.Append("-ERR ", 5);
+  buffer.Append(msg, ::strlen(msg));
+  buffer.Append("\r\n", 2);
+}
+
+void mmkv::protocol::SerializeRespResponse(
+    MmbpResponse const &response,
+    RespReply           reply,
+    uint8_t             version,
+    OutputBuffer       &buffer
+)
+{
+  const auto code = (StatusCode)response.status_code;
+
+  if (code != S_OK) {
+    if (code == S_INVALID_REQUEST && response.HasValue()) {
+      // The value is the command name
+      buffer.Append("-ERR invalid request of ", 24);
+      buffer.Append(response.value.data(), response.value.size());
+      buffer.Append("\r\n", 2);
+      return;
+    }
+
+    // The redis clients rely on the NOSCRIPT to fallback to EVAL
+    if (code == S_SCRIPT_NONEXISTS) {
+      static constexpr char kNoScript[] = "-NOSCRIPT No matching script. Please use EVAL.\r\n";
+      buffer.Append(kNoScript, sizeof(kNoScript) - 1);
+      return;
+    }
+
+    if (code == S_SCRIPT_ERROR && response.HasValue()) {
+      buffer.Append("-ERR ", 5);
+      buffer.Append(response.value.data(), response.value.size());
+      buffer.Append("\r\n", 2);
+      return;
+    }
+
+    const bool is_miss = IsMissStatus(code);
+    switch (reply) {
+      case RR_BOOL:
+      case RR_ZERO_ON_MISS:
+        if (is_miss) return RespCodec::AppendInteger(buffer, 0);
+        break;
+      case RR_EMPTY_ON_MISS:
+        if (is_miss || code == S_INVALID_RANGE) return RespCodec::AppendArrayHeader(buffer, 0);
+        break;
+      case RR_EMPTY_MAP_ON_MISS:
+        if (is_miss) return RespCodec::AppendMapHeader(buffer, 0, version);
+        break;
+      case RR_TTL_SECONDS:
+      case RR_TTL_MS:
+        // The key without expiration is also nonexists in mmkv
+        if (is_miss) return RespCodec::AppendInteger(buffer, -1);
+        break;
+      default:
+        if (is_miss) return RespCodec::AppendNull(buffer, version);
+        break;
+    }
+
+    return AppendStatusError(code, buffer);
+  }
+
+  switch (reply) {
+    case RR_OK:
+      return RespCodec::AppendSimpleString(buffer, "OK");
+    case RR_BOOL:
+      return RespCodec::AppendInteger(buffer, 1);
+    case RR_DOUBLE:
+      return RespCodec::AppendDouble(buffer, util::int2double(response.count), version);
+    case RR_TTL_SECONDS:
+      return RespCodec::AppendInteger(buffer, (response.count + 500) / 1000);
+    default:
+      break;
+  }
+
+  if (response.HasCursor()) {
+    char       buf[32];
+    const auto len = ::snprintf(buf, sizeof buf, "%" PRIu64, response.count);
+    RespCodec::AppendArrayHeader(buffer, 2);
+    RespCodec::AppendBulkString(buffer, StringView(buf, len));
+  }
+
+  if (response.HasValue()) {
+    auto const &value = response.value_ref ? *response.value_ref : response.value;
+    RespCodec::AppendBulkString(buffer, StringView(value.data(), value.size()));
+  } else if (response.HasValues()) {
+    AppendValues(response, buffer);
+  } else if (response.HasKvs()) {
+    AppendKvs(response, version, response.HasCursor(), buffer);
+  } else if (response.HasVmembers()) {
+    AppendVmembers(response, reply, version, response.HasCursor(), buffer);
+  } else if (response.HasCount()) {
+    RespCodec::AppendInteger(buffer, response.count);
+  } else {
+    RespCodec::AppendSimpleString(buffer, "OK");
+  }
+}
+
+/*--------------------------------------------------*/
+/* Builtin                                          */
+/*--------------------------------------------------*/
+
+static inline void AppendHello(RespSession const &session, OutputBuffer &buffer)
+{
+  RespCodec::AppendMapHeader(buffer, 5, session.version);
+  RespCodec::AppendBulkString(buffer, "server");
+  RespCodec::AppendBulkString(buffer, "mmkv");
+  RespCodec::AppendBulkString(buffer, "version");
+  RespCodec::AppendBulkString(buffer, MMKV_VERSION_STR);
+  RespCodec::AppendBulkString(buffer, "proto");
+  RespCodec::AppendInteger(buffer, session.version);
+  RespCodec::AppendBulkString(buffer, "mode");
+  RespCodec::AppendBulkString(buffer, "standalone");
+  RespCodec::AppendBulkString(buffer, "role");
+  RespCodec::AppendBulkString(buffer, "master");
+}
+
+void mmkv::protocol::ExecuteRespBuiltin(
+    RespCommand const &cmd,
+    RespArgs const    &args,
+    RespSession       &session,
+    OutputBuffer      &buffer
+)
+{
+  switch (cmd.builtin) {
+    case RB_PING: {
+      if (args.size() == 1)
+        RespCodec::AppendSimpleString(buffer, "PONG");
+      else if (args.size() == 2)
+        RespCodec::AppendBulkString(buffer, args[1]);
+      else
+        RespCodec::AppendError(buffer, RESP_ARG_NUM_ERROR);
+    } break;
+
+    case RB_ECHO: {
+      if (args.size() == 2)
+        RespCodec::AppendBulkString(buffer, args[1]);
+      else
+        RespCodec::AppendError(buffer, RESP_ARG_NUM_ERROR);
+    } break;
+
+    case RB_HELLO: {
+      // HELLO [protover [AUTH username password] [SETNAME clientname]]
+      // The AUTH and SETNAME are ignored since mmkv has no ACL
+      if (args.size() >= 2) {
+        int64_t version;
+        if (!ParseInteger(args[1], version)) {
+          RespCodec::AppendError(buffer, "ERR Protocol version is not an integer or out of range");
+          break;
+        }
+        if (version != 2 && version != 3) {
+          RespCodec::AppendError(buffer, "NOPROTO unsupported protocol version");
+          break;
+        }
+        session.version = version;
+      }
+      AppendHello(session, buffer);
+    } break;
+
+    case RB_QUIT: {
+      session.closing = true;
+      RespCodec::AppendSimpleString(buffer, "OK");
+    } break;
+
+    case RB_SELECT: {
+      // Only one logical database
+      if (args.size() == 2 && ArgCaseEqual(args[1], "0"))
+        RespCodec::AppendSimpleString(buffer, "OK");
+      else
+        RespCodec::AppendError(buffer, "ERR DB index is out of range");
+    } break;
+
+    case RB_CONFIG:
+    case RB_COMMAND: {
+      // The load tools fetch the config and command docs before running,
+      // reply empty to tell them nothing is available
+      if (cmd.builtin == RB_CONFIG && args.size() >= 2 && ArgCaseEqual(args[1], "get"))
+        RespCodec::AppendMapHeader(buffer, 0, session.version);
+      else
+        RespCodec::AppendArrayHeader(buffer, 0);
+    } break;
+
+    case RB_CLIENT: {
+      RespCodec::AppendSimpleString(buffer, "OK");
+    } break;
+
+    case RB_NONE:
+    default:
+      RespCodec::AppendError(buffer, "ERR unknown command");
+  }
+}
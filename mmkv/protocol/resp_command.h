@@ -0,0 +1,113 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_PROTOCOL_RESP_COMMAND_H_
+#define _MMKV_PROTOCOL_RESP_COMMAND_H_
+
+#include "command.h"
+#include "mmbp_request.h"
+#include "mmbp_response.h"
+#include "resp_codec.h"
+
+namespace mmkv {
+namespace protocol {
+
+/** The arguments format of RESP command(the command name is excluded) */
+enum RespFormat : uint8_t {
+  RF_NONE = 0,            // command
+  RF_KEY,                 // command key
+  RF_KEY_VALUE,           // command key value
+  RF_KEY_VALUES,          // command key values...
+  RF_KEYS,                // command keys...
+  RF_KEY_COUNT,           // command key [count], count is 1 by default
+  RF_KEY_FIELD_VALUE,     // command key field value
+  RF_KEY_KVS,             // command key <field value>...
+  RF_KEY_VMEMBERS,        // command key <weight member>...
+  RF_KEY_RANGE,           // command key start stop [WITHSCORES]
+  RF_KEY_INCLUSIVE_RANGE, // command key start stop, stop is included(e.g. lrange)
+  RF_KEY_DRANGE,          // command key min max [WITHSCORES]
+  RF_KEY_EXPIRE,          // command key time
+  RF_SET_OP,              // command key1 key2
+  RF_SET_OP_TO,           // command destination key1 key2
+  RF_SCAN,                // command cursor [[COUNT] count]
+  RF_KEY_SCAN,            // command key cursor [[COUNT] count]
+  RF_OPT_COUNT,           // command [count]
+  RF_SCRIPT,              // command script numkeys keys... args... or command script
+};
+
+/**
+ * How the MmbpResponse is encoded to RESP reply
+ * The miss indicates the key(or field, member) does not exist.
+ */
+enum RespReply : uint8_t {
+  RR_DEFAULT = 0,       // Deduced from the fields of response, null if miss
+  RR_OK,                // +OK, the count is ignored(e.g. rpush)
+  RR_BOOL,              // 1 if success, 0 if miss
+  RR_ZERO_ON_MISS,      // Integer, 0 if miss(e.g. llen)
+  RR_EMPTY_ON_MISS,     // Array, empty if miss or the range is invalid
+  RR_EMPTY_MAP_ON_MISS, // Map, empty if miss
+  RR_DOUBLE,            // The count is the bits of double(e.g. zscore)
+  RR_MEMBERS,           // Only the members of vset, WITHSCORES is not specified
+  RR_TTL_SECONDS,       // The count is ms, -1 if miss
+  RR_TTL_MS,            // -1 if miss
+};
+
+/** The commands handled by the codec instead of database */
+enum RespBuiltin : uint8_t {
+  RB_NONE = 0,
+  RB_PING,
+  RB_ECHO,
+  RB_HELLO,
+  RB_QUIT,
+  RB_SELECT,
+  RB_CONFIG,
+  RB_COMMAND,
+  RB_CLIENT,
+};
+
+struct RespCommand {
+  Command     command;
+  RespFormat  format;
+  RespReply   reply;
+  RespBuiltin builtin;
+};
+
+/**
+ * \brief Get the RESP command by the name(case-insensitive)
+ * Both the mmkv command names and the redis aliases are accepted.
+ * If the names collide, the redis semantic is adopted(e.g. del, ttl).
+ * \return nullptr if the command is unknown
+ */
+RespCommand const *GetRespCommand(StringView name);
+
+/**
+ * \brief Translate the RESP arguments to MmbpRequest
+ * \param reply The reply type of \p cmd, maybe modified by the options(e.g. WITHSCORES)
+ * \return nullptr if success, otherwise the error message
+ */
+char const *
+ParseRespRequest(RespCommand const &cmd, RespArgs const &args, MmbpRequest &request, RespReply &reply);
+
+/**
+ * \brief Encode the response to RESP reply
+ * The referenced stored data is appended directly like MmbpResponse::SerializeTo().
+ */
+void SerializeRespResponse(
+    MmbpResponse const &response,
+    RespReply           reply,
+    uint8_t             version,
+    OutputBuffer       &buffer
+);
+
+/**
+ * \brief Execute the connection commands(e.g. ping, hello, quit)
+ */
+void ExecuteRespBuiltin(
+    RespCommand const &cmd,
+    RespArgs const    &args,
+    RespSession       &session,
+    OutputBuffer      &buffer
+);
+
+} // namespace protocol
+} // namespace mmkv
+
+#endif // _MMKV_PROTOCOL_RESP_COMMAND_H_
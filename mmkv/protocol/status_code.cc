@@ -39,6 +39,16 @@ char const *mmkv::protocol::GetStatusMessage(mmkv::protocol::StatusCode code) no
       return "ERROR: The shard which key belonging is locked";
     case S_SHARD_NONEXISTS:
       return "ERROR: The shard does not exists in peer node";
+    case S_SCRIPT_NONEXISTS:
+      return "ERROR: The script does not exists, use EVAL or SCRIPTLOAD";
+    case S_SCRIPT_ERROR:
+      return "ERROR: Failed to run the script";
+    case S_READONLY:
+      return "ERROR: The replica is read-only, write to the primary";
+    case S_MOVED:
+      return "ERROR: The shard of key is moved to other node, fetch the configuration again";
+    case S_ASK:
+      return "ERROR: The key is migrated to other node, send ASKING and the request to it";
     default:
       fprintf(stderr, "There are some status code message aren't added");
       abort();
@@ -80,6 +90,16 @@ char const *mmkv::protocol::StatusCode2Str(StatusCode code) noexcept
       return "Shard is processing";
     case S_SHARD_NONEXISTS:
       return "Shard does not exists";
+    case S_SCRIPT_NONEXISTS:
+      return "script nonexists";
+    case S_SCRIPT_ERROR:
+      return "script error";
+    case S_READONLY:
+      return "read-only";
+    case S_MOVED:
+      return "moved";
+    case S_ASK:
+      return "ask";
     default:
       return "Unknown status code";
   }
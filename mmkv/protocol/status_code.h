@@ -30,6 +30,13 @@ enum StatusCode : uint8_t {
   S_SHARD_LOCKED,
   S_SHARD_PROCESSING,
   S_SHARD_NONEXISTS,
+
+  S_SCRIPT_NONEXISTS, /** The script isn't loaded, use EVAL or SCRIPTLOAD */
+  S_SCRIPT_ERROR,     /** The script is failed, the message is in the value */
+
+  S_READONLY, /** The replica only serves the read commands */
+  S_MOVED,    /** The shard of key isn't owned by the node, refresh the shard map */
+  S_ASK,      /** The key is migrated, ask the node in the value(host:port) with ASKING */
 };
 
 /**
@@ -44,6 +51,23 @@ char const *GetStatusMessage(StatusCode code) noexcept;
  */
 char const *StatusCode2Str(StatusCode code) noexcept;
 
+/**
+ * \brief The miss indicates the key(or field, member) does not exist
+ */
+inline bool IsMissStatus(StatusCode code) noexcept
+{
+  switch (code) {
+    case S_NONEXISTS:
+    case S_FIELD_NONEXISTS:
+    case S_VMEMBER_NONEXISTS:
+    case S_SET_MEMBER_NONEXISTS:
+    case S_SET_NO_MEMBER:
+      return true;
+    default:
+      return false;
+  }
+}
+
 } // namespace protocol
 } // namespace mmkv
 
@@ -6,6 +6,8 @@
 #include "mmkv/algo/key_value.h"
 #include "mmkv/algo/string.h"
 
+#include <kanon/string/string_view.h>
+
 namespace mmkv {
 namespace protocol {
 
@@ -20,6 +22,16 @@ using StrKvs = std::vector<StrKeyValue>;
 using StrValues = std::vector<String>;
 using WeightValues = std::vector<KeyValue<Weight, String>>;
 
+// 引用存储的数据, 避免拷贝(仅在持有实例锁时有效)
+using StrRefKeyValue = KeyValue<String const *, String const *>;
+using WeightRefValue = KeyValue<Weight, String const *>;
+using StrRefKvs = std::vector<StrRefKeyValue>;
+using StrRefValues = std::vector<String const *>;
+using WeightRefValues = std::vector<WeightRefValue>;
+
+// 引用输入缓冲区的数据, 避免分配(仅在回调中有效)
+using StrViews = std::vector<kanon::StringView>;
+
 namespace detail {
 
 template <typename T>
@@ -38,6 +38,19 @@ void PrintMmkvConfig(MmkvConfig const &config)
   LOG_DEBUG << "SharderAddress = " << config.sharder_endpoint;
   LOG_DEBUG << "SharderControllerAddress = " << config.shard_controller_endpoint;
   LOG_DEBUG << "ShardNum = " << config.shard_num;
+  LOG_DEBUG << "RespEndpoint = " << config.resp_endpoint;
+  LOG_DEBUG << "SlowlogThreshold = " << config.slowlog_threshold;
+  LOG_DEBUG << "SlowlogMaxLen = " << config.slowlog_max_len;
+  LOG_DEBUG << "StallBudget = " << config.stall_budget;
+  LOG_DEBUG << "ScriptTimeLimit = " << config.script_time_limit;
+  LOG_DEBUG << "ReplicationEndpoint = " << config.replication_endpoint;
+  LOG_DEBUG << "ReplicaOf = " << config.replica_of;
+  LOG_DEBUG << "ReplicationBacklogSize = " << config.replication_backlog_size;
+  LOG_DEBUG << "ReplicaOutputLimit = " << config.replica_output_limit;
+  LOG_DEBUG << "ShardMigrationConcurrency = " << config.shard_migration_concurrency;
+  LOG_DEBUG << "ShardMigrationRate = " << config.shard_migration_rate;
+  LOG_DEBUG << "LoadReportInterval = " << config.load_report_interval;
+  LOG_DEBUG << "NodeWeight = " << config.node_weight;
   LOG_DEBUG << "Nodes: ";
   for (size_t i = 0; i < config.nodes.size(); ++i) {
     LOG_DEBUG << "node " << i << ": " << config.nodes[i];
@@ -158,6 +171,87 @@ bool ParseMmkvConfig(StringArg filename, MmkvConfig &config)
     ERROR_HANDLE;
   }
 
+  if (!env.GetGlobal("RespEndpoint", config.resp_endpoint)) {
+    ERROR_HANDLE;
+  }
+
+  if (!env.GetGlobal("SlowlogThreshold", config.slowlog_threshold)) {
+    ERROR_HANDLE;
+  }
+
+  if (!env.GetGlobal("SlowlogMaxLen", config.slowlog_max_len)) {
+    ERROR_HANDLE;
+  }
+
+  if (!env.GetGlobal("StallBudget", config.stall_budget)) {
+    ERROR_HANDLE;
+  }
+
+  if (!env.GetGlobal("ScriptTimeLimit", config.script_time_limit)) {
+    ERROR_HANDLE;
+  }
+
+  if (!env.GetGlobal("ReplicationEndpoint", config.replication_endpoint)) {
+    ERROR_HANDLE;
+  }
+
+  if (!env.GetGlobal("ReplicaOf", config.replica_of)) {
+    ERROR_HANDLE;
+  }
+
+  char const *backlog_size = "16MB";
+  if (!env.GetGlobal("ReplicationBacklogSize", backlog_size, true)) {
+    ERROR_HANDLE;
+  }
+
+  std::tie(config.replication_backlog_size) =
+      env.CallFunction<Number>("ParseMemoryUsage", 0, &success, true, backlog_size);
+
+  if (!success) {
+    ERROR_HANDLE;
+  }
+
+  char const *output_limit = "64MB";
+  if (!env.GetGlobal("ReplicaOutputLimit", output_limit, true)) {
+    ERROR_HANDLE;
+  }
+
+  std::tie(config.replica_output_limit) =
+      env.CallFunction<Number>("ParseMemoryUsage", 0, &success, true, output_limit);
+
+  if (!success) {
+    ERROR_HANDLE;
+  }
+
+  if (!env.GetGlobal("ShardMigrationConcurrency", config.shard_migration_concurrency)) {
+    ERROR_HANDLE;
+  }
+
+  char const *migration_rate = "0B";
+  if (!env.GetGlobal("ShardMigrationRate", migration_rate, true)) {
+    ERROR_HANDLE;
+  }
+
+  std::tie(config.shard_migration_rate) =
+      env.CallFunction<Number>("ParseMemoryUsage", 0, &success, true, migration_rate);
+
+  if (!success) {
+    ERROR_HANDLE;
+  }
+
+  if (!env.GetGlobal("LoadReportInterval", config.load_report_interval)) {
+    ERROR_HANDLE;
+  }
+
+  if (!env.GetGlobal("NodeWeight", config.node_weight)) {
+    ERROR_HANDLE;
+  }
+
+  if (config.node_weight <= 0 || config.node_weight > UINT32_MAX) {
+    LOG_ERROR << "NodeWeight must be in [1, " << UINT32_MAX << "]";
+    return false;
+  }
+
   Table      data_nodes;
   TableGuard data_nodes_guard(data_nodes);
 
@@ -29,17 +29,30 @@ struct MmkvConfig {
   /* Set defalut value in case the field is not found in config file.
    * (Not found is also valid, use its default value)
    */
-  LogMethod                log_method                = LM_NONE;
-  ReplacePolicy            replace_policy            = RP_NONE;
-  bool                     lazy_expiration           = false;
-  uint64_t                 max_memory_usage          = 0;
-  long                     expiration_check_cycle    = 0;
-  std::string              request_log_location      = "/tmp/.mmkv-request.log";
-  std::string              diagnostic_log_dir        = "";
-  std::string              shard_controller_endpoint = "";
-  std::string              sharder_endpoint          = "*:19998";
-  shard_id_t               shard_num                 = 1;
-  int                      thread_num                = 1;
+  LogMethod                log_method                  = LM_NONE;
+  ReplacePolicy            replace_policy              = RP_NONE;
+  bool                     lazy_expiration             = false;
+  uint64_t                 max_memory_usage            = 0;
+  long                     expiration_check_cycle      = 0;
+  std::string              request_log_location        = "/tmp/.mmkv-request.log";
+  std::string              diagnostic_log_dir          = "";
+  std::string              shard_controller_endpoint   = "";
+  std::string              sharder_endpoint            = "*:19998";
+  std::string              resp_endpoint               = "";
+  shard_id_t               shard_num                   = 1;
+  int                      thread_num                  = 1;
+  long                     slowlog_threshold           = 10000; /** us, negative to disable */
+  long                     slowlog_max_len             = 128;
+  long                     stall_budget                = 100; /** ms, 0 to disable */
+  long                     script_time_limit           = 5000; /** ms, 0 is unlimited */
+  std::string              replication_endpoint        = "";
+  std::string              replica_of                  = "";
+  uint64_t                 replication_backlog_size    = 1 << 24;
+  uint64_t                 replica_output_limit        = 1 << 26; /** bytes, 0 is unlimited */
+  long                     shard_migration_concurrency = 8;
+  uint64_t                 shard_migration_rate        = 0; /** bytes/s, 0 is unlimited */
+  long                     load_report_interval        = 1000; /** ms, 0 to disable */
+  long                     node_weight                 = 1; /** Weight in rendezvous hashing */
   std::vector<std::string> nodes;
 
   bool inline IsExpirationDisable() const noexcept
@@ -53,6 +66,23 @@ struct MmkvConfig {
   bool inline IsSharder() const noexcept { return !shard_controller_endpoint.empty(); }
 
   bool inline SupportDistribution() const noexcept { return !shard_controller_endpoint.empty(); }
+
+  /* If the endpoint of RESP exists,
+   * the server accepts the redis clients also
+   */
+  bool inline IsRespEnabled() const noexcept { return !resp_endpoint.empty(); }
+
+  bool inline IsStallWatchdogEnabled() const noexcept { return stall_budget > 0; }
+
+  /* If the endpoint of replication exists,
+   * the server ships the write requests to the replicas
+   */
+  bool inline IsReplicationEnabled() const noexcept { return !replication_endpoint.empty(); }
+
+  /* If the primary exists,
+   * the server follows the primary and only serves the read commands
+   */
+  bool inline IsReplica() const noexcept { return !replica_of.empty(); }
 };
 
 MmkvConfig &mmkv_config();
@@ -1,5 +1,6 @@
 // SPDX-LICENSE-IDENTIFIER: Apache-2.0
 #include "mmkv_server.h"
+#include "mmkv_session.h"
 
 #include "mmkv/disk/recover.h"
 #include "mmkv/util/time_util.h"
@@ -8,16 +9,24 @@
 #include "mmkv/server/config.h"
 #include "mmkv/algo/hash_util.h"
 #include "mmkv/protocol/mmbp.h"
+#include "mmkv/protocol/mmbp_batch.h"
 #include "mmkv/protocol/mmbp_request.h"
 #include "mmkv/protocol/mmbp_response.h"
 #include "mmkv/protocol/mmbp_type.h"
+#include "mmkv/protocol/resp_command.h"
 #include "mmkv/util/macro.h"
 #include "mmkv/util/conv.h"
 #include "mmkv/storage/db.h"
 
 #include "mmkv/disk/request_log.h"
 #include "mmkv/disk/log_command.h"
+#include "mmkv/lua/script.h"
 #include "common.h"
+#include "replication.h"
+#include "replication_source.h"
+#include "slowlog.h"
+#include "stats.h"
+#include "storage_hooks.h"
 
 #include <kanon/util/ptr.h>
 
@@ -30,7 +39,38 @@ using namespace mmkv::util;
 using namespace mmkv::protocol;
 using namespace mmkv;
 
-static void LogRequestToFile(Buffer &buffer, uint32_t request_len);
+static void LogRequest(Buffer &buffer, uint32_t request_len);
+static void LogBatch(MmbpBatchRequest &batch);
+static void HandleBatch(
+    TcpConnectionPtr const &conn,
+    Buffer                 &buffer,
+    uint32_t                request_len,
+    MmbpCodec::ChecksumAlgo algo
+);
+static void HandleRespCommand(
+    TcpConnectionPtr const &conn,
+    RespArgs               &args,
+    RespSession            &session,
+    OutputBuffer           &output,
+    TimeStamp               recv_time
+);
+
+static void HandleRespCommandImpl(
+    TcpConnectionPtr const &conn,
+    RespArgs               &args,
+    RespSession            &session,
+    OutputBuffer           &output,
+    TimeStamp               recv_time
+);
+
+/* The OutputBuffer is a list of chunks */
+static inline size_t GetOutputSize(OutputBuffer const &output) noexcept
+{
+  size_t size = 0;
+  for (auto const &chunk : output)
+    size += chunk.GetReadableSize();
+  return size;
+}
 
 MmkvServer::MmkvServer(EventLoop *loop, InetAddr const &addr, InetAddr const &sharder_addr)
   : server_(loop, addr, "Mmkv")
@@ -46,16 +86,29 @@ MmkvServer::MmkvServer(EventLoop *loop, InetAddr const &addr, InetAddr const &sh
                                     )
                                   : nullptr
     )
+  , replica_cli_(
+        mmkv_config().IsReplica() ? new ReplicaClient(loop, InetAddr(mmkv_config().replica_of))
+                                  : nullptr
+    )
+  , watchdog_(
+        mmkv_config().IsStallWatchdogEnabled() ? new StallWatchdog(mmkv_config().stall_budget)
+                                               : nullptr
+    )
 {
+  InstallStorageHooks();
+
   server_.SetConnectionCallback([this](TcpConnectionPtr const &conn) {
     if (conn->IsConnected()) {
       LOG_MMKV(conn) << " connected";
+      if (watchdog_) watchdog_->AddLoop(conn->GetLoop());
+      auto p_session = new MmkvSession(conn, this);
+      conn->SetContext(*p_session);
       codec_.SetUpConnection(conn);
     } else {
-      // auto p = AnyCast<MmkvSession>(conn->GetContext());
-      // assert(p);
+      auto p_session = AnyCast<MmkvSession>(conn->GetContext());
+      assert(p_session);
 
-      // delete p;
+      delete p_session;
       LOG_MMKV(conn) << " disconnected";
     }
   });
@@ -64,29 +117,77 @@ MmkvServer::MmkvServer(EventLoop *loop, InetAddr const &addr, InetAddr const &sh
                                 TcpConnectionPtr const &conn,
                                 Buffer                 &buffer,
                                 uint32_t                request_len,
+                                MmbpCodec::ChecksumAlgo checksum_algo,
                                 TimeStamp               recv_time
                             ) {
     // Set g_recv_time for expireafter and expiremafter
     database_manager().SetRecvTime(recv_time.GetMicrosecondsSinceEpoch() / 1000);
 
-    MmbpRequest request;
+    // The request and response are reused to avoid allocation per message
+    auto  p_session = AnyCast<MmkvSession>(conn->GetContext());
+    auto &request   = p_session->request();
+    auto &response  = p_session->response();
+
+    StatsAdd(SC_NET_INPUT_BYTES, request_len);
+
+    if (request.PeekCommand(buffer) == BATCH) {
+      HandleBatch(conn, buffer, request_len, checksum_algo);
+      return;
+    }
+
+    const auto cmd_type = GetCommandType(request.PeekCommand(buffer));
+
+    // The replica only applies the writes from primary
+    if (cmd_type == CT_WRITE && mmkv_config().IsReplica()) {
+      buffer.AdvanceRead(request_len);
+      response.Reset();
+      response.status_code = S_READONLY;
+      OutputBuffer output;
+      MmbpCodec::SerializeTo(&response, output, checksum_algo);
+      conn->Send(output);
+      return;
+    }
+
+    // Held until the request is executed, see ReplicationGate
+    ReplicationGate repl_gate(cmd_type == CT_WRITE);
 
     // TODO Modify the recover logic of SHRAD_LEAVE/JOIN
-    if (mmkv_config().log_method == LM_REQUEST) {
-      LogRequestToFile(buffer, request_len);
+    if (IsRecordLogged()) {
+      LogRequest(buffer, request_len);
     }
 
-    request.ParseFrom(buffer);
+    // The read command only looks up the database,
+    // refer to the fields in buffer to avoid allocation
+    if (cmd_type == CT_READ) {
+      request.ParseViewFrom(buffer);
+    } else {
+      request.ParseFrom(buffer);
+    }
     request.DebugPrint();
 
     LOG_MMKV(conn) << " " << GetCommandString((Command)request.command);
 
     if (request.HasKey()) {
       LOG_MMKV(conn) << " "
-                     << "key: " << request.key;
+                     << "key: " << request.GetKey();
     }
 
-    MmbpResponse response;
+    // The key is copied before executing, since the write command moves it
+    SlowlogScope slowlog_scope(
+        SK_COMMAND,
+        GetCommandString((Command)request.command).c_str(),
+        request.HasKey() ? request.GetKey() : StringView(),
+        conn.get()
+    );
+
+    response.Reset();
+    OutputBuffer output;
+    // Reply with the checksum algorithm chosen by the client
+    auto         serialize_cb = [&output, checksum_algo](MmbpResponse const &response) {
+      response.DebugPrint();
+      MmbpCodec::SerializeTo(&response, output, checksum_algo);
+    };
+
     if (request.command == SHARD_JOIN) {
       if (!request.HasKey() || !request.HasCount()) {
         response.status_code = StatusCode::S_INVALID_REQUEST;
@@ -94,7 +195,8 @@ MmkvServer::MmkvServer(EventLoop *loop, InetAddr const &addr, InetAddr const &sh
         if (ctler_cli_ && !ctler_cli_->IsIdle()) {
           response.status_code = StatusCode::S_SHARD_PROCESSING;
         } else {
-          InetAddr controller_addr(request.key.c_str(), (uint16_t)request.count);
+          const auto controller_ip = request.GetKey().ToString();
+          InetAddr   controller_addr(controller_ip.c_str(), (uint16_t)request.count);
 
           // IsSharder() requires
           mmkv_config().shard_controller_endpoint = controller_addr.ToIpPort();
@@ -112,17 +214,46 @@ MmkvServer::MmkvServer(EventLoop *loop, InetAddr const &addr, InetAddr const &sh
       } else {
         // TODO
       }
+    } else if (request.command == ASKING) {
+      // The next request is redirected by S_ASK, serve it even if the shard is importing
+      p_session->SetAsking();
+      response.status_code = S_OK;
     } else {
-      database_manager().Execute(request, &response);
+      // The response is serialized into output with the instance lock held,
+      // thus the stored data is referenced instead of copied
+      request.is_asking = p_session->TakeAsking();
+      database_manager().Execute(request, &response, serialize_cb);
+      LogPendingDels();
     }
 
-    response.DebugPrint();
-    codec_.Send(conn, &response);
+    if (request.command == SHARD_JOIN || request.command == SHARD_LEAVE ||
+        request.command == ASKING)
+    {
+      serialize_cb(response);
+    }
+    StatsAdd(SC_NET_OUTPUT_BYTES, GetOutputSize(output));
+    conn->Send(output);
 
     LOG_MMKV(conn) << " " << response.status_code << " "
                    << StatusCode2Str((StatusCode)response.status_code);
   });
 
+  if (mmkv_config().IsRespEnabled()) {
+    resp_server_.reset(new TcpServer(loop, InetAddr(mmkv_config().resp_endpoint), "MmkvResp"));
+
+    resp_server_->SetConnectionCallback([this](TcpConnectionPtr const &conn) {
+      if (conn->IsConnected()) {
+        LOG_MMKV(conn) << " connected(RESP)";
+        if (watchdog_) watchdog_->AddLoop(conn->GetLoop());
+        resp_codec_.SetUpConnection(conn);
+      } else {
+        LOG_MMKV(conn) << " disconnected(RESP)";
+      }
+    });
+
+    resp_codec_.SetMessageCallback(&HandleRespCommand);
+  }
+
   if (ctler_cli_) {
     LOG_INFO << "This is configured as a shard server also";
     LOG_INFO << "Connecting to the router server...";
@@ -140,6 +271,7 @@ void MmkvServer::Start()
     try {
       Recover recover;
       recover.ParseFromRequest();
+      LogPendingDels();
       LOG_INFO << "Recover complete";
     }
     catch (FileException const &ex) {
@@ -150,6 +282,20 @@ void MmkvServer::Start()
     rlog().Start();
   }
 
+  if (resp_server_) {
+    LOG_INFO << "The mmkv accepts the redis clients in " << mmkv_config().resp_endpoint;
+  }
+
+  // Accept the replicas after recovering, thus the snapshot contains the recovered data
+  if (mmkv_config().IsReplicationEnabled()) {
+    repl_source().Listen(server_.GetLoop());
+  }
+
+  // Follow the primary after recovering, the full sync discards the recovered data
+  if (replica_cli_) {
+    replica_cli_->Connect();
+  }
+
   if (mmkv_config().expiration_check_cycle > 0) {
     LOG_INFO << "The mmkv will check all expired entries actively";
     LOG_INFO << "The cycle is " << mmkv_config().expiration_check_cycle << " seconds";
@@ -158,24 +304,208 @@ void MmkvServer::Start()
         []() {
           // FIXME thread-safe
           LOG_DEBUG << "Check expiration";
+          SlowlogScope slowlog_scope(SK_TASK, "EXPIRE_CYCLE");
           database_manager().CheckExpirationCycle();
+          LogPendingDels();
         },
         mmkv_config().expiration_check_cycle
     );
   }
 
+  if (watchdog_) {
+    // Start after recovering, the loop doesn't run while recovering
+    watchdog_->AddLoop(server_.GetLoop());
+    watchdog_->Start();
+  }
+
   Listen();
 }
 
-static inline void LogRequestToFile(Buffer &buffer, uint32_t request_len)
+static void HandleBatch(
+    TcpConnectionPtr const &conn,
+    Buffer                 &buffer,
+    uint32_t                request_len,
+    MmbpCodec::ChecksumAlgo algo
+)
+{
+  const auto       readable_size = buffer.GetReadableSize();
+  MmbpBatchRequest batch;
+  batch.ParseFrom(buffer);
+  batch.DebugPrint();
+
+  LOG_MMKV(conn) << " " << GetCommandString(BATCH) << " " << batch.requests.size();
+
+  MmbpBatchResponse response;
+  OutputBuffer      output;
+
+  // The batch failed to parse is rejected, the rest of frame is skipped
+  if (batch.requests.empty()) {
+    const auto parsed_size = readable_size - buffer.GetReadableSize();
+    if (parsed_size < request_len) buffer.AdvanceRead(request_len - parsed_size);
+    response.status_code = S_INVALID_REQUEST;
+    MmbpCodec::SerializeTo(&response, output, algo);
+    conn->Send(output);
+    return;
+  }
+
+  bool has_write = false;
+  for (auto const &request : batch.requests)
+    has_write |= GetCommandType((Command)request.command) == CT_WRITE;
+
+  // The replica only applies the writes from primary
+  if (has_write && mmkv_config().IsReplica()) {
+    response.status_code = S_READONLY;
+    MmbpCodec::SerializeTo(&response, output, algo);
+    conn->Send(output);
+    return;
+  }
+
+  // Held until the batch is executed, see ReplicationGate
+  ReplicationGate repl_gate(has_write);
+
+  // The batch is logged as a single record, thus it is also atomic when recovering
+  if (has_write && IsRecordLogged()) {
+    LogBatch(batch);
+  }
+
+  SlowlogScope slowlog_scope(SK_COMMAND, GetCommandString(BATCH).c_str(), StringView(), conn.get());
+
+  // The batch redirected by S_ASK is served even if the shard is importing
+  const bool is_asking = AnyCast<MmkvSession>(conn->GetContext())->TakeAsking();
+  for (auto &request : batch.requests)
+    request.is_asking = is_asking;
+
+  database_manager().ExecuteBatch(batch, &response, [&output, algo](MmbpBatchResponse const &response) {
+    response.DebugPrint();
+    MmbpCodec::SerializeTo(&response, output, algo);
+  });
+  LogPendingDels();
+  StatsAdd(SC_NET_OUTPUT_BYTES, GetOutputSize(output));
+  conn->Send(output);
+
+  LOG_MMKV(conn) << " " << response.status_code << " "
+                 << StatusCode2Str((StatusCode)response.status_code);
+}
+
+/* The RESP command is translated to MmbpRequest and executed like MMBP,
+ * the reply is encoded with the instance lock held also. */
+static void HandleRespCommand(
+    TcpConnectionPtr const &conn,
+    RespArgs               &args,
+    RespSession            &session,
+    OutputBuffer           &output,
+    TimeStamp               recv_time
+)
 {
-  if (mmkv_config().IsExpirationDisable()) return;
+  // The output is sent by the codec after all pipelined commands are handled
+  const auto output_size = GetOutputSize(output);
+  HandleRespCommandImpl(conn, args, session, output, recv_time);
+
+  size_t input_size = 0;
+  for (auto const &arg : args)
+    input_size += arg.size();
+  StatsAdd(SC_NET_INPUT_BYTES, input_size);
+  StatsAdd(SC_NET_OUTPUT_BYTES, GetOutputSize(output) - output_size);
+}
+
+static void HandleRespCommandImpl(
+    TcpConnectionPtr const &conn,
+    RespArgs               &args,
+    RespSession            &session,
+    OutputBuffer           &output,
+    TimeStamp               recv_time
+)
+{
+  auto cmd = GetRespCommand(args[0]);
+  if (!cmd) {
+    std::string errmsg = "ERR unknown command '";
+    errmsg.append(args[0].data(), args[0].size());
+    errmsg += "'";
+    RespCodec::AppendError(output, errmsg);
+    return;
+  }
+
+  if (cmd->builtin != RB_NONE) {
+    ExecuteRespBuiltin(*cmd, args, session, output);
+    return;
+  }
+
+  database_manager().SetRecvTime(recv_time.GetMicrosecondsSinceEpoch() / 1000);
+
+  MmbpRequest request;
+  RespReply   reply;
+  auto        errmsg = ParseRespRequest(*cmd, args, request, reply);
+  if (errmsg) {
+    RespCodec::AppendError(output, errmsg);
+    return;
+  }
+
+  LOG_MMKV(conn) << " " << GetCommandString((Command)request.command) << "(RESP)";
+
+  const auto cmd_type = GetCommandType((Command)request.command);
+  if (cmd_type == CT_WRITE && mmkv_config().IsReplica()) {
+    RespCodec::AppendError(output, "READONLY You can't write against a read only replica.");
+    return;
+  }
+
+  // Held until the request is executed, see ReplicationGate
+  ReplicationGate repl_gate(cmd_type == CT_WRITE);
+
+  // Log the translated request, thus the recover is same with MMBP
+  if (cmd_type == CT_WRITE && IsRecordLogged()) {
+    Buffer buffer;
+    request.SerializeTo(buffer);
+    LogRequest(buffer, buffer.GetReadableSize());
+  }
+
+  SlowlogScope slowlog_scope(
+      SK_COMMAND,
+      GetCommandString((Command)request.command).c_str(),
+      request.HasKey() ? request.GetKey() : StringView(),
+      conn.get()
+  );
 
+  MmbpResponse response;
+  database_manager().Execute(request, &response, [&](MmbpResponse const &response) {
+    SerializeRespResponse(response, reply, session.version, output);
+  });
+  LogPendingDels();
+}
+
+/* The script may be not cached when the record is replayed, e.g. the replica
+ * is full synced or the server recovers from the rewritten log, thus
+ * EVALSHA is logged as EVAL with the script body */
+static void LogEvalsha(Buffer const &buffer, uint32_t request_len)
+{
+  Buffer      record;
+  MmbpRequest request;
+  record.Append(buffer.GetReadBegin(), request_len);
+  request.ParseFrom(record);
+
+  // The unknown script is logged as is, it fails with S_SCRIPT_NONEXISTS also
+  std::string script;
+  if (request.HasValue() && lua::script_cache().Get(request.GetValue().ToString(), script)) {
+    request.command = EVAL;
+    request.value   = String(script.data(), script.size());
+  }
+
+  record.AdvanceAll();
+  request.SerializeTo(record);
+  LogRecord(record.GetReadBegin(), record.GetReadableSize());
+}
+
+/* The record is appended to the request log and shipped to the replicas */
+static inline void LogRequest(Buffer &buffer, uint32_t request_len)
+{
   auto cmd = buffer.GetReadBegin16();
+  if (cmd == EVALSHA) {
+    LogEvalsha(buffer, request_len);
+    return;
+  }
+
   if (GetCommandType((Command)cmd) == CT_WRITE) {
-    LOG_DEBUG << "Log request to file: " << GetCommandString((Command)cmd);
+    LOG_DEBUG << "Log request: " << GetCommandString((Command)cmd);
     LOG_DEBUG << "Log bytes = " << sizeof request_len + request_len;
-    rlog().Append32(request_len);
 
     ExpireTimeField exp = 0;
     if (buffer.GetReadableSize() >= 8) {
@@ -227,6 +557,35 @@ static inline void LogRequestToFile(Buffer &buffer, uint32_t request_len)
       default:;
     }
 
-    rlog().Append(buffer.GetReadBegin(), request_len);
+    LogRecord(buffer.GetReadBegin(), request_len);
   }
 }
+
+/* Like LogRequest(), the relative expiration is converted to
+ * the absolute one to make the recover idempotent */
+static void LogBatch(MmbpBatchRequest &batch)
+{
+  for (auto &request : batch.requests) {
+    switch (request.command) {
+      case EXPIRE_AT:
+        request.expire_time = 1000 * request.expire_time;
+        request.command     = EXPIREM_AT;
+        break;
+      case EXPIRE_AFTER:
+        request.expire_time = 1000 * request.expire_time + database_manager().recv_time();
+        request.command     = EXPIREM_AT;
+        break;
+      case EXPIREM_AFTER:
+        request.expire_time = request.expire_time + database_manager().recv_time();
+        request.command     = EXPIREM_AT;
+        break;
+      default:;
+    }
+  }
+
+  Buffer buffer;
+  batch.SerializeTo(buffer);
+  LOG_DEBUG << "Log batch: " << batch.requests.size() << " requests";
+  LOG_DEBUG << "Log bytes = " << sizeof(uint32_t) + buffer.GetReadableSize();
+  LogRecord(buffer.GetReadBegin(), buffer.GetReadableSize());
+}
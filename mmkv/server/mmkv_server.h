@@ -5,6 +5,9 @@
 #include "kanon/util/noncopyable.h"
 #include "kanon/net/user_server.h"
 #include "mmkv/protocol/mmbp_codec.h"
+#include "mmkv/protocol/resp_codec.h"
+#include "mmkv/server/replica_client.h"
+#include "mmkv/server/stall_watchdog.h"
 #include "mmkv/tracker/shard_controller_client.h"
 
 namespace mmkv {
@@ -16,15 +19,24 @@ class MmkvServer {
   DISABLE_EVIL_COPYABLE(MmkvServer)
   friend class MmkvSession;
 
-  using Codec = protocol::MmbpCodec;
+  using Codec     = protocol::MmbpCodec;
+  using RespCodec = protocol::RespCodec;
 
  public:
   explicit MmkvServer(EventLoop *loop, InetAddr const &addr, InetAddr const &sharder_addr);
   ~MmkvServer() noexcept;
 
-  void Listen() { server_.StartRun(); }
+  void Listen()
+  {
+    server_.StartRun();
+    if (resp_server_) resp_server_->StartRun();
+  }
 
-  void SetLoopNum(int num) { server_.SetLoopNum(num); }
+  void SetLoopNum(int num)
+  {
+    server_.SetLoopNum(num);
+    if (resp_server_) resp_server_->SetLoopNum(num);
+  }
 
   void Start();
 
@@ -33,8 +45,18 @@ class MmkvServer {
 
   Codec codec_;
 
+  /* Accept the redis clients if RespEndpoint is configured */
+  std::unique_ptr<TcpServer> resp_server_;
+  RespCodec                  resp_codec_;
+
   // std::unique_ptr<EventLoopThread> tracker_cli_loop_thr_;
   std::unique_ptr<ShardControllerClient> ctler_cli_;
+
+  /* Follow the primary if ReplicaOf is configured */
+  std::unique_ptr<ReplicaClient> replica_cli_;
+
+  /* Declared last, thus it is stopped before the loops are destroyed */
+  std::unique_ptr<StallWatchdog> watchdog_;
 };
 
 } // namespace server
@@ -7,6 +7,8 @@
 
 #include "mmkv/protocol/mmbp.h"
 #include "mmkv/protocol/mmbp_codec.h"
+#include "mmkv/protocol/mmbp_request.h"
+#include "mmkv/protocol/mmbp_response.h"
 #include <kanon/net/callback.h>
 
 namespace mmkv {
@@ -21,9 +23,38 @@ class MmkvSession {
   MmkvSession(TcpConnectionPtr const &conn, MmkvServer *server);
   ~MmkvSession() noexcept;
 
+  /**
+   * \brief The request and response reused by the messages of the connection
+   * The strings and containers keep their capacity between messages,
+   * thus no allocation is required once they are warm.
+   * \note
+   *  The request is overwritten by the next parse,
+   *  the response must be Reset() before executed.
+   */
+  protocol::MmbpRequest  &request() noexcept { return request_; }
+  protocol::MmbpResponse &response() noexcept { return response_; }
+
+  /**
+   * \brief The next request is asked by the node migrating its key
+   * Only the next request is affected, see TakeAsking().
+   */
+  void SetAsking() noexcept { is_asking_ = true; }
+
+  /** \brief Whether the request follows ASKING, then the flag is cleared */
+  bool TakeAsking() noexcept
+  {
+    const bool is_asking = is_asking_;
+    is_asking_           = false;
+    return is_asking;
+  }
+
  private:
   TcpConnection *conn_;
   MmkvServer    *server_;
+  bool           is_asking_ = false;
+
+  protocol::MmbpRequest  request_;
+  protocol::MmbpResponse response_;
 };
 
 } // namespace server
@@ -0,0 +1,204 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "replica_client.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mmkv/server/config.h"
+#include "mmkv/server/replication.h"
+#include "mmkv/storage/db.h"
+#include "mmkv/util/time_util.h"
+
+#include <kanon/log/logger.h>
+#include <kanon/net/tcp_client.h>
+
+using namespace mmkv::server;
+using namespace mmkv::protocol;
+using namespace mmkv::storage;
+using namespace mmkv::util;
+using namespace mmkv;
+using namespace kanon;
+
+static ReplicaClient *g_replica_client = nullptr;
+
+ReplicaClient *mmkv::server::replica_client() noexcept { return g_replica_client; }
+
+static char const *STATE_STRS[] = {"connecting", "handshake", "syncing", "streaming"};
+
+static inline char *EncodeU64(char *p, uint64_t i) noexcept
+{
+  i = sock::ToNetworkByteOrder64(i);
+  ::memcpy(p, &i, sizeof i);
+  return p + sizeof i;
+}
+
+ReplicaClient::ReplicaClient(EventLoop *loop, InetAddr const &primary_addr)
+  : cli_(NewTcpClient(loop, primary_addr, "ReplicaClient"))
+  , conn_(nullptr)
+  , has_ack_timer_(false)
+  , state_(RS_CONNECTING)
+  , repl_id_(0)
+  , offset_(0)
+  , last_io_ms_(0)
+  , full_sync_num_(0)
+{
+  assert(!g_replica_client);
+  g_replica_client = this;
+
+  cli_->EnableRetry();
+  cli_->SetConnectionCallback([this](TcpConnectionPtr const &conn) { OnConnection(conn); });
+}
+
+ReplicaClient::~ReplicaClient() noexcept { g_replica_client = nullptr; }
+
+void ReplicaClient::Connect()
+{
+  LOG_INFO << "Following the primary " << mmkv_config().replica_of;
+  cli_->Connect();
+}
+
+void ReplicaClient::OnConnection(TcpConnectionPtr const &conn)
+{
+  if (!conn->IsConnected()) {
+    LOG_WARN << "The connection to primary is broken, reconnecting...";
+    conn_ = nullptr;
+    if (has_ack_timer_) {
+      cli_->GetLoop()->CancelTimer(ack_timer_);
+      has_ack_timer_ = false;
+    }
+
+    // The data is incomplete, sync fully in the next time
+    if (state_ == RS_SYNCING) repl_id_ = 0;
+    state_ = RS_CONNECTING;
+    return;
+  }
+
+  conn_  = conn.get();
+  state_ = RS_HANDSHAKE;
+  conn->SetMessageCallback([this](TcpConnectionPtr const &conn, Buffer &buffer, TimeStamp) {
+    OnMessage(conn, buffer);
+  });
+
+  char handshake[REPL_HANDSHAKE_SIZE];
+  EncodeU64(EncodeU64(handshake, repl_id_), repl_id_ ? offset_.load() : 0);
+  OutputBuffer output;
+  output.Append(handshake, sizeof handshake);
+  conn->Send(output);
+
+  ack_timer_     = cli_->GetLoop()->RunEvery([this]() { SendAck(); }, REPL_ACK_INTERVAL);
+  has_ack_timer_ = true;
+}
+
+void ReplicaClient::OnMessage(TcpConnectionPtr const &conn, Buffer &buffer)
+{
+  last_io_ms_ = GetTimeMs();
+
+  if (state_ == RS_HANDSHAKE) {
+    if (buffer.GetReadableSize() < REPL_SYNC_HEADER_SIZE) return;
+    const auto sync_type = (ReplSyncType)*buffer.GetReadBegin();
+    buffer.AdvanceRead(sizeof(uint8_t));
+    repl_id_ = buffer.Read64();
+    offset_  = buffer.Read64();
+
+    if (sync_type == RST_FULL) {
+      LOG_INFO << "Full sync from offset " << offset_.load();
+      ++full_sync_num_;
+
+      // Discard the stale data, the deletion is also logged to be replayed
+      ReplicationGate repl_gate(true);
+      request_.Reset();
+      request_.command = DELALL;
+      if (IsRecordLogged()) {
+        Buffer record;
+        request_.SerializeTo(record);
+        LogRecord(record.GetReadBegin(), record.GetReadableSize());
+      }
+      database_manager().Execute(request_, nullptr);
+    } else {
+      LOG_INFO << "Continue from offset " << offset_.load();
+    }
+
+    state_ = sync_type == RST_FULL ? RS_SYNCING : RS_STREAMING;
+  }
+
+  ApplyRecords(buffer);
+}
+
+void ReplicaClient::ApplyRecords(Buffer &buffer)
+{
+  while (buffer.GetReadableSize() >= sizeof(uint32_t)) {
+    uint32_t   len         = buffer.GetReadBegin32();
+    const bool is_snapshot = len & REPL_SNAPSHOT_FLAG;
+    len &= ~REPL_SNAPSHOT_FLAG;
+    if (buffer.GetReadableSize() < sizeof(uint32_t) + len) break;
+    buffer.AdvanceRead32();
+
+    if (!is_snapshot) {
+      ApplyRecord(buffer, len);
+      offset_ += sizeof(uint32_t) + len;
+      continue;
+    }
+
+    if (len == 0) {
+      LOG_INFO << "The snapshot is applied, streaming from offset " << offset_.load();
+      state_ = RS_STREAMING;
+      continue;
+    }
+
+    // The chunk of snapshot consists of the dumped records, they don't advance the offset
+    const auto end_size = buffer.GetReadableSize() - len;
+    while (buffer.GetReadableSize() > end_size) {
+      const uint32_t record_len = buffer.GetReadBegin32();
+      buffer.AdvanceRead32();
+      ApplyRecord(buffer, record_len);
+    }
+  }
+}
+
+void ReplicaClient::ApplyRecord(Buffer &buffer, uint32_t len)
+{
+  // Like the write request from client, see ReplicationGate
+  ReplicationGate repl_gate(true);
+  if (IsRecordLogged()) LogRecord(buffer.GetReadBegin(), len);
+
+  // The record is parsed and executed like recovering
+  if (request_.PeekCommand(buffer) == BATCH) {
+    batch_.ParseFrom(buffer);
+    database_manager().ExecuteBatch(batch_, nullptr);
+  } else {
+    request_.ParseFrom(buffer);
+    database_manager().Execute(request_, nullptr);
+  }
+  LogPendingDels();
+}
+
+void ReplicaClient::SendAck()
+{
+  if (!conn_ || state_ == RS_HANDSHAKE) return;
+
+  char ack[REPL_ACK_SIZE];
+  EncodeU64(ack, offset_);
+  OutputBuffer output;
+  output.Append(ack, sizeof ack);
+  conn_->Send(output);
+}
+
+void ReplicaClient::GetInfo(algo::String &info)
+{
+  char       line[256];
+  const auto last_io_ms = last_io_ms_.load();
+  ::snprintf(
+      line,
+      sizeof line,
+      "role:replica\nprimary_endpoint:%s\nlink_status:%s\nsync_state:%s\nrepl_offset:%" PRIu64
+      "\nfull_sync_num:%" PRIu64 "\nlast_io_seconds_ago:%" PRId64 "\n",
+      mmkv_config().replica_of.c_str(),
+      state_ == RS_CONNECTING ? "down" : "up",
+      STATE_STRS[state_],
+      offset_.load(),
+      full_sync_num_.load(),
+      last_io_ms ? (GetTimeMs() - last_io_ms) / 1000 : -1
+  );
+  info += line;
+}
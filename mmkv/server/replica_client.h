@@ -0,0 +1,84 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_SERVER_REPLICA_CLIENT_H_
+#define _MMKV_SERVER_REPLICA_CLIENT_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#include "mmkv/algo/string.h"
+#include "mmkv/protocol/mmbp_batch.h"
+#include "mmkv/protocol/mmbp_request.h"
+
+#include <kanon/net/user_client.h>
+#include <kanon/util/noncopyable.h>
+
+namespace mmkv {
+namespace server {
+
+/**
+ * \brief Follow the primary, i.e. apply the records shipped by the primary
+ * The replica starts from a full sync(the snapshot of primary) and
+ * then applies the records in order, it reconnects and continues from
+ * its offset if the connection is broken.
+ * The applied records are also logged(see LogRecord()), thus the replica
+ * can recover from its request log and ship the records to its replicas.
+ */
+class ReplicaClient {
+  DISABLE_EVIL_COPYABLE(ReplicaClient)
+
+ public:
+  enum State : uint8_t {
+    RS_CONNECTING = 0,
+    RS_HANDSHAKE,
+    RS_SYNCING, /** Applying the snapshot */
+    RS_STREAMING,
+  };
+
+  ReplicaClient(kanon::EventLoop *loop, kanon::InetAddr const &primary_addr);
+  ~ReplicaClient() noexcept;
+
+  void Connect();
+
+  /** Append the state of replica to INFO */
+  void GetInfo(algo::String &info);
+
+ private:
+  void OnConnection(kanon::TcpConnectionPtr const &conn);
+  void OnMessage(kanon::TcpConnectionPtr const &conn, kanon::Buffer &buffer);
+
+  /* Apply the complete records and snapshot chunks in the buffer */
+  void ApplyRecords(kanon::Buffer &buffer);
+
+  /* Apply the record of len bytes at the beginning of buffer */
+  void ApplyRecord(kanon::Buffer &buffer, uint32_t len);
+
+  void SendAck();
+
+  kanon::TcpClientPtr   cli_;
+  kanon::TcpConnection *conn_;
+  kanon::TimerId        ack_timer_;
+  bool                  has_ack_timer_;
+
+  /* The fields are only modified in the loop thread,
+   * the atomics are read by INFO */
+  std::atomic<State>    state_;
+  uint64_t              repl_id_;
+  std::atomic<uint64_t> offset_;
+  std::atomic<int64_t>  last_io_ms_;
+  std::atomic<uint64_t> full_sync_num_;
+
+  protocol::MmbpRequest      request_;
+  protocol::MmbpBatchRequest batch_;
+};
+
+/**
+ * \brief The replica client of this server
+ * \return
+ *  nullptr if this isn't a replica
+ */
+ReplicaClient *replica_client() noexcept;
+
+} // namespace server
+} // namespace mmkv
+
+#endif // _MMKV_SERVER_REPLICA_CLIENT_H_
@@ -0,0 +1,144 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "replication.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "config.h"
+#include "replica_client.h"
+#include "replication_source.h"
+
+#include "mmkv/disk/request_log.h"
+#include "mmkv/protocol/mmbp_request.h"
+
+using namespace mmkv::server;
+using namespace mmkv::algo;
+using namespace mmkv::disk;
+using namespace mmkv::protocol;
+using namespace kanon;
+
+ReplicationBacklog::ReplicationBacklog(size_t capacity)
+  : ring_(capacity)
+  , size_(0)
+  , end_offset_(0)
+{
+  assert(capacity > 0);
+}
+
+void ReplicationBacklog::Append(void const *data, size_t len)
+{
+  const auto cap = ring_.size();
+  auto       p   = (char const *)data;
+
+  end_offset_ += len;
+  // Only the last capacity bytes are kept
+  if (len > cap) {
+    p   += len - cap;
+    len  = cap;
+  }
+
+  const size_t written = len;
+  size_t       pos     = (end_offset_ - len) % cap;
+  while (len > 0) {
+    const auto n = std::min(len, cap - pos);
+    ::memcpy(ring_.data() + pos, p, n);
+    p   += n;
+    len -= n;
+    pos  = 0;
+  }
+
+  size_ = std::min(cap, size_ + written);
+}
+
+bool ReplicationBacklog::CopyFrom(uint64_t offset, std::string &data) const
+{
+  if (!Contains(offset)) return false;
+
+  const auto cap = ring_.size();
+  size_t     len = end_offset_ - offset;
+  size_t     pos = offset % cap;
+  data.reserve(data.size() + len);
+  while (len > 0) {
+    const auto n = std::min(len, cap - pos);
+    data.append(ring_.data() + pos, n);
+    len -= n;
+    pos  = 0;
+  }
+  return true;
+}
+
+ReplicationGate::ReplicationGate(bool is_write)
+  : gate_(is_write && mmkv_config().IsReplicationEnabled() ? &repl_source().write_gate()
+                                                             : nullptr)
+{
+  if (gate_) gate_->RLock();
+}
+
+ReplicationGate::~ReplicationGate() noexcept
+{
+  if (gate_) gate_->RUnlock();
+}
+
+void mmkv::server::GetReplicationInfo(String &info)
+{
+  info += "# Replication\n";
+
+  auto replica = replica_client();
+  if (replica) {
+    replica->GetInfo(info);
+  } else if (mmkv_config().IsReplicationEnabled()) {
+    info += "role:primary\n";
+  } else {
+    info += "role:none\n";
+  }
+
+  // The replica can also be the primary of other replicas
+  if (mmkv_config().IsReplicationEnabled()) repl_source().GetInfo(info);
+}
+
+bool mmkv::server::IsRecordLogged() noexcept
+{
+  return mmkv_config().log_method == LM_REQUEST || mmkv_config().IsReplicationEnabled();
+}
+
+/* The DELs of the keys dropped by this thread, see LogDel() */
+static thread_local std::vector<String> t_pending_dels;
+
+static inline void AppendRecord(void const *data, uint32_t len)
+{
+  if (mmkv_config().log_method == LM_REQUEST) rlog().AppendRecord(data, len);
+  if (mmkv_config().IsReplicationEnabled()) repl_source().Append(data, len);
+}
+
+void mmkv::server::LogRecord(void const *data, uint32_t len)
+{
+  // The keys dropped before the record are deleted before it also
+  LogPendingDels();
+  AppendRecord(data, len);
+}
+
+void mmkv::server::LogDel(String key) { t_pending_dels.emplace_back(std::move(key)); }
+
+void mmkv::server::LogPendingDels()
+{
+  if (t_pending_dels.empty()) return;
+
+  MmbpRequest         request;
+  Buffer              buffer;
+  std::vector<String> keys;
+
+  // Appending may drop keys again, e.g. the replication dumps the expired key
+  while (!t_pending_dels.empty()) {
+    keys.swap(t_pending_dels);
+    for (auto &key : keys) {
+      request.SetKey();
+      request.key     = std::move(key);
+      request.command = DEL;
+      request.SerializeTo(buffer);
+      AppendRecord(buffer.GetReadBegin(), buffer.GetReadableSize());
+      buffer.AdvanceAll();
+      request.Reset();
+    }
+    keys.clear();
+  }
+}
@@ -0,0 +1,147 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_SERVER_REPLICATION_H_
+#define _MMKV_SERVER_REPLICATION_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "mmkv/algo/string.h"
+
+#include <kanon/thread/rw_lock.h>
+#include <kanon/util/noncopyable.h>
+
+namespace mmkv {
+namespace server {
+
+/*
+ * The replication protocol(the integers are in network byte order):
+ * 1. The replica sends the handshake <replication id(u64), offset(u64)>,
+ *    both are 0 if the replica has no data.
+ * 2. The primary replies <sync type(u8), replication id(u64), offset(u64)>.
+ *    If the replication id is same and the offset is kept in the backlog,
+ *    the sync type is RST_CONTINUE, otherwise RST_FULL.
+ * 3. The primary ships the records since the offset, the record is same with
+ *    the request log, i.e. MMBP request(or batch) with 32-bit length header.
+ *    In the full sync, the snapshot is streamed in chunks between the records,
+ *    the chunk is the dumped requests(see DumpKey()) framed with the length
+ *    header marked by REPL_SNAPSHOT_FLAG, and the empty chunk ends the snapshot.
+ *    Each key is dumped before the first record accessing it, thus the records
+ *    are applied on the keys consistent with the offset.
+ * 4. The replica acks its offset(u64) in every REPL_ACK_INTERVAL seconds.
+ *
+ * The offset is the number of record bytes shipped since the primary started,
+ * the replication id is generated when the primary started.
+ */
+#define REPL_HANDSHAKE_SIZE   (sizeof(uint64_t) * 2)
+#define REPL_SYNC_HEADER_SIZE (sizeof(uint8_t) + sizeof(uint64_t) * 2)
+#define REPL_ACK_SIZE         sizeof(uint64_t)
+#define REPL_ACK_INTERVAL     1 // second
+#define REPL_SNAPSHOT_FLAG    (1U << 31)
+#define REPL_SNAPSHOT_CHUNK   (1 << 16) // The snapshot is dumped in chunks of about this size
+
+enum ReplSyncType : uint8_t {
+  RST_CONTINUE = 0,
+  RST_FULL,
+};
+
+/**
+ * \brief The recent records in a fixed-size ring
+ * The disconnected replica continues from its offset if it is still kept.
+ *
+ * \warning Not thread-safe
+ */
+class ReplicationBacklog {
+  DISABLE_EVIL_COPYABLE(ReplicationBacklog)
+
+ public:
+  explicit ReplicationBacklog(size_t capacity);
+
+  /** The oldest bytes are overwritten if full */
+  void Append(void const *data, size_t len);
+
+  /**
+   * \brief Copy the bytes in [offset, end_offset())
+   * \return
+   *  false if the offset is not kept
+   */
+  bool CopyFrom(uint64_t offset, std::string &data) const;
+
+  bool Contains(uint64_t offset) const noexcept
+  {
+    return offset >= start_offset() && offset <= end_offset_;
+  }
+
+  /** The offset of the oldest kept byte */
+  uint64_t start_offset() const noexcept { return end_offset_ - size_; }
+
+  /** The offset of the next appended byte */
+  uint64_t end_offset() const noexcept { return end_offset_; }
+
+  size_t size() const noexcept { return size_; }
+  size_t capacity() const noexcept { return ring_.size(); }
+
+ private:
+  std::vector<char> ring_;
+  size_t            size_;
+  uint64_t          end_offset_;
+};
+
+/**
+ * \brief Block the start of full sync when the write request is being logged and executed
+ * The snapshot of full sync must be consistent with its offset,
+ * i.e. the records before the offset are applied,
+ * thus the write request holds the gate from logging to executing and
+ * the full sync starts until the gate is released by all the writers.
+ * The snapshot is streamed after the gate is released.
+ * Do nothing if the replication is disabled.
+ */
+class ReplicationGate {
+  DISABLE_EVIL_COPYABLE(ReplicationGate)
+
+ public:
+  explicit ReplicationGate(bool is_write);
+  ~ReplicationGate() noexcept;
+
+ private:
+  kanon::RWLock *gate_;
+};
+
+/**
+ * \brief Whether the write requests are recorded
+ * i.e. the request log or replication is enabled
+ */
+bool IsRecordLogged() noexcept;
+
+/**
+ * \brief Log the record(i.e. a serialized MMBP request or batch)
+ * The record is appended to the request log and shipped to the replicas
+ * with its 32-bit length header, thus the recover and replica replay it in same way.
+ * \note Thread-safe
+ */
+void LogRecord(void const *data, uint32_t len);
+
+/**
+ * \brief Log MMBP request "Del key" of the expired or evicted key
+ * The key is dropped with the lock of instance held, and the replication
+ * dumps keys when logging, thus the DEL is queued in the thread and
+ * logged by LogPendingDels() or before the next record of the thread.
+ */
+void LogDel(algo::String key);
+
+/**
+ * \brief Log the DELs queued by LogDel() in this thread
+ * \warning Don't hold the lock of any instance
+ */
+void LogPendingDels();
+
+/**
+ * \brief Append the replication section of INFO
+ * e.g. role, offset and the lag of each replica
+ */
+void GetReplicationInfo(algo::String &info);
+
+} // namespace server
+} // namespace mmkv
+
+#endif // _MMKV_SERVER_REPLICATION_H_
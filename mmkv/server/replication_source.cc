@@ -0,0 +1,429 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "replication_source.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <random>
+
+#include "mmkv/server/config.h"
+#include "mmkv/storage/db.h"
+#include "mmkv/util/time_util.h"
+
+#include <kanon/log/logger.h>
+
+using namespace mmkv::server;
+using namespace mmkv::protocol;
+using namespace mmkv::storage;
+using namespace mmkv::util;
+using namespace mmkv;
+using namespace kanon;
+
+/* The keys scanned in a step, the chunk is dumped by steps */
+#define SNAPSHOT_SCAN_COUNT 64
+
+ReplicationSource &mmkv::server::repl_source()
+{
+  static ReplicationSource source;
+  return source;
+}
+
+static inline char *EncodeU64(char *p, uint64_t i) noexcept
+{
+  i = sock::ToNetworkByteOrder64(i);
+  ::memcpy(p, &i, sizeof i);
+  return p + sizeof i;
+}
+
+static inline void SendSnapshotChunkTo(TcpConnection *conn, Buffer const &chunk)
+{
+  const auto nlen = sock::ToNetworkByteOrder32((uint32_t)chunk.GetReadableSize() | REPL_SNAPSHOT_FLAG);
+  OutputBuffer output;
+  output.Append(&nlen, sizeof nlen);
+  output.Append(chunk.GetReadBegin(), chunk.GetReadableSize());
+  conn->Send(output);
+}
+
+ReplicationSource::ReplicationSource()
+  : repl_id_(std::random_device{}() | ((uint64_t)std::random_device{}() << 32))
+  , backlog_(mmkv_config().replication_backlog_size)
+  , full_sync_num_(0)
+  , syncing_num_(0)
+{
+  // 0 indicates the replica has no data
+  if (repl_id_ == 0) repl_id_ = 1;
+}
+
+ReplicationSource::~ReplicationSource() noexcept {}
+
+void ReplicationSource::Listen(EventLoop *loop)
+{
+  server_.reset(new TcpServer(loop, InetAddr(mmkv_config().replication_endpoint), "MmkvReplication")
+  );
+
+  server_->SetConnectionCallback([this](TcpConnectionPtr const &conn) {
+    MutexGuard guard(mutex_);
+    if (conn->IsConnected()) {
+      LOG_INFO << "The replica " << conn->GetPeerAddr().ToIpPort() << " is connected";
+      std::unique_ptr<Replica> replica(new Replica);
+      replica->conn          = conn;
+      replica->addr          = conn->GetPeerAddr().ToIpPort();
+      replica->is_online     = false;
+      replica->is_syncing    = false;
+      replica->ack_offset    = 0;
+      replica->ack_time_ms   = GetTimeMs();
+      replica->sync_cursor   = 0;
+      replica->sync_start_ms = 0;
+      replicas_.emplace_back(std::move(replica));
+
+      conn->SetMessageCallback([this](TcpConnectionPtr const &conn, Buffer &buffer, TimeStamp) {
+        OnMessage(conn, buffer);
+      });
+
+      // The snapshot is streamed chunk by chunk, thus it isn't buffered entirely
+      conn->SetWriteCompleteCallback([this](TcpConnectionPtr const &conn) {
+        SendSnapshotChunk(conn.get());
+      });
+
+      // The replica can't keep up with the writes, the output is unbounded otherwise
+      const auto output_limit = mmkv_config().replica_output_limit;
+      if (output_limit > 0) {
+        conn->SetHighWaterMarkCallback(
+            [output_limit](TcpConnectionPtr const &conn, size_t size) {
+              LOG_WARN << "The output of replica " << conn->GetPeerAddr().ToIpPort() << " is "
+                       << size << " bytes, exceeds the limit " << output_limit
+                       << ", disconnect it";
+              conn->ForceClose();
+            },
+            output_limit
+        );
+      }
+    } else {
+      LOG_INFO << "The replica " << conn->GetPeerAddr().ToIpPort() << " is disconnected";
+      for (auto iter = replicas_.begin(); iter != replicas_.end(); ++iter) {
+        if ((*iter)->conn == conn) {
+          if ((*iter)->is_syncing) --syncing_num_;
+          replicas_.erase(iter);
+          break;
+        }
+      }
+    }
+  });
+
+  LOG_INFO << "The mmkv accepts the replicas in " << mmkv_config().replication_endpoint;
+  server_->StartRun();
+}
+
+void ReplicationSource::Append(void const *data, uint32_t len)
+{
+  {
+    MutexGuard guard(mutex_);
+    if (syncing_num_ == 0) {
+      ShipRecord(data, len);
+      return;
+    }
+  }
+
+  // The record may access the keys not dumped yet, they are dumped before it
+  std::vector<String> keys;
+  {
+    Buffer                  record;
+    MmbpRequest             request;
+    MmbpBatchRequest        batch;
+    std::vector<StringView> key_views;
+    record.Append(data, len);
+    if (request.PeekCommand(record) == BATCH) {
+      batch.ParseFrom(record);
+      for (auto const &sub_request : batch.requests)
+        GetRequestKeys(sub_request, key_views);
+    } else {
+      request.ParseFrom(record);
+      GetRequestKeys(request, key_views);
+    }
+    for (auto key : key_views)
+      keys.emplace_back(key.data(), key.size());
+  }
+
+  // The dumps are stale if a full sync starts after dumping,
+  // since the records before its offset may be applied after dumping
+  KeyDumps dumps;
+  bool     is_dumped     = false;
+  uint64_t full_sync_num = 0;
+  for (;;) {
+    {
+      MutexGuard guard(mutex_);
+      if (is_dumped && full_sync_num == full_sync_num_) {
+        for (auto &replica : replicas_) {
+          if (replica->is_syncing) SendKeyDumps(*replica, dumps);
+        }
+        ShipRecord(data, len);
+        return;
+      }
+
+      if (!HasUnsyncedKey(keys)) {
+        ShipRecord(data, len);
+        return;
+      }
+      full_sync_num = full_sync_num_;
+    }
+
+    dumps.Clear();
+    for (auto const &key : keys)
+      dumps.Dump(key);
+    is_dumped = true;
+  }
+}
+
+void ReplicationSource::ShipRecord(void const *data, uint32_t len)
+{
+  const auto nlen = sock::ToNetworkByteOrder32(len);
+  backlog_.Append(&nlen, sizeof nlen);
+  backlog_.Append(data, len);
+
+  for (auto &replica : replicas_) {
+    if (!replica->is_online) continue;
+    OutputBuffer output;
+    output.Append(&nlen, sizeof nlen);
+    output.Append(data, len);
+    replica->conn->Send(output);
+  }
+}
+
+bool ReplicationSource::HasUnsyncedKey(std::vector<String> const &keys)
+{
+  for (auto const &replica : replicas_) {
+    if (!replica->is_syncing) continue;
+    for (auto const &key : keys) {
+      if (!replica->synced_keys.Find(key)) return true;
+    }
+  }
+  return false;
+}
+
+void ReplicationSource::KeyDumps::Dump(String key)
+{
+  // The key not exists is also dumped(i.e. empty), it is created by the records
+  database_manager().Dump(key, buffer);
+  keys.emplace_back(std::move(key));
+  ends.push_back(buffer.GetReadableSize());
+}
+
+void ReplicationSource::KeyDumps::Clear()
+{
+  keys.clear();
+  ends.clear();
+  buffer.AdvanceAll();
+}
+
+bool ReplicationSource::SendKeyDumps(Replica &replica, KeyDumps const &dumps)
+{
+  Buffer chunk;
+  size_t begin = 0;
+  for (size_t i = 0; i < dumps.keys.size(); ++i) {
+    const auto end = dumps.ends[i];
+    if (replica.synced_keys.Insert(dumps.keys[i]) && end > begin) {
+      chunk.Append(dumps.buffer.GetReadBegin() + begin, end - begin);
+    }
+    begin = end;
+  }
+
+  if (chunk.GetReadableSize() == 0) return false;
+  SendSnapshotChunkTo(replica.conn.get(), chunk);
+  return true;
+}
+
+void ReplicationSource::OnMessage(TcpConnectionPtr const &conn, Buffer &buffer)
+{
+  Replica *replica = FindReplica(conn.get());
+  if (!replica) return;
+
+  if (!replica->is_online) {
+    if (buffer.GetReadableSize() < REPL_HANDSHAKE_SIZE) return;
+    const auto repl_id = buffer.Read64();
+    const auto offset  = buffer.Read64();
+    Sync(*replica, repl_id, offset);
+  }
+
+  uint64_t ack_offset = 0;
+  bool     has_ack    = false;
+  while (buffer.GetReadableSize() >= REPL_ACK_SIZE) {
+    ack_offset = buffer.Read64();
+    has_ack    = true;
+  }
+
+  if (has_ack) {
+    MutexGuard guard(mutex_);
+    replica->ack_offset  = ack_offset;
+    replica->ack_time_ms = GetTimeMs();
+  }
+}
+
+void ReplicationSource::Sync(Replica &replica, uint64_t repl_id, uint64_t offset)
+{
+  bool is_full;
+  {
+    MutexGuard guard(mutex_);
+    is_full = repl_id != repl_id_ || !backlog_.Contains(offset);
+  }
+
+  if (is_full) {
+    {
+      // The records before the offset must be applied when the snapshot starts,
+      // then the snapshot is streamed without blocking the writers
+      WLockGuard gate_guard(gate_);
+      MutexGuard guard(mutex_);
+      StartSync(replica, true, backlog_.end_offset(), std::string());
+    }
+    SendSnapshotChunk(replica.conn.get());
+    return;
+  }
+
+  MutexGuard  guard(mutex_);
+  std::string records;
+  if (!backlog_.CopyFrom(offset, records)) {
+    LOG_WARN << "The backlog is overwritten when syncing the replica " << replica.addr
+             << ", the backlog size may be too small";
+    replica.conn->ShutdownWrite();
+    return;
+  }
+  StartSync(replica, false, offset, records);
+}
+
+void ReplicationSource::StartSync(
+    Replica           &replica,
+    bool               is_full,
+    uint64_t           offset,
+    std::string const &records
+)
+{
+  char header[REPL_SYNC_HEADER_SIZE];
+  auto p = header;
+  *p++   = is_full ? RST_FULL : RST_CONTINUE;
+  p      = EncodeU64(p, repl_id_);
+  EncodeU64(p, offset);
+
+  // The records appended after the offset are shipped since now
+  OutputBuffer output;
+  output.Append(header, sizeof header);
+  output.Append(records.data(), records.size());
+  replica.conn->Send(output);
+
+  replica.is_online   = true;
+  replica.ack_offset  = offset;
+  replica.ack_time_ms = GetTimeMs();
+  if (!is_full) {
+    LOG_INFO << "The replica " << replica.addr << " continues from offset " << offset;
+    return;
+  }
+
+  LOG_INFO << "Full sync the replica " << replica.addr << " from offset " << offset;
+  replica.is_syncing    = true;
+  replica.sync_cursor   = 0;
+  replica.sync_start_ms = GetTimeMs();
+  replica.synced_keys.Clear();
+  ++syncing_num_;
+  ++full_sync_num_;
+}
+
+void ReplicationSource::SendSnapshotChunk(TcpConnection const *conn)
+{
+  KeyDumps  dumps;
+  StrValues keys;
+  for (;;) {
+    size_t start_cursor;
+    {
+      MutexGuard guard(mutex_);
+      auto       replica = FindReplicaLocked(conn);
+      if (!replica || !replica->is_syncing) return;
+      start_cursor = replica->sync_cursor;
+    }
+
+    // The scan returns the key multiple times if the instance is rehashed,
+    // and the keys accessed by the records since the offset are dumped already,
+    // they are filtered when sending
+    auto cursor = start_cursor;
+    dumps.Clear();
+    do {
+      keys.clear();
+      cursor = database_manager().Scan(cursor, SNAPSHOT_SCAN_COUNT, keys);
+      for (auto &key : keys)
+        dumps.Dump(std::move(key));
+    } while (cursor != 0 && dumps.buffer.GetReadableSize() < REPL_SNAPSHOT_CHUNK);
+
+    MutexGuard guard(mutex_);
+    auto       replica = FindReplicaLocked(conn);
+    if (!replica || !replica->is_syncing || replica->sync_cursor != start_cursor) return;
+    replica->sync_cursor = cursor;
+
+    const bool is_sent = SendKeyDumps(*replica, dumps);
+    if (cursor != 0) {
+      // The next chunk is sent when this is sent, nothing to wait otherwise
+      if (is_sent) return;
+      continue;
+    }
+
+    // The empty chunk ends the snapshot
+    SendSnapshotChunkTo(replica->conn.get(), Buffer());
+    LOG_INFO << "The snapshot of replica " << replica->addr << " is sent: "
+             << replica->synced_keys.size() << " keys, costs "
+             << GetTimeMs() - replica->sync_start_ms << "ms";
+    replica->is_syncing = false;
+    replica->synced_keys.Clear();
+    --syncing_num_;
+    return;
+  }
+}
+
+auto ReplicationSource::FindReplica(TcpConnection const *conn) -> Replica *
+{
+  MutexGuard guard(mutex_);
+  return FindReplicaLocked(conn);
+}
+
+auto ReplicationSource::FindReplicaLocked(TcpConnection const *conn) -> Replica *
+{
+  for (auto &replica : replicas_) {
+    if (replica->conn.get() == conn) return replica.get();
+  }
+  return nullptr;
+}
+
+void ReplicationSource::GetInfo(algo::String &info)
+{
+  char       line[256];
+  const auto now_ms = GetTimeMs();
+
+  MutexGuard guard(mutex_);
+  ::snprintf(
+      line,
+      sizeof line,
+      "repl_id:%016" PRIx64 "\nrepl_offset:%" PRIu64 "\nrepl_backlog_first_offset:%" PRIu64
+      "\nrepl_backlog_size:%zu\nfull_sync_num:%" PRIu64 "\nconnected_replicas:%zu\n",
+      repl_id_,
+      backlog_.end_offset(),
+      backlog_.start_offset(),
+      backlog_.capacity(),
+      full_sync_num_,
+      replicas_.size()
+  );
+  info += line;
+
+  // The lag is the number of bytes not acked by the replica
+  for (size_t i = 0; i < replicas_.size(); ++i) {
+    auto const &replica = *replicas_[i];
+    ::snprintf(
+        line,
+        sizeof line,
+        "replica%zu:addr=%s,state=%s,offset=%" PRIu64 ",lag=%" PRIu64 ",ack_age_ms=%" PRId64 "\n",
+        i,
+        replica.addr.c_str(),
+        replica.is_syncing  ? "syncing"
+        : replica.is_online ? "online"
+                            : "handshake",
+        replica.ack_offset,
+        backlog_.end_offset() - replica.ack_offset,
+        now_ms - replica.ack_time_ms
+    );
+    info += line;
+  }
+}
@@ -0,0 +1,133 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_SERVER_REPLICATION_SOURCE_H_
+#define _MMKV_SERVER_REPLICATION_SOURCE_H_
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mmkv/algo/hash_set.h"
+#include "mmkv/algo/string.h"
+#include "mmkv/server/replication.h"
+
+#include <kanon/net/user_server.h>
+#include <kanon/thread/mutex_lock.h>
+#include <kanon/thread/rw_lock.h>
+#include <kanon/util/noncopyable.h>
+
+namespace mmkv {
+namespace server {
+
+/**
+ * \brief Ship the records of write requests to the replicas asynchronously
+ * The records are appended by the threads executing the write requests,
+ * then sent to the online replicas and kept in the backlog.
+ * The primary doesn't wait the acks of replicas, the acks are only used
+ * to report the lag.
+ *
+ * \note
+ *  The snapshot of full sync is dumped in chunks when the previous is sent,
+ *  the writers are only blocked when the full sync starts.
+ *  The keys are dumped without the mutex_ held since the dump locks the instance.
+ */
+class ReplicationSource {
+  DISABLE_EVIL_COPYABLE(ReplicationSource)
+
+  struct Replica {
+    kanon::TcpConnectionPtr conn;
+    std::string             addr;
+    bool                    is_online;   /** The records are shipped */
+    bool                    is_syncing;  /** The snapshot is being streamed */
+    uint64_t                ack_offset;  /** The offset acked by the replica */
+    int64_t                 ack_time_ms; /** The time of the last ack */
+    size_t                  sync_cursor; /** The scan cursor of snapshot */
+    uint64_t                sync_start_ms;
+    /* The keys dumped to the snapshot, each key is dumped once
+     * either by the scan or before the first record accessing it */
+    algo::HashSet<algo::String> synced_keys;
+  };
+
+  /* The keys dumped out of the mutex_, the dump of keys[i] is
+   * [ends[i-1], ends[i]) in the buffer */
+  struct KeyDumps {
+    std::vector<algo::String> keys;
+    std::vector<size_t>       ends;
+    kanon::Buffer             buffer;
+
+    void Dump(algo::String key);
+    void Clear();
+  };
+
+ public:
+  ReplicationSource();
+  ~ReplicationSource() noexcept;
+
+  /**
+   * \brief Accept the replicas in the replication endpoint
+   */
+  void Listen(kanon::EventLoop *loop);
+
+  /**
+   * \brief Ship the record with its 32-bit length header
+   * \note Thread-safe
+   */
+  void Append(void const *data, uint32_t len);
+
+  kanon::RWLock &write_gate() noexcept { return gate_; }
+
+  /** Append the state of primary and replicas to INFO */
+  void GetInfo(algo::String &info);
+
+ private:
+  void OnMessage(kanon::TcpConnectionPtr const &conn, kanon::Buffer &buffer);
+
+  /* Reply the sync header, then start streaming the snapshot if full sync,
+   * or the records since the offset */
+  void Sync(Replica &replica, uint64_t repl_id, uint64_t offset);
+
+  /* Reply the sync header and the records, then the records since the offset are shipped,
+   * the mutex_ must be held */
+  void StartSync(Replica &replica, bool is_full, uint64_t offset, std::string const &records);
+
+  /* Send the next chunk of snapshot, called when the previous is sent */
+  void SendSnapshotChunk(kanon::TcpConnection const *conn);
+
+  /* Send the record to the online replicas and keep it in the backlog,
+   * the mutex_ must be held */
+  void ShipRecord(void const *data, uint32_t len);
+
+  /* Whether any key isn't dumped to the syncing replicas, the mutex_ must be held */
+  bool HasUnsyncedKey(std::vector<algo::String> const &keys);
+
+  /* Send the dumps of keys not dumped to the replica yet, the mutex_ must be held
+   * \return Whether any dump is sent */
+  bool SendKeyDumps(Replica &replica, KeyDumps const &dumps);
+
+  Replica *FindReplica(kanon::TcpConnection const *conn);
+
+  /* Like FindReplica() but the mutex_ must be held */
+  Replica *FindReplicaLocked(kanon::TcpConnection const *conn);
+
+  std::unique_ptr<kanon::TcpServer> server_;
+  uint64_t                          repl_id_;
+
+  /* Acquire the gate_ first if both are required */
+  kanon::RWLock                         gate_;
+  kanon::MutexLock                      mutex_;
+  ReplicationBacklog                    backlog_;
+  std::vector<std::unique_ptr<Replica>> replicas_;
+  uint64_t                              full_sync_num_;
+  size_t                                syncing_num_; /** The replicas streaming the snapshot */
+};
+
+/**
+ * \brief The replication source of this server
+ * Only be used if the replication is enabled
+ */
+ReplicationSource &repl_source();
+
+} // namespace server
+} // namespace mmkv
+
+#endif // _MMKV_SERVER_REPLICATION_SOURCE_H_
@@ -0,0 +1,188 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "slowlog.h"
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mmkv/server/config.h"
+#include "mmkv/util/time_util.h"
+
+#include <kanon/log/logger.h>
+#include <kanon/net/user_server.h>
+
+using namespace mmkv::server;
+using namespace mmkv::util;
+using namespace mmkv::protocol;
+using namespace kanon;
+
+static char const *kind_strings[] = {
+    "command",
+    "task",
+    "stall",
+};
+
+static_assert(sizeof kind_strings / sizeof kind_strings[0] == SK_NUM, "");
+
+Slowlog::Slowlog(size_t max_len)
+  : max_len_(max_len)
+  , next_index_(0)
+  , next_id_(0)
+{
+  entries_.reserve(max_len_);
+}
+
+void Slowlog::Add(
+    SlowlogKind kind,
+    char const *name,
+    StringView  key,
+    size_t      key_len,
+    int64_t     duration_us,
+    std::string client
+)
+{
+  if (max_len_ == 0) return;
+
+  SlowlogEntry entry;
+  entry.time_us     = GetTimeUs();
+  entry.duration_us = duration_us;
+  entry.kind        = kind;
+  entry.name        = name;
+  entry.key_len     = key_len;
+  entry.key.assign(key.data(), std::min(key.size(), (size_t)SLOWLOG_KEY_MAX_LEN));
+  entry.client = std::move(client);
+
+  MutexGuard guard(mutex_);
+  entry.id = next_id_++;
+  if (entries_.size() < max_len_) {
+    entries_.emplace_back(std::move(entry));
+  } else {
+    entries_[next_index_] = std::move(entry);
+    next_index_           = (next_index_ + 1) % max_len_;
+  }
+}
+
+void Slowlog::Get(size_t count, StrValues &entries)
+{
+  MutexGuard guard(mutex_);
+
+  if (count > entries_.size()) count = entries_.size();
+  entries.reserve(entries.size() + count);
+
+  char buf[512];
+  for (size_t i = 0; i < count; ++i) {
+    // The newest is the one before next_index_(wrap around)
+    auto const &entry = entries_[(next_index_ + entries_.size() - 1 - i) % entries_.size()];
+
+    int len = ::snprintf(
+        buf,
+        sizeof buf,
+        "id=%" PRIu64 " time=%" PRId64 ".%06" PRId64 " duration=%" PRId64 "us type=%s name=%s",
+        entry.id,
+        entry.time_us / 1000000,
+        entry.time_us % 1000000,
+        entry.duration_us,
+        kind_strings[entry.kind],
+        entry.name
+    );
+
+    String line(buf, len);
+    if (entry.key_len > 0) {
+      line.append(" key=");
+      line.append(entry.key.data(), entry.key.size());
+      if (entry.key_len > entry.key.size()) {
+        len = ::snprintf(buf, sizeof buf, "...(%zu more bytes)", entry.key_len - entry.key.size());
+        line.append(buf, len);
+      }
+    }
+    if (!entry.client.empty()) {
+      line.append(" client=");
+      line.append(entry.client.data(), entry.client.size());
+    }
+
+    entries.emplace_back(std::move(line));
+  }
+}
+
+void Slowlog::Reset()
+{
+  MutexGuard guard(mutex_);
+  entries_.clear();
+  next_index_ = 0;
+}
+
+size_t Slowlog::size()
+{
+  MutexGuard guard(mutex_);
+  return entries_.size();
+}
+
+namespace mmkv {
+namespace server {
+
+Slowlog &slowlog()
+{
+  static Slowlog log(
+      mmkv_config().slowlog_max_len > 0 ? (size_t)mmkv_config().slowlog_max_len : 0
+  );
+  return log;
+}
+
+ThreadActivity &thread_activity()
+{
+  static thread_local ThreadActivity activity;
+  return activity;
+}
+
+} // namespace server
+} // namespace mmkv
+
+SlowlogScope::SlowlogScope(
+    SlowlogKind          kind,
+    char const          *name,
+    StringView           key,
+    TcpConnection const *conn
+) noexcept
+  : kind_(kind)
+  , name_(name)
+  , conn_(conn)
+  , start_us_(GetMonotonicTimeUs())
+  , key_len_(key.size())
+{
+  ::memcpy(key_, key.data(), std::min(key_len_, sizeof key_));
+
+  auto &activity = thread_activity();
+  prev_name_     = activity.name.load(std::memory_order_relaxed);
+  prev_start_us_ = activity.start_us.load(std::memory_order_relaxed);
+  // The start_us is stored first, thus the watchdog never reads the older one with the name
+  activity.start_us.store(start_us_, std::memory_order_relaxed);
+  activity.name.store(name_, std::memory_order_release);
+}
+
+SlowlogScope::~SlowlogScope() noexcept
+{
+  auto &activity = thread_activity();
+  activity.name.store(prev_name_, std::memory_order_release);
+  activity.start_us.store(prev_start_us_, std::memory_order_relaxed);
+
+  const auto threshold = mmkv_config().slowlog_threshold;
+  if (threshold < 0) return;
+
+  const auto duration_us = GetMonotonicTimeUs() - start_us_;
+  if (duration_us < threshold) return;
+
+  try {
+    slowlog().Add(
+        kind_,
+        name_,
+        StringView(key_, std::min(key_len_, sizeof key_)),
+        key_len_,
+        duration_us,
+        conn_ ? conn_->GetPeerAddr().ToIpPort() : std::string()
+    );
+  }
+  catch (std::exception const &ex) {
+    LOG_ERROR << "Failed to add slowlog entry: " << ex.what();
+  }
+}
@@ -0,0 +1,140 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_SERVER_SLOWLOG_H_
+#define _MMKV_SERVER_SLOWLOG_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "mmkv/algo/string.h"
+#include "mmkv/protocol/type.h"
+
+#include <kanon/net/user_common.h>
+#include <kanon/string/string_view.h>
+#include <kanon/thread/mutex_lock.h>
+#include <kanon/util/noncopyable.h>
+
+namespace mmkv {
+namespace server {
+
+enum SlowlogKind : uint8_t {
+  SK_COMMAND = 0, /** Command of client */
+  SK_TASK,        /** Internal task, e.g. expiration check cycle, shard pull */
+  SK_STALL,       /** Event loop iteration exceeding the budget */
+  SK_NUM,
+};
+
+/** The key longer than this is truncated */
+#define SLOWLOG_KEY_MAX_LEN 64
+
+/** The number of entries returned by SLOWLOG if count is not specified */
+#define SLOWLOG_DEFAULT_GET_NUM 10
+
+struct SlowlogEntry {
+  uint64_t    id;
+  int64_t     time_us;     /** Unix timestamp when the entry is added */
+  int64_t     duration_us;
+  SlowlogKind kind;
+  char const *name;        /** Command string or task name(static lifetime) */
+  std::string key;         /** Truncated */
+  size_t      key_len;     /** The length before truncated */
+  std::string client;      /** ip:port of client, the loop for stall, empty for task */
+};
+
+/**
+ * \brief Fixed-size ring buffer of slow operations
+ * The oldest entry is overwritten when it is full.
+ * The maximum length is decided by the SlowlogMaxLen of config.
+ *
+ * \note Thread-safe
+ */
+class Slowlog {
+  DISABLE_EVIL_COPYABLE(Slowlog)
+
+ public:
+  explicit Slowlog(size_t max_len);
+
+  /**
+   * \param key The key truncated to SLOWLOG_KEY_MAX_LEN at most
+   * \param key_len The length of key before truncated
+   */
+  void Add(
+      SlowlogKind       kind,
+      char const       *name,
+      kanon::StringView key,
+      size_t            key_len,
+      int64_t           duration_us,
+      std::string       client
+  );
+
+  /**
+   * \brief Format the newest \p count entries(newest first)
+   */
+  void Get(size_t count, protocol::StrValues &entries);
+
+  /** The entries are cleared but the id keeps increasing */
+  void Reset();
+
+  size_t size();
+
+ private:
+  kanon::MutexLock          mutex_;
+  std::vector<SlowlogEntry> entries_;
+  size_t                    max_len_;
+  size_t                    next_index_; /** Index to be overwritten when full */
+  uint64_t                  next_id_;
+};
+
+Slowlog &slowlog();
+
+/**
+ * \brief The operation running in the calling thread
+ * The fields are read by the stall watchdog from other thread.
+ * name is nullptr if no operation is running.
+ */
+struct ThreadActivity {
+  std::atomic<char const *> name{nullptr};
+  std::atomic<int64_t>      start_us{0};
+};
+
+ThreadActivity &thread_activity();
+
+/**
+ * \brief Measure the operation in the scope and add it to the slowlog
+ * if the duration reaches the SlowlogThreshold of config.
+ * The thread activity is also set to this operation,
+ * the outer one is restored when the scope is nested.
+ *
+ * The key is copied(truncated) in the construction since
+ * the key of request may be moved when executing.
+ * The address of client is only formatted when the operation is slow.
+ */
+class SlowlogScope {
+  DISABLE_EVIL_COPYABLE(SlowlogScope)
+
+ public:
+  SlowlogScope(
+      SlowlogKind                 kind,
+      char const                 *name,
+      kanon::StringView           key  = kanon::StringView(),
+      kanon::TcpConnection const *conn = nullptr
+  ) noexcept;
+
+  ~SlowlogScope() noexcept;
+
+ private:
+  SlowlogKind                 kind_;
+  char const                 *name_;
+  kanon::TcpConnection const *conn_;
+  int64_t                     start_us_;
+  char const                 *prev_name_;
+  int64_t                     prev_start_us_;
+  size_t                      key_len_;
+  char                        key_[SLOWLOG_KEY_MAX_LEN];
+};
+
+} // namespace server
+} // namespace mmkv
+
+#endif // _MMKV_SERVER_SLOWLOG_H_
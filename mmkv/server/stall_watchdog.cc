@@ -0,0 +1,107 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "stall_watchdog.h"
+
+#include "mmkv/util/time_util.h"
+
+#include <kanon/log/logger.h>
+
+using namespace mmkv::server;
+using namespace mmkv::util;
+using namespace kanon;
+
+StallWatchdog::StallWatchdog(long budget_ms)
+  : budget_us_((int64_t)budget_ms * 1000)
+  , interval_sec_(budget_ms >= 4 ? (double)budget_ms / 4000 : 0.001)
+  , cond_(mutex_)
+  , running_(false)
+  , thread_("StallWatchdog")
+{
+}
+
+StallWatchdog::~StallWatchdog() noexcept
+{
+  Stop();
+
+  // The timer callback holds the state, thus it is safe even if the timer is triggering
+  MutexGuard guard(mutex_);
+  for (auto const &state : loops_)
+    state->loop->CancelTimer(state->timer_id);
+}
+
+void StallWatchdog::AddLoop(EventLoop *loop)
+{
+  MutexGuard guard(mutex_);
+  for (auto const &state : loops_) {
+    if (state->loop == loop) return;
+  }
+
+  std::shared_ptr<LoopState> state(new LoopState);
+  state->loop = loop;
+  state->last_beat_us.store(GetMonotonicTimeUs(), std::memory_order_relaxed);
+  state->activity.store(nullptr, std::memory_order_relaxed);
+  state->reported_beat_us = 0;
+  state->name             = "loop-" + std::to_string(loops_.size());
+
+  state->timer_id = loop->RunEvery(
+      [state]() {
+        state->activity.store(&thread_activity(), std::memory_order_relaxed);
+        state->last_beat_us.store(GetMonotonicTimeUs(), std::memory_order_release);
+      },
+      interval_sec_
+  );
+  loops_.emplace_back(std::move(state));
+}
+
+void StallWatchdog::Start()
+{
+  LOG_INFO << "The stall watchdog is started, the budget is " << budget_us_ / 1000 << "ms";
+
+  running_ = true;
+  thread_.StartRun([this]() {
+    MutexGuard guard(mutex_);
+    while (running_) {
+      cond_.WaitForSeconds(interval_sec_);
+      if (!running_) break;
+      Check();
+    }
+  });
+}
+
+void StallWatchdog::Stop() noexcept
+{
+  {
+    MutexGuard guard(mutex_);
+    if (!running_) return;
+    running_ = false;
+    cond_.Notify();
+  }
+  thread_.Join();
+}
+
+/* The duration of stall is the lag when it is detected,
+ * i.e. at least the budget, the real one may be longer. */
+void StallWatchdog::Check()
+{
+  const auto now_us      = GetMonotonicTimeUs();
+  const auto interval_us = (int64_t)(interval_sec_ * 1000000);
+
+  for (auto const &state : loops_) {
+    const auto last_beat_us = state->last_beat_us.load(std::memory_order_acquire);
+    const auto lag_us       = now_us - last_beat_us - interval_us;
+    if (lag_us <= budget_us_ || state->reported_beat_us == last_beat_us) continue;
+    state->reported_beat_us = last_beat_us;
+
+    auto        activity   = state->activity.load(std::memory_order_relaxed);
+    char const *name       = activity ? activity->name.load(std::memory_order_acquire) : nullptr;
+    int64_t     running_us = 0;
+    if (name) {
+      running_us = now_us - activity->start_us.load(std::memory_order_relaxed);
+    } else {
+      name = "unknown";
+    }
+
+    LOG_WARN << "The event loop " << state->name << " is stalled for " << lag_us << "us"
+             << ", running: " << name << "(" << running_us << "us)";
+    slowlog().Add(SK_STALL, name, StringView(), 0, lag_us, state->name);
+  }
+}
@@ -0,0 +1,83 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_SERVER_STALL_WATCHDOG_H_
+#define _MMKV_SERVER_STALL_WATCHDOG_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mmkv/server/slowlog.h"
+
+#include <kanon/net/user_server.h>
+#include <kanon/thread/condition.h>
+#include <kanon/thread/mutex_lock.h>
+#include <kanon/thread/thread.h>
+#include <kanon/util/noncopyable.h>
+
+namespace mmkv {
+namespace server {
+
+/**
+ * \brief Detect the event loop iterations exceeding the budget
+ *
+ * Each registered loop runs a heartbeat timer in every (budget / 4),
+ * the background thread checks the heartbeats in the same interval.
+ * If the heartbeat of a loop is late more than the budget,
+ * the loop is blocked by something, then the operation running in
+ * the loop thread(see SlowlogScope) is recorded to slowlog as a stall
+ * and a warning is logged.
+ * A stall is reported once even if it lasts many intervals.
+ *
+ * \warning
+ *  Must be destroyed before the registered loops,
+ *  since the thread activities of the loop threads are referenced
+ */
+class StallWatchdog {
+  DISABLE_EVIL_COPYABLE(StallWatchdog)
+
+  struct LoopState {
+    kanon::EventLoop             *loop;
+    kanon::TimerId                timer_id;
+    std::atomic<int64_t>          last_beat_us;
+    std::atomic<ThreadActivity *> activity;
+    int64_t                       reported_beat_us; /** Only accessed by the watchdog thread */
+    std::string                   name;
+  };
+
+ public:
+  /**
+   * \param budget_ms The maximum allowed time of a loop iteration
+   */
+  explicit StallWatchdog(long budget_ms);
+  ~StallWatchdog() noexcept;
+
+  /**
+   * \brief Start the heartbeat of the loop
+   * The loop registered already is ignored,
+   * thus this can be called in the connection callback.
+   * \note Thread-safe
+   */
+  void AddLoop(kanon::EventLoop *loop);
+
+  void Start();
+  void Stop() noexcept;
+
+ private:
+  void Check();
+
+  int64_t budget_us_;
+  double  interval_sec_;
+
+  kanon::MutexLock                        mutex_;
+  kanon::Condition                        cond_;
+  std::vector<std::shared_ptr<LoopState>> loops_; /** Shared with the heartbeat timer */
+  bool                                    running_;
+  kanon::Thread                           thread_;
+};
+
+} // namespace server
+} // namespace mmkv
+
+#endif // _MMKV_SERVER_STALL_WATCHDOG_H_
@@ -0,0 +1,210 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "stats.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "mmkv/util/time_util.h"
+
+using namespace mmkv::server;
+using namespace mmkv::util;
+using namespace mmkv::protocol;
+using namespace kanon;
+
+namespace mmkv {
+namespace server {
+
+class StatsRegistry {
+ public:
+  StatsRegistry()
+    : last_time_us_(GetMonotonicTimeUs())
+  {
+  }
+
+  void Register(ThreadStats *stats)
+  {
+    MutexGuard guard(mutex_);
+    stats_list_.push_back(stats);
+  }
+
+  /* The statistics of exited thread are merged into the retired */
+  void Unregister(ThreadStats *stats)
+  {
+    MutexGuard guard(mutex_);
+    stats_list_.erase(std::find(stats_list_.begin(), stats_list_.end(), stats));
+    Merge(*stats, retired_.counters, retired_.hists);
+    MergeShardOps(*stats, retired_shard_ops_);
+  }
+
+  void GetShardOps(std::vector<uint64_t> &ops)
+  {
+    MutexGuard guard(mutex_);
+    ops = retired_shard_ops_;
+    for (auto stats : stats_list_)
+      MergeShardOps(*stats, ops);
+  }
+
+  void GetSnapshot(StatsSnapshot &snapshot)
+  {
+    MutexGuard guard(mutex_);
+
+    for (int i = 0; i < SC_NUM; ++i)
+      snapshot.counters[i] = retired_.counters[i];
+    for (int i = 0; i < COMMAND_NUM; ++i) {
+      auto const &hist = retired_.hists[i];
+      snapshot.hists[i].reset(hist ? new LatencyHistogram(*hist) : nullptr);
+    }
+
+    for (auto stats : stats_list_)
+      Merge(*stats, snapshot.counters, snapshot.hists);
+
+    snapshot.total_commands = 0;
+    for (auto const &hist : snapshot.hists) {
+      if (hist) snapshot.total_commands += hist->count();
+    }
+
+    const auto now_us = GetMonotonicTimeUs();
+    if (now_us > last_time_us_) {
+      const auto command_num = snapshot.total_commands - last_total_commands_;
+      snapshot.ops_per_sec   = (double)command_num * 1000000 / (now_us - last_time_us_);
+    }
+    last_time_us_        = now_us;
+    last_total_commands_ = snapshot.total_commands;
+  }
+
+ private:
+  static void Merge(
+      ThreadStats                             &stats,
+      uint64_t                                *counters,
+      std::unique_ptr<util::LatencyHistogram> *hists
+  )
+  {
+    for (int i = 0; i < SC_NUM; ++i)
+      counters[i] += stats.counters_[i].load(std::memory_order_relaxed);
+
+    MutexGuard guard(stats.mutex_);
+    for (int i = 0; i < COMMAND_NUM; ++i) {
+      if (!stats.hists_[i]) continue;
+      if (!hists[i]) hists[i].reset(new LatencyHistogram);
+      hists[i]->Merge(*stats.hists_[i]);
+    }
+  }
+
+  static void MergeShardOps(ThreadStats &stats, std::vector<uint64_t> &ops)
+  {
+    MutexGuard guard(stats.mutex_);
+    if (ops.size() < stats.shard_ops_.size()) ops.resize(stats.shard_ops_.size(), 0);
+    for (size_t i = 0; i < stats.shard_ops_.size(); ++i)
+      ops[i] += stats.shard_ops_[i];
+  }
+
+  MutexLock                  mutex_;
+  std::vector<ThreadStats *> stats_list_;
+  StatsSnapshot              retired_;
+  std::vector<uint64_t>      retired_shard_ops_;
+  int64_t                    last_time_us_;
+  uint64_t                   last_total_commands_ = 0;
+};
+
+} // namespace server
+} // namespace mmkv
+
+static StatsRegistry &stats_registry()
+{
+  static StatsRegistry registry;
+  return registry;
+}
+
+ThreadStats::ThreadStats()
+{
+  for (auto &counter : counters_)
+    counter.store(0, std::memory_order_relaxed);
+  stats_registry().Register(this);
+}
+
+ThreadStats::~ThreadStats() noexcept { stats_registry().Unregister(this); }
+
+void ThreadStats::RecordCommand(Command cmd, uint64_t latency_ns)
+{
+  // The command comes from the client, the invalid one isn't recorded
+  if ((size_t)cmd >= COMMAND_NUM) return;
+
+  MutexGuard guard(mutex_);
+  auto      &hist = hists_[cmd];
+  if (!hist) hist.reset(new LatencyHistogram);
+  hist->Record(latency_ns);
+}
+
+void ThreadStats::RecordShardOp(uint64_t shard_id)
+{
+  MutexGuard guard(mutex_);
+  if (shard_id >= shard_ops_.size()) shard_ops_.resize(shard_id + 1, 0);
+  ++shard_ops_[shard_id];
+}
+
+ThreadStats &mmkv::server::thread_stats()
+{
+  static thread_local ThreadStats stats;
+  return stats;
+}
+
+void mmkv::server::GetStatsSnapshot(StatsSnapshot &snapshot)
+{
+  stats_registry().GetSnapshot(snapshot);
+}
+
+void mmkv::server::GetShardOps(std::vector<uint64_t> &ops) { stats_registry().GetShardOps(ops); }
+
+/* Append the formatted string, the line of info is short */
+#define INFO_APPEND(...)                                                                           \
+  do {                                                                                             \
+    ::snprintf(line, sizeof line, __VA_ARGS__);                                                    \
+    info += line;                                                                                  \
+  } while (0)
+
+void mmkv::server::GetStatsInfo(algo::String &info, bool has_stats, bool has_commandstats)
+{
+  if (!has_stats && !has_commandstats) return;
+
+  StatsSnapshot stats;
+  GetStatsSnapshot(stats);
+  char line[256];
+
+  if (has_stats) {
+    INFO_APPEND("# Stats\n");
+    INFO_APPEND("total_commands_processed:%" PRIu64 "\n", stats.total_commands);
+    INFO_APPEND("instantaneous_ops_per_sec:%.0lf\n", stats.ops_per_sec);
+    INFO_APPEND("total_net_input_bytes:%" PRIu64 "\n", stats.counters[SC_NET_INPUT_BYTES]);
+    INFO_APPEND("total_net_output_bytes:%" PRIu64 "\n", stats.counters[SC_NET_OUTPUT_BYTES]);
+    INFO_APPEND("keyspace_hits:%" PRIu64 "\n", stats.counters[SC_KEYSPACE_HITS]);
+    INFO_APPEND("keyspace_misses:%" PRIu64 "\n", stats.counters[SC_KEYSPACE_MISSES]);
+    INFO_APPEND("evicted_keys:%" PRIu64 "\n", stats.counters[SC_EVICTED_KEYS]);
+    INFO_APPEND("expired_keys:%" PRIu64 "\n", stats.counters[SC_EXPIRED_KEYS]);
+    INFO_APPEND("\n");
+  }
+
+  if (has_commandstats) {
+    // The latency is in microseconds
+    INFO_APPEND("# Commandstats\n");
+    for (int i = 0; i < COMMAND_NUM; ++i) {
+      auto const &hist = stats.hists[i];
+      if (!hist || hist->count() == 0) continue;
+
+      INFO_APPEND(
+          "cmdstat_%s:calls=%" PRIu64 ",usec_per_call=%.2lf,p50=%.2lf,p99=%.2lf,p999=%.2lf,"
+          "max=%.2lf\n",
+          GetCommandString((Command)i).c_str(),
+          hist->count(),
+          hist->mean() / 1000,
+          (double)hist->GetPercentile(50) / 1000,
+          (double)hist->GetPercentile(99) / 1000,
+          (double)hist->GetPercentile(99.9) / 1000,
+          (double)hist->max() / 1000
+      );
+    }
+    INFO_APPEND("\n");
+  }
+}
@@ -0,0 +1,111 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_SERVER_STATS_H_
+#define _MMKV_SERVER_STATS_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "mmkv/algo/string.h"
+#include "mmkv/protocol/command.h"
+#include "mmkv/util/latency_histogram.h"
+
+#include <kanon/thread/mutex_lock.h>
+#include <kanon/util/noncopyable.h>
+
+namespace mmkv {
+namespace server {
+
+enum StatsCounter : uint8_t {
+  SC_KEYSPACE_HITS = 0,
+  SC_KEYSPACE_MISSES,
+  SC_EVICTED_KEYS,
+  SC_EXPIRED_KEYS,
+  SC_NET_INPUT_BYTES,
+  SC_NET_OUTPUT_BYTES,
+  SC_NUM,
+};
+
+/**
+ * \brief The statistics recorded by a thread
+ * Only the owner thread modifies the statistics:
+ * - The counters are relaxed atomics, i.e. plain load and store in x86,
+ *   thus they are read by the aggregator without lock.
+ * - The histograms(nanoseconds) are allocated when the command is executed first,
+ *   and protected by a mutex, which is contended only when aggregating.
+ */
+class ThreadStats {
+  DISABLE_EVIL_COPYABLE(ThreadStats)
+
+  friend class StatsRegistry;
+
+ public:
+  ThreadStats();
+  ~ThreadStats() noexcept;
+
+  void Add(StatsCounter counter, uint64_t n) noexcept
+  {
+    counters_[counter].store(
+        counters_[counter].load(std::memory_order_relaxed) + n,
+        std::memory_order_relaxed
+    );
+  }
+
+  void RecordCommand(protocol::Command cmd, uint64_t latency_ns);
+
+  /** Count the request to the shard(sharder only), see GetShardOps() */
+  void RecordShardOp(uint64_t shard_id);
+
+ private:
+  std::atomic<uint64_t>                   counters_[SC_NUM];
+  kanon::MutexLock                        mutex_;
+  std::unique_ptr<util::LatencyHistogram> hists_[protocol::COMMAND_NUM];
+  std::vector<uint64_t>                   shard_ops_; /** Indexed by shard id */
+};
+
+/**
+ * \brief The statistics of all threads
+ * The statistics of exited threads are kept also.
+ */
+struct StatsSnapshot {
+  uint64_t                                counters[SC_NUM] = {0};
+  uint64_t                                total_commands   = 0;
+  double                                  ops_per_sec      = 0;
+  std::unique_ptr<util::LatencyHistogram> hists[protocol::COMMAND_NUM]; // nullptr if no calls
+};
+
+/** The statistics of the calling thread */
+ThreadStats &thread_stats();
+
+inline void StatsAdd(StatsCounter counter, uint64_t n = 1) noexcept
+{
+  thread_stats().Add(counter, n);
+}
+
+/**
+ * \brief Aggregate the statistics of all threads
+ * The ops_per_sec is computed from the previous call(or the start).
+ * \note Thread-safe
+ */
+void GetStatsSnapshot(StatsSnapshot &snapshot);
+
+/**
+ * \brief Append the stats and commandstats sections of INFO
+ * Each section ends with an empty line.
+ * \note Thread-safe
+ */
+void GetStatsInfo(algo::String &info, bool has_stats, bool has_commandstats);
+
+/**
+ * \brief Aggregate the number of requests per shard of all threads
+ * The numbers are accumulated since the start, the caller computes the rate.
+ * \param[out] ops Indexed by shard id
+ * \note Thread-safe
+ */
+void GetShardOps(std::vector<uint64_t> &ops);
+
+} // namespace server
+} // namespace mmkv
+
+#endif // _MMKV_SERVER_STATS_H_
@@ -0,0 +1,61 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "storage_hooks.h"
+
+#include "replication.h"
+#include "slowlog.h"
+#include "stats.h"
+
+#include "mmkv/db/kvdb.h"
+#include "mmkv/storage/db.h"
+
+using namespace mmkv;
+using namespace mmkv::server;
+using namespace mmkv::storage;
+using namespace mmkv::protocol;
+
+void mmkv::server::InstallStorageHooks()
+{
+  StorageHooks hooks;
+
+  hooks.on_command = [](Command cmd, StatusCode code, bool is_lookup, int64_t latency_ns) {
+    auto &stats = thread_stats();
+    if (is_lookup) {
+      if (code == S_OK)
+        stats.Add(SC_KEYSPACE_HITS, 1);
+      else if (code == S_NONEXISTS)
+        stats.Add(SC_KEYSPACE_MISSES, 1);
+    }
+    stats.RecordCommand(cmd, latency_ns);
+  };
+
+  hooks.on_shard_op = [](shard_id_t shard_id) { thread_stats().RecordShardOp(shard_id); };
+
+  hooks.on_slowlog = [](MmbpRequest const &request, MmbpResponse &response) {
+    if (request.command == SLOWLOG_RESET) {
+      slowlog().Reset();
+      response.SetOk();
+      return;
+    }
+
+    const size_t count = request.HasCount() ? request.count : SLOWLOG_DEFAULT_GET_NUM;
+    slowlog().Get(count, response.values);
+    response.SetOk();
+    response.SetValues();
+  };
+
+  hooks.get_info = [](bool const *is_included, String &info) {
+    GetStatsInfo(info, is_included[IS_STATS], is_included[IS_COMMANDSTATS]);
+    if (is_included[IS_REPLICATION]) {
+      GetReplicationInfo(info);
+      info += "\n";
+    }
+  };
+
+  SetStorageHooks(std::move(hooks));
+
+  // The lock of instance is held, the DEL is logged once it is released
+  db::SetKeyDropCallback([](String key, db::KeyDropReason reason) {
+    StatsAdd(reason == db::KDR_EXPIRED ? SC_EXPIRED_KEYS : SC_EVICTED_KEYS);
+    if (IsRecordLogged()) LogDel(std::move(key));
+  });
+}
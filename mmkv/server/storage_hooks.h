@@ -0,0 +1,18 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_SERVER_STORAGE_HOOKS_H_
+#define _MMKV_SERVER_STORAGE_HOOKS_H_
+
+namespace mmkv {
+namespace server {
+
+/**
+ * \brief Register the statistics, slowlog, INFO sections and the logging of dropped keys
+ * to the storage, see storage::SetStorageHooks() and db::SetKeyDropCallback()
+ * \note Not thread-safe, call it before the database is accessed
+ */
+void InstallStorageHooks();
+
+} // namespace server
+} // namespace mmkv
+
+#endif // _MMKV_SERVER_STORAGE_HOOKS_H_
@@ -3,6 +3,7 @@
 
 #include "mmkv/sharder/sharder.h"
 
+#include "mmkv/server/option.h"
 #include "mmkv/storage/db.h"
 #include "mmkv/util/shard_util.h"
 #include "mmkv/sharder/util.h"
@@ -26,39 +27,21 @@ struct SharderSession::Impl {
   )
   {
     auto        *p_db_instance = &database_manager().GetShardDatabaseInstance(shard_id);
-    auto        *p_db          = &p_db_instance->db;
     ShardMessage resp          = MakeShardResponse();
 
-    {
-      WLockGuard db_lock_guard(p_db_instance->lock);
-
-      /* Don't care whether the shard does exists.
-       * Database allow ignore the locked shard when executing command
-       *
-       * You must unlock the shard when the shard is deleted */
-      p_db->LockShard(shard_id);
-    }
-
-    {
-      /* The shard is locked, so the read lock is locked later is safe */
-      RLockGuard db_lock_guard(p_db_instance->lock);
-      auto       shard_code = p_db->GetShardKeys(shard_id, session->keys_);
-      if (SC_OK == shard_code) {
-        /* FIXME The shard is exists in database, but the shard can be incomplete.
-         * We must check it first. */
-
-        SerializeMmbpDataToSharderRequest(p_db, session->keys_, &session->send_key_index_, &resp);
-
-        resp.set_shard_id(shard_id);
-      } else if (SC_NO_SHARD == shard_code) {
-        MutexGuard guard(sharder->pending_session_lock_);
-        sharder->pending_shard_session_dict_.InsertKv(shard_id, session);
-        resp.set_status(SHARD_STATUS_WAIT);
-      }
-    }
-
-    if (session->keys_.size() == session->send_key_index_) {
-      session->send_key_index_ = 0;
+    /* The shard is served by both nodes until it is deleted,
+     * the keys pulled by the previous chunks are asked to the peer.
+     *
+     * FIXME The shard is exists in database, but the shard can be incomplete.
+     * We must check it first. */
+    resp.set_shard_id(shard_id);
+    const auto shard_code =
+        SerializeShardChunk(p_db_instance, shard_id, &session->migration_, &resp);
+
+    if (SC_NO_SHARD == shard_code) {
+      MutexGuard guard(sharder->pending_session_lock_);
+      sharder->pending_shard_session_dict_.InsertKv(shard_id, session);
+      resp.set_status(SHARD_STATUS_WAIT);
     }
 
     codec->Send(conn, &resp);
@@ -72,37 +55,50 @@ struct SharderSession::Impl {
       ShardRequest const  &req
   )
   {
-    /* No need to lock the shard, because the shard must not be represented in the database */
-    auto  shard_id      = req.shard_id();
-    auto *p_db_instance = &database_manager().GetShardDatabaseInstance(shard_id);
-    auto *p_db          = &p_db_instance->db;
-    assert(!p_db->HasShard(shard_id));
-
-    auto resp = MakeShardResponse();
-
-    auto        data_num  = req.data_num();
-    const char *p_data    = req.data().data();
-    size_t      data_size = req.data().size();
+    /* No need to lock the shard, because the shard must not be represented in the database
+     * except the previous chunks and the keys asked by the peer */
+    auto       shard_id      = req.shard_id();
+    auto      *p_db_instance = &database_manager().GetShardDatabaseInstance(shard_id);
+    auto      *p_db          = &p_db_instance->db;
+    const bool is_complete   = !req.has_is_shard_complete() || req.is_shard_complete();
 
     std::vector<MmbpRequest> mmbp_reqs;
-    mmbp_reqs.resize(data_num);
-    for (size_t i = 0; i < data_num; ++i) {
-      auto p_old_data = p_data;
-      mmbp_reqs[i].ParseFrom((void const **)&p_data, data_size);
-      data_size -= p_data - p_old_data;
+    if (!ParseMmbpDataFromSharderRequest(req, mmbp_reqs)) {
+      // The pushing is canceled by the disconnection
+      LOG_ERROR << "Reject the chunk of shard " << shard_id << ", disconnect the peer";
+      conn->ShutdownWrite();
+      return;
     }
 
-    assert(data_size == 0);
-
     {
       WLockGuard guard(p_db_instance->lock);
 
+      // Only the requests asked by the peer are served until the shard is complete
+      if (!p_db->HasShard(shard_id)) p_db->AddShard(shard_id);
+      if (is_complete)
+        p_db->StopShardImport(shard_id);
+      else
+        p_db->StartShardImport(shard_id);
+
       p_db->is_ignore_locked_shard = true;
       for (auto &mmbp_req : mmbp_reqs) {
         p_db_instance->Execute(mmbp_req, nullptr, 0 /* Dummy arg */);
       }
       p_db->is_ignore_locked_shard = false;
     }
+    session->importing_shard_id_ = shard_id;
+    session->is_importing_       = !is_complete;
+
+    /* The peer pushes the next chunk after this is replied,
+     * and asks the keys applied to the mmkvd of this */
+    auto resp = MakeShardResponse();
+    resp.set_status(SHARD_STATUS_OK);
+    resp.set_shard_id(shard_id);
+    resp.set_is_shard_complete(is_complete);
+    resp.set_mmkvd_port(mmkv_option().port);
+    codec->Send(conn, &resp);
+
+    if (!is_complete) return;
 
     /* This session receive the PushShard Request indicates peer is a leaving node.
      * The session don't receive any PullShard request, hence, we only check the pending client.
@@ -135,7 +131,7 @@ struct SharderSession::Impl {
       WLockGuard guard(p_db_instance->lock);
 
       p_db->RemoveShard(shard_id);
-      p_db->UnlockShard(shard_id);
+      if (p_db->IsShardLocked(shard_id)) p_db->UnlockShard(shard_id);
     }
   }
 };
@@ -21,6 +21,7 @@ Sharder::Sharder(EventLoop *loop, InetAddr const &addr)
       auto *p_session = AnyCast<SharderSession>(conn->GetContext());
       // FIXME Complete related logic
       if (p_session) {
+        p_session->CancelMigration();
         canceling_sessions_set_.Erase(p_session);
       }
     }
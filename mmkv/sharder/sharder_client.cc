@@ -4,9 +4,12 @@
 #include "mmkv/sharder/util.h"
 #include "mmkv/tracker/shard_controller_client.h"
 #include "mmkv/storage/db.h"
+#include "mmkv/server/option.h"
+#include "mmkv/server/slowlog.h"
 #include "mmkv/protocol/shard_code.h"
 #include "mmkv/sharder/sharder_session.h"
 #include "mmkv/util/shard_util.h"
+#include "mmkv/util/time_util.h"
 
 using namespace kanon;
 using namespace mmkv::server;
@@ -24,14 +27,14 @@ SharderClient::SharderClient(
   , shard_ids_(nullptr)
   , shard_num_(0)
   , shard_index_(0)
-  , send_keys_(0)
 {
 }
 
 void SharderClient::SetUpCodec(Sharder *sharder, Codec *codec)
 {
   codec->SetMessageCallback(
-      [sharder](TcpConnectionPtr const &conn, Buffer &buffer, size_t payload_size, TimeStamp) {
+      [sharder,
+       codec](TcpConnectionPtr const &conn, Buffer &buffer, size_t payload_size, TimeStamp) {
         auto resp = MakeShardResponse();
         ParseFromBuffer(&resp, payload_size, &buffer);
 
@@ -41,42 +44,65 @@ void SharderClient::SetUpCodec(Sharder *sharder, Codec *codec)
           case SHARD_STATUS_OK: {
             switch (sharder_cli->state()) {
               case PULLING: {
-                // assert(shard_index_ == resp.shard_id());
-                LOG_DEBUG << "Pull shard [" << sharder_cli->shard_index_ << "] successfully";
+                // The pulled chunk is applied with the write lock held
+                SlowlogScope slowlog_scope(SK_TASK, "SHARD_PULL");
 
-                // assert(resp.has_data() && resp.has_data_num());
                 const shard_id_t shard_id = resp.shard_id();
                 auto            *p_db     = &database_manager().GetShardDatabaseInstance(shard_id);
+                const bool       is_shard_complete =
+                    !resp.has_is_shard_complete() || resp.is_shard_complete();
 
+                std::vector<MmbpRequest> requests;
+                if (!ParseMmbpDataFromSharderRequest(resp, requests)) {
+                  // The pulling is canceled by the disconnection
+                  LOG_ERROR << "Reject the chunk of shard " << shard_id << ", disconnect the peer";
+                  conn->ShutdownWrite();
+                  return;
+                }
                 {
                   WLockGuard guard(p_db->lock);
-                  p_db->db.AddShard(shard_id);
-                }
-
-                if (resp.has_data() && resp.has_data_num()) {
-                  const size_t data_num = resp.data_num();
-                  void const  *p_data   = &resp.data()[0];
-                  size_t       index    = resp.data().size();
-                  for (size_t i = 0; i < data_num; ++i) {
-                    /* The request has some members are unsafe after be moved. */
-                    MmbpRequest request;
-
-                    /* The ParseFrom() is override in the virtual table,
-                     * the non-virtual ParseFrom() isn't inherited implicitly.
-                     *
-                     * You can use "useing Base::ParseFrom()" to import this
-                     * but I don't likt it and rename it to ParseFrom2()
-                     */
-                    request.ParseFrom2(&p_data, &index);
+                  if (!p_db->db.HasShard(shard_id)) p_db->db.AddShard(shard_id);
+                  for (auto &request : requests) {
                     p_db->Execute(request, nullptr, 0);
                   }
+                  // All keys are here, the requests are served without asking
+                  if (is_shard_complete) p_db->db.StopShardImport(shard_id);
+                }
+
+                const auto delay_us = sharder_cli->controller_clie_->OnMigrationChunk(
+                    resp.data().size(),
+                    is_shard_complete
+                );
+
+                // Pull the next chunk after this is applied, i.e. only one chunk is in flight
+                if (!is_shard_complete) {
+                  sharder_cli->RunAfterBudget(delay_us, [sharder_cli, codec, conn, shard_id]() {
+                    sharder_cli->GetShard(codec, conn.get(), shard_id);
+                  });
+                  return;
                 }
 
+                // The keys of last chunk are asked to this by peer
+                auto ack = MakeShardRequest();
+                ack.set_operation(SHARD_OP_ACK);
+                ack.set_shard_id(shard_id);
+                codec->Send(conn.get(), &ack);
+
+                LOG_DEBUG << "Pull shard [" << sharder_cli->shard_index_ << "] successfully";
                 sharder_cli->shard_index_++;
                 if (sharder_cli->shard_index_ == sharder_cli->shard_num_) {
                   LOG_DEBUG << "Pull shards complete";
                   sharder_cli->controller_clie_->NotifyPullFinish();
                   sharder_cli->shard_index_ = 0;
+                } else {
+                  // The shards of this client are pulled one by one
+                  const auto next_shard_id = sharder_cli->shard_ids_[sharder_cli->shard_index_];
+                  sharder_cli->RunAfterBudget(
+                      delay_us,
+                      [sharder_cli, codec, conn, next_shard_id]() {
+                        sharder_cli->GetShard(codec, conn.get(), next_shard_id);
+                      }
+                  );
                 }
 
                 /* Currently, node in ADDING state.
@@ -97,12 +123,41 @@ void SharderClient::SetUpCodec(Sharder *sharder, Codec *codec)
               } break;
 
               case PUSHING: {
+                assert(sharder_cli->shard_ids_[sharder_cli->shard_index_] == resp.shard_id());
+
+                // The keys pushed are asked to the mmkvd of peer
+                if (resp.has_mmkvd_port()) {
+                  sharder_cli->migration_.peer_endpoint =
+                      GetPeerMmkvdEndpoint(conn->GetPeerAddr().ToIp(), resp);
+                }
+
+                // Push the next chunk after the peer applies this
+                const auto delay_us = sharder_cli->put_ready_us_ - util::GetTimeUs();
+                if (resp.has_is_shard_complete() && !resp.is_shard_complete()) {
+                  const auto shard_id = resp.shard_id();
+                  sharder_cli->RunAfterBudget(
+                      delay_us,
+                      [sharder_cli, sharder, codec, conn, shard_id]() {
+                        sharder_cli->PutShard(sharder, codec, conn.get(), shard_id);
+                      }
+                  );
+                  return;
+                }
+
+                AckShardLastChunk(resp.shard_id());
                 LOG_DEBUG << "Push shard [" << sharder_cli->shard_index_ << "] successfully";
-                assert(sharder_cli->shard_index_ == resp.shard_id());
                 sharder_cli->shard_index_++;
                 if (sharder_cli->shard_index_ == sharder_cli->shard_num_) {
                   LOG_DEBUG << "Push shards complete";
                   sharder_cli->controller_clie_->NotifyPushFinish();
+                } else {
+                  const auto next_shard_id = sharder_cli->shard_ids_[sharder_cli->shard_index_];
+                  sharder_cli->RunAfterBudget(
+                      delay_us,
+                      [sharder_cli, sharder, codec, conn, next_shard_id]() {
+                        sharder_cli->PutShard(sharder, codec, conn.get(), next_shard_id);
+                      }
+                  );
                 }
               } break; // state()
 
@@ -132,15 +187,22 @@ void SharderClient::SetUp(
       conn_ = conn.get();
       codec->SetUpConnection(conn);
       LOG_DEBUG << "Shard num = " << shard_num_;
-      for (size_t i = 0; i < shard_num_; ++i) {
-        if (state_ == PULLING)
-          GetShard(codec, conn.get(), shard_ids_[i]);
-        else if (state_ == PUSHING)
-          PutShard(sharder, codec, conn.get(), shard_ids_[i]);
-      }
       conn->SetContext(this);
+
+      // The shards are migrated one by one in chunks,
+      // the next is requested when the previous is applied
+      shard_index_ = 0;
+      if (state_ == PULLING)
+        GetShard(codec, conn.get(), shard_ids_[shard_index_]);
+      else if (state_ == PUSHING)
+        PutShard(sharder, codec, conn.get(), shard_ids_[shard_index_]);
     } else {
       LOG_DEBUG << "The Sharder Client: [" << conn->GetName() << "] is down";
+      CancelShardMigration(&migration_);
+      if (state_ == PULLING) {
+        for (size_t i = 0; i < shard_num_; ++i)
+          CancelShardImport(shard_ids_[i]);
+      }
       sharder->canceling_client_set_.Erase(this);
       conn->SetContext(nullptr);
     }
@@ -150,9 +212,19 @@ void SharderClient::SetUp(
 
 void SharderClient::GetShard(Codec *codec, kanon::TcpConnection *conn, shard_id_t shard_id)
 {
+  /* The peer serves the shard until it is complete, then asks the keys pulled to this.
+   * Only the asked requests are served before the shard is complete. */
+  {
+    auto      *p_db_instance = &database_manager().GetShardDatabaseInstance(shard_id);
+    WLockGuard guard(p_db_instance->lock);
+    if (!p_db_instance->db.HasShard(shard_id)) p_db_instance->db.AddShard(shard_id);
+    p_db_instance->db.StartShardImport(shard_id);
+  }
+
   auto req = MakeShardRequest();
   req.set_operation(SHARD_OP_PULL);
   req.set_shard_id(shard_id);
+  req.set_mmkvd_port(mmkv_option().port);
   codec->Send(conn, &req);
 }
 
@@ -184,36 +256,30 @@ void SharderClient::PutShard(
     shard_id_t            shard_id
 )
 {
-  auto      req           = MakeShardRequest();
-  auto     *p_db_instance = &storage::database_manager().GetShardDatabaseInstance(shard_id);
-  auto     *p_db          = &p_db_instance->db;
-  ShardCode code;
+  SlowlogScope slowlog_scope(SK_TASK, "SHARD_PUT");
 
-  {
-    WLockGuard guard(p_db_instance->lock);
-    /* FIXME unlock when all shards are pushed */
-    p_db->LockShard(shard_id);
-  }
+  auto  req           = MakeShardRequest();
+  auto *p_db_instance = &storage::database_manager().GetShardDatabaseInstance(shard_id);
 
-  p_db_instance->lock.RLock();
-  code = p_db->GetShardKeys(shard_id, send_keys_);
-  /* TODO SharderSession(PushRequest) and SharderClient(PullRequest) must call this to send pending
+  /* Send the next chunk to peer, the progress is kept in migration_.
+   * FIXME unlock when all shards are pushed
+   * TODO SharderSession(PushRequest) and SharderClient(PullRequest) must call this to send pending
    * shard */
-  if (SC_NO_SHARD == code) {
-    p_db_instance->lock.RUnlock();
-
+  if (SC_NO_SHARD == SerializeShardChunk(p_db_instance, shard_id, &migration_, &req)) {
+    // Pushed when the shard is pulled
     MutexGuard guard(sharder->pending_client_lock_);
     sharder->pending_shard_client_dict_.InsertKv(shard_id, this);
-  } else if (SC_OK == code) {
-    // Send shards to peer
-    SerializeMmbpDataToSharderRequest(p_db, send_keys_, &send_key_index_, &req);
-
-    p_db_instance->lock.RUnlock();
+    return;
   }
 
   req.set_operation(SHARD_OP_PUSH);
   req.set_shard_id(shard_id);
   codec->Send(conn, &req);
+
+  // The next chunk is pushed when this is acked and the budget is available
+  const bool is_shard_complete = !req.has_is_shard_complete() || req.is_shard_complete();
+  const auto delay_us = controller_clie_->OnMigrationChunk(req.data().size(), is_shard_complete);
+  put_ready_us_       = util::GetTimeUs() + delay_us;
 }
 
 void SharderClient::PutShard(Sharder *sharder, Codec *codec, shard_id_t shard_id)
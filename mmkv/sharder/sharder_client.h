@@ -10,6 +10,7 @@
 #include "mmkv/algo/string.h"
 #include "mmkv/tracker/common_type.h"
 #include "mmkv/sharder/sharder_codec.h"
+#include "mmkv/sharder/util.h"
 
 namespace mmkv {
 namespace server {
@@ -63,6 +64,16 @@ class SharderClient : kanon::noncopyable {
   /** Put shard to other sharder */
   void PutShard(Sharder *sharder, Codec *codec, kanon::TcpConnection *conn, shard_id_t shard_id);
 
+  /** Run the cb after the delay required by the bandwidth budget */
+  template <typename F>
+  void RunAfterBudget(int64_t delay_us, F &&cb)
+  {
+    if (delay_us <= 0)
+      cb();
+    else
+      clie_->GetLoop()->RunAfter(std::forward<F>(cb), delay_us / 1000000.);
+  }
+
   TcpClientPtr   clie_;
   TcpConnection *conn_;
 
@@ -73,9 +84,8 @@ class SharderClient : kanon::noncopyable {
   u64   shard_index_ = 0; /** Record the shard index that has handled */
   State state_       = IDLE;
 
-  /* Push shard aux */
-  std::vector<const algo::String *> send_keys_;
-  size_t                            send_key_index_;
+  ShardMigration migration_;        /** The shard pushed to peer */
+  int64_t        put_ready_us_ = 0; /** The next chunk can be pushed after this */
 };
 
 } // namespace server
@@ -2,13 +2,18 @@
 #include "internal/shard_session_impl.h"
 
 SharderSession::SharderSession(TcpConnection *conn)
-  : send_key_index_(0)
-  , conn_(conn)
+  : conn_(conn)
 {
 }
 
 SharderSession::~SharderSession() noexcept {}
 
+void SharderSession::CancelMigration()
+{
+  CancelShardMigration(&migration_);
+  if (is_importing_) CancelShardImport(importing_shard_id_);
+}
+
 void SharderSession::SetUp(Sharder *sharder, Codec *codec)
 {
   codec->SetMessageCallback(
@@ -20,6 +25,10 @@ void SharderSession::SetUp(Sharder *sharder, Codec *codec)
         const shard_id_t shard_id = req.shard_id();
         switch (req.operation()) {
           case SHARD_OP_PULL:
+            // The keys of pulled shard are asked to the mmkvd of peer
+            if (req.has_mmkvd_port()) {
+              migration_.peer_endpoint = GetPeerMmkvdEndpoint(conn->GetPeerAddr().ToIp(), req);
+            }
             Impl::OnPullShard(sharder, this, codec, conn.get(), shard_id);
             break;
           case SHARD_OP_PUSH:
@@ -28,6 +37,9 @@ void SharderSession::SetUp(Sharder *sharder, Codec *codec)
           case SHARD_OP_DEL:
             Impl::OnDelShard(sharder, this, codec, conn.get(), req);
             break;
+          case SHARD_OP_ACK:
+            AckShardLastChunk(shard_id);
+            break;
         }
       }
   );
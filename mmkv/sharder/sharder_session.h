@@ -4,7 +4,7 @@
 
 #include <kanon/net/user_server.h>
 
-#include "mmkv/algo/string.h"
+#include "mmkv/sharder/util.h"
 #include "mmkv/tracker/common_type.h"
 
 namespace mmkv {
@@ -24,10 +24,14 @@ class SharderSession : kanon::noncopyable {
 
   void PushShard(Sharder *sharder, shard_id_t shard_id);
 
+  /** The peer is down before the pulled shard is deleted or the pushed shard is complete */
+  void CancelMigration();
+
  private:
-  size_t                            send_key_index_;
-  std::vector<algo::String const *> keys_;
-  TcpConnection                    *conn_;
+  ShardMigration migration_; /** The shard pulled by peer */
+  shard_id_t     importing_shard_id_ = 0;
+  bool           is_importing_       = false; /** The shard pushed by peer is incomplete */
+  TcpConnection *conn_;
 
   friend struct Impl;
   struct Impl;
@@ -1,58 +1,174 @@
 // SPDX-LICENSE-IDENTIFIER: Apache-2.0
 #include "mmkv/sharder/util.h"
 #include "mmkv/storage/db.h"
+#include "mmkv/storage/dump.h"
 #include "mmkv/protocol/mmbp_util.h"
 #include "mmkv/protocol/mmbp_request.h"
 #include "mmkv/algo/string.h"
 #include "util.h"
 
+#include <string.h>
+
+#include <algorithm>
+
+#include <kanon/log/logger.h>
+
 using namespace mmkv::algo;
 using namespace mmkv;
 using namespace mmkv::db;
 using namespace mmkv::protocol;
 using namespace kanon;
 
-void mmkv::SerializeMmbpDataToSharderRequest(
-    MmkvDb                            *p_db,
-    std::vector<const String *> const &keys,
-    size_t                            *p_index,
-    ShardMessage                      *p_msg
+ShardCode mmkv::GetShardMigrationKeys(MmkvDb *p_db, shard_id_t shard_id, std::vector<String> &keys)
+{
+  std::vector<String const *> p_keys;
+
+  auto code = p_db->GetShardKeys(shard_id, p_keys);
+  keys.clear();
+  keys.reserve(p_keys.size());
+  for (auto p_key : p_keys) {
+    if (!p_db->IsShardKeyMoved(shard_id, *p_key)) keys.emplace_back(*p_key);
+  }
+  return code;
+}
+
+bool mmkv::SerializeMmbpDataToSharderRequest(
+    MmkvDb                    *p_db,
+    std::vector<String> const &keys,
+    size_t                    *p_index,
+    ShardMessage              *p_msg
+)
+{
+  Buffer buffer;
+  size_t data_num = 0;
+  // The migrating key isn't dropped here, the expired key is dumped with its expiration
+  // and the peer expires it
+  db::LazyExpirationPause pause;
+  for (; *p_index < keys.size() && buffer.GetReadableSize() < SHARD_CHUNK_SIZE; ++*p_index) {
+    // The removed key is skipped
+    if (storage::DumpKey(*p_db, keys[*p_index], buffer)) ++data_num;
+  }
+
+  const bool is_complete = *p_index == keys.size();
+  p_msg->set_data_num(data_num);
+  p_msg->mutable_data()->assign(buffer.GetReadBegin(), buffer.GetReadableSize());
+  p_msg->set_is_shard_complete(is_complete);
+  return is_complete;
+}
+
+ShardCode mmkv::SerializeShardChunk(
+    storage::DatabaseInstance *p_instance,
+    shard_id_t                 shard_id,
+    ShardMigration            *p_migration,
+    ShardMessage              *p_msg
 )
 {
-  db::DataType data_type;
-  Buffer       buffer;
-  for (; *p_index < keys.size(); ++*p_index) {
-    MmbpRequest mmbp_req;
-
-    auto &key = *keys[*p_index];
-    p_db->Type(key, data_type);
-    switch (data_type) {
-      case DataType::D_STRING: {
-        String *p_str;
-        auto    code = p_db->GetStr(key, p_str);
-        if (S_OK == code) {
-          mmbp_req.command = Command::STR_ADD;
-          mmbp_req.key     = key;
-          mmbp_req.SetKey();
-          mmbp_req.value = *p_str;
-          mmbp_req.SetValue();
-
-        } else {
-          continue;
-        }
-      } break;
-
-        // FIXME Complete
-      default:
-        assert(false);
+  auto *p_db = &p_instance->db;
+  auto &mig  = *p_migration;
+
+  // The progress of shard is modified, thus the write lock is required
+  WLockGuard guard(p_instance->lock);
+
+  if (mig.phase == ShardMigration::SMP_IDLE) {
+    auto code = GetShardMigrationKeys(p_db, shard_id, mig.keys);
+    if (code != SC_OK) return code;
+
+    // The keys created since now are stored in the peer
+    p_db->StartShardMigration(shard_id);
+    mig.index    = 0;
+    mig.shard_id = shard_id;
+    mig.phase    = ShardMigration::SMP_LIVE;
+  }
+
+  // The peer is known once it requests or replies
+  if (!mig.peer_endpoint.empty()) p_db->SetShardMigrationPeer(shard_id, mig.peer_endpoint);
+
+  const size_t first       = mig.index;
+  const bool   is_complete = SerializeMmbpDataToSharderRequest(p_db, mig.keys, &mig.index, p_msg);
+  p_db->SendShardKeys(shard_id, mig.keys.data() + first, mig.keys.data() + mig.index);
+
+  if (is_complete) {
+    LOG_DEBUG << "The shard " << shard_id << " is migrated, " << mig.keys.size() << " keys";
+    mig.Reset();
+  }
+  return SC_OK;
+}
+
+void mmkv::AckShardLastChunk(shard_id_t shard_id)
+{
+  auto *p_instance = &storage::database_manager().GetShardDatabaseInstance(shard_id);
+
+  WLockGuard guard(p_instance->lock);
+  p_instance->db.AckShardKeys(shard_id);
+}
+
+void mmkv::CancelShardMigration(ShardMigration *p_migration)
+{
+  if (p_migration->phase == ShardMigration::SMP_IDLE) return;
+
+  const auto shard_id   = p_migration->shard_id;
+  auto      *p_instance = &storage::database_manager().GetShardDatabaseInstance(shard_id);
+
+  {
+    WLockGuard guard(p_instance->lock);
+    p_instance->db.CancelShardMigration(shard_id);
+  }
+
+  LOG_WARN << "The migration of shard " << shard_id << " is canceled";
+  p_migration->Reset();
+}
+
+void mmkv::CancelShardImport(shard_id_t shard_id)
+{
+  auto *p_instance = &storage::database_manager().GetShardDatabaseInstance(shard_id);
+
+  WLockGuard guard(p_instance->lock);
+  if (!p_instance->db.IsShardImporting(shard_id)) return;
+  p_instance->db.StopShardImport(shard_id);
+  LOG_WARN << "The import of shard " << shard_id << " is canceled";
+}
+
+std::string mmkv::GetPeerMmkvdEndpoint(std::string const &peer_ip, ShardMessage const &msg)
+{
+  if (!msg.has_mmkvd_port()) return std::string();
+  return peer_ip + ":" + std::to_string(msg.mmkvd_port());
+}
+
+bool mmkv::ParseMmbpDataFromSharderRequest(
+    ShardMessage const       &msg,
+    std::vector<MmbpRequest> &requests
+)
+{
+  void const *p_data    = msg.data().data();
+  size_t      data_size = msg.data().size();
+
+  // A key may be dumped to multiple requests(e.g. with expiration),
+  // thus the requests are parsed until the data is consumed.
+  // The key number comes from peer also, each record has a length prefix at least.
+  requests.clear();
+  requests.reserve(std::min<size_t>(msg.data_num(), data_size / sizeof(uint32_t)));
+  while (data_size >= sizeof(uint32_t)) {
+    uint32_t len;
+    ::memcpy(&len, p_data, sizeof len);
+    len    = sock::ToHostByteOrder32(len);
+    p_data = (char const *)p_data + sizeof len;
+    // The data comes from peer, the length can't be trusted
+    if (len > data_size - sizeof len) {
+      LOG_ERROR << "The shard chunk is truncated, record length = " << len
+                << ", remaining = " << data_size - sizeof len;
+      return false;
     }
+    data_size -= sizeof len + len;
+
+    auto p_record = p_data;
+    requests.emplace_back();
+    requests.back().ParseFrom(&p_record, len);
+    p_data = (char const *)p_data + len;
+  }
 
-    mmbp_req.SerializeTo(buffer);
-    p_msg->set_data_num(p_msg->data_num() + 1);
-    p_msg->mutable_data()->append(buffer.GetReadBegin(), buffer.GetReadableSize());
-    // if (p_msg->data().size() > (1 << 16)) {
-    //   break;
-    // }
-    buffer.AdvanceAll();
+  if (data_size != 0) {
+    LOG_ERROR << "The shard chunk has " << data_size << " trailing bytes";
+    return false;
   }
+  return true;
 }
@@ -2,17 +2,31 @@
 #ifndef _MMKV_SHARDER_UTIL_H__
 #define _MMKV_SHARDER_UTIL_H__
 
+#include <string>
+#include <vector>
+
 #include "sharder.pb.h"
 
 #include "mmkv/algo/string.h"
+#include "mmkv/protocol/mmbp_request.h"
+#include "mmkv/protocol/shard_code.h"
+#include "mmkv/tracker/common_type.h"
 #include "mmkv/util/macro.h"
 
+/* The shard is migrated in chunks of about this size,
+ * only one chunk is in flight per connection */
+#define SHARD_CHUNK_SIZE (1 << 16)
+
 namespace mmkv {
 
 namespace db {
 class MmkvDb;
 }
 
+namespace storage {
+struct DatabaseInstance;
+}
+
 MMKV_INLINE ShardMessage MakeShardRequest()
 {
   ShardMessage msg;
@@ -30,11 +44,123 @@ MMKV_INLINE ShardMessage MakeShardResponse()
 using ShardRequest  = ShardMessage;
 using ShardResponse = ShardMessage;
 
-void SerializeMmbpDataToSharderRequest(
-    db::MmkvDb                              *p_db,
-    std::vector<const algo::String *> const &keys,
-    size_t                                  *p_index,
-    ShardMessage                            *p_msg
+/**
+ * \brief Get the keys of shard to be migrated
+ * The keys are copied since the database is unlocked between the chunks,
+ * the key may be removed(e.g. expired) in the meantime.
+ * The keys moved by the canceled migration are skipped.
+ *
+ * \warning Not thread-safe, the read lock of instance is required
+ */
+protocol::ShardCode
+GetShardMigrationKeys(db::MmkvDb *p_db, shard_id_t shard_id, std::vector<algo::String> &keys);
+
+/**
+ * \brief Serialize the data of keys[*p_index, keys.size()) to the message
+ * Each key is serialized by storage::DumpKey(), i.e. the requests rebuilding
+ * it(including its expiration) framed with the 32-bit length header,
+ * the expired key is also serialized since it isn't dropped.
+ * The serializing stops when the data reaches SHARD_CHUNK_SIZE, and
+ * the *p_index records the progress for the next chunk.
+ * The is_shard_complete of message is set if it is the last chunk.
+ *
+ * \return
+ *  true if all keys are serialized
+ *
+ * \warning Not thread-safe, the read lock of instance is required
+ */
+bool SerializeMmbpDataToSharderRequest(
+    db::MmkvDb                      *p_db,
+    std::vector<algo::String> const &keys,
+    size_t                          *p_index,
+    ShardMessage                    *p_msg
+);
+
+/**
+ * \brief The progress of the shard migrated to peer
+ * The keys of shard are fixed when the migration is started, then they are
+ * migrated in chunks while both nodes serve the shard(see MmkvDb::CheckShardMigration()):
+ * - The keys in the in-flight chunk are read-only
+ * - The chunk is acked when the next one is serialized(i.e. the peer has applied it),
+ *   then the requests to its keys are asked to the peer(S_ASK)
+ * - The last chunk is acked by the response of peer(pushing) or SHARD_OP_ACK(pulling)
+ * Thus no key is unwritable longer than a chunk round trip.
+ */
+struct ShardMigration {
+  enum Phase : uint8_t {
+    SMP_IDLE = 0,
+    SMP_LIVE,
+  };
+
+  std::vector<algo::String> keys; /** The keys to be migrated */
+  size_t                    index    = 0;
+  shard_id_t                shard_id = 0;
+  Phase                     phase    = SMP_IDLE;
+  std::string               peer_endpoint; /** The mmkvd endpoint of peer, empty if unknown */
+
+  void Reset() noexcept
+  {
+    keys.clear();
+    index = 0;
+    phase = SMP_IDLE;
+  }
+};
+
+/**
+ * \brief Serialize the next chunk of the migrating shard
+ * The migration is started by the first chunk, the progress of the shard
+ * is kept in database until the shard is deleted(or the migration is canceled).
+ * The p_migration is reset after the last chunk.
+ *
+ * \return
+ *  SC_NO_SHARD if the shard doesn't exist and nothing is serialized
+ *
+ * \note The lock of instance is acquired internally
+ */
+protocol::ShardCode SerializeShardChunk(
+    storage::DatabaseInstance *p_instance,
+    shard_id_t                 shard_id,
+    ShardMigration            *p_migration,
+    ShardMessage              *p_msg
+);
+
+/**
+ * \brief The last chunk of shard is applied by the peer, ask the requests to its keys
+ * \note The lock of instance is acquired internally
+ */
+void AckShardLastChunk(shard_id_t shard_id);
+
+/**
+ * \brief Cancel the unfinished migration, e.g. the peer is down
+ * The keys in flight are served by this again, the keys moved are still asked to
+ * the peer until the shard is removed(see MmkvDb::CancelShardMigration()).
+ */
+void CancelShardMigration(ShardMigration *p_migration);
+
+/**
+ * \brief Cancel the unfinished import, e.g. the peer is down
+ * The keys applied are served by this without asking, since the source
+ * keeps asking them to this.
+ * \note The lock of instance is acquired internally
+ */
+void CancelShardImport(shard_id_t shard_id);
+
+/**
+ * \brief Get the mmkvd endpoint of peer that the migrated keys are asked to
+ * \param peer_ip The ip of peer sharder, the port of mmkvd is carried by the message
+ * \return
+ *  empty if the port isn't carried
+ */
+std::string GetPeerMmkvdEndpoint(std::string const &peer_ip, ShardMessage const &msg);
+
+/**
+ * \brief Parse the requests serialized by SerializeMmbpDataToSharderRequest()
+ * \return
+ *  false if the data is truncated or corrupted, the chunk must be rejected
+ */
+bool ParseMmbpDataFromSharderRequest(
+    ShardMessage const                 &msg,
+    std::vector<protocol::MmbpRequest> &requests
 );
 
 } // namespace mmkv
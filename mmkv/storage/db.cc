@@ -1,6 +1,11 @@
 // SPDX-LICENSE-IDENTIFIER: Apache-2.0
 #include "db.h"
+#include "dump.h"
 
+#include <algorithm>
+
+#include "mmkv/db/memory_usage.h"
+#include "mmkv/lua/script.h"
 #include "mmkv/protocol/command.h"
 #include "mmkv/protocol/command_type.h" // GetCommandType
 #include "mmkv/protocol/status_code.h"
@@ -8,6 +13,9 @@
 #include "mmkv/util/macro.h"    // MMKV_ASSert
 #include "mmkv/util/memory_footprint.h"
 #include "mmkv/util/time_util.h"
+#include "mmkv/version.h"
+
+#include <inttypes.h>
 
 namespace storage = mmkv::storage;
 using namespace mmkv::storage;
@@ -22,11 +30,20 @@ DatabaseManager &storage::database_manager()
   return manager;
 }
 
+static StorageHooks g_hooks;
+
+void storage::SetStorageHooks(StorageHooks hooks) { g_hooks = std::move(hooks); }
+
 #define SET_OK_VALUE(_value)                                                                       \
   response->SetOk();                                                                               \
   response->SetValue();                                                                            \
   response->value = (_value)
 
+#define SET_OK_VALUE_REF(_pvalue)                                                                  \
+  response->SetOk();                                                                               \
+  response->SetValue();                                                                            \
+  response->value_ref = (_pvalue)
+
 #define SET_OK_VALUE_                                                                              \
   response->SetOk();                                                                               \
   response->SetValue()
@@ -84,6 +101,12 @@ DatabaseManager &storage::database_manager()
     }                                                                                              \
   } while (0)
 
+/* The default number of elements returned by scan commands */
+#define SCAN_DEFAULT_COUNT 10
+
+#define SCAN_COUNT(request)                                                                        \
+  ((request).range.right > 0 ? (size_t)(request).range.right : SCAN_DEFAULT_COUNT)
+
 static inline size_t RoundUpTo2Power(size_t src) noexcept
 {
   size_t ret = 1;
@@ -119,8 +142,12 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
     case STR_GET: {
       CHECK_INVALID_REQUEST(request.HasKey(), "strget");
       String *str  = nullptr;
-      auto    code = db.GetStr(request.key, str);
-      SET_XX_ELSE_CODE(SET_OK_VALUE(*str));
+      auto    code = db.GetStr(request.GetKey(), str);
+      if (response->IsReferenceAllowed()) {
+        SET_XX_ELSE_CODE(SET_OK_VALUE_REF(str));
+      } else {
+        SET_XX_ELSE_CODE(SET_OK_VALUE(*str));
+      }
     } break;
     case STR_DEL: {
       CHECK_INVALID_REQUEST(request.HasKey(), "strdel");
@@ -137,7 +164,7 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
     case STRLEN: {
       CHECK_INVALID_REQUEST(request.HasKey(), "strlen");
       String *str  = nullptr;
-      auto    code = db.GetStr(request.key, str);
+      auto    code = db.GetStr(request.GetKey(), str);
       SET_XX_ELSE_CODE(SET_OK_COUNT(str->size()));
     } break;
 
@@ -198,7 +225,7 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
     case LGETSIZE: {
       CHECK_INVALID_REQUEST(request.HasKey(), "lgetsize");
       size_t count = 0;
-      if ((response->status_code = db.ListGetSize(request.key, count)) == S_OK) {
+      if ((response->status_code = db.ListGetSize(request.GetKey(), count)) == S_OK) {
         response->SetCount();
         response->count = count;
       }
@@ -208,7 +235,7 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
       CHECK_INVALID_REQUEST(request.HasRange(), "lgetrange");
 
       if ((response->status_code = db.ListGetRange(
-               request.key,
+               request.GetKey(),
                response->values,
                request.range.left,
                request.range.right
@@ -221,9 +248,10 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
     case LGETALL: {
       CHECK_INVALID_REQUEST(request.HasKey(), "lgetrange/getall");
 
-      if ((response->status_code = db.ListGetAll(request.key, response->values)) == S_OK) {
-        response->SetValues();
-      }
+      auto code = response->IsReferenceAllowed()
+                      ? db.ListGetAll(request.GetKey(), response->values_ref)
+                      : db.ListGetAll(request.GetKey(), response->values);
+      SET_XX_ELSE_CODE(SET_OK_VALUES_);
     } break;
 
     case LDEL: {
@@ -243,10 +271,18 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
 
     case VALL: {
       CHECK_INVALID_REQUEST(request.HasKey(), "vall");
-      WeightValues values;
-      if ((response->status_code = db.VsetAll(request.key, response->vmembers)) == S_OK) {
-        response->SetVmembers();
-      }
+      auto code = response->IsReferenceAllowed()
+                      ? db.VsetAll(request.GetKey(), response->vmembers_ref)
+                      : db.VsetAll(request.GetKey(), response->vmembers);
+      SET_XX_ELSE_CODE(SET_OK_VMEMBERS_);
+    } break;
+
+    case VSCAN: {
+      CHECK_INVALID_REQUEST(request.HasKey() && request.HasRange(), "vscan");
+      size_t cursor = request.range.left;
+      auto   code =
+          db.VsetScan(request.GetKey(), cursor, SCAN_COUNT(request), response->vmembers);
+      SET_XX_ELSE_CODE(SET_OK_VMEMBERS_; response->SetCursor(cursor));
     } break;
 
     case VDELM: {
@@ -276,62 +312,64 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
     case VSIZE: {
       CHECK_INVALID_REQUEST(request.HasKey(), "vsize");
       size_t size;
-      auto   code = db.VsetSize(request.key, size);
+      auto   code = db.VsetSize(request.GetKey(), size);
       SET_XX_ELSE_CODE(SET_OK_COUNT(size))
     } break;
 
     case VSIZEBYWEIGHT: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasRange(), "vsizebyweight");
       size_t size;
-      auto   code = db.VsetSizeByWeight(request.key, request.GetWeightRange(), size);
+      auto   code = db.VsetSizeByWeight(request.GetKey(), request.GetWeightRange(), size);
       SET_XX_ELSE_CODE(SET_OK_COUNT(size))
     } break;
 
     case VWEIGHT: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "vweight");
       Weight weight;
-      auto   code = db.VsetWeight(request.key, request.value, weight);
+      auto   code = db.VsetWeight(request.GetKey(), request.GetValue(), weight);
       SET_XX_ELSE_CODE(SET_OK_COUNT(util::double2u64(weight)))
     } break;
 
     case VORDER: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "vorder");
       size_t order = 0;
-      auto   code  = db.VsetOrder(request.key, request.value, order);
+      auto   code  = db.VsetOrder(request.GetKey(), request.GetValue(), order);
       SET_XX_ELSE_CODE(SET_OK_COUNT(order))
     } break;
 
     case VRORDER: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "vrorder");
       size_t order = 0;
-      auto   code  = db.VsetROrder(request.key, request.value, order);
+      auto   code  = db.VsetROrder(request.GetKey(), request.GetValue(), order);
       SET_XX_ELSE_CODE(SET_OK_COUNT(order))
     } break;
 
     case VRANGE: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasRange(), "vrange");
-      auto code = db.VsetRange(request.key, request.range, response->vmembers);
+      auto code = db.VsetRange(request.GetKey(), request.range, response->vmembers);
 
       SET_XX_ELSE_CODE(SET_OK_VMEMBERS_)
     } break;
 
     case VRRANGE: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasRange(), "vrrange");
-      auto code = db.VsetRRange(request.key, request.range, response->vmembers);
+      auto code = db.VsetRRange(request.GetKey(), request.range, response->vmembers);
 
       SET_XX_ELSE_CODE(SET_OK_VMEMBERS_)
     } break;
 
     case VRANGEBYWEIGHT: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasRange(), "vrangebyweight");
-      auto code = db.VsetRangeByWeight(request.key, request.GetWeightRange(), response->vmembers);
+      auto code =
+          db.VsetRangeByWeight(request.GetKey(), request.GetWeightRange(), response->vmembers);
 
       SET_XX_ELSE_CODE(SET_OK_VMEMBERS_)
     } break;
 
     case VRRANGEBYWEIGHT: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasRange(), "vrrangebyweight");
-      auto code = db.VsetRRangeByWeight(request.key, request.GetWeightRange(), response->vmembers);
+      auto code =
+          db.VsetRRangeByWeight(request.GetKey(), request.GetWeightRange(), response->vmembers);
 
       SET_XX_ELSE_CODE(SET_OK_VMEMBERS_)
     } break;
@@ -348,15 +386,17 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
 
     case MGET: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "mget");
-      auto code = db.MapGet(request.key, request.value, response->value);
+      auto code = db.MapGet(request.GetKey(), request.GetValue(), response->value);
       SET_XX_ELSE_CODE(SET_OK_VALUE_);
     } break;
 
     case MGETS: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValues(), "mgets");
-      auto code = db.MapGets(request.key, request.values, response->values);
+      auto code = request.IsView()
+                      ? db.MapGets(request.GetKey(), request.values_view, response->values)
+                      : db.MapGets(request.GetKey(), request.values, response->values);
       SET_XX_ELSE_CODE(SET_OK_VALUES_);
-    }
+    } break;
 
     case MSET: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValues(), "mset");
@@ -373,33 +413,42 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
 
     case MALL: {
       CHECK_INVALID_REQUEST(request.HasKey(), "mall");
-      auto code = db.MapAll(request.key, response->kvs);
+      auto code = response->IsReferenceAllowed()
+                      ? db.MapAll(request.GetKey(), response->kvs_ref)
+                      : db.MapAll(request.GetKey(), response->kvs);
 
       SET_XX_ELSE_CODE(SET_OK_KVS_);
     } break;
 
+    case MSCAN: {
+      CHECK_INVALID_REQUEST(request.HasKey() && request.HasRange(), "mscan");
+      size_t cursor = request.range.left;
+      auto   code   = db.MapScan(request.GetKey(), cursor, SCAN_COUNT(request), response->kvs);
+      SET_XX_ELSE_CODE(SET_OK_KVS_; response->SetCursor(cursor));
+    } break;
+
     case MFIELDS: {
       CHECK_INVALID_REQUEST(request.HasKey(), "mfields");
-      auto code = db.MapFields(request.key, response->values);
+      auto code = db.MapFields(request.GetKey(), response->values);
       SET_XX_ELSE_CODE(SET_OK_VALUES_);
     } break;
 
     case MVALUES: {
       CHECK_INVALID_REQUEST(request.HasKey(), "mvalues");
-      auto code = db.MapValues(request.key, response->values);
+      auto code = db.MapValues(request.GetKey(), response->values);
       SET_XX_ELSE_CODE(SET_OK_VALUES_);
     } break;
 
     case MSIZE: {
       CHECK_INVALID_REQUEST(request.HasKey(), "msize");
       size_t count = 0;
-      auto   code  = db.MapSize(request.key, count);
+      auto   code  = db.MapSize(request.GetKey(), count);
       SET_XX_ELSE_CODE(SET_OK_COUNT(count));
     } break;
 
     case MEXISTS: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "mexists");
-      response->status_code = db.MapExists(request.key, request.value);
+      response->status_code = db.MapExists(request.GetKey(), request.GetValue());
     } break;
 
     case SADD: {
@@ -419,13 +468,13 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
 
     case SEXISTS: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "sexists");
-      response->status_code = db.SetExists(request.key, request.value);
+      response->status_code = db.SetExists(request.GetKey(), request.GetValue());
     } break;
 
     case SSIZE: {
       CHECK_INVALID_REQUEST(request.HasKey(), "ssize");
       size_t count          = 0;
-      response->status_code = db.SetSize(request.key, count);
+      response->status_code = db.SetSize(request.GetKey(), count);
       if (response->status_code == S_OK) {
         response->count = count;
         response->SetCount();
@@ -434,25 +483,32 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
 
     case SALL: {
       CHECK_INVALID_REQUEST(request.HasKey(), "sall");
-      response->status_code = db.SetAll(request.key, response->values);
+      response->status_code = db.SetAll(request.GetKey(), response->values);
       if (response->status_code == S_OK) response->SetValues();
     } break;
 
+    case SSCAN: {
+      CHECK_INVALID_REQUEST(request.HasKey() && request.HasRange(), "sscan");
+      size_t cursor = request.range.left;
+      auto   code   = db.SetScan(request.GetKey(), cursor, SCAN_COUNT(request), response->values);
+      SET_XX_ELSE_CODE(SET_OK_VALUES_; response->SetCursor(cursor));
+    } break;
+
     case SAND: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "sand");
-      response->status_code = db.SetAnd(request.key, request.value, response->values);
+      response->status_code = db.SetAnd(request.GetKey(), request.GetValue(), response->values);
       if (response->status_code == S_OK) response->SetValues();
     } break;
 
     case SOR: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "sor");
-      response->status_code = db.SetOr(request.key, request.value, response->values);
+      response->status_code = db.SetOr(request.GetKey(), request.GetValue(), response->values);
       if (response->status_code == S_OK) response->SetValues();
     } break;
 
     case SSUB: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "ssub");
-      response->status_code = db.SetSub(request.key, request.value, response->values);
+      response->status_code = db.SetSub(request.GetKey(), request.GetValue(), response->values);
       if (response->status_code == S_OK) response->SetValues();
     } break;
 
@@ -477,21 +533,21 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
     case SANDSIZE: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "sandsize");
       size_t count = 0;
-      auto   code  = db.SetAndSize(request.key, request.value, count);
+      auto   code  = db.SetAndSize(request.GetKey(), request.GetValue(), count);
       SET_XX_ELSE_CODE(SET_OK_COUNT(count));
     } break;
 
     case SORSIZE: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "sorsize");
       size_t count = 0;
-      auto   code  = db.SetOrSize(request.key, request.value, count);
+      auto   code  = db.SetOrSize(request.GetKey(), request.GetValue(), count);
       SET_XX_ELSE_CODE(SET_OK_COUNT(count));
     } break;
 
     case SSUBSIZE: {
       CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "ssubsize");
       size_t count = 0;
-      auto   code  = db.SetSubSize(request.key, request.value, count);
+      auto   code  = db.SetSubSize(request.GetKey(), request.GetValue(), count);
       SET_XX_ELSE_CODE(SET_OK_COUNT(count));
     } break;
     case SRANDDELM: {
@@ -532,14 +588,14 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
 
     case EXPIRATION: {
       CHECK_INVALID_REQUEST(request.HasKey(), "expiration");
-      const auto code = db.GetExpiration(request.key, response->count);
+      const auto code = db.GetExpiration(request.GetKey(), response->count);
       response->SetCount();
       response->status_code = code;
     } break;
 
     case TTL: {
       CHECK_INVALID_REQUEST(request.HasKey(), "TTL");
-      const auto code = db.GetTimeToLive(request.key, response->count);
+      const auto code = db.GetTimeToLive(request.GetKey(), response->count);
       response->SetCount();
       response->status_code = code;
     } break;
@@ -547,7 +603,7 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
     case TYPE: {
       CHECK_INVALID_REQUEST(request.HasKey(), "type");
       db::DataType type;
-      if (db.Type(request.key, type)) {
+      if (db.Type(request.GetKey(), type)) {
         SET_OK_VALUE(GetDataTypeString(type));
       } else {
         response->status_code = S_NONEXISTS;
@@ -565,6 +621,17 @@ void DatabaseInstance::Execute(MmbpRequest &request, MmbpResponse *response, uin
       auto code = db.Rename(request.key, std::move(request.value));
       if (response) response->status_code = code;
     } break;
+
+    case MEM_USAGE: {
+      CHECK_INVALID_REQUEST(request.HasKey(), "memusage");
+      size_t usage = 0;
+      auto   code  = db.MemoryUsage(
+          request.GetKey(),
+          request.HasCount() ? request.count : MEMORY_USAGE_DEFAULT_SAMPLE_NUM,
+          usage
+      );
+      SET_XX_ELSE_CODE(SET_OK_COUNT(usage));
+    } break;
   }
 }
 
@@ -576,6 +643,7 @@ DatabaseManager::DatabaseManager()
                                                      : DatabaseManager::LOCAL_MULTI_THREAD)
     )
   , current_index_(0)
+  , start_time_sec_(util::GetTimeSec())
 {
   size_t db_num = 0;
   switch (type_) {
@@ -642,17 +710,134 @@ void DatabaseManager::CheckExpirationCycle()
     instance.lock.WUnlock();                                                                       \
   }
 
+/* The commands referencing the keys other than request.key */
+static inline bool IsMultiKeyCommand(Command cmd) noexcept
+{
+  switch (cmd) {
+    case SAND:
+    case SOR:
+    case SSUB:
+    case SANDSIZE:
+    case SORSIZE:
+    case SSUBSIZE:
+    case SANDTO:
+    case SORTO:
+    case SSUBTO:
+    case RENAME:
+    case DELS:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/* Visit the keys referenced by the multi-key command with whether it is written */
+template <typename F>
+static inline void ForEachMultiKey(MmbpRequest const &request, F const &f)
+{
+  switch (request.command) {
+    case SAND:
+    case SOR:
+    case SSUB:
+    case SANDSIZE:
+    case SORSIZE:
+    case SSUBSIZE: {
+      if (request.HasKey()) f(request.GetKey(), false);
+      if (request.HasValue()) f(request.GetValue(), false);
+    } break;
+
+    case SANDTO:
+    case SORTO:
+    case SSUBTO: {
+      // <destination, key1, key2>
+      for (size_t i = 0; i < request.values.size(); ++i)
+        f(request.values[i], i == 0);
+    } break;
+
+    case RENAME: {
+      if (request.HasKey()) f(request.GetKey(), true);
+      if (request.HasValue()) f(request.GetValue(), true);
+    } break;
+
+    case DELS: {
+      for (auto const &key : request.values)
+        f(key, true);
+    } break;
+  }
+}
+
+void storage::GetRequestKeys(MmbpRequest const &request, std::vector<StringView> &keys)
+{
+  switch (request.command) {
+    case EVAL:
+    case EVALSHA: {
+      // The script can only access the declared keys
+      const size_t key_num = request.HasCount() ? request.count : 0;
+      for (size_t i = 0; i < key_num && i < request.values.size(); ++i)
+        keys.emplace_back(request.values[i]);
+    } break;
+
+    default:
+      if (IsMultiKeyCommand((Command)request.command)) {
+        ForEachMultiKey(request, [&keys](StringView key, bool) { keys.emplace_back(key); });
+      } else if (request.HasKey()) {
+        keys.emplace_back(request.GetKey());
+      }
+      break;
+  }
+}
+
+/* The request is redirected by the code of CheckKeyShard() */
+static inline void SetShardRedirection(
+    MmbpResponse *response,
+    StatusCode    code,
+    String const *p_endpoint
+)
+{
+  response->status_code = code;
+  if (code == S_ASK) {
+    response->value = *p_endpoint;
+    response->SetValue();
+  }
+}
+
 void DatabaseManager::Execute(MmbpRequest &request, MmbpResponse *response)
 {
+  Execute(request, response, SerializeCallback());
+}
+
+void DatabaseManager::Execute(
+    MmbpRequest             &request,
+    MmbpResponse            *response,
+    SerializeCallback const &serialize_cb
+)
+{
+  // The command comes from the client, reject the unknown one before looking up its type
+  if (request.command >= COMMAND_NUM) {
+    if (response) {
+      response->status_code = S_INVALID_REQUEST;
+      if (serialize_cb) serialize_cb(*response);
+    }
+    return;
+  }
+
+  /* The response can reference the stored data
+   * only if it is serialized before unlocking */
+  if (response && serialize_cb) response->AllowReference();
+
+  // The requests replayed in recovery(no response) are not counted
+  const int64_t start_ns = response ? util::GetMonotonicTimeNs() : 0;
+
   DatabaseInstance *instance     = nullptr;
+  InstanceLocks     locks;
   auto              command_type = GetCommandType((Command)request.command);
-  if (request.HasKey()) {
-    if (DISTRIBUTED == type_) {
-      // FIXME Allow set the shard_id by user before calling this function or by arguments
-      instance = &GetShardDatabaseInstance(MakeShardId(request.key));
-    } else {
-      instance = &GetDatabaseInstance(request.key);
-    }
+  if (IsMultiKeyCommand((Command)request.command)) {
+    // Executed by the instance directly if all keys are in it
+    CollectMultiKeyLocks(request, locks);
+    LockInstances(locks);
+    if (locks.size() == 1 && request.HasKey()) instance = &instances_[locks[0].first];
+  } else if (request.HasKey()) {
+    instance = &instances_[GetKeyInstanceIndex(request.GetKey())];
 
     if (command_type == CommandType::CT_READ) {
       instance->lock.RLock();
@@ -665,8 +850,65 @@ void DatabaseManager::Execute(MmbpRequest &request, MmbpResponse *response)
 
   switch (request.command) {
     case MEM_STAT: {
-      CHECK_INVALID_REQUEST(request.HasNone(), "memorystat");
-      SET_OK_VALUE(util::GetMemoryStat());
+      /* Don't return early, the response must be serialized */
+      if (!request.HasNone()) {
+        response->status_code = S_INVALID_REQUEST;
+        response->value       = "memorystat";
+        response->SetValue();
+      } else {
+        SET_OK_VALUE(util::GetMemoryStat());
+      }
+    } break;
+
+    case MEM_REPORT: {
+      const size_t key_num = request.HasCount() ? request.count : MEMORY_REPORT_DEFAULT_KEY_NUM;
+      SET_OK_VALUE(GetMemoryReport(key_num));
+    } break;
+
+    case INFO: {
+      String info;
+      if (!GetInfo(request.HasValue() ? request.GetValue() : StringView(), info)) {
+        response->status_code = S_INVALID_REQUEST;
+        response->value       = "info";
+        response->SetValue();
+      } else {
+        SET_OK_VALUE(std::move(info));
+      }
+    } break;
+
+    case SLOWLOG:
+    case SLOWLOG_RESET: {
+      // The slowlog is maintained by the server
+      if (g_hooks.on_slowlog) {
+        g_hooks.on_slowlog(request, *response);
+      } else {
+        SET_OK_VALUES_;
+      }
+    } break;
+
+    case EVAL:
+    case EVALSHA: {
+      Eval(request, response);
+    } break;
+
+    case SCRIPT_LOAD: {
+      if (!request.HasValue()) {
+        if (response) {
+          response->status_code = S_INVALID_REQUEST;
+          response->value       = "scriptload";
+          response->SetValue();
+        }
+      } else {
+        auto hash = lua::script_cache().Load(request.GetValue());
+        if (response) {
+          SET_OK_VALUE(String(hash.data(), hash.size()));
+        }
+      }
+    } break;
+
+    case SCRIPT_FLUSH: {
+      lua::script_cache().Flush();
+      if (response) response->SetOk();
     } break;
 
     case KEYALL: {
@@ -679,18 +921,22 @@ void DatabaseManager::Execute(MmbpRequest &request, MmbpResponse *response)
       RUNLOCK_ALL
     } break;
 
-    case DELS: {
-      auto  &keys  = request.values;
-      size_t count = 0;
-      for (auto const &key : keys) {
-        count += GetDatabaseInstance(key).db.Delete(key) ? 1 : 0;
+    case SCAN: {
+      if (!request.HasRange()) {
+        response->status_code = S_INVALID_REQUEST;
+        response->value       = "scan";
+        response->SetValue();
+      } else {
+        const auto cursor = Scan(request.range.left, SCAN_COUNT(request), response->values);
+        SET_OK_VALUES_;
+        response->SetCursor(cursor);
       }
+    } break;
 
-      if (response) {
-        response->status_code = S_OK;
-        response->count       = count;
-        response->SetCount();
-      }
+    case DELS: {
+      if (response && server::mmkv_config().IsSharder() && !CheckMultiKeyShard(request, response))
+        break;
+      ExecuteMultiKey(request, response);
     } break;
 
     case DELALL: {
@@ -712,20 +958,653 @@ void DatabaseManager::Execute(MmbpRequest &request, MmbpResponse *response)
     } break;
 
     default:
+      // Neither the keyless request nor the multi-key command without keys can
+      // determine the instance to execute it
+      if (!instance && locks.empty()) {
+        if (response) response->status_code = S_INVALID_REQUEST;
+        break;
+      }
+
+      // The requests without response are replayed or migrated, they aren't redirected.
+      if (response && server::mmkv_config().IsSharder()) {
+        if (!locks.empty()) {
+          // All keys of multi-key command must be served by this node
+          if (!CheckMultiKeyShard(request, response)) break;
+        } else {
+          String const *p_endpoint = nullptr;
+          const auto    code       = CheckKeyShard(
+              *instance,
+              request.GetKey(),
+              command_type == CommandType::CT_WRITE,
+              request.is_asking,
+              &p_endpoint
+          );
+          if (code != S_OK) {
+            SetShardRedirection(response, code, p_endpoint);
+            break;
+          }
+        }
+      }
+
+      // The keys of multi-key command are in different instances
+      if (!instance) {
+        ExecuteMultiKey(request, response);
+        break;
+      }
       instance->Execute(request, response, recv_time_);
       break;
   }
 
-  if (instance) {
+  if (response && serialize_cb) serialize_cb(*response);
+
+  if (!locks.empty()) {
+    UnlockInstances(locks);
+  } else if (instance) {
     if (command_type == CommandType::CT_READ) {
       instance->lock.RUnlock();
     } else if (command_type == CommandType::CT_WRITE) {
       instance->lock.WUnlock();
     }
   }
+
+  if (response && g_hooks.on_command) {
+    // Only the keyed read commands look up the keyspace
+    g_hooks.on_command(
+        (Command)request.command,
+        (StatusCode)response->status_code,
+        instance && command_type == CommandType::CT_READ,
+        util::GetMonotonicTimeNs() - start_ns
+    );
+  }
+}
+
+/* The commands handled by the manager instead of instance */
+static inline bool IsManagerCommand(Command cmd) noexcept
+{
+  switch (cmd) {
+    case MEM_STAT:
+    case MEM_REPORT:
+    case INFO:
+    case SLOWLOG:
+    case SLOWLOG_RESET:
+    case EVAL:
+    case EVALSHA:
+    case SCRIPT_LOAD:
+    case SCRIPT_FLUSH:
+    case KEYALL:
+    case SCAN:
+    case DELS:
+    case DELALL:
+    case SHARD_JOIN:
+    case SHARD_LEAVE:
+    case ASKING:
+    case BATCH:
+      return true;
+    default:
+      return cmd >= COMMAND_NUM;
+  }
 }
 
-size_t DatabaseManager::GetDatabaseInstanceIndex(String const &key) const
+void DatabaseManager::ExecuteBatch(
+    MmbpBatchRequest             &batch,
+    MmbpBatchResponse            *response,
+    BatchSerializeCallback const &serialize_cb
+)
+{
+  auto         &requests = batch.requests;
+  const int64_t start_ns = response ? util::GetMonotonicTimeNs() : 0;
+
+  // The batch failed to parse is also empty(see MmbpBatchRequest::ParseFrom())
+  if (requests.empty()) {
+    if (response) {
+      response->status_code = S_INVALID_REQUEST;
+      if (serialize_cb) serialize_cb(*response);
+    }
+    return;
+  }
+
+  // The keys are moved by the write commands,
+  // hence the instances must be determined before executing
+  InstanceLocks request_locks;
+  InstanceLocks locks;
+  request_locks.reserve(requests.size());
+  locks.reserve(requests.size());
+
+  for (auto const &request : requests) {
+    const auto cmd          = (Command)request.command;
+    const bool is_write     = GetCommandType(cmd) == CommandType::CT_WRITE;
+    const bool is_multi_key = IsMultiKeyCommand(cmd);
+    const auto lock_num     = locks.size();
+
+    // The multi-key command locks the instances of all its keys like Execute()
+    if (is_multi_key) {
+      CollectMultiKeyLocks(request, locks);
+    } else if (request.HasKey() && !IsManagerCommand(cmd)) {
+      locks.emplace_back(GetKeyInstanceIndex(request.GetKey()), is_write);
+    }
+
+    if (locks.size() == lock_num) {
+      if (response) {
+        response->status_code = S_INVALID_REQUEST;
+        if (serialize_cb) serialize_cb(*response);
+      }
+      return;
+    }
+    // The instance of multi-key command is unused, it is executed by ExecuteMultiKey()
+    request_locks.emplace_back(locks[lock_num].first, is_write);
+  }
+
+  LockInstances(locks);
+
+  if (response) {
+    response->status_code = S_OK;
+    response->responses.clear();
+    response->responses.resize(requests.size());
+  }
+
+  // The whole batch is redirected if any key isn't served by this node,
+  // the sub-response of the key carries the endpoint of S_ASK
+  size_t request_num = requests.size();
+  if (response && server::mmkv_config().IsSharder()) {
+    for (size_t i = 0; i < requests.size(); ++i) {
+      if (IsMultiKeyCommand((Command)requests[i].command)) {
+        if (!CheckMultiKeyShard(requests[i], &response->responses[i])) {
+          response->status_code = response->responses[i].status_code;
+          request_num           = 0;
+          break;
+        }
+        continue;
+      }
+
+      String const *p_endpoint = nullptr;
+      const auto    code       = CheckKeyShard(
+          instances_[request_locks[i].first],
+          requests[i].GetKey(),
+          request_locks[i].second,
+          requests[i].is_asking,
+          &p_endpoint
+      );
+      if (code != S_OK) {
+        response->status_code = code;
+        SetShardRedirection(&response->responses[i], code, p_endpoint);
+        request_num = 0;
+        break;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < request_num; ++i) {
+    MmbpResponse *sub_response = nullptr;
+    if (response) {
+      sub_response = &response->responses[i];
+      if (serialize_cb) sub_response->AllowReference();
+    } else if (!request_locks[i].second) {
+      continue;
+    }
+
+    if (IsMultiKeyCommand((Command)requests[i].command)) {
+      ExecuteMultiKey(requests[i], sub_response);
+    } else {
+      instances_[request_locks[i].first].Execute(requests[i], sub_response, recv_time_);
+    }
+  }
+
+  if (response && serialize_cb) serialize_cb(*response);
+
+  UnlockInstances(locks);
+
+  if (response && g_hooks.on_command) {
+    g_hooks.on_command(
+        BATCH,
+        (StatusCode)response->status_code,
+        false,
+        util::GetMonotonicTimeNs() - start_ns
+    );
+  }
+}
+
+void DatabaseManager::Eval(MmbpRequest &request, MmbpResponse *response)
+{
+  // The script is also run when recovering, only the response is discarded.
+  // The requests without response are replayed, they aren't redirected.
+  const bool   is_redirectable = response && server::mmkv_config().IsSharder();
+  // The replayed script isn't aborted, otherwise its writes diverge from the primary
+  const long   time_limit_ms   = response ? server::mmkv_config().script_time_limit : 0;
+  MmbpResponse dummy_response;
+  if (!response) response = &dummy_response;
+
+  const size_t key_num = request.HasCount() ? request.count : 0;
+  if (!request.HasValue() || key_num > request.values.size()) {
+    response->status_code = S_INVALID_REQUEST;
+    response->value       = request.command == EVAL ? "eval" : "evalsha";
+    response->SetValue();
+    return;
+  }
+
+  const auto hash = request.command == EVAL ? lua::script_cache().Load(request.GetValue())
+                                            : request.GetValue().ToString();
+
+  InstanceLocks locks;
+  locks.reserve(key_num);
+  for (size_t i = 0; i < key_num; ++i)
+    locks.emplace_back(GetKeyInstanceIndex(request.values[i]), true);
+  LockInstances(locks);
+
+  // The script isn't run if any declared key isn't served by this node
+  if (is_redirectable) {
+    for (size_t i = 0; i < key_num; ++i) {
+      String const *p_endpoint = nullptr;
+      const auto    code       = CheckKeyShard(
+          instances_[GetKeyInstanceIndex(request.values[i])],
+          request.values[i],
+          true,
+          request.is_asking,
+          &p_endpoint
+      );
+      if (code != S_OK) {
+        SetShardRedirection(response, code, p_endpoint);
+        UnlockInstances(locks);
+        return;
+      }
+    }
+  }
+
+  lua::RunScript(
+      hash,
+      request.values,
+      key_num,
+      [this, &request, key_num, is_redirectable](
+          MmbpRequest  &sub_request,
+          MmbpResponse &sub_response
+      ) -> char const * {
+        const auto cmd          = (Command)sub_request.command;
+        const bool is_multi_key = IsMultiKeyCommand(cmd);
+
+        /* <key, is write> */
+        std::vector<std::pair<StringView, bool>> keys;
+        if (is_multi_key) {
+          ForEachMultiKey(sub_request, [&keys](StringView key, bool is_write) {
+            keys.emplace_back(key, is_write);
+          });
+        } else if (sub_request.HasKey() && !IsManagerCommand(cmd)) {
+          keys.emplace_back(sub_request.GetKey(), GetCommandType(cmd) == CommandType::CT_WRITE);
+        }
+        if (keys.empty()) {
+          return "ERR only the command with a key can be called from script";
+        }
+
+        // The replication ships the declared keys with the script(see GetRequestKeys()),
+        // thus the undeclared key is refused even if its instance is locked.
+        // The instance holds other shards also, each key must be checked itself.
+        const auto first = request.values.begin();
+        for (auto const &key : keys) {
+          const auto is_declared = std::any_of(first, first + key_num, [&key](String const &k) {
+            return StringView(k.data(), k.size()) == key.first;
+          });
+          if (!is_declared) {
+            return "ERR the key called from script must be declared in KEYS";
+          }
+
+          String const *p_endpoint = nullptr;
+          if (is_redirectable && CheckKeyShard(
+                                     instances_[GetKeyInstanceIndex(key.first)],
+                                     key.first,
+                                     key.second,
+                                     request.is_asking,
+                                     &p_endpoint
+                                 ) != S_OK)
+          {
+            return "ERR the key called from script isn't served by this node";
+          }
+        }
+
+        // The instances of all declared keys are locked
+        if (is_multi_key) {
+          ExecuteMultiKey(sub_request, &sub_response);
+          return nullptr;
+        }
+        const auto index = GetKeyInstanceIndex(keys[0].first);
+        instances_[index].Execute(sub_request, &sub_response, recv_time_);
+        return nullptr;
+      },
+      time_limit_ms,
+      *response
+  );
+
+  UnlockInstances(locks);
+}
+
+void DatabaseManager::CollectMultiKeyLocks(MmbpRequest const &request, InstanceLocks &locks) const
+{
+  if (request.command == DELS) locks.reserve(request.values.size());
+  ForEachMultiKey(request, [this, &locks](StringView key, bool is_write) {
+    locks.emplace_back(GetKeyInstanceIndex(key), is_write);
+  });
+}
+
+StatusCode DatabaseManager::CheckKeyShard(
+    DatabaseInstance &instance,
+    StringView        key,
+    bool              is_write,
+    bool              is_asking,
+    String const    **p_endpoint
+)
+{
+  // The client routes by a stale shard map, it should fetch the configuration again.
+  const auto shard_id = MakeShardId(key) % server::mmkv_config().shard_num;
+  if (!instance.db.HasShard(shard_id)) return S_MOVED;
+
+  // The shard is migrated key by key, the key may be served by the peer
+  const auto code = instance.db.CheckShardMigration(shard_id, key, is_write, is_asking, p_endpoint);
+  if (code != S_OK) return code;
+
+  // The load of shard is reported to the controller for rebalancing
+  if (g_hooks.on_shard_op) g_hooks.on_shard_op(shard_id);
+  return S_OK;
+}
+
+bool DatabaseManager::CheckMultiKeyShard(MmbpRequest const &request, MmbpResponse *response)
+{
+  StatusCode    code       = S_OK;
+  String const *p_endpoint = nullptr;
+  ForEachMultiKey(request, [&](StringView key, bool is_write) {
+    if (code != S_OK) return;
+    code = CheckKeyShard(
+        instances_[GetKeyInstanceIndex(key)],
+        key,
+        is_write,
+        request.is_asking,
+        &p_endpoint
+    );
+  });
+
+  if (code != S_OK) {
+    SetShardRedirection(response, code, p_endpoint);
+    return false;
+  }
+  return true;
+}
+
+void DatabaseManager::ExecuteMultiKey(MmbpRequest &request, MmbpResponse *response)
+{
+  switch (request.command) {
+    case SAND:
+    case SOR:
+    case SSUB: {
+      CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "sand/sor/ssub");
+      auto      &db1  = instances_[GetKeyInstanceIndex(request.GetKey())].db;
+      auto      &db2  = instances_[GetKeyInstanceIndex(request.GetValue())].db;
+      auto const key1 = request.GetKey();
+      auto const key2 = request.GetValue();
+
+      StatusCode code;
+      switch (request.command) {
+        case SAND:
+          code = db1.SetAnd(key1, db2, key2, response->values);
+          break;
+        case SOR:
+          code = db1.SetOr(key1, db2, key2, response->values);
+          break;
+        default:
+          code = db1.SetSub(key1, db2, key2, response->values);
+          break;
+      }
+      SET_XX_ELSE_CODE(SET_OK_VALUES_);
+    } break;
+
+    case SANDSIZE:
+    case SORSIZE:
+    case SSUBSIZE: {
+      CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "sandsize/sorsize/ssubsize");
+      auto      &db1   = instances_[GetKeyInstanceIndex(request.GetKey())].db;
+      auto      &db2   = instances_[GetKeyInstanceIndex(request.GetValue())].db;
+      auto const key1  = request.GetKey();
+      auto const key2  = request.GetValue();
+      size_t     count = 0;
+
+      StatusCode code;
+      switch (request.command) {
+        case SANDSIZE:
+          code = db1.SetAndSize(key1, db2, key2, count);
+          break;
+        case SORSIZE:
+          code = db1.SetOrSize(key1, db2, key2, count);
+          break;
+        default:
+          code = db1.SetSubSize(key1, db2, key2, count);
+          break;
+      }
+      SET_XX_ELSE_CODE(SET_OK_COUNT(count));
+    } break;
+
+    case SANDTO:
+    case SORTO:
+    case SSUBTO: {
+      auto &values = request.values;
+      CHECK_INVALID_REQUEST(request.HasValues() && values.size() == 3, "sandto/sorto/ssubto");
+      auto &dest_db = instances_[GetKeyInstanceIndex(values[0])].db;
+      auto &db1     = instances_[GetKeyInstanceIndex(values[1])].db;
+      auto &db2     = instances_[GetKeyInstanceIndex(values[2])].db;
+
+      StatusCode code;
+      switch (request.command) {
+        case SANDTO:
+          code = dest_db.SetAndTo(db1, values[1], db2, values[2], std::move(values[0]));
+          break;
+        case SORTO:
+          code = dest_db.SetOrTo(db1, values[1], db2, values[2], std::move(values[0]));
+          break;
+        default:
+          code = dest_db.SetSubTo(db1, values[1], db2, values[2], std::move(values[0]));
+          break;
+      }
+      if (response) response->status_code = code;
+    } break;
+
+    case RENAME: {
+      CHECK_INVALID_REQUEST(request.HasKey() && request.HasValue(), "rename");
+      auto &old_db = instances_[GetKeyInstanceIndex(request.GetKey())].db;
+      auto &new_db = instances_[GetKeyInstanceIndex(request.GetValue())].db;
+      auto  code   = old_db.Rename(request.key, new_db, std::move(request.value));
+      if (response) response->status_code = code;
+    } break;
+
+    case DELS: {
+      size_t count = 0;
+      for (auto const &key : request.values) {
+        count += instances_[GetKeyInstanceIndex(key)].db.Delete(key) == S_OK ? 1 : 0;
+      }
+
+      if (response) {
+        response->status_code = S_OK;
+        response->count       = count;
+        response->SetCount();
+      }
+    } break;
+
+    default:
+      if (response) response->status_code = S_INVALID_REQUEST;
+      break;
+  }
+}
+
+void DatabaseManager::LockInstances(InstanceLocks &locks)
+{
+  std::sort(locks.begin(), locks.end());
+  size_t lock_num = 0;
+  for (size_t i = 0; i < locks.size(); ++i) {
+    if (lock_num > 0 && locks[lock_num - 1].first == locks[i].first) {
+      locks[lock_num - 1].second |= locks[i].second;
+    } else {
+      locks[lock_num++] = locks[i];
+    }
+  }
+  locks.resize(lock_num);
+
+  for (auto const &lock : locks) {
+    auto &instance_lock = instances_[lock.first].lock;
+    if (lock.second)
+      instance_lock.WLock();
+    else
+      instance_lock.RLock();
+  }
+}
+
+void DatabaseManager::UnlockInstances(InstanceLocks const &locks)
+{
+  for (auto iter = locks.rbegin(); iter != locks.rend(); ++iter) {
+    auto &instance_lock = instances_[iter->first].lock;
+    if (iter->second)
+      instance_lock.WUnlock();
+    else
+      instance_lock.RUnlock();
+  }
+}
+
+size_t DatabaseManager::Scan(size_t cursor, size_t count, StrValues &keys)
+{
+  // cursor = instance_cursor * instance_num + instance_index
+  const size_t instance_num    = instances_.size();
+  size_t       index           = cursor % instance_num;
+  size_t       instance_cursor = cursor / instance_num;
+
+  while (keys.size() < count) {
+    auto &instance = instances_[index];
+    {
+      RLockGuard g(instance.lock);
+      instance_cursor = instance.db.Scan(instance_cursor, count - keys.size(), keys);
+    }
+
+    if (instance_cursor != 0) break;
+
+    // The instance is completed, continue with the next instance
+    if (++index == instance_num) return 0;
+  }
+
+  return instance_cursor * instance_num + index;
+}
+
+bool DatabaseManager::Dump(StringView key, Buffer &buffer)
+{
+  auto      &instance = instances_[GetKeyInstanceIndex(key)];
+  RLockGuard g(instance.lock);
+  // The dump is logged before the records accessing the key,
+  // the DEL of expired key would be logged after them
+  db::LazyExpirationPause pause;
+  return DumpKey(instance.db, String(key.data(), key.size()), buffer);
+}
+
+/* The number of keys sampled in a round.
+ * The read lock of instance is released between rounds,
+ * hence the writers are not blocked for long. */
+#define MEMORY_REPORT_ROUND_KEY_NUM 64
+
+String DatabaseManager::GetMemoryReport(size_t key_num)
+{
+  db::MemoryReport report;
+  const size_t     instance_key_num = std::max<size_t>(key_num / instances_.size(), 1);
+
+  for (auto &instance : instances_) {
+    size_t total_num = 0;
+    {
+      RLockGuard g(instance.lock);
+      total_num = instance.db.GetKeyNum();
+    }
+    report.AddTotalKeyNum(total_num);
+
+    const size_t target_num  = std::min(instance_key_num, total_num);
+    size_t       sampled_num = 0;
+    while (sampled_num < target_num) {
+      RLockGuard g(instance.lock);
+      const auto n = instance.db.SampleMemoryUsage(
+          std::min<size_t>(MEMORY_REPORT_ROUND_KEY_NUM, target_num - sampled_num),
+          MEMORY_USAGE_DEFAULT_SAMPLE_NUM,
+          report
+      );
+      if (n == 0) break;
+      sampled_num += n;
+    }
+  }
+
+  return report.ToString();
+}
+
+static char const *INFO_SECTION_STRS[] = {
+    "server",
+    "stats",
+    "commandstats",
+    "replication",
+    "keyspace",
+};
+
+/* Append the formatted string, the line of info is short */
+#define INFO_APPEND(...)                                                                           \
+  do {                                                                                             \
+    ::snprintf(line, sizeof line, __VA_ARGS__);                                                    \
+    info += line;                                                                                  \
+  } while (0)
+
+bool DatabaseManager::GetInfo(StringView section, String &info)
+{
+  bool       is_included[IS_NUM];
+  const bool is_all   = section.empty() || section == "all";
+  bool       is_valid = is_all;
+  for (int i = 0; i < IS_NUM; ++i) {
+    is_included[i] = is_all || section == INFO_SECTION_STRS[i];
+    is_valid       = is_valid || is_included[i];
+  }
+  if (!is_valid) return false;
+
+  char line[256];
+  info.clear();
+
+  if (is_included[IS_SERVER]) {
+    INFO_APPEND("# Server\n");
+    INFO_APPEND("mmkv_version:%s\n", MMKV_VERSION_STR);
+    INFO_APPEND("uptime_in_seconds:%" PRId64 "\n", util::GetTimeSec() - start_time_sec_);
+    INFO_APPEND("thread_num:%d\n", server::mmkv_config().thread_num);
+    INFO_APPEND("instance_num:%zu\n", instances_.size());
+    INFO_APPEND("\n");
+  }
+
+  // The sections maintained by the server
+  if (g_hooks.get_info) g_hooks.get_info(is_included, info);
+
+  if (is_included[IS_KEYSPACE]) {
+    INFO_APPEND("# Keyspace\n");
+    for (size_t i = 0; i < instances_.size(); ++i) {
+      auto  &instance  = instances_[i];
+      size_t key_num   = 0;
+      size_t exp_num   = 0;
+      size_t moved_num = 0;
+      size_t total_num = 0;
+      bool   rehashing = false;
+      {
+        RLockGuard g(instance.lock);
+        key_num   = instance.db.GetKeyNum();
+        exp_num   = instance.db.GetExpireKeyNum();
+        rehashing = instance.db.GetRehashProgress(&moved_num, &total_num);
+      }
+
+      if (rehashing) {
+        INFO_APPEND(
+            "db%zu:keys=%zu,expires=%zu,rehashing=%zu/%zu\n",
+            i,
+            key_num,
+            exp_num,
+            moved_num,
+            total_num
+        );
+      } else {
+        INFO_APPEND("db%zu:keys=%zu,expires=%zu,rehashing=no\n", i, key_num, exp_num);
+      }
+    }
+  }
+
+  return true;
+}
+
+size_t DatabaseManager::GetDatabaseInstanceIndex(StringView key) const
 {
   return instances_.size() == 1 ? 0 : (XXH32(key.data(), key.size(), 0) & (instances_.size() - 1));
 }
@@ -741,3 +1620,10 @@ size_t DatabaseManager::GetDatabaseInstanceIndex2(shard_id_t shard_id) const
 {
   return instances_.size() == 1 ? 0 : (shard_id & (instances_.size() - 1));
 }
+
+size_t DatabaseManager::GetKeyInstanceIndex(StringView key) const
+{
+  // FIXME Allow set the shard_id by user before calling this function or by arguments
+  return DISTRIBUTED == type_ ? GetDatabaseInstanceIndex2(MakeShardId(key))
+                              : GetDatabaseInstanceIndex(key);
+}
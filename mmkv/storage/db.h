@@ -4,10 +4,13 @@
 
 #include "mmkv/db/kvdb.h"
 
+#include "mmkv/protocol/mmbp_batch.h"
 #include "mmkv/protocol/mmbp_request.h"
 #include "mmkv/protocol/mmbp_response.h"
 #include "mmkv/algo/string.h"
 
+#include <functional>
+#include <vector>
 #include <xxhash.h>
 #include <kanon/thread/rw_lock.h>
 
@@ -17,8 +20,54 @@ namespace storage {
 using algo::String;
 using db::MmkvDb;
 using kanon::RWLock;
+using kanon::StringView;
+using protocol::MmbpBatchRequest;
+using protocol::MmbpBatchResponse;
 using protocol::MmbpRequest;
 using protocol::MmbpResponse;
+using protocol::StrValues;
+
+/**
+ * \brief The sections of INFO
+ */
+enum InfoSection : uint8_t {
+  IS_SERVER = 0,
+  IS_STATS,
+  IS_COMMANDSTATS,
+  IS_REPLICATION,
+  IS_KEYSPACE,
+  IS_NUM,
+};
+
+/**
+ * \brief The callbacks registered by the server
+ * The storage doesn't depend on the server, the statistics, slowlog and
+ * the sections of INFO maintained by the server are provided by these.
+ * The hook not set is skipped.
+ */
+struct StorageHooks {
+  /** The command with response is executed, the latency is in nanoseconds.
+   *  is_lookup indicates the keyed read, i.e. hit if S_OK and miss if S_NONEXISTS */
+  std::function<
+      void(protocol::Command cmd, protocol::StatusCode code, bool is_lookup, int64_t latency_ns)>
+      on_command;
+
+  /** The key of shard is accessed(sharder only) */
+  std::function<void(shard_id_t shard_id)> on_shard_op;
+
+  /** Handle SLOWLOG and SLOWLOG_RESET */
+  std::function<void(MmbpRequest const &request, MmbpResponse &response)> on_slowlog;
+
+  /** Append the sections maintained by the server, i.e. stats, commandstats and replication.
+   *  is_included is indexed by InfoSection */
+  std::function<void(bool const *is_included, String &info)> get_info;
+};
+
+/**
+ * \brief Register the hooks of all database managers
+ * \note Not thread-safe, register them before the database is accessed
+ */
+void SetStorageHooks(StorageHooks hooks);
 
 struct DatabaseInstance : kanon::noncopyable {
   MmkvDb db;
@@ -59,8 +108,10 @@ class DatabaseManager : kanon::noncopyable {
   using instances_t = algo::ReservedArray<DatabaseInstance>;
 
  public:
-  using Iterator      = instances_t::iterator;
-  using ConstIterator = instances_t::const_iterator;
+  using Iterator          = instances_t::iterator;
+  using ConstIterator     = instances_t::const_iterator;
+  using SerializeCallback      = std::function<void(MmbpResponse const &)>;
+  using BatchSerializeCallback = std::function<void(MmbpBatchResponse const &)>;
 
   DatabaseManager();
   ~DatabaseManager() noexcept;
@@ -76,21 +127,134 @@ class DatabaseManager : kanon::noncopyable {
    */
   void Execute(MmbpRequest &request, MmbpResponse *response);
 
+  /**
+   * \brief Execute the request and serialize the response before unlocking
+   *
+   * The read commands that return the whole value(e.g. strget, lgetall, mall, vall)
+   * reference the stored data instead of copying them to the response,
+   * then \p serialize_cb appends them into the output buffer directly.
+   *
+   * The multi-key commands(e.g. sand, sandto, rename, dels) lock the instances
+   * of all keys in the ascending order of instance index like ExecuteBatch(),
+   * thus the keys in different instances are operated atomically without
+   * locking all instances.
+   *
+   * \param serialize_cb Called with the instance lock held
+   *
+   * \note
+   *  Thread-safe
+   *  The references in response are dangling after this returns
+   */
+  void Execute(MmbpRequest &request, MmbpResponse *response, SerializeCallback const &serialize_cb);
+
+  /**
+   * \brief Execute the requests of the batch atomically
+   *
+   * The locks of all touched instances are acquired in the ascending order of
+   * instance index(i.e. a fixed global order, no deadlock between batches),
+   * then the requests are executed in order and the response is serialized
+   * before unlocking.
+   * Only the keyed requests and the multi-key commands(locking all their keys
+   * like Execute()) are allowed, otherwise(also the empty batch) the batch is
+   * rejected and no request is executed.
+   * The failure of a request doesn't roll back the executed ones.
+   * In the sharder, the whole batch is redirected if any key isn't served by this node.
+   *
+   * \param response Can be nullptr when recovering, the read requests are skipped
+   * \param serialize_cb Called with the instance locks held
+   *
+   * \note
+   *  Thread-safe
+   */
+  void ExecuteBatch(
+      MmbpBatchRequest             &batch,
+      MmbpBatchResponse            *response,
+      BatchSerializeCallback const &serialize_cb = BatchSerializeCallback()
+  );
+
+  /**
+   * \brief Run the script of EVAL or EVALSHA atomically
+   * The write locks of the instances of declared keys are acquired in
+   * the ascending order of instance index like ExecuteBatch(),
+   * the commands called by the script(including the multi-key commands)
+   * can only access the declared keys.
+   * In the sharder, the script isn't run if any declared key isn't served by this node.
+   *
+   * \param response Can be nullptr when recovering
+   *
+   * \note
+   *  Thread-safe
+   */
+  void Eval(MmbpRequest &request, MmbpResponse *response);
+
   /**
    * Check the expiration actively
    * in round-robin method.
    */
   void CheckExpirationCycle();
 
+  /**
+   * \brief Sample the keyspace and report the memory usage
+   * The report includes bytes by type, the largest keys and
+   * average element size.
+   * Each instance is sampled in several rounds and only
+   * the read lock is held in a round.
+   * \param key_num The number of sampled keys totally
+   *
+   * \note
+   *  Thread-safe
+   */
+  String GetMemoryReport(size_t key_num);
+
+  /**
+   * \brief Report the statistics of the server
+   * The per-thread statistics are aggregated on demand.
+   * \param section server, stats, commandstats, keyspace or all(also empty)
+   * \return
+   *  false if the section is invalid
+   *
+   * \note
+   *  Thread-safe
+   */
+  bool GetInfo(StringView section, String &info);
+
+  /**
+   * \brief Get some keys of all instances incrementally
+   * The instances are scanned one by one and the read lock of
+   * an instance is only held for a batch.
+   * \param cursor 0 indicates starting a new scan.
+   *               The index of instance is encoded in the cursor.
+   * \param count The expected number of keys
+   * \return
+   *  The next cursor, 0 indicates the scan is completed
+   *
+   * \note
+   *  Thread-safe
+   */
+  size_t Scan(size_t cursor, size_t count, StrValues &keys);
+
+  /**
+   * \brief Dump the key as the replayable requests(see DumpKey())
+   * The key is dumped with the read lock of its instance held.
+   * The expired key isn't dropped, it is dumped with its expiration.
+   * \param[out] buffer The framed requests are appended to it
+   * \return
+   *  false if the key does not exist
+   *
+   * \note
+   *  Thread-safe
+   */
+  bool Dump(StringView key, kanon::Buffer &buffer);
+
   void     SetRecvTime(uint64_t tm) noexcept { recv_time_ = tm; }
   uint64_t recv_time() const noexcept { return recv_time_; }
 
-  DatabaseInstance &GetDatabaseInstance(String const &key) noexcept
+  DatabaseInstance &GetDatabaseInstance(StringView key) noexcept
   {
     return instances_[GetDatabaseInstanceIndex(key)];
   }
 
-  DatabaseInstance const &GetDatabaseInstance(String const &key) const noexcept
+  DatabaseInstance const &GetDatabaseInstance(StringView key) const noexcept
   {
     return const_cast<DatabaseManager *>(this)->GetDatabaseInstance(key);
   }
@@ -112,9 +276,43 @@ class DatabaseManager : kanon::noncopyable {
   ConstIterator end() const noexcept { return instances_.end(); }
 
  private:
-  size_t GetDatabaseInstanceIndex(String const &key) const;
+  /* <instance index, is write> */
+  using InstanceLocks = std::vector<std::pair<size_t, bool>>;
+
+  /* Sort and merge the locks of same instance then lock them in order,
+   * the write lock is required if any of them is write */
+  void LockInstances(InstanceLocks &locks);
+  void UnlockInstances(InstanceLocks const &locks);
+
+  /* Collect the instances of all keys referenced by the multi-key command,
+   * the destination keys require the write lock */
+  void CollectMultiKeyLocks(MmbpRequest const &request, InstanceLocks &locks) const;
+
+  /* Execute the multi-key command whose keys are in different instances,
+   * the locks collected by CollectMultiKeyLocks() must be held */
+  void ExecuteMultiKey(MmbpRequest &request, MmbpResponse *response);
+
+  /* Check whether the key is served by this sharder, otherwise the request is
+   * redirected by the returned code(see MmkvDb::CheckShardMigration()).
+   * The lock of instance must be held */
+  protocol::StatusCode CheckKeyShard(
+      DatabaseInstance &instance,
+      StringView        key,
+      bool              is_write,
+      bool              is_asking,
+      String const    **p_endpoint
+  );
+
+  /* CheckKeyShard() for all keys of the multi-key command, the response is set
+   * to redirect the whole request if any of them isn't served */
+  bool CheckMultiKeyShard(MmbpRequest const &request, MmbpResponse *response);
+
+  size_t GetDatabaseInstanceIndex(StringView key) const;
   size_t GetDatabaseInstanceIndex2(shard_id_t shard_id) const;
 
+  /* Choose GetDatabaseInstanceIndex() or GetDatabaseInstanceIndex2() by type */
+  size_t GetKeyInstanceIndex(StringView key) const;
+
   enum Type : uint8_t {
     LOCAL,
     LOCAL_MULTI_THREAD,
@@ -125,6 +323,7 @@ class DatabaseManager : kanon::noncopyable {
   instances_t instances_;
   uint64_t    recv_time_;
   uint64_t    current_index_; /** Round-robin index */
+  int64_t     start_time_sec_;
 };
 
 /* Declare pointer to avoid
@@ -134,6 +333,13 @@ class DatabaseManager : kanon::noncopyable {
 
 DatabaseManager &database_manager();
 
+/**
+ * \brief Collect the keys accessed by the request
+ * The keys of multi-key command and the keys declared by script are included.
+ * \param[out] keys The keys reference the request
+ */
+void GetRequestKeys(MmbpRequest const &request, std::vector<StringView> &keys);
+
 // void DbExpireAfter(MmbpRequest &request, uint64_t ms, MmbpResponse
 // *response);
 
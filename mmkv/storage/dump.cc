@@ -0,0 +1,82 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "dump.h"
+
+using namespace mmkv::storage;
+using namespace mmkv::protocol;
+using namespace mmkv::db;
+using namespace kanon;
+
+static inline void AppendRecord(MmbpRequest const &request, Buffer &record, Buffer &buffer)
+{
+  record.AdvanceAll();
+  request.SerializeTo(record);
+  buffer.Append32(record.GetReadableSize());
+  buffer.Append(record.GetReadBegin(), record.GetReadableSize());
+}
+
+bool mmkv::storage::DumpKey(MmkvDb &db, String const &key, Buffer &buffer)
+{
+  DataType type;
+  if (!db.Type(key, type)) return false;
+
+  MmbpRequest request;
+  request.key = key;
+  request.SetKey();
+
+  StatusCode code = S_NONEXISTS;
+  switch (type) {
+    case D_STRING: {
+      String *str = nullptr;
+      code        = db.GetStr(key, str);
+      if (code != S_OK) break;
+      request.command = STR_ADD;
+      request.value   = *str;
+      request.SetValue();
+    } break;
+
+    case D_STRLIST: {
+      code = db.ListGetAll(key, request.values);
+      request.command = LADD;
+      request.SetValues();
+    } break;
+
+    case D_SORTED_SET: {
+      code = db.VsetAll(key, request.vmembers);
+      request.command = VADD;
+      request.SetVmembers();
+    } break;
+
+    case D_MAP: {
+      code = db.MapAll(key, request.kvs);
+      request.command = MADD;
+      request.SetKvs();
+    } break;
+
+    case D_SET: {
+      code = db.SetAll(key, request.values);
+      request.command = SADD;
+      request.SetValues();
+    } break;
+
+    default:
+      assert(false && "Unknown data type");
+  }
+
+  if (code != S_OK) return false;
+
+  Buffer record;
+  AppendRecord(request, record, buffer);
+
+  uint64_t expire_time;
+  if (db.GetExpiration(key, expire_time) == S_OK) {
+    request.Reset();
+    request.command = EXPIREM_AT;
+    request.key     = key;
+    request.SetKey();
+    request.expire_time = expire_time;
+    request.SetExpireTime();
+    AppendRecord(request, record, buffer);
+  }
+
+  return true;
+}
@@ -0,0 +1,30 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_STORAGE_DUMP_H_
+#define _MMKV_STORAGE_DUMP_H_
+
+#include "mmkv/db/kvdb.h"
+#include "mmkv/protocol/mmbp_request.h"
+
+namespace mmkv {
+namespace storage {
+
+/**
+ * \brief Dump the key as the write requests that rebuild it
+ * The key is dumped as an add request(i.e. stradd, ladd, vadd, madd, sadd),
+ * followed by expiremat if it has expiration.
+ * Each request is framed with the 32-bit length header like the request log,
+ * thus the dumped data is replayed like the request log.
+ *
+ * \param[out] buffer The requests are appended to it
+ * \return
+ *  false if the key does not exist(or is expired)
+ *
+ * \warning
+ *  Not thread-safe, the read lock of instance is required
+ */
+bool DumpKey(db::MmkvDb &db, protocol::String const &key, kanon::Buffer &buffer);
+
+} // namespace storage
+} // namespace mmkv
+
+#endif // _MMKV_STORAGE_DUMP_H_
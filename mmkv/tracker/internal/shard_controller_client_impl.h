@@ -5,16 +5,24 @@
 #include "mmkv/sharder/util.h"
 #include "controller.pb.h"
 
+#include "mmkv/db/memory_usage.h"
 #include "mmkv/storage/db.h"
 #include "mmkv/server/config.h"
+#include "mmkv/server/stats.h"
+#include "mmkv/util/time_util.h"
 
 #include <kanon/log/logger.h>
 
+#include <algorithm>
+
 using namespace mmkv::server;
 using namespace kanon;
 using namespace mmkv::storage;
 using namespace ::kanon::protobuf;
 
+/* The number of sampled keys per shard to estimate its memory usage */
+#define LOAD_REPORT_SAMPLE_KEY_NUM 8
+
 struct ShardControllerClient::Impl {
   using Self = ShardControllerClient;
 
@@ -26,29 +34,91 @@ struct ShardControllerClient::Impl {
     return req;
   }
 
-  MMKV_INLINE static void SendAllPeersRequest(
+  /**
+   * The shards of each peer are split to multiple clients(i.e. connections),
+   * thus at most shard_migration_concurrency shards are migrated concurrently
+   * (but one client per peer at least).
+   * \return The number of clients
+   */
+  MMKV_INLINE static size_t SendAllPeersRequest(
       Self                *ctler,
       size_t               peer_num,
       SharderClient::State state
   )
   {
-    ctler->shard_clis_.reserve(peer_num);
+    const size_t concurrency   = std::max(1L, mmkv_config().shard_migration_concurrency);
+    const size_t conn_per_peer = std::max<size_t>(1, concurrency / std::max<size_t>(1, peer_num));
+    size_t       client_num    = 0;
+    size_t       shard_num     = 0;
+
     for (size_t i = 0; i < peer_num; ++i) {
-      const auto &node_info = ctler->node_infos_[i];
-      ctler->shard_clis_.emplace_back(
-          ctler->cli_->GetLoop(),
-          InetAddr(node_info.host(), node_info.port()),
-          ctler
-      );
-      ctler->shard_clis_[i].SetUp(
-          &ctler->sharder_,
-          ctler->node_infos_[i].shard_ids().data(),
-          ctler->node_infos_[i].shard_ids_size(),
-          &ctler->sharder_codec_
-      );
-      ctler->shard_clis_[i].SetState(state);
-      ctler->shard_clis_[i].Connect();
+      const auto  &node_info      = ctler->node_infos_[i];
+      const size_t peer_shard_num = node_info.shard_ids_size();
+      const size_t conn_num       = std::min(conn_per_peer, peer_shard_num);
+      const auto   peer_addr      = InetAddr(node_info.host(), node_info.port());
+
+      for (size_t c = 0; c < conn_num; ++c) {
+        const size_t begin = peer_shard_num * c / conn_num;
+        const size_t end   = peer_shard_num * (c + 1) / conn_num;
+
+        ctler->shard_clis_.emplace_back(
+            new SharderClient(ctler->cli_->GetLoop(), peer_addr, ctler)
+        );
+        auto &shard_cli = *ctler->shard_clis_.back();
+        shard_cli.SetUp(
+            &ctler->sharder_,
+            node_info.shard_ids().data() + begin,
+            end - begin,
+            &ctler->sharder_codec_
+        );
+        shard_cli.SetState(state);
+        shard_cli.Connect();
+      }
+
+      client_num += conn_num;
+      shard_num  += peer_shard_num;
+    }
+
+    StartMigration(ctler, shard_num);
+    LOG_INFO << "Migrate " << shard_num << " shards over " << client_num << " connections";
+    return client_num;
+  }
+
+  MMKV_INLINE static void StartMigration(Self *ctler, size_t shard_num)
+  {
+    if (ctler->migration_start_ms_ == 0) {
+      ctler->migration_start_ms_ = util::GetTimeMs();
+      ctler->migration_limiter_.SetRate(mmkv_config().shard_migration_rate);
     }
+    ctler->total_shard_num_ += shard_num;
+  }
+
+  /* Report the progress to controller, but not block if the controller is disconnected */
+  MMKV_INLINE static void ReportMigrationProgress(Self *ctler)
+  {
+    ControllerRequest req = MakeRequest(ctler, CONTROL_OP_MIGRATION_PROGRESS);
+    req.set_migrated_shard_num(ctler->migrated_shard_num_);
+    req.set_total_shard_num(ctler->total_shard_num_);
+    req.set_migrated_bytes(ctler->migrated_bytes_);
+    req.set_elapsed_ms(util::GetTimeMs() - ctler->migration_start_ms_);
+
+    MutexGuard guard(ctler->conn_lock_);
+    if (ctler->conn_) ctler->codec_.Send(ctler->conn_, &req);
+    ctler->last_report_ms_ = util::GetTimeMs();
+  }
+
+  MMKV_INLINE static void FinishMigration(Self *ctler)
+  {
+    if (ctler->migration_start_ms_ == 0) return;
+
+    ReportMigrationProgress(ctler);
+    LOG_INFO << "Rebalance costs " << util::GetTimeMs() - ctler->migration_start_ms_ << "ms: "
+             << ctler->migrated_shard_num_ << " shards, " << ctler->migrated_bytes_ << " bytes";
+
+    ctler->migrated_shard_num_ = 0;
+    ctler->total_shard_num_    = 0;
+    ctler->migrated_bytes_     = 0;
+    ctler->migration_start_ms_ = 0;
   }
 
   MMKV_INLINE static void HandleJoinOk(
@@ -128,15 +198,70 @@ struct ShardControllerClient::Impl {
     }
   }
 
+  /* The shards of the hot node are pulled like joining */
+  MMKV_INLINE static void HandleRebalance(ShardControllerClient *ctler)
+  {
+    // The clients of previous migration have finished
+    ctler->shard_clis_.clear();
+    ctler->joining_push_num_ = 0;
+    ctler->finish_node_num_  = 0;
+    ctler->state_            = REBALANCING;
+
+    SendAllPeersRequest(ctler, ctler->node_infos_.size(), SharderClient::PULLING);
+  }
+
+  /**
+   * Report the requests/sec and estimated memory usage of the held shards,
+   * the controller replies the shards to pull if this is the coldest node.
+   */
+  MMKV_INLINE static void ReportLoad(Self *ctler)
+  {
+    // The held shards are changing in the migration
+    if (!ctler->IsIdle() || ctler->node_id_ == INVALID_NODE_ID) return;
+
+    std::vector<uint64_t> shard_ops;
+    GetShardOps(shard_ops);
+
+    const auto now_ms     = util::GetTimeMs();
+    const auto elapsed_ms = now_ms - ctler->last_load_report_ms_;
+    auto const last_ops   = [ctler](shard_id_t shard_id) -> uint64_t {
+      return shard_id < ctler->last_shard_ops_.size() ? ctler->last_shard_ops_[shard_id] : 0;
+    };
+
+    ControllerRequest req = MakeRequest(ctler, CONTROL_OP_HEARTBEAT);
+    for (auto &db_instance : database_manager()) {
+      RLockGuard guard(db_instance.lock);
+      for (auto beg = db_instance.db.ShardBegin(); beg != db_instance.db.ShardEnd(); ++beg) {
+        const shard_id_t shard_id = beg->key;
+        const uint64_t   ops      = shard_id < shard_ops.size() ? shard_ops[shard_id] : 0;
+
+        auto *p_shard_load = req.add_shard_loads();
+        p_shard_load->set_shard_id(shard_id);
+        p_shard_load->set_ops_per_sec(
+            elapsed_ms > 0 ? (ops - std::min(ops, last_ops(shard_id))) * 1000 / elapsed_ms : 0
+        );
+        p_shard_load->set_memory_usage(db_instance.db.EstimateShardMemoryUsage(
+            shard_id,
+            LOAD_REPORT_SAMPLE_KEY_NUM,
+            MEMORY_USAGE_DEFAULT_SAMPLE_NUM
+        ));
+      }
+    }
+
+    ctler->last_shard_ops_      = std::move(shard_ops);
+    ctler->last_load_report_ms_ = now_ms;
+
+    MutexGuard guard(ctler->conn_lock_);
+    if (ctler->conn_) ctler->codec_.Send(ctler->conn_, &req);
+  }
+
   MMKV_INLINE static void HandleJoinPushing(
       ShardControllerClient    *ctl,
       ControllerResponse const &resp
   )
   {
     const auto peer_num    = resp.node_infos_size();
-    ctl->joining_push_num_ = peer_num;
-
-    SendAllPeersRequest(ctl, peer_num, SharderClient::PUSHING);
+    ctl->joining_push_num_ = SendAllPeersRequest(ctl, peer_num, SharderClient::PUSHING);
   }
 
   MMKV_INLINE static void HandleLeaveOk(
@@ -160,7 +285,7 @@ struct ShardControllerClient::Impl {
     /* Notify the peers delete shards */
     auto pull_node_num = ctler->shard_clis_.size() - ctler->joining_push_num_;
     for (size_t i = 0; i < pull_node_num; ++i) {
-      ctler->shard_clis_[i].DelAllShards(&ctler->sharder_codec_);
+      ctler->shard_clis_[i]->DelAllShards(&ctler->sharder_codec_);
     }
     ctler->state_            = IDLE;
     ctler->joining_push_num_ = 0;
@@ -173,7 +298,11 @@ struct ShardControllerClient::Impl {
     for (auto &db_instance : database_manager()) {
       WLockGuard locked_shard_guard(db_instance.lock);
 
+      // The shards are migrated already, drop them with their progress
+      db_instance.db.is_ignore_locked_shard = true;
       db_instance.db.DeleteAll(&cnt);
+      db_instance.db.is_ignore_locked_shard = false;
+      db_instance.db.RemoveAllShard();
       db_instance.db.UnlockAllShard();
     }
 
@@ -3,10 +3,18 @@
 
 #include <kanon/protobuf/protobuf_codec2.h>
 
+#include "mmkv/configd/configd_config.h"
 #include "mmkv/util/macro.h"
+#include "mmkv/util/shard_util.h"
+#include "mmkv/util/time_util.h"
 #include "controller.pb.h"
 #include "../shard_controller_server.h"
 
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
 using namespace mmkv::server;
 using namespace kanon;
 using namespace kanon::protobuf;
@@ -67,4 +75,270 @@ struct ShardControllerSession::Impl {
 
     codec->Send(conn, &resp);
   }
+
+  MMKV_INLINE static void SetNodeInfo(
+      NodeInfo       *p_node_info,
+      node_id_t       node_id,
+      NodeConf const &node_conf,
+      bool            is_push
+  )
+  {
+    p_node_info->set_node_id(node_id);
+    p_node_info->set_host(node_conf.host());
+    p_node_info->set_port(node_conf.port());
+    p_node_info->set_is_push(is_push);
+  }
+
+  /**
+   * \brief Move the shards owned by the joining node in rendezvous hashing
+   * Only the shards whose owner is changed to the joining node are pulled from
+   * their owners, the other shards are kept.
+   *
+   * \param pending_conf The configuration without the joining node
+   * \return false if the joining node owns no shard
+   */
+  static bool PlaceJoinNodeShards(
+      PendingConf        &pending_conf,
+      node_id_t           new_node_id,
+      NodeConf           &new_node_conf,
+      ControllerResponse &resp
+  )
+  {
+    auto *p_node_conf_map = pending_conf.conf.mutable_node_conf_map();
+
+    std::vector<node_id_t> node_ids;
+    node_ids.reserve(p_node_conf_map->size() + 1);
+    for (auto const &id_node_conf : *p_node_conf_map)
+      node_ids.push_back(id_node_conf.first);
+    node_ids.push_back(new_node_id);
+
+    auto get_weight = [p_node_conf_map, new_node_id, &new_node_conf](node_id_t node_id) {
+      return node_id == new_node_id ? new_node_conf.weight() : p_node_conf_map->at(node_id).weight();
+    };
+
+    for (auto &id_node_conf : *p_node_conf_map) {
+      auto     &shard_ids   = *id_node_conf.second.mutable_shard_ids();
+      NodeInfo *p_node_info = nullptr;
+      int       kept_num    = 0;
+
+      for (int i = 0; i < shard_ids.size(); ++i) {
+        const auto shard_id = shard_ids.Get(i);
+        if (SelectRendezvousNode(shard_id, node_ids, get_weight) != new_node_id) {
+          shard_ids.Set(kept_num++, shard_id);
+          continue;
+        }
+
+        if (!p_node_info) {
+          p_node_info = resp.add_node_infos();
+          SetNodeInfo(p_node_info, id_node_conf.first, id_node_conf.second, false);
+        }
+        p_node_info->add_shard_ids(shard_id);
+        new_node_conf.add_shard_ids(shard_id);
+      }
+
+      shard_ids.Truncate(kept_num);
+    }
+
+    return new_node_conf.shard_ids_size() > 0;
+  }
+
+  /**
+   * \brief Move the shards of the leaving node to their owners in rendezvous hashing
+   * \param pending_conf The configuration without the leaving node
+   */
+  static void PlaceLeaveNodeShards(
+      PendingConf        &pending_conf,
+      NodeConf const     &leave_node_conf,
+      ControllerResponse &resp
+  )
+  {
+    auto *p_node_conf_map = pending_conf.conf.mutable_node_conf_map();
+
+    std::vector<node_id_t> node_ids;
+    node_ids.reserve(p_node_conf_map->size());
+    for (auto const &id_node_conf : *p_node_conf_map)
+      node_ids.push_back(id_node_conf.first);
+
+    auto get_weight = [p_node_conf_map](node_id_t node_id) {
+      return p_node_conf_map->at(node_id).weight();
+    };
+
+    std::unordered_map<node_id_t, NodeInfo *> node_info_map;
+    for (auto const shard_id : leave_node_conf.shard_ids()) {
+      const node_id_t owner     = SelectRendezvousNode(shard_id, node_ids, get_weight);
+      auto           &node_conf = p_node_conf_map->at(owner);
+
+      auto &p_node_info = node_info_map[owner];
+      if (!p_node_info) {
+        p_node_info = resp.add_node_infos();
+        SetNodeInfo(p_node_info, owner, node_conf, true);
+      }
+      p_node_info->add_shard_ids(shard_id);
+      node_conf.add_shard_ids(shard_id);
+    }
+  }
+
+  /* The reported load is smoothed to avoid rebalancing by the burst */
+  MMKV_INLINE static void UpdateShardLoad(ShardControllerServer *server, ControllerRequest &req)
+  {
+    for (auto const &shard_load : req.shard_loads()) {
+      const double ops_per_sec = shard_load.ops_per_sec();
+      auto         iter        = server->shard_load_map_.find(shard_load.shard_id());
+      if (iter == server->shard_load_map_.end()) {
+        server->shard_load_map_.emplace(
+            shard_load.shard_id(),
+            ShardControllerServer::ShardLoadStat{ops_per_sec, shard_load.memory_usage()}
+        );
+      } else {
+        iter->second.ops_per_sec  = (iter->second.ops_per_sec + ops_per_sec) / 2;
+        iter->second.memory_usage = shard_load.memory_usage();
+      }
+    }
+
+    server->node_report_ms_map_[req.node_id()] = mmkv::util::GetTimeMs();
+  }
+
+  MMKV_INLINE static double GetNodeLoad(ShardControllerServer *server, NodeConf const &node_conf)
+  {
+    double load = 0;
+    for (auto const shard_id : node_conf.shard_ids()) {
+      auto iter = server->shard_load_map_.find(shard_id);
+      if (iter != server->shard_load_map_.end()) load += iter->second.ops_per_sec;
+    }
+    return load;
+  }
+
+  /**
+   * Move the hottest shards of the hottest node to the coldest node until
+   * the difference of their loads is within the threshold.
+   * The hysteresis avoids thrashing:
+   * - The difference within the threshold is regarded as balanced
+   * - The shard whose load exceeds the half of difference isn't moved,
+   *   otherwise, the coldest node becomes the hottest one
+   * - The rebalancings are separated by the interval at least
+   *
+   * \param node_id The node reporting the load, which pulls the shards if it is the coldest
+   * \return false if the load is balanced or the rebalancing isn't allowed now
+   */
+  static bool PlanRebalance(
+      ShardControllerServer *server,
+      node_id_t              node_id,
+      ControllerResponse    &resp
+  )
+  {
+    auto const &config = configd_config();
+    const auto  now_ms = mmkv::util::GetTimeMs();
+
+    // The owner of shard is computed from the node ids, can't be moved
+    if (server->GetPlacement() == SHARD_PLACEMENT_RENDEZVOUS) return false;
+
+    if (config.rebalance_threshold == 0 || server->rebalancing_node_id_ != INVALID_NODE_ID ||
+        server->HasPendingConf() ||
+        now_ms - server->last_rebalance_ms_ < (int64_t)config.rebalance_interval)
+    {
+      return false;
+    }
+
+    auto const &node_conf_map = server->GetCurrentConf()->node_conf_map();
+    if (node_conf_map.size() < 2) return false;
+
+    node_id_t hot_node_id  = INVALID_NODE_ID;
+    node_id_t cold_node_id = INVALID_NODE_ID;
+    double    hot_load     = 0;
+    double    cold_load    = 0;
+    double    total_load   = 0;
+
+    for (auto const &id_node_conf : node_conf_map) {
+      // The load of all nodes should be known
+      if (!server->node_report_ms_map_.count(id_node_conf.first)) return false;
+
+      const double load  = GetNodeLoad(server, id_node_conf.second);
+      total_load        += load;
+      if (hot_node_id == INVALID_NODE_ID || load > hot_load) {
+        hot_node_id = id_node_conf.first;
+        hot_load    = load;
+      }
+      if (cold_node_id == INVALID_NODE_ID || load < cold_load) {
+        cold_node_id = id_node_conf.first;
+        cold_load    = load;
+      }
+    }
+
+    if (cold_node_id != node_id || hot_node_id == node_id) return false;
+
+    const double band = total_load / node_conf_map.size() * config.rebalance_threshold / 100;
+    double       gap  = hot_load - cold_load;
+    if (gap <= band) return false;
+
+    auto const &hot_node_conf = node_conf_map.at(hot_node_id);
+
+    std::vector<std::pair<double, shard_id_t>> hot_shards;
+    for (auto const shard_id : hot_node_conf.shard_ids()) {
+      auto iter = server->shard_load_map_.find(shard_id);
+      if (iter != server->shard_load_map_.end() && iter->second.ops_per_sec > 0) {
+        hot_shards.emplace_back(iter->second.ops_per_sec, shard_id);
+      }
+    }
+    std::sort(hot_shards.begin(), hot_shards.end(), std::greater<std::pair<double, shard_id_t>>());
+
+    // The hot node holds one shard at least
+    const size_t max_shard_num =
+        std::min<size_t>(config.rebalance_max_shard_num, hot_node_conf.shard_ids_size() - 1);
+
+    std::vector<shard_id_t> moved_shards;
+    u64                     moved_bytes = 0;
+    for (auto const &ops_shard : hot_shards) {
+      if (moved_shards.size() >= max_shard_num || gap <= band) break;
+      if (ops_shard.first * 2 > gap) continue;
+
+      const auto memory_usage = server->shard_load_map_[ops_shard.second].memory_usage;
+      if (moved_bytes + memory_usage > config.rebalance_max_bytes) continue;
+
+      moved_shards.push_back(ops_shard.second);
+      moved_bytes += memory_usage;
+      gap         -= ops_shard.first * 2;
+    }
+
+    if (moved_shards.empty()) return false;
+
+    // Move the shards from the hot node to the cold node in the pending configuration
+    PendingConf pending_conf;
+    pending_conf.conf    = *server->GetRecentConf();
+    pending_conf.node_id = node_id;
+    pending_conf.state   = CONF_STATE_REBALANCE;
+
+    auto *p_pending_node_conf_map = pending_conf.conf.mutable_node_conf_map();
+    auto &pending_hot_node_conf   = (*p_pending_node_conf_map)[hot_node_id];
+    auto &pending_cold_node_conf  = (*p_pending_node_conf_map)[node_id];
+
+    ::google::protobuf::RepeatedField<uint64_t> hot_shard_ids;
+    for (auto const shard_id : pending_hot_node_conf.shard_ids()) {
+      if (std::find(moved_shards.begin(), moved_shards.end(), shard_id) == moved_shards.end()) {
+        hot_shard_ids.Add(shard_id);
+      }
+    }
+    *pending_hot_node_conf.mutable_shard_ids() = std::move(hot_shard_ids);
+
+    auto *p_resp_node_info = resp.add_node_infos();
+    for (auto const shard_id : moved_shards) {
+      pending_cold_node_conf.add_shard_ids(shard_id);
+      p_resp_node_info->add_shard_ids(shard_id);
+    }
+
+    p_resp_node_info->set_node_id(hot_node_id);
+    p_resp_node_info->set_host(hot_node_conf.host());
+    p_resp_node_info->set_port(hot_node_conf.port());
+    p_resp_node_info->set_is_push(false);
+
+    resp.set_status(CONTROL_STATUS_REBALANCE);
+    resp.set_shard_num(server->GetShardNum());
+
+    server->PushPendingConf(&pending_conf);
+    server->rebalancing_node_id_ = node_id;
+
+    LOG_INFO << "Rebalance: move " << moved_shards.size() << " shards(" << moved_bytes
+             << " bytes) from node [" << hot_node_id << "](" << hot_load << " ops/s) to node ["
+             << node_id << "](" << cold_load << " ops/s)";
+    return true;
+  }
 };
@@ -3,6 +3,8 @@
 
 #include "mmkv/server/option.h"
 
+#define MIGRATION_REPORT_INTERVAL 1000 /** ms */
+
 ShardControllerClient::ShardControllerClient(
     EventLoop         *loop,
     InetAddr const    &addr,
@@ -75,7 +77,8 @@ ShardControllerClient::ShardControllerClient(
       case CONTROL_STATUS_CONF_CHANGE: {
         switch (state()) {
           case JOIN_PUSHING:
-          case JOINING: {
+          case JOINING:
+          case REBALANCING: {
             Impl::HandleJoinConfChange(this);
           } break;
 
@@ -95,6 +98,15 @@ ShardControllerClient::ShardControllerClient(
         LOG_DEBUG << "Recv a Heart Beat Packet";
       } break;
 
+      case CONTROL_STATUS_REBALANCE: {
+        if (!IsIdle()) {
+          LOG_ERROR << "Recv controller rebalance, state must be IDLE";
+          return;
+        }
+        node_infos_ = std::move(*response.mutable_node_infos());
+        Impl::HandleRebalance(this);
+      } break;
+
       case CONTROL_STATUS_NODE_FULL: {
         LOG_DEBUG << "The cluster is full, your can't join to it";
       } break;
@@ -135,6 +147,13 @@ ShardControllerClient::ShardControllerClient(
   });
   // shard_cli_loop_thr_.StartRun();
 
+  if (mmkv_config().load_report_interval > 0) {
+    cli_->GetLoop()->RunEvery(
+        [this]() { Impl::ReportLoad(this); },
+        mmkv_config().load_report_interval / 1000.
+    );
+  }
+
   // TODO When to start sharder?
   StartSharder();
 }
@@ -148,6 +167,7 @@ void ShardControllerClient::Join()
   req.set_operation(CONTROL_OP_ADD_NODE);
   req.set_sharder_port(sharder_port_);
   req.set_mmkvd_port(mmkv_option().port);
+  req.set_weight(mmkv_config().node_weight);
 
   LOG_INFO << "Controller request: " << req.DebugString();
   codec_.Send(cli_->GetConnection(), &req);
@@ -193,8 +213,12 @@ void ShardControllerClient::NotifyPushFinish()
 
 void ShardControllerClient::NotifyJoinFinish()
 {
+  Impl::FinishMigration(this);
   Impl::WaitConn(this);
-  ControllerRequest req = Impl::MakeRequest(this, CONTROL_OP_ADD_NODE_COMPLETE);
+  ControllerRequest req = Impl::MakeRequest(
+      this,
+      state_ == REBALANCING ? CONTROL_OP_REBALANCE_COMPLETE : CONTROL_OP_ADD_NODE_COMPLETE
+  );
   codec_.Send(conn_, &req);
 
 #ifndef NDEBUG
@@ -212,12 +236,26 @@ void ShardControllerClient::NotifyJoinFinish()
 
 void ShardControllerClient::NotifyLeaveFinish()
 {
+  Impl::FinishMigration(this);
   Impl::WaitConn(this);
   ControllerRequest req = Impl::MakeRequest(this, CONTROL_OP_LEAVE_NODE_COMPLETE);
   codec_.Send(conn_, &req);
   finish_node_num_ = 0;
 }
 
+int64_t ShardControllerClient::OnMigrationChunk(size_t bytes, bool is_shard_complete)
+{
+  migrated_bytes_ += bytes;
+  if (is_shard_complete) {
+    ++migrated_shard_num_;
+    if (util::GetTimeMs() - last_report_ms_ >= MIGRATION_REPORT_INTERVAL) {
+      Impl::ReportMigrationProgress(this);
+    }
+  }
+
+  return migration_limiter_.Consume(bytes, util::GetTimeUs());
+}
+
 void ShardControllerClient::StartSharder()
 {
   sharder_.Listen();
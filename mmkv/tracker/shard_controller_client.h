@@ -10,6 +10,7 @@
 #include "mmkv/sharder/sharder_client.h"
 #include "mmkv/sharder/sharder.h"
 #include "mmkv/tracker/shard_controller_codec.h"
+#include "mmkv/util/rate_limiter.h"
 
 namespace mmkv {
 namespace server {
@@ -33,6 +34,9 @@ class ShardControllerClient : kanon::noncopyable {
     // in this case, push these shards to other nodes to make the state is consistent
     // and correct.
     JOIN_PUSHING,
+    // Pull the shards of the hot node, which is planned by the controller
+    // according to the reported load
+    REBALANCING,
   };
 
   /**
@@ -70,6 +74,7 @@ class ShardControllerClient : kanon::noncopyable {
   void StartSharder();
 
   shard_id_t GetShardNum() const noexcept { return mmkv_config().shard_num; }
+  /** The number of sharder clients, a peer may be migrated over multiple clients */
   size_t     GetPeerNum() const noexcept { return shard_clis_.size(); }
   State      state() const noexcept { return state_; }
 
@@ -80,6 +85,15 @@ class ShardControllerClient : kanon::noncopyable {
   void NotifyJoinFinish();
   void NotifyLeaveFinish();
 
+  /**
+   * \brief Account the migrated chunk in the bandwidth budget and the progress
+   * \param bytes The size of the chunk
+   * \param is_shard_complete The chunk is the last one of its shard
+   * \return
+   *  The microseconds to wait before migrating the next chunk
+   */
+  int64_t OnMigrationChunk(size_t bytes, bool is_shard_complete);
+
  private:
   friend struct Impl;
   struct Impl;
@@ -95,6 +109,26 @@ class ShardControllerClient : kanon::noncopyable {
   kanon::AtomicCounter<uint32_t> finish_node_num_{0};
   node_id_t                      node_id_; /** The id of the node */
 
+  /*------------------------------------*/
+  /* Migration                          */
+  /*------------------------------------*/
+
+  /* The chunks are migrated in the loop of this,
+   * thus the fields are not protected */
+  util::RateLimiter migration_limiter_;
+  uint64_t          migrated_shard_num_ = 0;
+  uint64_t          total_shard_num_    = 0; /** The number of shards to be migrated */
+  uint64_t          migrated_bytes_     = 0;
+  int64_t           migration_start_ms_ = 0;
+  int64_t           last_report_ms_     = 0;
+
+  /*------------------------------------*/
+  /* Load report                        */
+  /*------------------------------------*/
+
+  std::vector<uint64_t> last_shard_ops_; /** Indexed by shard id, see GetShardOps() */
+  int64_t               last_load_report_ms_ = 0;
+
   /*------------------------------------*/
   /* Sharder Clients                      */
   /*------------------------------------*/
@@ -103,8 +137,8 @@ class ShardControllerClient : kanon::noncopyable {
   ::google::protobuf::RepeatedPtrField<::mmkv::NodeInfo> node_infos_;
 
   // EventLoopThread            shard_cli_loop_thr_;
-  // std::vector<std::unique_ptr<ShardClient>> shard_clis_;
-  std::vector<SharderClient> shard_clis_;
+  /* The address of client is the context of its connection, thus it can't be moved */
+  std::vector<std::unique_ptr<SharderClient>> shard_clis_;
 
   size_t joining_push_num_ = 0;
 
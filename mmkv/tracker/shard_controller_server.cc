@@ -15,7 +15,15 @@ ShardControllerServer::ShardControllerServer(EventLoop *loop, InetAddr const &ad
   : server_(loop, addr, "ShardController")
   , codec_()
   , shard_num_(configd_config().shard_num)
+  , placement_(SHARD_PLACEMENT_ASSIGNED)
 {
+  auto const &placement = configd_config().shard_placement;
+  if (placement == "rendezvous") {
+    placement_ = SHARD_PLACEMENT_RENDEZVOUS;
+  } else if (placement != "assigned") {
+    LOG_WARN << "Unknown shard placement: " << placement << ", use assigned placement";
+  }
+
   codec_.SetMessageCallback(
       [this](TcpConnectionPtr const &conn, Buffer &buffer, size_t payload_size, TimeStamp) {
         ControllerRequest req;
@@ -38,6 +46,15 @@ ShardControllerServer::ShardControllerServer(EventLoop *loop, InetAddr const &ad
           case CONTROL_OP_LEAVE_NODE_COMPLETE:
             p_session->LeaveComplete(this, conn, &codec_, req);
             break;
+          case CONTROL_OP_MIGRATION_PROGRESS:
+            p_session->MigrationProgress(this, req);
+            break;
+          case CONTROL_OP_HEARTBEAT:
+            p_session->Heartbeat(this, conn.get(), &codec_, req);
+            break;
+          case CONTROL_OP_REBALANCE_COMPLETE:
+            p_session->RebalanceComplete(this, conn, &codec_, req);
+            break;
           case CONTROL_OP_QUERY_NODE_INFO:
             p_session->QueryNodeInfo(this, conn, &codec_, req);
           default:;
@@ -54,6 +71,9 @@ ShardControllerServer::ShardControllerServer(EventLoop *loop, InetAddr const &ad
     } else {
       auto p_session = AnyCast<ShardControllerSession>(conn->GetContext());
       node_session_map.erase(p_session->node_id_);
+      if (p_session->reported_node_id_ != INVALID_NODE_ID) {
+        RemoveNodeLoad(p_session->reported_node_id_);
+      }
       delete p_session;
     }
   });
@@ -131,3 +151,22 @@ void ShardControllerServer::UpdateConfig(Configuration &&conf)
   LOG_DEBUG << "Recent config: " << config_.DebugString();
   p_configd_->SyncConfig(config_);
 }
+
+void ShardControllerServer::RemoveNodeLoad(node_id_t node_id)
+{
+  MutexGuard guard(pending_conf_lock_);
+  node_report_ms_map_.erase(node_id);
+
+  if (rebalancing_node_id_ != node_id) return;
+  rebalancing_node_id_ = INVALID_NODE_ID;
+
+  // The shards are still held by the hot node
+  // FIXME Unlock the migrated shards in the hot node
+  if (HasPendingConf()) {
+    auto p_pending_conf = GetRecentPendingConf();
+    if (p_pending_conf->state == CONF_STATE_REBALANCE && p_pending_conf->node_id == node_id) {
+      LOG_WARN << "The node [" << node_id << "] is disconnected, the rebalancing is aborted";
+      PopPendingConf();
+    }
+  }
+}
@@ -36,6 +36,8 @@ class ShardControllerServer : kanon::noncopyable {
 
   u64 GetShardNum() const noexcept { return shard_num_; }
 
+  ShardPlacement GetPlacement() const noexcept { return placement_; }
+
   Configuration const *GetRecentConf() const noexcept
   {
     if (pending_conf_q_.empty()) return &config_;
@@ -67,6 +69,9 @@ class ShardControllerServer : kanon::noncopyable {
 
   void CheckPendingConfSessionAndResponse();
 
+  /* Forget the load reported by the node, abort its rebalancing */
+  void RemoveNodeLoad(node_id_t node_id);
+
  private:
   TcpServer            server_;
   ShardControllerCodec codec_;
@@ -95,7 +100,22 @@ class ShardControllerServer : kanon::noncopyable {
   algo::Dictionary<PendingState, std::weak_ptr<TcpConnection>, PendingStateHash, PendingStateEqual>
       pending_conf_conn_dict_;
 
-  u64 shard_num_;
+  u64            shard_num_;
+  ShardPlacement placement_;
+
+  /*------------------------------------*/
+  /* Rebalancing                        */
+  /*------------------------------------*/
+
+  struct ShardLoadStat {
+    double ops_per_sec;  /** Smoothed by the reports */
+    u64    memory_usage; /** The last report */
+  };
+
+  std::unordered_map<shard_id_t, ShardLoadStat> shard_load_map_;
+  std::unordered_map<node_id_t, int64_t>        node_report_ms_map_; /** The last report time */
+  node_id_t rebalancing_node_id_ = INVALID_NODE_ID; /** The node pulling the shards */
+  int64_t   last_rebalance_ms_   = 0;
 
   Configd *p_configd_;
 };
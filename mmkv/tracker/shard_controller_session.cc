@@ -73,6 +73,8 @@ void ShardControllerSession::Join(
   new_node_conf.set_host(conn->GetPeerAddr().ToIp());
   new_node_conf.set_port(req.sharder_port());
   new_node_conf.set_mmkvd_port(req.mmkvd_port());
+  // The node with weight 0 would own no shard, the default is used instead
+  if (req.weight() > 0) new_node_conf.set_weight(req.weight());
 
   // The first node can't steal any shard from other nodes
   // but return all shards to the first node
@@ -91,6 +93,13 @@ void ShardControllerSession::Join(
     for (shard_id_t i = 0; i < server->GetShardNum(); ++i) {
       p_new_conf_shard_ids->AddAlreadyReserved(i);
     }
+  } else if (server->GetPlacement() == SHARD_PLACEMENT_RENDEZVOUS) {
+    if (!Impl::PlaceJoinNodeShards(new_pending_conf, peer_node_id, new_node_conf, response)) {
+      LOG_DEBUG << "The new node owns no shard in rendezvous hashing, can't add it";
+      Impl::SendRejectResponse(codec, conn, CONTROL_STATUS_NODE_FULL);
+      conn->ShutdownWrite();
+      return;
+    }
   } else {
     LOG_DEBUG << "Node num > 1, Redistribute the shards";
 
@@ -225,7 +234,10 @@ void ShardControllerSession::Leave(
   ControllerResponse resp;
   resp.set_node_id(peer_node_id);
 
-  if (new_node_num > 0) {
+  if (new_node_num > 0 && server->GetPlacement() == SHARD_PLACEMENT_RENDEZVOUS) {
+    pending_conf.conf.mutable_node_conf_map()->erase(peer_node_id);
+    Impl::PlaceLeaveNodeShards(pending_conf, recent_node_conf, resp);
+  } else if (new_node_num > 0) {
     // Get the old node shard conf and remove it from pending conf
     // The old conf is readonly, don't modify it!
     // auto  new_node_conf_iter = pending_conf.conf.mutable_node_conf_map()->find(peer_node_id);
@@ -390,3 +402,57 @@ void ShardControllerSession::QueryNodeInfo(
 
   codec->Send(conn, &resp);
 }
+
+void ShardControllerSession::MigrationProgress(ShardControllerServer *, ControllerRequest &req)
+{
+  migrated_shard_num_ = req.migrated_shard_num();
+  total_shard_num_    = req.total_shard_num();
+  migrated_bytes_     = req.migrated_bytes();
+  elapsed_ms_         = req.elapsed_ms();
+
+  const double seconds = elapsed_ms_ / 1000.;
+  LOG_INFO << "The node [" << req.node_id() << "] migrated " << migrated_shard_num_ << "/"
+           << total_shard_num_ << " shards, " << migrated_bytes_ << " bytes in " << elapsed_ms_
+           << "ms(" << (seconds > 0 ? migrated_bytes_ / seconds : 0) << " bytes/s)";
+}
+
+void ShardControllerSession::Heartbeat(
+    ShardControllerServer *server,
+    TcpConnection         *conn,
+    ShardControllerCodec  *codec,
+    ControllerRequest     &req
+)
+{
+  ControllerResponse resp;
+  resp.set_status(CONTROL_STATUS_HB);
+
+  {
+    MutexGuard  guard(server->pending_conf_lock_);
+    auto const &node_conf_map = server->GetCurrentConf()->node_conf_map();
+    if (node_conf_map.find(req.node_id()) == node_conf_map.end()) {
+      LOG_WARN << "The node [" << req.node_id() << "] isn't joined, the load is ignored";
+    } else {
+      reported_node_id_ = req.node_id();
+      Impl::UpdateShardLoad(server, req);
+      Impl::PlanRebalance(server, req.node_id(), resp);
+    }
+  }
+
+  codec->Send(conn, &resp);
+}
+
+void ShardControllerSession::RebalanceComplete(
+    ShardControllerServer  *server,
+    TcpConnectionPtr const &conn,
+    ShardControllerCodec   *codec,
+    ControllerRequest      &req
+)
+{
+  Impl::ControllorOperationComplete(this, server, conn, codec, req, CONF_STATE_REBALANCE);
+
+  MutexGuard guard(server->pending_conf_lock_);
+  if (server->rebalancing_node_id_ == req.node_id()) {
+    server->rebalancing_node_id_ = INVALID_NODE_ID;
+    server->last_rebalance_ms_   = mmkv::util::GetTimeMs();
+  }
+}
@@ -73,11 +73,46 @@ class ShardControllerSession : kanon::noncopyable {
       ControllerRequest      &req
   );
 
+  /*
+   * Record the progress of shard migration reported by the node
+   * No response.
+   */
+  void MigrationProgress(ShardControllerServer *server, ControllerRequest &req);
+
+  /*
+   * Record the load of shards reported by the node
+   * If the node is the coldest one and the load is imbalanced,
+   * reply the shards of the hottest node to pull(CONTROL_STATUS_REBALANCE),
+   * otherwise, reply a heartbeat.
+   */
+  void Heartbeat(
+      ShardControllerServer *server,
+      TcpConnection         *conn,
+      ShardControllerCodec  *codec,
+      ControllerRequest     &req
+  );
+
+  void RebalanceComplete(
+      ShardControllerServer  *server,
+      TcpConnectionPtr const &conn,
+      ShardControllerCodec   *codec,
+      ControllerRequest      &req
+  );
+
  private:
   friend struct Impl;
   struct Impl;
 
   uint32_t node_id_;
+
+  /* The node reporting load by this session */
+  uint64_t reported_node_id_ = -1;
+
+  /* The last progress reported by the node */
+  uint64_t migrated_shard_num_ = 0;
+  uint64_t total_shard_num_    = 0;
+  uint64_t migrated_bytes_     = 0;
+  uint64_t elapsed_ms_         = 0;
 };
 
 } // namespace server
@@ -14,6 +14,7 @@ static constexpr node_id_t INVALID_NODE_ID = -1;
 enum ConfState {
   CONF_STATE_JOIN_NODE = 0,
   CONF_STATE_LEAVE_NODE,
+  CONF_STATE_REBALANCE, /** The node pulls the shards of the hot node */
   // CHANGE_NODE
 };
 
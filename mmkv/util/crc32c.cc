@@ -0,0 +1,98 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "crc32c.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#  define MMKV_CRC32C_HW 1
+#  include <nmmintrin.h>
+#endif
+
+using namespace mmkv::util;
+
+/* Reversed polynomial of CRC32C(Castagnoli) */
+#define CRC32C_POLY 0x82F63B78u
+
+namespace {
+
+struct Crc32cTable {
+  uint32_t table[256];
+
+  Crc32cTable() noexcept
+  {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int j = 0; j < 8; ++j) {
+        crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+      }
+      table[i] = crc;
+    }
+  }
+};
+
+} // namespace
+
+static uint32_t SoftwareCrc32c(uint32_t crc, void const *data, size_t len) noexcept
+{
+  static const Crc32cTable crc_table;
+
+  auto p = (unsigned char const *)data;
+  for (size_t i = 0; i < len; ++i) {
+    crc = crc_table.table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#ifdef MMKV_CRC32C_HW
+/* Compile this function with SSE4.2 only,
+ * the others is not affected, and the caller must check CPU supports it */
+__attribute__((target("sse4.2"))) static uint32_t
+HardwareCrc32c(uint32_t crc, void const *data, size_t len) noexcept
+{
+  auto     p     = (unsigned char const *)data;
+  uint64_t crc64 = crc;
+
+  for (; len >= 8; len -= 8, p += 8) {
+    uint64_t word;
+    ::memcpy(&word, p, sizeof word);
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+
+  auto crc32 = (uint32_t)crc64;
+  for (; len > 0; --len, ++p) {
+    crc32 = _mm_crc32_u8(crc32, *p);
+  }
+  return crc32;
+}
+#endif
+
+using Crc32cFunc = uint32_t (*)(uint32_t, void const *, size_t);
+
+static Crc32cFunc ChooseCrc32cFunc() noexcept
+{
+#ifdef MMKV_CRC32C_HW
+  if (__builtin_cpu_supports("sse4.2")) return &HardwareCrc32c;
+#endif
+  return &SoftwareCrc32c;
+}
+
+static Crc32cFunc GetCrc32cFunc() noexcept
+{
+  static const Crc32cFunc func = ChooseCrc32cFunc();
+  return func;
+}
+
+uint32_t mmkv::util::Crc32cExtend(uint32_t crc, void const *data, size_t len) noexcept
+{
+  return ~GetCrc32cFunc()(~crc, data, len);
+}
+
+uint32_t mmkv::util::SoftwareCrc32cExtend(uint32_t crc, void const *data, size_t len) noexcept
+{
+  return ~SoftwareCrc32c(~crc, data, len);
+}
+
+bool mmkv::util::IsHardwareCrc32c() noexcept
+{
+  return GetCrc32cFunc() != &SoftwareCrc32c;
+}
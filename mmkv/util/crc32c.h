@@ -0,0 +1,40 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_UTIL_CRC32C_H_
+#define _MMKV_UTIL_CRC32C_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace mmkv {
+namespace util {
+
+/**
+ * \brief Extend the CRC32C(Castagnoli) of the previous data with \p data
+ * The SSE4.2 crc32 instruction is used if CPU supports it,
+ * otherwise, fallback to the table-driven implementation.
+ *
+ * \param crc The CRC32C of the previous data, 0 for the first call
+ * \return The CRC32C of the previous data concatenated with \p data
+ */
+uint32_t Crc32cExtend(uint32_t crc, void const *data, size_t len) noexcept;
+
+inline uint32_t Crc32c(void const *data, size_t len) noexcept
+{
+  return Crc32cExtend(0, data, len);
+}
+
+/**
+ * \brief Same with Crc32cExtend() but always use the table-driven implementation
+ * The result of hardware path can be verified by it.
+ */
+uint32_t SoftwareCrc32cExtend(uint32_t crc, void const *data, size_t len) noexcept;
+
+/**
+ * \brief Check whether the CRC32C is computed by the SSE4.2 instruction
+ */
+bool IsHardwareCrc32c() noexcept;
+
+} // namespace util
+} // namespace mmkv
+
+#endif // _MMKV_UTIL_CRC32C_H_
@@ -0,0 +1,86 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "latency_histogram.h"
+
+#include <string.h>
+
+using namespace mmkv::util;
+
+constexpr size_t LatencyHistogram::BUCKET_NUM;
+
+LatencyHistogram::LatencyHistogram() noexcept { Reset(); }
+
+void LatencyHistogram::Reset() noexcept
+{
+  ::memset(counts_, 0, sizeof counts_);
+  count_ = 0;
+  sum_   = 0;
+  min_   = UINT64_MAX;
+  max_   = 0;
+}
+
+/*
+ * For value in [2^e, 2^(e+1)) where e >= SUB_BUCKET_BITS,
+ * the top (SUB_BUCKET_BITS + 1) bits m is in [SUB_BUCKET_NUM, 2 * SUB_BUCKET_NUM),
+ * index = (e - SUB_BUCKET_BITS + 1) * SUB_BUCKET_NUM + (m - SUB_BUCKET_NUM)
+ *       = (e - SUB_BUCKET_BITS) * SUB_BUCKET_NUM + m
+ */
+size_t LatencyHistogram::GetBucketIndex(uint64_t value) noexcept
+{
+  if (value < SUB_BUCKET_NUM) return value;
+
+  const int exp = 63 - __builtin_clzll(value);
+  if (exp >= MAX_VALUE_BITS) return BUCKET_NUM - 1;
+
+  const int shift = exp - SUB_BUCKET_BITS;
+  return shift * SUB_BUCKET_NUM + (value >> shift);
+}
+
+uint64_t LatencyHistogram::GetBucketLowerBound(size_t idx) noexcept
+{
+  if (idx < SUB_BUCKET_NUM) return idx;
+
+  const size_t shift = idx / SUB_BUCKET_NUM - 1;
+  const size_t m     = idx % SUB_BUCKET_NUM + SUB_BUCKET_NUM;
+  return (uint64_t)m << shift;
+}
+
+void LatencyHistogram::Record(uint64_t value) noexcept
+{
+  ++counts_[GetBucketIndex(value)];
+  ++count_;
+  sum_ += value;
+  if (value < min_) min_ = value;
+  if (value > max_) max_ = value;
+}
+
+void LatencyHistogram::Merge(LatencyHistogram const &other) noexcept
+{
+  for (size_t i = 0; i < BUCKET_NUM; ++i)
+    counts_[i] += other.counts_[i];
+
+  count_ += other.count_;
+  sum_   += other.sum_;
+  if (other.min_ < min_) min_ = other.min_;
+  if (other.max_ > max_) max_ = other.max_;
+}
+
+uint64_t LatencyHistogram::GetPercentile(double percentile) const noexcept
+{
+  if (count_ == 0) return 0;
+
+  if (percentile > 100.) percentile = 100.;
+  uint64_t rank = (uint64_t)(percentile / 100. * count_ + 0.5);
+  if (rank == 0) rank = 1;
+
+  uint64_t acc = 0;
+  for (size_t i = 0; i < BUCKET_NUM; ++i) {
+    acc += counts_[i];
+    if (acc >= rank) {
+      if (i == BUCKET_NUM - 1) return max_;
+      const auto upper = GetBucketLowerBound(i + 1) - 1;
+      return upper < max_ ? upper : max_;
+    }
+  }
+
+  return max_;
+}
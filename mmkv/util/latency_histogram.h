@@ -0,0 +1,65 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_UTIL_LATENCY_HISTOGRAM_H_
+#define _MMKV_UTIL_LATENCY_HISTOGRAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace mmkv {
+namespace util {
+
+/**
+ * \brief Log-linear histogram of latency(HDR-style)
+ * The values in [2^e, 2^(e+1)) are divided into 2^SUB_BUCKET_BITS linear buckets,
+ * thus the relative error of percentile is at most 1/2^SUB_BUCKET_BITS(~1.6%),
+ * and the values less than 2^SUB_BUCKET_BITS are recorded exactly.
+ *
+ * The unit of value is decided by the user(e.g. microseconds).
+ * The values greater than or equal to 2^MAX_VALUE_BITS are recorded in the last bucket.
+ *
+ * \note Not thread-safe, use one histogram per thread and Merge() them.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr int    SUB_BUCKET_BITS = 6;
+  static constexpr int    MAX_VALUE_BITS  = 40;
+  static constexpr size_t SUB_BUCKET_NUM  = (size_t)1 << SUB_BUCKET_BITS;
+  static constexpr size_t BUCKET_NUM      = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_NUM;
+
+  LatencyHistogram() noexcept;
+
+  void Record(uint64_t value) noexcept;
+
+  void Merge(LatencyHistogram const &other) noexcept;
+
+  void Reset() noexcept;
+
+  /**
+   * \brief Get the value at the given percentile
+   * \param percentile in [0, 100]
+   * \return
+   *  The upper bound of the bucket containing the value(not greater than max()),
+   *  0 if no value is recorded
+   */
+  uint64_t GetPercentile(double percentile) const noexcept;
+
+  uint64_t count() const noexcept { return count_; }
+  uint64_t min() const noexcept { return count_ ? min_ : 0; }
+  uint64_t max() const noexcept { return max_; }
+  double   mean() const noexcept { return count_ ? (double)sum_ / count_ : 0.; }
+
+ private:
+  static size_t   GetBucketIndex(uint64_t value) noexcept;
+  static uint64_t GetBucketLowerBound(size_t idx) noexcept;
+
+  uint64_t counts_[BUCKET_NUM];
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t min_;
+  uint64_t max_;
+};
+
+} // namespace util
+} // namespace mmkv
+
+#endif // _MMKV_UTIL_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,14 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#include "rate_limiter.h"
+
+using namespace mmkv::util;
+
+int64_t RateLimiter::Consume(uint64_t n, int64_t now_us) noexcept
+{
+  if (rate_ == 0) return 0;
+
+  // The unused budget isn't accumulated, i.e. no burst after idle
+  if (next_us_ < now_us) next_us_ = now_us;
+  next_us_ += (int64_t)(n * 1000000. / rate_);
+  return next_us_ - now_us;
+}
@@ -0,0 +1,47 @@
+// SPDX-LICENSE-IDENTIFIER: Apache-2.0
+#ifndef _MMKV_UTIL_RATE_LIMITER_H_
+#define _MMKV_UTIL_RATE_LIMITER_H_
+
+#include <stdint.h>
+
+namespace mmkv {
+namespace util {
+
+/**
+ * \brief Limit the average rate of bytes(or any unit) consumed
+ * The consumer consumes first and then waits the returned time,
+ * i.e. the budget is borrowed from the future. Thus a large
+ * consumption is allowed but the next one is delayed accordingly.
+ *
+ * \note Not thread-safe
+ */
+class RateLimiter {
+ public:
+  /**
+   * \param rate The units per second, 0 indicates unlimited
+   */
+  explicit RateLimiter(uint64_t rate = 0) noexcept
+    : rate_(rate)
+    , next_us_(0)
+  {
+  }
+
+  void SetRate(uint64_t rate) noexcept { rate_ = rate; }
+  uint64_t rate() const noexcept { return rate_; }
+
+  /**
+   * \brief Consume n units at now_us
+   * \return
+   *  The microseconds to wait before the next consumption
+   */
+  int64_t Consume(uint64_t n, int64_t now_us) noexcept;
+
+ private:
+  uint64_t rate_;
+  int64_t  next_us_; /** The budget is available after this */
+};
+
+} // namespace util
+} // namespace mmkv
+
+#endif // _MMKV_UTIL_RATE_LIMITER_H_
@@ -7,6 +7,8 @@
 
 #include <xxhash.h>
 
+#include <cmath>
+
 #define DEFAULT_SHARD_NUM (1 << 12) /** Default number of shard */
 #define SHARD_TEST        1
 
@@ -24,6 +26,82 @@ MMKV_INLINE Shard MakeShardId(std::basic_string<char, std::char_traits<char>, Al
 
 MMKV_INLINE Shard MakeShardId(StringView key) noexcept { return XXH64(key.data(), key.size(), 0); }
 
+/**
+ * \brief The hash of the node for the shard in rendezvous hashing
+ * (i.e. The mix function of splitmix64), independent of the platform
+ */
+MMKV_INLINE uint64_t RendezvousHash(uint64_t shard_id, uint64_t node_id) noexcept
+{
+  uint64_t x = shard_id * 0x9e3779b97f4a7c15ULL ^ node_id;
+  x          = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x          = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/**
+ * \brief The score of the node with \p weight for the shard in weighted rendezvous hashing
+ * score = -weight / ln(h), h is the hash mapped to (0, 1).
+ * The node wins the shard with the probability proportional to its weight.
+ */
+MMKV_INLINE double RendezvousScore(uint64_t shard_id, uint64_t node_id, uint32_t weight) noexcept
+{
+  // The high 53 bits fill the mantissa, 0.5 avoids ln(0)
+  const double h = ((RendezvousHash(shard_id, node_id) >> 11) + 0.5) / (double)(1ULL << 53);
+  return -(double)weight / std::log(h);
+}
+
+/**
+ * \brief Select the owner of shard by rendezvous hashing
+ * The node with the highest hash owns the shard, thus the owner can
+ * be computed from the node ids alone and adding(or removing) a node
+ * only moves the shards it owns.
+ * It is equivalent to the weighted version with the same weight of all nodes.
+ *
+ * \param node_ids The container of node ids
+ * \return -1 if there is no node
+ */
+template <typename NodeIds>
+MMKV_INLINE uint64_t SelectRendezvousNode(uint64_t shard_id, NodeIds const &node_ids) noexcept
+{
+  uint64_t owner    = -1;
+  uint64_t max_hash = 0;
+  for (uint64_t const node_id : node_ids) {
+    const auto hash = RendezvousHash(shard_id, node_id);
+    if (owner == (uint64_t)-1 || hash > max_hash || (hash == max_hash && node_id > owner)) {
+      owner    = node_id;
+      max_hash = hash;
+    }
+  }
+  return owner;
+}
+
+/**
+ * \brief Select the owner of shard by weighted rendezvous hashing(see RendezvousScore())
+ * The node with the highest score owns the shard, the node with larger weight
+ * owns more shards proportionally and the movement is still minimal.
+ *
+ * \param node_ids The container of node ids
+ * \param get_weight uint32_t(uint64_t node_id), the weight of node, 0 owns no shard
+ * \return -1 if there is no node with positive weight
+ */
+template <typename NodeIds, typename GetWeight>
+MMKV_INLINE uint64_t
+SelectRendezvousNode(uint64_t shard_id, NodeIds const &node_ids, GetWeight const &get_weight)
+{
+  uint64_t owner     = -1;
+  double   max_score = 0;
+  for (uint64_t const node_id : node_ids) {
+    const uint32_t weight = get_weight(node_id);
+    if (weight == 0) continue;
+    const auto score = RendezvousScore(shard_id, node_id, weight);
+    if (owner == (uint64_t)-1 || score > max_score || (score == max_score && node_id > owner)) {
+      owner     = node_id;
+      max_score = score;
+    }
+  }
+  return owner;
+}
+
 } // namespace mmkv
 
 #endif // MMKV_UTIL_SHARD_UTIL_H_
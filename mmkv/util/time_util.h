@@ -65,6 +65,29 @@ inline int64_t GetTimeSec() noexcept
   return ::time(NULL);
 }
 
+/**
+ * \brief Get the microseconds of the monotonic clock
+ * Used for measuring the elapsed time, e.g. latency,
+ * since it is not affected by the adjustment of system time.
+ */
+inline int64_t GetMonotonicTimeUs() noexcept
+{
+  struct timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * \brief Get the nanoseconds of the monotonic clock
+ * The execution of most commands is less than one microsecond.
+ */
+inline int64_t GetMonotonicTimeNs() noexcept
+{
+  struct timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
 } // namespace util
 
 } // namespace mmkv
@@ -2,6 +2,8 @@
 #include "mmkv/algo/avl_tree_hashtable.h"
 #include "mmkv/algo/avl_dictionary.h"
 #include "mmkv/algo/avl_tree.h"
+#include "mmkv/algo/comparator_util.h"
+#include "mmkv/algo/string.h"
 
 #include "util.h"
 
@@ -56,3 +58,24 @@ TEST(dictionary_test, insert) {
 }
 
 
+
+TEST(dictionary_test, find_like) {
+  AvlDictionary<String, int, Comparator<String>> dict;
+
+  for (int i = 0; i < 100; ++i) {
+    auto si = std::to_string(i);
+    ASSERT_TRUE(dict.InsertKv(String(si.data(), si.size()), i));
+  }
+
+  for (int i = 0; i < 100; ++i) {
+    auto si = std::to_string(i);
+    // The view isn't null-terminated
+    si.push_back('x');
+    auto kv = dict.FindLike(kanon::StringView(si.data(), si.size() - 1));
+    ASSERT_TRUE(kv);
+    EXPECT_EQ(kv->value, i);
+  }
+
+  EXPECT_FALSE(dict.FindLike(kanon::StringView("100")));
+  EXPECT_FALSE(dict.FindLike(kanon::StringView("1", 0)));
+}
@@ -194,3 +194,25 @@ TEST(hash_set_test, intersection) {
   }
   std::cout << std::endl;
 }
+
+TEST(hash_set_test, scan) {
+  HashSet<int> hset;
+  for (int i = 0; i < 100; ++i) {
+    hset.Insert(i);
+  }
+
+  std::vector<int> visited;
+  size_t cursor = 0;
+  int new_entry = 100;
+  do {
+    cursor = hset.Scan(cursor, [&visited](int x) { visited.push_back(x); });
+    for (int i = 0; i < 10; ++i)
+      hset.Insert(new_entry++);
+  } while (cursor != 0);
+
+  std::sort(visited.begin(), visited.end());
+  visited.erase(std::unique(visited.begin(), visited.end()), visited.end());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(std::binary_search(visited.begin(), visited.end(), i)) << i;
+  }
+}
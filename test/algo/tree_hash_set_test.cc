@@ -186,3 +186,27 @@ TEST(hash_set, find2) {
 //   }
 //   std::cout << std::endl;
 // }
+
+TEST(hash_set, scan) {
+  HashSet<int> hset;
+  for (int i = 0; i < 100; ++i) {
+    hset.Insert(i);
+  }
+
+  // Insert new entries between the calls to trigger rehash,
+  // the entries inserted before the scan must be visited
+  std::vector<int> visited;
+  size_t cursor = 0;
+  int new_entry = 100;
+  do {
+    cursor = hset.Scan(cursor, [&visited](int x) { visited.push_back(x); });
+    for (int i = 0; i < 10; ++i)
+      hset.Insert(new_entry++);
+  } while (cursor != 0);
+
+  std::sort(visited.begin(), visited.end());
+  visited.erase(std::unique(visited.begin(), visited.end()), visited.end());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(std::binary_search(visited.begin(), visited.end(), i)) << i;
+  }
+}
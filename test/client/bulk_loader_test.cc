@@ -0,0 +1,173 @@
+#include "mmkv/client/bulk_loader.h"
+#include "mmkv/client/information.h"
+#include "mmkv/client/option.h"
+#include "mmkv/protocol/mmbp_response.h"
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <kanon/net/user_server.h>
+#include <kanon/thread/count_down_latch.h>
+
+using namespace mmkv::client;
+using namespace mmkv::protocol;
+using namespace kanon;
+
+/* Record the requests and reply S_OK, except that DEL is replied S_NONEXISTS */
+class FakeMmkvd {
+ public:
+  FakeMmkvd(EventLoop *loop, InetAddr const &addr)
+    : server_(loop, addr, "FakeMmkvd")
+    , codec_(MmbpRequest::GetPrototype())
+  {
+    server_.SetConnectionCallback([this](TcpConnectionPtr const &conn) {
+      if (conn->IsConnected()) codec_.SetUpConnection(conn);
+    });
+
+    codec_.SetMessageCallback([this](
+                                  TcpConnectionPtr const &conn,
+                                  Buffer                 &buffer,
+                                  uint32_t,
+                                  MmbpCodec::ChecksumAlgo,
+                                  TimeStamp
+                              ) {
+      MmbpRequest request;
+      request.ParseFrom(buffer);
+
+      MmbpResponse response;
+      response.status_code = request.command == DEL ? S_NONEXISTS : S_OK;
+      {
+        MutexGuard guard(mutex_);
+        keys_.emplace_back(request.command, request.GetKey().ToString());
+      }
+      codec_.Send(conn, &response);
+    });
+  }
+
+  void Listen() { server_.StartRun(); }
+
+  std::vector<std::pair<uint16_t, std::string>> TakeKeys()
+  {
+    std::vector<std::pair<uint16_t, std::string>> keys;
+    MutexGuard                                    guard(mutex_);
+    keys.swap(keys_);
+    return keys;
+  }
+
+ private:
+  TcpServer server_;
+  MmbpCodec codec_;
+
+  MutexLock                                     mutex_;
+  std::vector<std::pair<uint16_t, std::string>> keys_;
+};
+
+static constexpr char SERVER_ADDR[] = "127.0.0.1:19980";
+
+/* The server is shared by all tests and isn't destroyed out of its loop */
+static FakeMmkvd &fake_mmkvd()
+{
+  static EventLoopThread loop_thread("FakeMmkvd");
+  static FakeMmkvd      *p_server = []() {
+    auto           loop = loop_thread.StartRun();
+    FakeMmkvd     *p    = nullptr;
+    CountDownLatch latch(1);
+    loop->RunInLoop([&]() {
+      p = new FakeMmkvd(loop, InetAddr(SERVER_ADDR));
+      p->Listen();
+      latch.Countdown();
+    });
+    latch.Wait();
+    return p;
+  }();
+
+  return *p_server;
+}
+
+static bool Load(std::string input, bool raw = false, int window = 4096)
+{
+  static bool installed = (InstallInformation(), true);
+  (void)installed;
+  fake_mmkvd();
+
+  cli_option().pipe_raw    = raw;
+  cli_option().pipe_window = window;
+
+  EventLoopThread loop_thread;
+  BulkLoader      loader(loop_thread.StartRun(), InetAddr(SERVER_ADDR));
+
+  auto fp = ::fmemopen(&input[0], input.size(), "r");
+  EXPECT_TRUE(fp);
+  const auto ok = loader.Run(fp);
+  ::fclose(fp);
+  return ok;
+}
+
+TEST(bulk_loader, text)
+{
+  EXPECT_TRUE(Load("# comment\n\nSTRADD a 1\r\nSTRGET a\n"));
+
+  auto keys = fake_mmkvd().TakeKeys();
+  ASSERT_EQ(keys.size(), 2);
+  EXPECT_EQ(keys[0].first, STR_ADD);
+  EXPECT_EQ(keys[0].second, "a");
+  EXPECT_EQ(keys[1].first, STR_GET);
+  EXPECT_EQ(keys[1].second, "a");
+}
+
+TEST(bulk_loader, error)
+{
+  // The invalid lines are skipped and the rest are still sent
+  EXPECT_FALSE(Load("NOTACOMMAND a\nSTRADD b\nSTRADD c 1\n"));
+  auto keys = fake_mmkvd().TakeKeys();
+  ASSERT_EQ(keys.size(), 1);
+  EXPECT_EQ(keys[0].second, "c");
+
+  // The response is not ok
+  EXPECT_FALSE(Load("DEL a\nSTRADD a 1\n"));
+  EXPECT_EQ(fake_mmkvd().TakeKeys().size(), 2);
+}
+
+TEST(bulk_loader, window)
+{
+  std::string input;
+  for (int i = 0; i < 1000; ++i)
+    input += "STRADD k" + std::to_string(i) + " v\n";
+
+  // The requests are sent in order even if only one is in flight
+  EXPECT_TRUE(Load(input, false, 1));
+  auto keys = fake_mmkvd().TakeKeys();
+  ASSERT_EQ(keys.size(), 1000);
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(keys[i].second, "k" + std::to_string(i));
+}
+
+TEST(bulk_loader, raw)
+{
+  Buffer buffer;
+  for (int i = 0; i < 3; ++i) {
+    MmbpRequest request;
+    request.command = STR_ADD;
+    request.SetKey();
+    request.SetValue();
+    request.key   = ("k" + std::to_string(i)).c_str();
+    request.value = "v";
+
+    Buffer record;
+    request.SerializeTo(record);
+    buffer.Append32(record.GetReadableSize());
+    buffer.Append(record.GetReadBegin(), record.GetReadableSize());
+  }
+
+  auto input = buffer.RetrieveAllAsString();
+  EXPECT_TRUE(Load(input, true));
+  EXPECT_EQ(fake_mmkvd().TakeKeys().size(), 3);
+
+  // The truncated record is reported, the complete ones are sent
+  input.pop_back();
+  EXPECT_FALSE(Load(input, true));
+  EXPECT_EQ(fake_mmkvd().TakeKeys().size(), 2);
+}
@@ -0,0 +1,343 @@
+#include "mmkv/client/routing_client.h"
+#include "mmkv/configd/configd_codec.h"
+#include "mmkv/util/shard_util.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <kanon/net/user_server.h>
+#include <kanon/thread/count_down_latch.h>
+
+using namespace mmkv;
+using namespace mmkv::client;
+using namespace mmkv::protocol;
+using namespace kanon;
+
+static constexpr uint16_t   CONFIGD_PORT = 19981;
+static constexpr uint16_t   NODE_PORT    = 19982;
+static constexpr size_t     NODE_NUM     = 2;
+static constexpr shard_id_t SHARD_NUM    = 4;
+
+static std::string GetEndpoint(uint16_t port) { return "127.0.0.1:" + std::to_string(port); }
+
+/*
+ * Reply S_OK with the endpoint of node if the shard of key is owned,
+ * S_ASK if the key is moved to the peer, S_MOVED otherwise.
+ * The request following ASKING is served even if the shard isn't owned.
+ */
+class FakeNode {
+ public:
+  FakeNode(EventLoop *loop, uint16_t port)
+    : server_(loop, InetAddr(port), "FakeNode")
+    , codec_(MmbpRequest::GetPrototype())
+    , endpoint_(GetEndpoint(port))
+  {
+    server_.SetConnectionCallback([this](TcpConnectionPtr const &conn) {
+      if (conn->IsConnected()) codec_.SetUpConnection(conn);
+    });
+
+    codec_.SetMessageCallback([this](
+                                  TcpConnectionPtr const &conn,
+                                  Buffer                 &buffer,
+                                  uint32_t,
+                                  MmbpCodec::ChecksumAlgo,
+                                  TimeStamp
+                              ) {
+      MmbpRequest request;
+      request.ParseFrom(buffer);
+
+      MmbpResponse response;
+      response.SetValue();
+      {
+        MutexGuard guard(mutex_);
+        const auto key = request.HasKey() ? request.GetKey().ToString() : std::string();
+        const auto shard_id =
+            request.HasKey() ? MakeShardId(request.GetKey()) % SHARD_NUM : (shard_id_t)0;
+
+        if (request.command == ASKING) {
+          is_asking_           = true;
+          response.status_code = S_OK;
+        } else if (ask_keys_.count(key)) {
+          response.status_code = S_ASK;
+          response.value       = ask_endpoint_.c_str();
+        } else if (shards_.count(shard_id) || is_asking_) {
+          response.status_code = S_OK;
+          response.value       = endpoint_.c_str();
+        } else {
+          response.status_code = S_MOVED;
+        }
+
+        if (request.command != ASKING) is_asking_ = false;
+      }
+      codec_.Send(conn, &response);
+    });
+  }
+
+  void Listen() { server_.StartRun(); }
+
+  void SetShards(std::set<shard_id_t> shards)
+  {
+    MutexGuard guard(mutex_);
+    shards_ = std::move(shards);
+  }
+
+  void Ask(std::string const &key, std::string const &endpoint)
+  {
+    MutexGuard guard(mutex_);
+    ask_keys_.insert(key);
+    ask_endpoint_ = endpoint;
+  }
+
+  void ClearAsk()
+  {
+    MutexGuard guard(mutex_);
+    ask_keys_.clear();
+  }
+
+ private:
+  TcpServer   server_;
+  MmbpCodec   codec_;
+  std::string endpoint_;
+
+  MutexLock             mutex_;
+  std::set<shard_id_t>  shards_;
+  std::set<std::string> ask_keys_;
+  std::string           ask_endpoint_;
+  bool                  is_asking_ = false;
+};
+
+/* Reply the whole configuration to both fetch and watch */
+class FakeConfigd {
+ public:
+  FakeConfigd(EventLoop *loop, uint16_t port)
+    : server_(loop, InetAddr(port), "FakeConfigd")
+  {
+    server_.SetConnectionCallback([this](TcpConnectionPtr const &conn) {
+      if (conn->IsConnected()) codec_.SetUpConnection(conn);
+    });
+
+    codec_.SetMessageCallback(
+        [this](TcpConnectionPtr const &conn, Buffer &buffer, size_t payload_size, TimeStamp) {
+          ConfigRequest req;
+          protobuf::ParseFromBuffer(&req, payload_size, &buffer);
+
+          ConfigResponse resp;
+          resp.set_status(CONF_STATUS_OK);
+          {
+            MutexGuard guard(mutex_);
+            *resp.mutable_conf() = conf_;
+          }
+          codec_.Send(conn, &resp);
+        }
+    );
+  }
+
+  void Listen() { server_.StartRun(); }
+
+  /* The shards of node i, the node i serves in NODE_PORT + i */
+  void SetShards(std::vector<std::set<shard_id_t>> const &node_shards)
+  {
+    MutexGuard guard(mutex_);
+    conf_.clear_node_conf_map();
+    for (size_t i = 0; i < node_shards.size(); ++i) {
+      auto &node_conf = (*conf_.mutable_node_conf_map())[i];
+      node_conf.set_host("127.0.0.1");
+      node_conf.set_mmkvd_port(NODE_PORT + i);
+      for (auto shard_id : node_shards[i])
+        node_conf.add_shard_ids(shard_id);
+    }
+    conf_.set_epoch(conf_.epoch() + 1);
+  }
+
+ private:
+  TcpServer    server_;
+  ConfigdCodec codec_;
+
+  MutexLock     mutex_;
+  Configuration conf_;
+};
+
+/* The servers are shared by all tests and aren't destroyed out of their loop */
+struct Cluster {
+  FakeConfigd *configd;
+  FakeNode    *nodes[NODE_NUM];
+
+  /* Both the configd and nodes agree that the node i owns the shards in node_shards[i] */
+  void SetShards(std::vector<std::set<shard_id_t>> const &node_shards)
+  {
+    configd->SetShards(node_shards);
+    for (size_t i = 0; i < NODE_NUM; ++i)
+      nodes[i]->SetShards(i < node_shards.size() ? node_shards[i] : std::set<shard_id_t>{});
+  }
+};
+
+static Cluster &cluster()
+{
+  static EventLoopThread loop_thread("FakeCluster");
+  static Cluster         cluster = []() {
+    auto           loop = loop_thread.StartRun();
+    Cluster        c;
+    CountDownLatch latch(1);
+    loop->RunInLoop([&]() {
+      c.configd = new FakeConfigd(loop, CONFIGD_PORT);
+      c.configd->Listen();
+      for (size_t i = 0; i < NODE_NUM; ++i) {
+        c.nodes[i] = new FakeNode(loop, NODE_PORT + i);
+        c.nodes[i]->Listen();
+      }
+      latch.Countdown();
+    });
+    latch.Wait();
+    return c;
+  }();
+
+  return cluster;
+}
+
+/* The nth key(i.e. k<i>) in the shard */
+static std::string GetKeyOfShard(shard_id_t shard_id, int nth = 0)
+{
+  for (int i = 0;; ++i) {
+    auto key = "k" + std::to_string(i);
+    if (MakeShardId(key) % SHARD_NUM == shard_id && nth-- == 0) return key;
+  }
+}
+
+static MmbpRequest MakeGet(std::string const &key)
+{
+  MmbpRequest request;
+  request.command = STR_GET;
+  request.SetKey();
+  request.key = key.c_str();
+  return request;
+}
+
+static std::string ExecuteGet(RoutingClient &router, std::string const &key, StatusCode status)
+{
+  MmbpResponse response;
+  EXPECT_TRUE(router.Execute(MakeGet(key), response));
+  EXPECT_EQ(response.status_code, status) << key;
+  return std::string(response.value.data(), response.value.size());
+}
+
+TEST(routing_client, route)
+{
+  cluster().SetShards({{0, 1}, {2, 3}});
+
+  EventLoopThread loop_thread;
+  RoutingClient   router(loop_thread.StartRun(), InetAddr(GetEndpoint(CONFIGD_PORT)));
+  ASSERT_TRUE(router.Start());
+
+  // The connections are reused
+  for (int round = 0; round < 2; ++round) {
+    for (shard_id_t shard_id = 0; shard_id < SHARD_NUM; ++shard_id) {
+      EXPECT_EQ(
+          ExecuteGet(router, GetKeyOfShard(shard_id), S_OK),
+          GetEndpoint(NODE_PORT + shard_id / 2)
+      );
+    }
+  }
+
+  // The request without key is routed to the owner of shard 0
+  MmbpRequest request;
+  request.command = KEYALL;
+  MmbpResponse response;
+  EXPECT_TRUE(router.Execute(request, response));
+  EXPECT_EQ(response.status_code, S_OK);
+  EXPECT_EQ(std::string(response.value.data(), response.value.size()), GetEndpoint(NODE_PORT));
+
+  // The pipelined requests are replied in order
+  std::vector<std::string> endpoints(64);
+  CountDownLatch           latch(endpoints.size());
+  for (size_t i = 0; i < endpoints.size(); ++i) {
+    router.Send(MakeGet(GetKeyOfShard(i % SHARD_NUM)), [&, i](MmbpResponse *p_response) {
+      if (p_response) endpoints[i].assign(p_response->value.data(), p_response->value.size());
+      latch.Countdown();
+    });
+  }
+  latch.Wait();
+  for (size_t i = 0; i < endpoints.size(); ++i)
+    EXPECT_EQ(endpoints[i], GetEndpoint(NODE_PORT + i % SHARD_NUM / 2));
+
+  EXPECT_EQ(router.moved_num(), 0);
+  EXPECT_EQ(router.ask_num(), 0);
+  router.Stop();
+}
+
+TEST(routing_client, moved)
+{
+  cluster().SetShards({{0, 1}, {2, 3}});
+
+  EventLoopThread loop_thread;
+  RoutingClient   router(loop_thread.StartRun(), InetAddr(GetEndpoint(CONFIGD_PORT)));
+  ASSERT_TRUE(router.Start());
+
+  const auto key = GetKeyOfShard(1);
+  EXPECT_EQ(ExecuteGet(router, key, S_OK), GetEndpoint(NODE_PORT));
+
+  // The shard map is stale, it is fetched again once the node replies S_MOVED
+  cluster().SetShards({{0}, {1, 2, 3}});
+  EXPECT_EQ(ExecuteGet(router, key, S_OK), GetEndpoint(NODE_PORT + 1));
+  EXPECT_EQ(router.moved_num(), 1);
+
+  // The refreshed shard map is used by the following requests
+  EXPECT_EQ(ExecuteGet(router, key, S_OK), GetEndpoint(NODE_PORT + 1));
+  EXPECT_EQ(router.moved_num(), 1);
+
+  // The configd is inconsistent with the nodes, S_MOVED is replied after redirected
+  cluster().configd->SetShards({{0, 1}, {2, 3}});
+  cluster().nodes[0]->SetShards({0});
+  cluster().nodes[1]->SetShards({2, 3});
+  EXPECT_EQ(ExecuteGet(router, key, S_MOVED), "");
+  EXPECT_EQ(router.moved_num(), 1 + RoutingClient::MAX_REDIRECT_NUM);
+  router.Stop();
+}
+
+TEST(routing_client, ask)
+{
+  cluster().SetShards({{0, 1}, {2, 3}});
+
+  EventLoopThread loop_thread;
+  RoutingClient   router(loop_thread.StartRun(), InetAddr(GetEndpoint(CONFIGD_PORT)));
+  ASSERT_TRUE(router.Start());
+
+  // The key moved is asked in the destination, the shard map isn't changed
+  const auto key = GetKeyOfShard(0);
+  cluster().nodes[0]->Ask(key, GetEndpoint(NODE_PORT + 1));
+  EXPECT_EQ(ExecuteGet(router, key, S_OK), GetEndpoint(NODE_PORT + 1));
+  EXPECT_EQ(router.ask_num(), 1);
+  EXPECT_EQ(router.moved_num(), 0);
+
+  // The other keys of the shard are served by the source still
+  EXPECT_EQ(ExecuteGet(router, GetKeyOfShard(0, 1), S_OK), GetEndpoint(NODE_PORT));
+
+  // The key isn't asked once the migration is canceled
+  cluster().nodes[0]->ClearAsk();
+  EXPECT_EQ(ExecuteGet(router, key, S_OK), GetEndpoint(NODE_PORT));
+  EXPECT_EQ(router.ask_num(), 1);
+
+  // The destination doesn't reply S_ASK again, the redirection is bounded
+  cluster().nodes[0]->Ask(key, GetEndpoint(NODE_PORT));
+  EXPECT_EQ(ExecuteGet(router, key, S_ASK), GetEndpoint(NODE_PORT));
+  EXPECT_EQ(router.ask_num(), 1 + RoutingClient::MAX_REDIRECT_NUM);
+  EXPECT_EQ(router.moved_num(), 0);
+  cluster().nodes[0]->ClearAsk();
+  router.Stop();
+}
+
+TEST(routing_client, no_node)
+{
+  cluster().SetShards({});
+
+  EventLoopThread loop_thread;
+  RoutingClient   router(loop_thread.StartRun(), InetAddr(GetEndpoint(CONFIGD_PORT)));
+  ASSERT_TRUE(router.Start());
+
+  // The request can't be routed
+  MmbpResponse response;
+  EXPECT_FALSE(router.Execute(MakeGet("k"), response));
+  router.Stop();
+}
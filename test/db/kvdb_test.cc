@@ -1,12 +1,18 @@
 #include "mmkv/db/kvdb.h"
 
+#include "mmkv/server/config.h"
+#include "mmkv/util/shard_util.h"
 #include "mmkv/util/time_util.h"
 
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
 using namespace mmkv::db;
 using namespace mmkv::util;
 using namespace mmkv::protocol;
+using namespace mmkv::server;
+using namespace mmkv;
 
 TEST(kvdb, expire) {
   MmkvDb db;
@@ -16,4 +22,121 @@ TEST(kvdb, expire) {
   ::sleep(2);
   String* value = nullptr;
   EXPECT_EQ(db.GetStr("a", value), S_NONEXISTS);
-}
\ No newline at end of file
+}
+
+TEST(kvdb, drop_key) {
+  mmkv_config().lazy_expiration = true;
+
+  std::vector<std::pair<String, KeyDropReason>> drops;
+  SetKeyDropCallback([&drops](String key, KeyDropReason reason) {
+    drops.emplace_back(std::move(key), reason);
+  });
+
+  MmkvDb db;
+  EXPECT_EQ(db.InsertStr("a", "1"), S_OK);
+  EXPECT_EQ(db.InsertStr("b", "1"), S_OK);
+  EXPECT_EQ(db.ExpireAfterMs("a", GetTimeMs(), 10), S_OK);
+  EXPECT_EQ(db.ExpireAfterMs("b", GetTimeMs(), 10), S_OK);
+  ::usleep(20 * 1000);
+
+  // The expired key is read as is while paused
+  String  *value = nullptr;
+  uint64_t expiration;
+  {
+    LazyExpirationPause pause;
+    { LazyExpirationPause nested_pause; }
+    EXPECT_EQ(db.GetStr("a", value), S_OK);
+    EXPECT_EQ(db.GetExpiration("a", expiration), S_OK);
+  }
+  EXPECT_TRUE(drops.empty());
+
+  EXPECT_EQ(db.GetStr("a", value), S_NONEXISTS);
+  ASSERT_EQ(drops.size(), 1);
+  EXPECT_EQ(drops[0].first, "a");
+  EXPECT_EQ(drops[0].second, KDR_EXPIRED);
+
+  db.CheckExpireCycle();
+  ASSERT_EQ(drops.size(), 2);
+  EXPECT_EQ(drops[1].first, "b");
+  EXPECT_EQ(drops[1].second, KDR_EXPIRED);
+
+  SetKeyDropCallback(nullptr);
+}
+
+TEST(kvdb, cross_db) {
+  MmkvDb db1;
+  MmkvDb db2;
+  size_t count = 0;
+
+  StrValues members1{"a", "b", "c"};
+  StrValues members2{"b", "c", "d"};
+  EXPECT_EQ(db1.SetAdd("s1", members1, count), S_OK);
+  EXPECT_EQ(db2.SetAdd("s2", members2, count), S_OK);
+
+  StrValues members;
+  EXPECT_EQ(db1.SetAnd("s1", db2, "s2", members), S_OK);
+  EXPECT_EQ(members.size(), 2);
+  EXPECT_EQ(db1.SetOrSize("s1", db2, "s2", count), S_OK);
+  EXPECT_EQ(count, 4);
+  EXPECT_EQ(db1.SetAnd("s1", "s2", members), S_NONEXISTS);
+
+  // The destination is stored in the third database
+  MmkvDb db3;
+  EXPECT_EQ(db3.SetSubTo(db1, "s1", db2, "s2", "dest"), S_OK);
+  EXPECT_EQ(db3.SetSize("dest", count), S_OK);
+  EXPECT_EQ(count, 1);
+  EXPECT_EQ(db3.SetExists("dest", "a"), S_OK);
+
+  // The record is moved with its expiration time
+  uint64_t exp = 0;
+  mmkv_config().lazy_expiration = true;
+  EXPECT_EQ(db1.ExpireAfter("s1", GetTimeMs(), 100), S_OK);
+  EXPECT_EQ(db1.Rename("s1", db2, "s2"), S_EXISTS);
+  EXPECT_EQ(db1.Rename("s1", db2, "s3"), S_OK);
+  EXPECT_EQ(db1.SetSize("s1", count), S_NONEXISTS);
+  EXPECT_EQ(db1.GetExpiration("s1", exp), S_NONEXISTS);
+  EXPECT_EQ(db2.SetSize("s3", count), S_OK);
+  EXPECT_EQ(count, 3);
+  EXPECT_EQ(db2.GetExpiration("s3", exp), S_OK);
+  mmkv_config().lazy_expiration = false;
+}
+
+TEST(kvdb, shard) {
+  mmkv_config().shard_controller_endpoint = "127.0.0.1:9998";
+  mmkv_config().shard_num                 = 4;
+  MmkvDb db;
+
+  for (shard_id_t i = 0; i < 4; ++i)
+    db.AddShard(i);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(db.InsertStr(std::to_string(i).c_str(), "value"), S_OK);
+  EXPECT_EQ(db.GetKeyNum(), 100);
+
+  std::vector<String const *> keys;
+  EXPECT_EQ(db.GetShardKeys(0, keys), SC_OK);
+  for (auto key : keys)
+    EXPECT_EQ(mmkv::MakeShardId(*key) % 4, 0);
+  const auto shard_key_num = keys.size();
+
+  EXPECT_GT(db.EstimateShardMemoryUsage(0, 8, 0), shard_key_num * (sizeof("value") - 1));
+
+  // The keys of other shards are not affected
+  db.RemoveShard(0);
+  EXPECT_FALSE(db.HasShard(0));
+  EXPECT_EQ(db.GetKeyNum(), 100 - shard_key_num);
+  EXPECT_EQ(db.EstimateShardMemoryUsage(0, 8, 0), 0);
+
+  // The shards are still owned after all keys are deleted
+  size_t del_cnt = 0;
+  EXPECT_EQ(db.DeleteAll(&del_cnt), S_OK);
+  EXPECT_EQ(del_cnt, 100 - shard_key_num);
+  EXPECT_EQ(db.GetKeyNum(), 0);
+  for (int i = 0; i < 100; ++i) {
+    String key(std::to_string(i).c_str());
+    if (mmkv::MakeShardId(key) % 4 == 0) continue;
+    EXPECT_EQ(db.InsertStr(std::move(key), "value"), S_OK);
+  }
+
+  mmkv_config().shard_controller_endpoint.clear();
+  mmkv_config().shard_num = 1;
+}
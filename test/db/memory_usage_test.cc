@@ -0,0 +1,98 @@
+#include "mmkv/db/kvdb.h"
+#include "mmkv/db/memory_usage.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+using namespace mmkv::db;
+using namespace mmkv::protocol;
+
+#define N 100
+
+TEST(memory_usage, string)
+{
+  MmkvDb db;
+  size_t usage = 0;
+
+  EXPECT_EQ(db.MemoryUsage("a", 0, usage), S_NONEXISTS);
+  EXPECT_EQ(db.InsertStr("a", String(1000, 'a')), S_OK);
+  EXPECT_EQ(db.MemoryUsage("a", 0, usage), S_OK);
+  EXPECT_GE(usage, 1000);
+}
+
+TEST(memory_usage, sample)
+{
+  MmkvDb    db;
+  StrValues values;
+  for (int i = 0; i < 10 * N; ++i) {
+    values.emplace_back(String(64, 'a'));
+  }
+  EXPECT_EQ(db.ListAdd("list", values), S_OK);
+
+  size_t full_usage   = 0;
+  size_t sample_usage = 0;
+  EXPECT_EQ(db.MemoryUsage("list", 0, full_usage), S_OK);
+  EXPECT_EQ(db.MemoryUsage("list", 16, sample_usage), S_OK);
+  // The elements have same size, so the extrapolation is exact
+  EXPECT_EQ(full_usage, sample_usage);
+}
+
+TEST(memory_usage, report)
+{
+  MmkvDb db;
+
+  for (int i = 0; i < N; ++i) {
+    std::string si = std::to_string(i);
+    EXPECT_EQ(db.InsertStr(String(si.c_str(), si.size()), String(si.c_str(), si.size())), S_OK);
+  }
+
+  StrValues values;
+  for (int i = 0; i < N; ++i) {
+    values.emplace_back(String(64, 'a'));
+  }
+  EXPECT_EQ(db.ListAdd("list", values), S_OK);
+
+  MemoryReport report(3);
+  report.AddTotalKeyNum(db.GetKeyNum());
+  EXPECT_EQ(db.SampleMemoryUsage(2 * N, 0, report), N + 1);
+  EXPECT_EQ(report.sampled_key_num(), N + 1);
+  EXPECT_EQ(report.key_num(D_STRING), N);
+  EXPECT_EQ(report.key_num(D_STRLIST), 1);
+  EXPECT_EQ(report.elem_num(D_STRLIST), N);
+  ASSERT_EQ(report.top_keys().size(), 3);
+  EXPECT_EQ(report.top_keys()[0].key, "list");
+  EXPECT_GE(report.top_keys()[1].usage, report.top_keys()[2].usage);
+
+  // The keys sampled in the previous round aren't counted again
+  EXPECT_EQ(db.SampleMemoryUsage(2 * N, 0, report), 0);
+  EXPECT_EQ(report.sampled_key_num(), N + 1);
+  EXPECT_EQ(report.key_num(D_STRING), N);
+  EXPECT_EQ(report.elem_num(D_STRLIST), N);
+  ASSERT_EQ(report.top_keys().size(), 3);
+}
+
+TEST(memory_usage, concurrent_sample)
+{
+  MmkvDb db;
+
+  for (int i = 0; i < N; ++i) {
+    std::string si = std::to_string(i);
+    EXPECT_EQ(db.InsertStr(String(si.c_str(), si.size()), String(si.c_str(), si.size())), S_OK);
+  }
+
+  // The sampling only requires the read lock, thus it can run in multiple threads
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&db]() {
+      for (int j = 0; j < 100; ++j) {
+        MemoryReport report;
+        const auto sampled_num = db.SampleMemoryUsage(N / 10, 0, report);
+        EXPECT_EQ(sampled_num, report.sampled_key_num());
+        EXPECT_LE(report.sampled_key_num(), N / 10);
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+}
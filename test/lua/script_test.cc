@@ -0,0 +1,196 @@
+#include "mmkv/lua/script.h"
+#include "mmkv/storage/db.h"
+#include "mmkv/server/config.h"
+
+#include <gtest/gtest.h>
+
+using namespace mmkv;
+using namespace mmkv::storage;
+using namespace mmkv::protocol;
+using namespace mmkv::server;
+
+/* The first key_num of keys_args are keys */
+static MmbpResponse Eval(
+    DatabaseManager &manager,
+    Command          cmd,
+    String           script,
+    StrValues        keys_args = {},
+    size_t           key_num   = 0
+)
+{
+  MmbpRequest request;
+  request.command = cmd;
+  request.value   = std::move(script);
+  request.SetValue();
+  request.values = std::move(keys_args);
+  request.SetValues();
+  request.count = key_num;
+  request.SetCount();
+
+  MmbpResponse response;
+  manager.Execute(request, &response);
+  return response;
+}
+
+static bool Contains(String const &value, char const *str)
+{
+  return value.find(str) != String::npos;
+}
+
+TEST(script, eval)
+{
+  DatabaseManager manager;
+
+  auto response = Eval(
+      manager,
+      EVAL,
+      "mmkv.call('set', KEYS[1], ARGV[1]) return mmkv.call('get', KEYS[1])",
+      {"k", "v"},
+      1
+  );
+  EXPECT_EQ(response.status_code, S_OK);
+  EXPECT_EQ(response.value, "v");
+
+  // The return value is converted to the response
+  response = Eval(manager, EVAL, "return 1");
+  EXPECT_EQ(response.status_code, S_OK);
+  EXPECT_EQ(response.count, 1);
+
+  response = Eval(manager, EVAL, "return nil");
+  EXPECT_EQ(response.status_code, S_NONEXISTS);
+
+  response = Eval(manager, EVAL, "return {'a', 'b'}");
+  EXPECT_EQ(response.status_code, S_OK);
+  ASSERT_EQ(response.values.size(), 2);
+  EXPECT_EQ(response.values[1], "b");
+
+  response = Eval(manager, EVAL, "return {err = 'failed'}");
+  EXPECT_EQ(response.status_code, S_SCRIPT_ERROR);
+  EXPECT_EQ(response.value, "failed");
+
+  // The globals aren't kept between runs
+  Eval(manager, EVAL, "x = 1");
+  response = Eval(manager, EVAL, "return x");
+  EXPECT_EQ(response.status_code, S_NONEXISTS);
+}
+
+TEST(script, evalsha)
+{
+  DatabaseManager manager;
+  String const    script = "return ARGV[1]";
+
+  MmbpRequest request;
+  request.command = SCRIPT_LOAD;
+  request.value   = script;
+  request.SetValue();
+  MmbpResponse response;
+  manager.Execute(request, &response);
+  EXPECT_EQ(response.status_code, S_OK);
+
+  const auto hash = lua::GetScriptHash(StringView(script.data(), script.size()));
+  EXPECT_EQ(response.value, hash.c_str());
+
+  response = Eval(manager, EVALSHA, hash.c_str(), {"a"});
+  EXPECT_EQ(response.status_code, S_OK);
+  EXPECT_EQ(response.value, "a");
+
+  // The script is discarded once flushed
+  request         = MmbpRequest();
+  request.command = SCRIPT_FLUSH;
+  manager.Execute(request, &response);
+  EXPECT_EQ(response.status_code, S_OK);
+  response = Eval(manager, EVALSHA, hash.c_str(), {"a"});
+  EXPECT_EQ(response.status_code, S_SCRIPT_NONEXISTS);
+
+  // The script loaded by EVAL is cached also
+  Eval(manager, EVAL, script, {"b"});
+  response = Eval(manager, EVALSHA, hash.c_str(), {"b"});
+  EXPECT_EQ(response.status_code, S_OK);
+  EXPECT_EQ(response.value, "b");
+}
+
+TEST(script, undeclared_key)
+{
+  DatabaseManager manager;
+
+  auto response = Eval(manager, EVAL, "return mmkv.call('get', 'k')");
+  EXPECT_EQ(response.status_code, S_SCRIPT_ERROR);
+  EXPECT_TRUE(Contains(response.value, "declared")) << response.value;
+
+  response = Eval(manager, EVAL, "return mmkv.call('get', 'other')", {"k"}, 1);
+  EXPECT_EQ(response.status_code, S_SCRIPT_ERROR);
+
+  // The error is returned by pcall() instead of raised
+  response = Eval(
+      manager,
+      EVAL,
+      "local v, err = mmkv.pcall('set', 'other', 'v') return err",
+      {"k"},
+      1
+  );
+  EXPECT_EQ(response.status_code, S_OK);
+  EXPECT_TRUE(Contains(response.value, "declared")) << response.value;
+
+  // The undeclared key isn't written
+  response = Eval(manager, EVAL, "return mmkv.call('get', KEYS[1])", {"other"}, 1);
+  EXPECT_EQ(response.status_code, S_NONEXISTS);
+}
+
+TEST(script, error)
+{
+  DatabaseManager manager;
+
+  // The script isn't compiled
+  auto response = Eval(manager, EVAL, "return +");
+  EXPECT_EQ(response.status_code, S_SCRIPT_ERROR);
+  EXPECT_FALSE(response.value.empty());
+
+  response = Eval(manager, EVAL, "error('boom')");
+  EXPECT_EQ(response.status_code, S_SCRIPT_ERROR);
+  EXPECT_TRUE(Contains(response.value, "boom")) << response.value;
+
+  response = Eval(manager, EVAL, "return mmkv.call('nocommand', KEYS[1])", {"k"}, 1);
+  EXPECT_EQ(response.status_code, S_SCRIPT_ERROR);
+  EXPECT_TRUE(Contains(response.value, "unknown command")) << response.value;
+
+  response = Eval(manager, EVAL, "return mmkv.call()");
+  EXPECT_EQ(response.status_code, S_SCRIPT_ERROR);
+
+  // The number of keys exceeds the arguments
+  response = Eval(manager, EVAL, "return 1", {"k"}, 2);
+  EXPECT_EQ(response.status_code, S_INVALID_REQUEST);
+
+  // The io and os aren't opened
+  response = Eval(manager, EVAL, "return os.time()");
+  EXPECT_EQ(response.status_code, S_SCRIPT_ERROR);
+}
+
+TEST(script, time_limit)
+{
+  DatabaseManager manager;
+  mmkv_config().script_time_limit = 100;
+
+  auto response = Eval(manager, EVAL, "while true do end");
+  EXPECT_EQ(response.status_code, S_SCRIPT_ERROR);
+  EXPECT_TRUE(Contains(response.value, "time limit")) << response.value;
+
+  // The error caught by the script is raised again
+  response =
+      Eval(manager, EVAL, "while true do pcall(function() while true do end end) end return 1");
+  EXPECT_EQ(response.status_code, S_SCRIPT_ERROR);
+  EXPECT_TRUE(Contains(response.value, "time limit")) << response.value;
+
+  // The writes before aborting are kept
+  response = Eval(manager, EVAL, "mmkv.call('set', KEYS[1], 'x') while true do end", {"k"}, 1);
+  EXPECT_EQ(response.status_code, S_SCRIPT_ERROR);
+  response = Eval(manager, EVAL, "return mmkv.call('get', KEYS[1])", {"k"}, 1);
+  EXPECT_EQ(response.status_code, S_OK);
+  EXPECT_EQ(response.value, "x");
+
+  // The lua state is reusable after aborting
+  response = Eval(manager, EVAL, "local n = 0 for i = 1, 100000 do n = n + 1 end return n");
+  EXPECT_EQ(response.status_code, S_OK);
+  EXPECT_EQ(response.count, 100000);
+
+  mmkv_config().script_time_limit = 5000;
+}
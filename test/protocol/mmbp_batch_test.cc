@@ -0,0 +1,73 @@
+#include "mmkv/protocol/mmbp_batch.h"
+#include "mmkv/protocol/mmbp_util.h"
+
+#include <gtest/gtest.h>
+
+using namespace mmkv::protocol;
+
+TEST(mmbp_batch, serialize_parse)
+{
+  MmbpBatchRequest batch;
+  batch.requests.resize(2);
+  batch.requests[0].command = STR_ADD;
+  batch.requests[0].SetKey();
+  batch.requests[0].SetValue();
+  batch.requests[0].key   = "k";
+  batch.requests[0].value = "v";
+  batch.requests[1].command = STR_GET;
+  batch.requests[1].SetKey();
+  batch.requests[1].key = "k";
+
+  Buffer buffer;
+  batch.SerializeTo(buffer);
+
+  MmbpRequest peek;
+  EXPECT_EQ(peek.PeekCommand(buffer), BATCH);
+
+  MmbpBatchRequest parsed;
+  parsed.ParseFrom(buffer);
+  EXPECT_EQ(buffer.GetReadableSize(), 0);
+  ASSERT_EQ(parsed.requests.size(), 2);
+  EXPECT_EQ(parsed.requests[0].command, STR_ADD);
+  EXPECT_EQ(parsed.requests[0].value, "v");
+  EXPECT_EQ(parsed.requests[1].key, "k");
+
+  MmbpBatchResponse response;
+  response.status_code = S_OK;
+  response.responses.resize(1);
+  response.responses[0].status_code = S_OK;
+  response.responses[0].SetValue();
+  response.responses[0].value = "v";
+  response.SerializeTo(buffer);
+
+  MmbpBatchResponse parsed_response;
+  parsed_response.ParseFrom(buffer);
+  EXPECT_EQ(parsed_response.status_code, S_OK);
+  ASSERT_EQ(parsed_response.responses.size(), 1);
+  EXPECT_EQ(parsed_response.responses[0].value, "v");
+}
+
+TEST(mmbp_batch, invalid_count)
+{
+  // The count exceeds the requests in the buffer
+  Buffer buffer;
+  SerializeComponent((uint16_t)BATCH, buffer);
+  SerializeComponent((uint32_t)UINT32_MAX, buffer);
+  MmbpRequest request;
+  request.command = STR_GET;
+  request.SetKey();
+  request.key = "k";
+  request.SerializeTo(buffer);
+
+  MmbpBatchRequest parsed;
+  parsed.ParseFrom(buffer);
+  EXPECT_TRUE(parsed.requests.empty());
+
+  buffer.AdvanceAll();
+  SerializeComponent((uint8_t)S_OK, buffer);
+  SerializeComponent((uint32_t)1000, buffer);
+  MmbpBatchResponse parsed_response;
+  parsed_response.ParseFrom(buffer);
+  EXPECT_EQ(parsed_response.status_code, S_INVALID_REQUEST);
+  EXPECT_TRUE(parsed_response.responses.empty());
+}
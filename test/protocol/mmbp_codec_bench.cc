@@ -0,0 +1,57 @@
+#include "mmkv/protocol/mmbp_codec.h"
+#include "mmkv/protocol/mmbp_response.h"
+
+#include <benchmark/benchmark.h>
+
+using namespace benchmark;
+using namespace mmkv::protocol;
+
+using ChecksumAlgo = MmbpCodec::ChecksumAlgo;
+
+/* Serialize a response whose value is range(0) bytes into a frame */
+template <ChecksumAlgo algo>
+static void BM_Serialize(State &state)
+{
+  MmbpResponse response;
+  response.status_code = S_OK;
+  response.value       = String(state.range(0), 'a');
+  response.SetValue();
+
+  for (auto _ : state) {
+    OutputBuffer buffer;
+    MmbpCodec::SerializeTo(&response, buffer, algo);
+    DoNotOptimize(buffer);
+  }
+
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+/* The receiver verifies the whole contiguous frame */
+template <ChecksumAlgo algo>
+static void BM_Checksum(State &state)
+{
+  String frame(state.range(0), 'a');
+
+  for (auto _ : state) {
+    DoNotOptimize(MmbpCodec::CalculateCheckSum(frame.data(), frame.size(), algo));
+  }
+
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+#define MMBP_CODEC_BENCH_DEFINE(_func, _name)                                                      \
+  BENCHMARK_TEMPLATE(_func, MmbpCodec::CA_XXHASH32)                                                \
+      ->Name(_name " xxhash")                                                                      \
+      ->RangeMultiplier(16)                                                                        \
+      ->Range(64, 1 << 20);                                                                        \
+  BENCHMARK_TEMPLATE(_func, MmbpCodec::CA_CRC32C)                                                  \
+      ->Name(_name " crc32c")                                                                      \
+      ->RangeMultiplier(16)                                                                        \
+      ->Range(64, 1 << 20);                                                                        \
+  BENCHMARK_TEMPLATE(_func, MmbpCodec::CA_NONE)                                                    \
+      ->Name(_name " none")                                                                        \
+      ->RangeMultiplier(16)                                                                        \
+      ->Range(64, 1 << 20)
+
+MMBP_CODEC_BENCH_DEFINE(BM_Serialize, "MmbpCodec Serialize");
+MMBP_CODEC_BENCH_DEFINE(BM_Checksum, "MmbpCodec Checksum");
@@ -2,12 +2,16 @@
 #include "mmkv/protocol/mmbp_codec.h"
 #include "mmkv/protocol/mmbp_request.h"
 #include "mmkv/protocol/mmbp_util.h"
+#include "mmkv/util/crc32c.h"
 
 #include <kanon/log/logger.h>
 #include <kanon/util/ptr.h>
 #include <xxhash.h>
 #include <gtest/gtest.h>
 
+#include <random>
+#include <vector>
+
 using namespace mmkv::protocol;
 
 TEST(mmbp_codec, xxhash) {
@@ -108,3 +112,68 @@ TEST(mmbp_codec, parse_response) {
   EXPECT_EQ(msg1->status_code, S_OK);
   EXPECT_EQ(msg1->value, "OK");
 }
+
+TEST(mmbp_codec, checksum_algo) {
+  MmbpResponse res;
+  res.status_code = S_OK;
+  res.value = "OK";
+  res.SetValue();
+
+  char const *tags[] = {"MMBP", "MMBC", "MMBN"};
+  for (int i = 0; i < MmbpCodec::CA_NUM; ++i) {
+    auto algo = (MmbpCodec::ChecksumAlgo)i;
+    EXPECT_EQ(algo, MmbpCodec::GetChecksumAlgo(MmbpCodec::GetChecksumAlgoString(algo)));
+
+    ChunkList output_buffer;
+    MmbpCodec::SerializeTo(&res, output_buffer, algo);
+
+    Buffer input_buffer;
+    for (auto const& chunk : output_buffer) {
+      input_buffer.Append(chunk.ToStringView());
+    }
+
+    uint32_t size_header = 0;
+    size_t size_header_len = 0;
+    ASSERT_EQ(KVARINT_OK,
+              kvarint_decode32(input_buffer.GetReadBegin(), input_buffer.GetReadableSize(),
+                               &size_header_len, &size_header));
+    input_buffer.AdvanceRead(size_header_len);
+    ASSERT_EQ(size_header, input_buffer.GetReadableSize());
+    EXPECT_EQ(0, ::memcmp(input_buffer.GetReadBegin(), tags[i], 4));
+
+    auto checksum =
+        MmbpCodec::CalculateCheckSum(input_buffer.GetReadBegin(), size_header - 4, algo);
+    input_buffer.AdvanceRead(size_header - 4);
+    EXPECT_EQ(checksum, input_buffer.GetReadBegin32());
+  }
+
+  EXPECT_EQ(MmbpCodec::CA_NUM, MmbpCodec::GetChecksumAlgo("md5"));
+}
+
+TEST(mmbp_codec, crc32c) {
+  using mmkv::util::Crc32c;
+  using mmkv::util::Crc32cExtend;
+  using mmkv::util::SoftwareCrc32cExtend;
+
+  // The check value of CRC32C(Castagnoli)
+  EXPECT_EQ(Crc32c("123456789", 9), 0xE3069283u);
+  EXPECT_EQ(SoftwareCrc32cExtend(0, "123456789", 9), 0xE3069283u);
+  EXPECT_EQ(Crc32c("", 0), 0u);
+
+  // The hardware path handles the unaligned address and length same with the software
+  std::mt19937 rng(12345);
+  std::vector<unsigned char> data(4096 + 8);
+  for (auto &c : data) c = (unsigned char)rng();
+
+  for (int i = 0; i < 1000; ++i) {
+    const size_t offset = rng() % 8;
+    const size_t len = rng() % 4096;
+    auto p = data.data() + offset;
+    const auto crc = Crc32c(p, len);
+    EXPECT_EQ(crc, SoftwareCrc32cExtend(0, p, len)) << "offset = " << offset << ", len = " << len;
+
+    // The data can be checksummed in pieces
+    const size_t split = len ? rng() % len : 0;
+    EXPECT_EQ(crc, Crc32cExtend(Crc32c(p, split), p + split, len - split));
+  }
+}
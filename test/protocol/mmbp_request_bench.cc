@@ -0,0 +1,185 @@
+#include "mmkv/protocol/command_type.h"
+#include "mmkv/protocol/mmbp_codec.h"
+#include "mmkv/protocol/mmbp_request.h"
+#include "mmkv/protocol/mmbp_response.h"
+#include "mmkv/protocol/mmbp_util.h"
+
+
+#include <benchmark/benchmark.h>
+
+using namespace benchmark;
+using namespace mmkv::protocol;
+using mmkv::disk::CT_READ;
+
+/* The strings use malloc() and realloc() directly(LibcAllocatorWithRealloc),
+ * and operator new forwards to malloc() in libstdc++,
+ * thus the allocation count is collected by interposing the glibc allocator. */
+static size_t g_alloc_count = 0;
+
+extern "C" {
+
+void *__libc_malloc(size_t n);
+void *__libc_realloc(void *p, size_t n);
+
+void *malloc(size_t n)
+{
+  ++g_alloc_count;
+  return __libc_malloc(n);
+}
+
+void *realloc(void *p, size_t n)
+{
+  ++g_alloc_count;
+  return __libc_realloc(p, n);
+}
+}
+
+/* The pipelined frames of keyed requests(strset/strget/ladd) as the clients send,
+ * the values are 64 bytes */
+static String MakeFrames(size_t frame_num)
+{
+  String      frames;
+  MmbpRequest request;
+  char        key[32];
+  for (size_t i = 0; i < frame_num; ++i) {
+    ::snprintf(key, sizeof key, "key:%06zu", i);
+    request.Reset();
+    request.key = key;
+    request.SetKey();
+    switch (i % 3) {
+      case 0:
+        request.command = STR_SET;
+        request.value   = String(64, 'a' + i % 26);
+        request.SetValue();
+        break;
+      case 1:
+        request.command = STR_GET;
+        break;
+      default:
+        request.command = LADD;
+        for (int j = 0; j < 8; ++j)
+          request.values.emplace_back(64, 'a' + j);
+        request.SetValues();
+        break;
+    }
+
+    // The checksum covers the whole output, thus each frame is serialized alone
+    OutputBuffer output;
+    MmbpCodec::SerializeTo(&request, output, MmbpCodec::CA_XXHASH32);
+    for (auto const &chunk : output)
+      frames.append(chunk.GetReadBegin(), chunk.GetReadableSize());
+  }
+  return frames;
+}
+
+/* The length of tag(MMBP, MMBC or MMBN) */
+#define MMBP_TAG_SIZE 4
+
+/* The server parses the read requests as views of the buffer */
+static void ParseRequest(Buffer &buffer, MmbpRequest &request)
+{
+  if (GetCommandType(request.PeekCommand(buffer)) == CT_READ)
+    request.ParseViewFrom(buffer);
+  else
+    request.ParseFrom(buffer);
+}
+
+/* Decode the frames like the message callback of MmbpCodec,
+ * \p handle parses the request of each frame */
+template <typename F>
+static void ParseFrames(Buffer &buffer, F const &handle)
+{
+  while (buffer.GetReadableSize() > 0) {
+    uint32_t size_header     = 0;
+    size_t   size_header_len = 0;
+    kvarint_decode32(
+        buffer.GetReadBegin(),
+        buffer.GetReadableSize(),
+        &size_header_len,
+        &size_header
+    );
+    buffer.AdvanceRead(size_header_len);
+
+    // tag | payload | checksum
+    const auto payload_len = size_header - MMBP_TAG_SIZE - sizeof(MmbpCodec::CheckSumType);
+    const auto checksum    = MmbpCodec::CalculateCheckSum(
+        buffer.GetReadBegin(),
+        MMBP_TAG_SIZE + payload_len,
+        MmbpCodec::CA_XXHASH32
+    );
+    buffer.AdvanceRead(MMBP_TAG_SIZE);
+
+    handle(buffer);
+
+    if (checksum != buffer.GetReadBegin32()) abort();
+    buffer.AdvanceRead32();
+  }
+}
+
+/* The handler references the stored value as the server does */
+static void FillResponse(MmbpRequest const &request, MmbpResponse &response, String const &stored)
+{
+  response.AllowReference();
+  response.status_code = S_OK;
+  if (request.command == STR_GET) {
+    response.SetValue();
+    response.value_ref = &stored;
+  }
+}
+
+#define FRAME_NUM 64
+
+/* Construct the request and response per message(the old way) */
+static void BM_Fresh(State &state)
+{
+  const auto frames = MakeFrames(FRAME_NUM);
+  String     stored(64, 'b');
+  Buffer     buffer;
+
+  g_alloc_count = 0;
+  for (auto _ : state) {
+    buffer.Append(frames.data(), frames.size());
+
+    ParseFrames(buffer, [&stored](Buffer &buffer) {
+      MmbpRequest  request;
+      MmbpResponse response;
+      ParseRequest(buffer, request);
+      FillResponse(request, response, stored);
+      DoNotOptimize(response);
+    });
+  }
+
+  state.SetItemsProcessed(state.iterations() * FRAME_NUM);
+  state.SetBytesProcessed(state.iterations() * frames.size());
+  state.counters["allocs/op"] = Counter(g_alloc_count, Counter::kAvgIterations);
+}
+
+/* Reuse the request and response of the session */
+static void BM_Reuse(State &state)
+{
+  const auto frames = MakeFrames(FRAME_NUM);
+  String     stored(64, 'b');
+  Buffer     buffer;
+
+  MmbpRequest  request;
+  MmbpResponse response;
+
+  g_alloc_count = 0;
+  for (auto _ : state) {
+    buffer.Append(frames.data(), frames.size());
+
+    ParseFrames(buffer, [&stored, &request, &response](Buffer &buffer) {
+      response.Reset();
+      ParseRequest(buffer, request);
+      FillResponse(request, response, stored);
+      DoNotOptimize(response);
+    });
+  }
+
+  state.SetItemsProcessed(state.iterations() * FRAME_NUM);
+  state.SetBytesProcessed(state.iterations() * frames.size());
+  state.counters["allocs/op"] = Counter(g_alloc_count, Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_Fresh)->Name("MmbpRequest Fresh");
+BENCHMARK(BM_Reuse)->Name("MmbpRequest Reuse");
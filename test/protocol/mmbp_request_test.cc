@@ -82,3 +82,29 @@ TEST(mmbp_request, parse) {
   ASSERT_EQ(request.key, "Conzxy");
   ASSERT_EQ(request.value, "MMKV");
 }
+
+TEST(mmbp_request, parse_view) {
+  MmbpRequest mmbp_message;
+  mmbp_message.SetKey();
+  mmbp_message.key = "Conzxy";
+  mmbp_message.SetValues();
+  mmbp_message.values = {"field1", "field2"};
+  mmbp_message.command = (Command::MGETS);
+
+  Buffer input_buffer{};
+  mmbp_message.SerializeTo(input_buffer);
+
+  MmbpRequest request;
+  request.ParseViewFrom(input_buffer);
+
+  ASSERT_TRUE(request.IsView());
+  ASSERT_TRUE(request.HasKey());
+  ASSERT_TRUE(request.HasValues());
+  ASSERT_EQ(request.command, MGETS);
+  ASSERT_TRUE(request.key.empty());
+  ASSERT_EQ(request.GetKey(), "Conzxy");
+  ASSERT_EQ(request.values_view.size(), 2);
+  ASSERT_EQ(request.values_view[0], "field1");
+  ASSERT_EQ(request.values_view[1], "field2");
+  ASSERT_EQ(input_buffer.GetReadableSize(), 0);
+}
@@ -29,3 +29,50 @@ TEST(mmbp_response, serialize) {
 TEST(mmbp_response, parse) {
 
 }
+
+TEST(mmbp_response, reference) {
+  String value(1000, 'a');
+  StrValues values{"a", "bb", "ccc"};
+  StrKvs kvs{{"f1", "v1"}, {"f2", "v2"}};
+  WeightValues vmembers{{1.0, "m1"}, {2.0, "m2"}};
+
+  MmbpResponse msgs[4];
+  MmbpResponse ref_msgs[4];
+  for (auto &msg : msgs) msg.SetOk();
+  for (auto &msg : ref_msgs) msg.SetOk();
+
+  msgs[0].SetValue();
+  msgs[0].value = value;
+  ref_msgs[0].SetValue();
+  ref_msgs[0].value_ref = &value;
+
+  msgs[1].SetValues();
+  msgs[1].values = values;
+  ref_msgs[1].SetValues();
+  for (auto const &v : values) ref_msgs[1].values_ref.push_back(&v);
+
+  msgs[2].SetKvs();
+  msgs[2].kvs = kvs;
+  ref_msgs[2].SetKvs();
+  for (auto const &kv : kvs) ref_msgs[2].kvs_ref.push_back({&kv.key, &kv.value});
+
+  msgs[3].SetVmembers();
+  msgs[3].vmembers = vmembers;
+  ref_msgs[3].SetVmembers();
+  for (auto const &wm : vmembers) ref_msgs[3].vmembers_ref.push_back({wm.key, &wm.value});
+
+  for (int i = 0; i < 4; ++i) {
+    Buffer buffer;
+    Buffer ref_buffer;
+    msgs[i].SerializeTo(buffer);
+    ref_msgs[i].SerializeTo(ref_buffer);
+    EXPECT_EQ(buffer.ToStringView().ToString(), ref_buffer.ToStringView().ToString());
+  }
+
+  Buffer buffer;
+  ref_msgs[0].SerializeTo(buffer);
+  MmbpResponse response;
+  response.ParseFrom(buffer);
+  ASSERT_TRUE(response.HasValue());
+  EXPECT_EQ(response.value, value);
+}
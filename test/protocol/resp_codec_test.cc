@@ -0,0 +1,111 @@
+#include "mmkv/protocol/resp_codec.h"
+#include "mmkv/protocol/resp_command.h"
+#include "mmkv/util/conv.h"
+
+#include <gtest/gtest.h>
+
+using namespace mmkv::protocol;
+
+static std::string ToString(OutputBuffer const &buffer)
+{
+  std::string ret;
+  for (auto const &chunk : buffer) {
+    auto view = chunk.ToStringView();
+    ret.append(view.data(), view.size());
+  }
+  return ret;
+}
+
+TEST(resp_codec, parse_pipeline)
+{
+  Buffer buffer;
+  buffer.Append(StringView("*3\r\n$3\r\nSET\r\n$1\r\nk\r\n$5\r\nvalue\r\n"));
+  buffer.Append(StringView("PING  hello\r\n"));
+  buffer.Append(StringView("*2\r\n$3\r\nGET\r\n$1\r\n"));
+
+  RespArgs args;
+  size_t   len = 0;
+  ASSERT_EQ(RespCodec::Parse(buffer, args, &len), RespCodec::E_NOERROR);
+  ASSERT_EQ(args.size(), 3);
+  EXPECT_EQ(args[2], StringView("value"));
+  buffer.AdvanceRead(len);
+
+  ASSERT_EQ(RespCodec::Parse(buffer, args, &len), RespCodec::E_NOERROR);
+  ASSERT_EQ(args.size(), 2);
+  EXPECT_EQ(args[1], StringView("hello"));
+  buffer.AdvanceRead(len);
+
+  // Short read
+  ASSERT_EQ(RespCodec::Parse(buffer, args, &len), RespCodec::E_NO_COMPLETE_MESSAGE);
+  buffer.Append(StringView("k\r\n"));
+  ASSERT_EQ(RespCodec::Parse(buffer, args, &len), RespCodec::E_NOERROR);
+  EXPECT_EQ(len, buffer.GetReadableSize());
+
+  Buffer invalid;
+  invalid.Append(StringView("*1\r\n+PING\r\n"));
+  EXPECT_EQ(RespCodec::Parse(invalid, args, &len), RespCodec::E_INVALID_BULK_LENGTH);
+}
+
+TEST(resp_codec, translate)
+{
+  RespArgs    args{"zrange", "k", "0", "-1", "WITHSCORES"};
+  MmbpRequest request;
+  RespReply   reply;
+
+  auto cmd = GetRespCommand("ZRANGE");
+  ASSERT_TRUE(cmd);
+  EXPECT_EQ(ParseRespRequest(*cmd, args, request, reply), nullptr);
+  EXPECT_EQ(request.command, VRANGE);
+  EXPECT_EQ(reply, RR_DEFAULT);
+
+  // The stop of lrange is included
+  MmbpRequest lrange;
+  args = {"lrange", "k", "0", "1"};
+  EXPECT_EQ(ParseRespRequest(*GetRespCommand("lrange"), args, lrange, reply), nullptr);
+  EXPECT_EQ(lrange.range.right, 2);
+
+  MmbpRequest del;
+  args = {"del", "a", "b"};
+  EXPECT_EQ(ParseRespRequest(*GetRespCommand("del"), args, del, reply), nullptr);
+  EXPECT_EQ(del.command, DELS);
+  EXPECT_EQ(del.values.size(), 2);
+
+  MmbpRequest hset;
+  args = {"hset", "k", "f"};
+  EXPECT_NE(ParseRespRequest(*GetRespCommand("hset"), args, hset, reply), nullptr);
+
+  EXPECT_EQ(GetRespCommand("nonexistent"), nullptr);
+}
+
+TEST(resp_codec, serialize)
+{
+  MmbpResponse response;
+  response.status_code = S_OK;
+  response.values.push_back("a");
+  response.SetValues();
+  response.SetCursor(12);
+
+  OutputBuffer buffer;
+  SerializeRespResponse(response, RR_DEFAULT, 2, buffer);
+  EXPECT_EQ(ToString(buffer), "*2\r\n$2\r\n12\r\n*1\r\n$1\r\na\r\n");
+
+  MmbpResponse miss;
+  miss.status_code = S_NONEXISTS;
+
+  OutputBuffer null_buffer;
+  SerializeRespResponse(miss, RR_DEFAULT, 3, null_buffer);
+  EXPECT_EQ(ToString(null_buffer), "_\r\n");
+
+  OutputBuffer zero_buffer;
+  SerializeRespResponse(miss, RR_ZERO_ON_MISS, 2, zero_buffer);
+  EXPECT_EQ(ToString(zero_buffer), ":0\r\n");
+
+  MmbpResponse weight;
+  weight.status_code = S_OK;
+  weight.SetCount();
+  weight.count = mmkv::util::double2u64(1.5);
+
+  OutputBuffer double_buffer;
+  SerializeRespResponse(weight, RR_DOUBLE, 3, double_buffer);
+  EXPECT_EQ(ToString(double_buffer), ",1.5\r\n");
+}
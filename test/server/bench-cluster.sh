@@ -0,0 +1,140 @@
+#!/bin/bash
+# Launch a shard cluster on loopback and measure the rebalancing under load:
+# start configd and NODES nodes, load KEYS keys by mmkv-benchmark, then
+# join JOIN nodes and let LEAVE nodes leave one by one while the load
+# generator runs at RATE requests/sec for DURATION seconds.
+# The throughput and latency are reported every second(the events are
+# stamped in the same timeline), followed by the migration time of each
+# join/leave and the total.
+#
+# The parameters are passed by environment variables, e.g.
+#   NODES=3 JOIN=2 LEAVE=1 ./bench-cluster.sh
+# or through the build target:
+#   NODES=3 cmake --build build --target bench-cluster
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+cd ${BIN_DIR:-$ROOT/build/bin} || exit 1
+
+NODES=${NODES:-2}
+JOIN=${JOIN:-1}
+LEAVE=${LEAVE:-1}
+KEYS=${KEYS:-100000}
+RATE=${RATE:-20000}
+DURATION=${DURATION:-30}
+SHARD_NUM=${SHARD_NUM:-1024}
+CONCURRENCY=${CONCURRENCY:-8}
+MIGRATION_RATE=${MIGRATION_RATE:-0B}
+TIMEOUT=${TIMEOUT:-120}
+
+CONFIGD_PORT=29997
+CONTROLLER_PORT=29996
+NODE_PORT_BASE=29980    # mmkvd of node i listens on NODE_PORT_BASE + i
+SHARDER_PORT_BASE=29960 # sharder of node i listens on SHARDER_PORT_BASE + i
+
+TMP=$(mktemp -d)
+PIDS=()
+
+cleanup() {
+  kill ${PIDS[@]} 2> /dev/null
+  wait 2> /dev/null
+  rm -rf $TMP
+}
+trap cleanup EXIT
+
+cat > $TMP/configd.lua << CONF
+ShardNum = $SHARD_NUM
+ShardControllerEndpoint = "*:$CONTROLLER_PORT"
+RebalanceThreshold = 0
+CONF
+
+# Wait the pattern is logged by the file, fail if timeout
+wait_log() {
+  local deadline=$((SECONDS + TIMEOUT))
+  while ! grep -q "$2" $1 2> /dev/null; do
+    if [ $SECONDS -ge $deadline ]; then
+      echo "Timeout: \"$2\" isn't found in $1"
+      exit 1
+    fi
+    sleep 0.1
+  done
+}
+
+now_ms() {
+  echo $(($(date +%s%N) / 1000000))
+}
+
+# Stamp the event in the timeline of load generator
+event() {
+  local elapsed_ms=$(($(now_ms) - LOAD_START_MS))
+  printf "[%6d.%ds] --- %s\n" $((elapsed_ms / 1000)) $((elapsed_ms % 1000 / 100)) "$1" >> $TMP/events.log
+}
+
+start_node() {
+  sed -e "s/^-- ShardControllerEndpoint = .*/ShardControllerEndpoint = \"127.0.0.1:$CONTROLLER_PORT\"/" \
+      -e "s/^SharderEndpoint = .*/SharderEndpoint = \"127.0.0.1:$((SHARDER_PORT_BASE + $1))\"/" \
+      -e "s/^ShardMigrationConcurrency = .*/ShardMigrationConcurrency = $CONCURRENCY/" \
+      -e "s/^ShardMigrationRate = .*/ShardMigrationRate = \"$MIGRATION_RATE\"/" \
+      $ROOT/bin/mmkvconf.lua > $TMP/node$1.lua
+  ./mmkv-server -p $((NODE_PORT_BASE + $1)) -c $TMP/node$1.lua > $TMP/node$1.log 2>&1 &
+  PIDS+=($!)
+}
+
+# The first node owns all shards, the others pull shards from the nodes in cluster
+join_node() {
+  start_node $1
+  if [ $1 -eq 1 ]; then
+    sleep 1
+  else
+    wait_log $TMP/node$1.log "Rebalance costs"
+  fi
+}
+
+leave_node() {
+  echo "SHARD_LEAVE" | ./mmkv-cli -p $((NODE_PORT_BASE + $1)) --pipe > /dev/null
+  wait_log $TMP/node$1.log "Rebalance costs"
+}
+
+./mmkv-configd -e "127.0.0.1:$CONFIGD_PORT" -c $TMP/configd.lua > $TMP/configd.log 2>&1 &
+PIDS+=($!)
+sleep 1
+
+for ((i = 1; i <= NODES; ++i)); do
+  join_node $i
+done
+echo "The cluster of $NODES nodes is started, $SHARD_NUM shards"
+
+BENCH="./mmkv-benchmark --configd 127.0.0.1:$CONFIGD_PORT -r $KEYS -cs none"
+$BENCH -n $KEYS -m strset:1 | grep "requests completed"
+
+# The load generator runs in open loop, thus the latency of the requests
+# stalled by the migration is measured from their scheduled time
+LOAD_START_MS=$(now_ms)
+$BENCH -n $((RATE * DURATION)) -R $RATE -i 1 -m strset:1,strget:1 > $TMP/load.log 2>&1 &
+LOAD_PID=$!
+PIDS+=($LOAD_PID)
+sleep 2
+
+for ((i = NODES + 1; i <= NODES + JOIN; ++i)); do
+  event "node$i joins"
+  join_node $i
+  event "node$i joined: $(grep -o 'Rebalance costs.*' $TMP/node$i.log)"
+done
+
+for ((i = NODES + JOIN; i > NODES + JOIN - LEAVE && i > 1; --i)); do
+  event "node$i leaves"
+  leave_node $i
+  event "node$i left: $(grep -o 'Rebalance costs.*' $TMP/node$i.log)"
+done
+
+wait $LOAD_PID
+
+echo "nodes: $NODES, join: $JOIN, leave: $LEAVE, keys: $KEYS, rate: $RATE requests/sec"
+echo "migration concurrency: $CONCURRENCY, rate: $MIGRATION_RATE/s"
+echo
+grep "^\[" $TMP/load.log | cat - $TMP/events.log 2> /dev/null | sort -s -n -k 1.2
+sed -n '/======/,$p' $TMP/load.log
+
+TOTAL_MS=$(cat $TMP/node*.log | grep -o "Rebalance costs [0-9]*ms" | grep -o "[0-9]*" |
+           awk '{ sum += $1 } END { print sum + 0 }')
+echo
+echo "total migration time: ${TOTAL_MS}ms"
+exit 0
@@ -0,0 +1,262 @@
+#include "mmkv/server/replication_source.h"
+#include "mmkv/server/config.h"
+#include "mmkv/server/replication.h"
+#include "mmkv/server/storage_hooks.h"
+#include "mmkv/protocol/mmbp_request.h"
+#include "mmkv/protocol/mmbp_response.h"
+#include "mmkv/storage/db.h"
+#include "mmkv/util/time_util.h"
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+
+#include <kanon/net/user_client.h>
+#include <kanon/thread/count_down_latch.h>
+
+using namespace mmkv;
+using namespace mmkv::server;
+using namespace mmkv::storage;
+using namespace mmkv::protocol;
+using namespace mmkv::util;
+using namespace kanon;
+
+static constexpr char REPL_ADDR[] = "127.0.0.1:19984";
+
+/* Apply the snapshot and records to its own database like ReplicaClient */
+class FakeReplica {
+ public:
+  FakeReplica(EventLoop *loop, InetAddr const &addr)
+    : cli_(NewTcpClient(loop, addr, "FakeReplica"))
+    , has_header_(false)
+    , is_synced_(false)
+    , offset_(0)
+  {
+    cli_->SetConnectionCallback([this](TcpConnectionPtr const &conn) {
+      if (!conn->IsConnected()) return;
+      conn->SetMessageCallback([this](TcpConnectionPtr const &, Buffer &buffer, TimeStamp) {
+        OnMessage(buffer);
+      });
+
+      // The replica has no data
+      char         handshake[REPL_HANDSHAKE_SIZE] = {0};
+      OutputBuffer output;
+      output.Append(handshake, sizeof handshake);
+      conn->Send(output);
+    });
+  }
+
+  void Connect() { cli_->Connect(); }
+
+  bool     is_synced() const noexcept { return is_synced_; }
+  uint64_t offset() const noexcept { return offset_; }
+
+  DatabaseManager &db() noexcept { return db_; }
+
+ private:
+  void OnMessage(Buffer &buffer)
+  {
+    if (!has_header_) {
+      if (buffer.GetReadableSize() < REPL_SYNC_HEADER_SIZE) return;
+      EXPECT_EQ((ReplSyncType)*buffer.GetReadBegin(), RST_FULL);
+      buffer.AdvanceRead(sizeof(uint8_t));
+      buffer.Read64();
+      offset_     = buffer.Read64();
+      has_header_ = true;
+    }
+
+    while (buffer.GetReadableSize() >= sizeof(uint32_t)) {
+      uint32_t   len         = buffer.GetReadBegin32();
+      const bool is_snapshot = len & REPL_SNAPSHOT_FLAG;
+      len &= ~REPL_SNAPSHOT_FLAG;
+      if (buffer.GetReadableSize() < sizeof(uint32_t) + len) break;
+      buffer.AdvanceRead32();
+
+      if (!is_snapshot) {
+        Apply(buffer);
+        offset_ += sizeof(uint32_t) + len;
+        continue;
+      }
+
+      if (len == 0) {
+        is_synced_ = true;
+        continue;
+      }
+
+      const auto end_size = buffer.GetReadableSize() - len;
+      while (buffer.GetReadableSize() > end_size) {
+        buffer.AdvanceRead32();
+        Apply(buffer);
+      }
+    }
+  }
+
+  void Apply(Buffer &buffer)
+  {
+    request_.ParseFrom(buffer);
+    db_.Execute(request_, nullptr);
+  }
+
+  TcpClientPtr          cli_;
+  DatabaseManager       db_;
+  MmbpRequest           request_;
+  bool                  has_header_;
+  std::atomic<bool>     is_synced_;
+  std::atomic<uint64_t> offset_;
+};
+
+/* Log the request and execute it like the server */
+static void Write(MmbpRequest &request)
+{
+  ReplicationGate repl_gate(true);
+
+  Buffer record;
+  request.SerializeTo(record);
+  LogRecord(record.GetReadBegin(), record.GetReadableSize());
+  database_manager().Execute(request, nullptr);
+  LogPendingDels();
+}
+
+static void SetStr(std::string const &key, std::string const &value)
+{
+  MmbpRequest request;
+  request.command = STR_SET;
+  request.key     = key.c_str();
+  request.SetKey();
+  request.value = value.c_str();
+  request.SetValue();
+  Write(request);
+}
+
+static void ExpireAt(std::string const &key, uint64_t expire_time)
+{
+  MmbpRequest request;
+  request.command = EXPIREM_AT;
+  request.key     = key.c_str();
+  request.SetKey();
+  request.expire_time = expire_time;
+  request.SetExpireTime();
+  Write(request);
+}
+
+static std::map<std::string, std::string> GetAll(DatabaseManager &manager)
+{
+  std::map<std::string, std::string> kvs;
+  StrValues                          keys;
+  size_t                             cursor = 0;
+  do {
+    keys.clear();
+    cursor = manager.Scan(cursor, 64, keys);
+    for (auto const &key : keys) {
+      MmbpRequest request;
+      request.command = STR_GET;
+      request.key     = key;
+      request.SetKey();
+      MmbpResponse response;
+      manager.Execute(request, &response);
+      if (response.status_code == S_OK)
+        kvs[key.c_str()] = std::string(response.value.data(), response.value.size());
+    }
+  } while (cursor != 0);
+  return kvs;
+}
+
+static uint64_t GetPrimaryOffset()
+{
+  String info;
+  repl_source().GetInfo(info);
+  const auto pos = info.find("repl_offset:");
+  EXPECT_NE(pos, String::npos);
+  return ::strtoull(info.c_str() + pos + sizeof("repl_offset:") - 1, nullptr, 10);
+}
+
+TEST(replication_source, full_sync_with_writers)
+{
+  mmkv_config().replication_endpoint = REPL_ADDR;
+  mmkv_config().lazy_expiration      = true;
+
+  // Like the server, the DEL of dropped key is logged once the lock is released
+  InstallStorageHooks();
+
+  // The loops and the replica aren't destroyed out of their loop
+  static EventLoopThread primary_thread("Primary");
+  static EventLoopThread replica_thread("FakeReplica");
+  auto                   primary_loop = primary_thread.StartRun();
+  auto                   replica_loop = replica_thread.StartRun();
+  FakeReplica           *replica      = nullptr;
+  CountDownLatch         latch(2);
+  primary_loop->RunInLoop([&]() {
+    repl_source().Listen(primary_loop);
+    latch.Countdown();
+  });
+  replica_loop->RunInLoop([&]() {
+    replica = new FakeReplica(replica_loop, InetAddr(REPL_ADDR));
+    latch.Countdown();
+  });
+  latch.Wait();
+
+  // The snapshot is streamed in several chunks, and some keys expire in the meantime
+  constexpr int KEY_NUM = 20000;
+  for (int i = 0; i < KEY_NUM; ++i)
+    SetStr("key" + std::to_string(i), std::string(64, 'x'));
+  const auto expire_time = GetTimeMs() + 100;
+  for (int i = 0; i < 1000; ++i) {
+    SetStr("exp" + std::to_string(i), "x");
+    ExpireAt("exp" + std::to_string(i), expire_time);
+  }
+
+  // The writers and the expiration cycle log with the instance lock released,
+  // thus they don't deadlock with the dump of snapshot
+  std::atomic<bool> is_done(false);
+  std::thread       expiration_thread([&is_done]() {
+    while (!is_done) {
+      database_manager().CheckExpirationCycle();
+      LogPendingDels();
+      ::usleep(1000);
+    }
+  });
+
+  std::thread writers[2];
+  for (int t = 0; t < 2; ++t) {
+    writers[t] = std::thread([t]() {
+      for (int i = t; i < KEY_NUM; i += 2) {
+        SetStr("key" + std::to_string(i), "v" + std::to_string(i));
+        if (i % 16 == t) SetStr("new" + std::to_string(i), "v");
+      }
+    });
+  }
+
+  replica_loop->RunInLoop([replica]() { replica->Connect(); });
+
+  for (auto &writer : writers)
+    writer.join();
+  ::usleep(200 * 1000);
+  is_done = true;
+  expiration_thread.join();
+
+  // All expired keys are dropped, and the DELs are shipped to the replica
+  database_manager().CheckExpirationCycle();
+  LogPendingDels();
+
+  const auto deadline = GetTimeMs() + 10000;
+  while (!replica->is_synced() || replica->offset() != GetPrimaryOffset()) {
+    ASSERT_LT(GetTimeMs(), deadline) << "The replica doesn't catch up";
+    ::usleep(10 * 1000);
+  }
+
+  const auto kvs = GetAll(database_manager());
+  EXPECT_EQ(kvs.size(), KEY_NUM + KEY_NUM / 8);
+  EXPECT_EQ(kvs.count("exp0"), 0);
+  EXPECT_EQ(kvs.at("key1"), "v1");
+  EXPECT_TRUE(kvs == GetAll(replica->db()));
+
+  SetStorageHooks(StorageHooks());
+  db::SetKeyDropCallback(nullptr);
+  mmkv_config().lazy_expiration = false;
+}
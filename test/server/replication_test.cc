@@ -0,0 +1,42 @@
+#include "mmkv/server/replication.h"
+
+#include <gtest/gtest.h>
+
+using namespace mmkv::server;
+
+TEST(replication, backlog)
+{
+  ReplicationBacklog backlog(8);
+  std::string        data;
+
+  backlog.Append("abcde", 5);
+  EXPECT_EQ(backlog.start_offset(), 0);
+  EXPECT_EQ(backlog.end_offset(), 5);
+  EXPECT_TRUE(backlog.CopyFrom(2, data));
+  EXPECT_EQ(data, "cde");
+
+  // The oldest bytes are overwritten when wrapping
+  backlog.Append("fghij", 5);
+  EXPECT_EQ(backlog.size(), 8);
+  EXPECT_EQ(backlog.start_offset(), 2);
+  EXPECT_FALSE(backlog.Contains(1));
+  EXPECT_TRUE(backlog.Contains(10));
+  EXPECT_FALSE(backlog.Contains(11));
+
+  data.clear();
+  EXPECT_TRUE(backlog.CopyFrom(2, data));
+  EXPECT_EQ(data, "cdefghij");
+
+  data.clear();
+  EXPECT_TRUE(backlog.CopyFrom(10, data));
+  EXPECT_TRUE(data.empty());
+
+  // Only the last capacity bytes are kept
+  backlog.Append("0123456789", 10);
+  EXPECT_EQ(backlog.end_offset(), 20);
+  EXPECT_EQ(backlog.start_offset(), 12);
+  data.clear();
+  EXPECT_TRUE(backlog.CopyFrom(12, data));
+  EXPECT_EQ(data, "23456789");
+  EXPECT_FALSE(backlog.CopyFrom(11, data));
+}
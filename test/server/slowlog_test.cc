@@ -0,0 +1,68 @@
+#include "mmkv/server/slowlog.h"
+
+#include <gtest/gtest.h>
+
+using namespace mmkv::server;
+using namespace mmkv::protocol;
+
+TEST(slowlog, ring)
+{
+  Slowlog log(3);
+
+  for (int i = 0; i < 5; ++i)
+    log.Add(SK_COMMAND, "STRGET", "key", 3, 100 + i, "127.0.0.1:9999");
+  EXPECT_EQ(log.size(), 3);
+
+  // The oldest are overwritten, newest first
+  StrValues entries;
+  log.Get(10, entries);
+  ASSERT_EQ(entries.size(), 3);
+  EXPECT_EQ(entries[0].find("id=4 "), 0);
+  EXPECT_EQ(entries[2].find("id=2 "), 0);
+  EXPECT_NE(entries[0].find("duration=104us type=command name=STRGET key=key"), std::string::npos);
+  EXPECT_NE(entries[0].find("client=127.0.0.1:9999"), std::string::npos);
+
+  entries.clear();
+  log.Get(1, entries);
+  ASSERT_EQ(entries.size(), 1);
+  EXPECT_EQ(entries[0].find("id=4 "), 0);
+
+  // The id keeps increasing after reset
+  log.Reset();
+  EXPECT_EQ(log.size(), 0);
+  log.Add(SK_STALL, "unknown", "", 0, 200000, "loop-0");
+  entries.clear();
+  log.Get(10, entries);
+  ASSERT_EQ(entries.size(), 1);
+  EXPECT_EQ(entries[0].find("id=5 "), 0);
+  EXPECT_EQ(entries[0].find("key="), std::string::npos);
+}
+
+TEST(slowlog, truncated_key)
+{
+  Slowlog     log(1);
+  std::string key(SLOWLOG_KEY_MAX_LEN + 10, 'k');
+
+  log.Add(SK_TASK, "SHARD_PULL", key.substr(0, SLOWLOG_KEY_MAX_LEN), key.size(), 1, "");
+
+  StrValues entries;
+  log.Get(1, entries);
+  ASSERT_EQ(entries.size(), 1);
+  EXPECT_NE(entries[0].find("...(10 more bytes)"), std::string::npos);
+  EXPECT_EQ(entries[0].find("client="), std::string::npos);
+}
+
+TEST(slowlog, scope_activity)
+{
+  EXPECT_EQ(thread_activity().name.load(), nullptr);
+  {
+    SlowlogScope outer(SK_TASK, "EXPIRE_CYCLE");
+    EXPECT_STREQ(thread_activity().name.load(), "EXPIRE_CYCLE");
+    {
+      SlowlogScope inner(SK_COMMAND, "STRSET", "key");
+      EXPECT_STREQ(thread_activity().name.load(), "STRSET");
+    }
+    EXPECT_STREQ(thread_activity().name.load(), "EXPIRE_CYCLE");
+  }
+  EXPECT_EQ(thread_activity().name.load(), nullptr);
+}
@@ -0,0 +1,74 @@
+#include "mmkv/server/stats.h"
+
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace mmkv::server;
+using namespace mmkv::protocol;
+
+static uint64_t GetCommandCount(StatsSnapshot const &snapshot, Command cmd)
+{
+  return snapshot.hists[cmd] ? snapshot.hists[cmd]->count() : 0;
+}
+
+TEST(stats, aggregate)
+{
+  StatsSnapshot before;
+  GetStatsSnapshot(before);
+
+  // The statistics of the exited threads are kept
+  std::thread threads[4];
+  for (auto &thr : threads) {
+    thr = std::thread([]() {
+      StatsAdd(SC_KEYSPACE_HITS, 3);
+      StatsAdd(SC_NET_INPUT_BYTES, 100);
+      for (int i = 0; i < 10; ++i)
+        thread_stats().RecordCommand(STR_GET, 1000 + i);
+    });
+  }
+  for (auto &thr : threads)
+    thr.join();
+
+  StatsAdd(SC_KEYSPACE_MISSES);
+  thread_stats().RecordCommand(STR_SET, 5000);
+
+  StatsSnapshot after;
+  GetStatsSnapshot(after);
+
+  EXPECT_EQ(after.counters[SC_KEYSPACE_HITS] - before.counters[SC_KEYSPACE_HITS], 12);
+  EXPECT_EQ(after.counters[SC_KEYSPACE_MISSES] - before.counters[SC_KEYSPACE_MISSES], 1);
+  EXPECT_EQ(after.counters[SC_NET_INPUT_BYTES] - before.counters[SC_NET_INPUT_BYTES], 400);
+  EXPECT_EQ(GetCommandCount(after, STR_GET) - GetCommandCount(before, STR_GET), 40);
+  EXPECT_EQ(GetCommandCount(after, STR_SET) - GetCommandCount(before, STR_SET), 1);
+  EXPECT_EQ(after.total_commands - before.total_commands, 41);
+  EXPECT_GE(after.hists[STR_GET]->max(), 1009);
+
+  // The invalid command from client is ignored
+  thread_stats().RecordCommand((Command)COMMAND_NUM, 1000);
+  thread_stats().RecordCommand((Command)UINT16_MAX, 1000);
+  GetStatsSnapshot(before);
+  EXPECT_EQ(before.total_commands, after.total_commands);
+}
+
+TEST(stats, shard_ops)
+{
+  std::vector<uint64_t> before;
+  GetShardOps(before);
+
+  std::thread thr([]() {
+    for (int i = 0; i < 5; ++i)
+      thread_stats().RecordShardOp(3);
+  });
+  thr.join();
+  thread_stats().RecordShardOp(1);
+  thread_stats().RecordShardOp(3);
+
+  std::vector<uint64_t> after;
+  GetShardOps(after);
+  before.resize(after.size(), 0);
+
+  ASSERT_GE(after.size(), 4);
+  EXPECT_EQ(after[1] - before[1], 1);
+  EXPECT_EQ(after[3] - before[3], 6);
+  EXPECT_EQ(after[2] - before[2], 0);
+}
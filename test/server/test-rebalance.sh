@@ -0,0 +1,48 @@
+#!/bin/bash
+# Measure the rebalance time when a node joins the shard cluster:
+# load the first node by mmkv-benchmark, then start the second node
+# which pulls half of the shards. The concurrency and bandwidth budget
+# of migration are given by the arguments.
+cd ../../build/bin
+
+REQUESTS=${1:-200000}
+CONCURRENCY=${2:-8}
+RATE=${3:-0B}
+TMP=$(mktemp -d)
+
+cat > $TMP/configd.lua << CONF
+ShardNum = 4096
+ShardControllerEndpoint = "*:19997"
+CONF
+
+node_conf() {
+  sed -e 's/^-- ShardControllerEndpoint = .*/ShardControllerEndpoint = "127.0.0.1:19997"/' \
+      -e "s/^SharderEndpoint = .*/SharderEndpoint = \"*:$1\"/" \
+      -e "s/^ShardMigrationConcurrency = .*/ShardMigrationConcurrency = $CONCURRENCY/" \
+      -e "s/^ShardMigrationRate = .*/ShardMigrationRate = \"$RATE\"/" \
+      ../../bin/mmkvconf.lua > $TMP/$2.lua
+}
+
+node_conf 19981 node1
+node_conf 19982 node2
+
+timeout -k 2s 120s ./mmkv-configd -e "*:9997" -c $TMP/configd.lua > $TMP/configd.log 2>&1 &
+sleep 1
+timeout -k 2s 120s ./mmkv-server -p 9981 -c $TMP/node1.lua > $TMP/node1.log 2>&1 &
+sleep 1
+
+./mmkv-benchmark -p 9981 -n $REQUESTS -m strset:1 -cs none | tail -3
+
+timeout -k 2s 120s ./mmkv-server -p 9982 -c $TMP/node2.lua > $TMP/node2.log 2>&1 &
+while ! grep -q "Rebalance costs" $TMP/node2.log; do
+  sleep 0.1
+done
+
+echo "concurrency: $CONCURRENCY, rate: $RATE/s"
+grep -o "Migrate .*connections" $TMP/node2.log
+grep -o "Rebalance costs.*" $TMP/node2.log
+grep -o "The node .*bytes/s)" $TMP/configd.log | tail -1
+
+kill %1 %2 %3
+rm -rf $TMP
+exit 0
@@ -0,0 +1,45 @@
+#!/bin/bash
+# Measure the catch-up throughput of a replica:
+# load the primary by mmkv-benchmark, then wait the replica reaches
+# the offset of primary. The INFO is queried by redis-cli through RESP.
+cd ../../build/bin
+
+PRIMARY_PORT=9990
+REPLICA_PORT=9991
+REQUESTS=${1:-200000}
+TMP=$(mktemp -d)
+
+sed -e 's/^ReplicationEndpoint = ""/ReplicationEndpoint = "*:19990"/' \
+    -e 's/^RespEndpoint = ""/RespEndpoint = "*:6390"/' \
+    -e 's/^SharderEndpoint = .*/SharderEndpoint = ""/' \
+    ../../bin/mmkvconf.lua > $TMP/primary.lua
+sed -e 's/^ReplicaOf = ""/ReplicaOf = "127.0.0.1:19990"/' \
+    -e 's/^RespEndpoint = ""/RespEndpoint = "*:6391"/' \
+    -e 's/^SharderEndpoint = .*/SharderEndpoint = ""/' \
+    ../../bin/mmkvconf.lua > $TMP/replica.lua
+
+repl_offset() {
+  redis-cli -p $1 info replication | tr -d '\r' | grep '^repl_offset:' | head -1 | cut -d: -f2
+}
+
+timeout -k 2s 60s ./mmkv-server -p $PRIMARY_PORT -c $TMP/primary.lua > $TMP/primary.log 2>&1 &
+sleep 1
+timeout -k 2s 60s ./mmkv-server -p $REPLICA_PORT -c $TMP/replica.lua > $TMP/replica.log 2>&1 &
+sleep 1
+
+./mmkv-benchmark -p $PRIMARY_PORT -n $REQUESTS -m strset:1 -cs none | tail -3
+
+START=$(date +%s%N)
+PRIMARY_OFFSET=$(repl_offset 6390)
+while [ "$(repl_offset 6391)" != "$PRIMARY_OFFSET" ]; do
+  sleep 0.01
+done
+ELAPSED_MS=$((($(date +%s%N) - START) / 1000000))
+
+echo "primary offset: $PRIMARY_OFFSET bytes"
+echo "catch-up after load: ${ELAPSED_MS}ms"
+redis-cli -p 6390 info replication | grep replica0
+
+kill %1 %2
+rm -rf $TMP
+exit 0
@@ -0,0 +1,156 @@
+#include "mmkv/sharder/util.h"
+#include "mmkv/db/kvdb.h"
+#include "mmkv/server/config.h"
+#include "mmkv/util/time_util.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+using namespace mmkv;
+using namespace mmkv::db;
+using namespace mmkv::util;
+using namespace mmkv::protocol;
+using namespace mmkv::server;
+
+TEST(migration, chunk)
+{
+  mmkv_config().lazy_expiration = true;
+
+  MmkvDb              db;
+  std::vector<String> keys;
+
+  for (int i = 0; i < 2000; ++i) {
+    keys.emplace_back(("str" + std::to_string(i)).c_str());
+    EXPECT_EQ(db.InsertStr(String(keys.back()), String(64, 'x')), S_OK);
+  }
+
+  size_t    count = 0;
+  StrValues values{"a", "b"};
+  EXPECT_EQ(db.ListAdd("list", values), S_OK);
+  EXPECT_EQ(db.SetAdd("set", values, count), S_OK);
+  EXPECT_EQ(db.MapAdd("map", StrKvs{{"f", "v"}}, count), S_OK);
+  EXPECT_EQ(db.VsetAdd("vset", WeightValues{{1, "m"}}, count), S_OK);
+  EXPECT_EQ(db.ExpireAfter("map", GetTimeMs(), 100000), S_OK);
+  keys.emplace_back("list");
+  keys.emplace_back("set");
+  keys.emplace_back("map");
+  keys.emplace_back("vset");
+  keys.emplace_back("nonexists");
+
+  size_t                   index     = 0;
+  size_t                   chunk_num = 0;
+  size_t                   key_num   = 0;
+  std::vector<MmbpRequest> requests;
+  std::vector<MmbpRequest> chunk_requests;
+  bool                     is_complete = false;
+  while (!is_complete) {
+    auto msg    = MakeShardResponse();
+    is_complete = SerializeMmbpDataToSharderRequest(&db, keys, &index, &msg);
+    EXPECT_EQ(msg.is_shard_complete(), is_complete);
+    EXPECT_LT(msg.data().size(), SHARD_CHUNK_SIZE + 128);
+    key_num += msg.data_num();
+    ++chunk_num;
+
+    EXPECT_TRUE(ParseMmbpDataFromSharderRequest(msg, chunk_requests));
+    for (auto &request : chunk_requests)
+      requests.emplace_back(std::move(request));
+  }
+
+  EXPECT_GT(chunk_num, 1);
+  EXPECT_EQ(index, keys.size());
+  EXPECT_EQ(key_num, keys.size() - 1);
+
+  // Each key is rebuilt by an add request, and the expiration is kept
+  ASSERT_EQ(requests.size(), keys.size());
+  EXPECT_EQ(requests[0].command, STR_ADD);
+  EXPECT_EQ(requests[0].key, "str0");
+  EXPECT_EQ(requests[2000].command, LADD);
+  EXPECT_EQ(requests[2001].command, SADD);
+  EXPECT_EQ(requests[2002].command, MADD);
+  EXPECT_EQ(requests[2003].command, EXPIREM_AT);
+  EXPECT_EQ(requests[2003].key, "map");
+  EXPECT_EQ(requests[2004].command, VADD);
+  EXPECT_EQ(requests[2004].vmembers.size(), 1);
+
+  // The key number from peer isn't trusted
+  auto msg = MakeShardResponse();
+  index    = 0;
+  SerializeMmbpDataToSharderRequest(&db, keys, &index, &msg);
+  msg.set_data_num(UINT64_MAX);
+  EXPECT_TRUE(ParseMmbpDataFromSharderRequest(msg, chunk_requests));
+  EXPECT_FALSE(chunk_requests.empty());
+
+  // The truncated chunk is rejected
+  msg.mutable_data()->pop_back();
+  EXPECT_FALSE(ParseMmbpDataFromSharderRequest(msg, chunk_requests));
+  msg.mutable_data()->resize(2);
+  EXPECT_FALSE(ParseMmbpDataFromSharderRequest(msg, chunk_requests));
+}
+
+TEST(migration, live)
+{
+  mmkv_config().shard_controller_endpoint = "127.0.0.1:9998";
+  mmkv_config().shard_num                 = 1;
+
+  MmkvDb db;
+  db.AddShard(0);
+  EXPECT_EQ(db.InsertStr("a", "1"), S_OK);
+  EXPECT_EQ(db.InsertStr("b", "1"), S_OK);
+
+  std::vector<String> keys;
+  EXPECT_EQ(GetShardMigrationKeys(&db, 0, keys), SC_OK);
+  ASSERT_EQ(keys.size(), 2);
+  db.StartShardMigration(0);
+  EXPECT_TRUE(db.IsShardMigrating(0));
+
+  // The new key is stored in the peer, refused until the peer is known
+  String const *p_endpoint = nullptr;
+  EXPECT_EQ(db.CheckShardMigration(0, "c", true, false, &p_endpoint), S_SHARD_LOCKED);
+  db.SetShardMigrationPeer(0, "127.0.0.1:9999");
+  EXPECT_EQ(db.CheckShardMigration(0, "c", true, false, &p_endpoint), S_ASK);
+  ASSERT_TRUE(p_endpoint);
+  EXPECT_EQ(*p_endpoint, "127.0.0.1:9999");
+
+  // The key in flight is read-only, and asked once acked
+  EXPECT_EQ(db.CheckShardMigration(0, keys[0], true, false, &p_endpoint), S_OK);
+  db.SendShardKeys(0, &keys[0], &keys[1]);
+  EXPECT_EQ(db.CheckShardMigration(0, keys[0], true, false, &p_endpoint), S_SHARD_LOCKED);
+  EXPECT_EQ(db.CheckShardMigration(0, keys[0], false, false, &p_endpoint), S_OK);
+  EXPECT_EQ(db.CheckShardMigration(0, keys[1], true, false, &p_endpoint), S_OK);
+
+  db.SendShardKeys(0, &keys[1], &keys[1] + 1);
+  EXPECT_EQ(db.CheckShardMigration(0, keys[0], false, false, &p_endpoint), S_ASK);
+  EXPECT_EQ(db.CheckShardMigration(0, keys[1], true, false, &p_endpoint), S_SHARD_LOCKED);
+
+  // The canceled migration serves the keys in flight, and the moved keys are still asked
+  db.CancelShardMigration(0);
+  EXPECT_TRUE(db.IsShardMigrating(0));
+  EXPECT_EQ(db.CheckShardMigration(0, keys[0], true, false, &p_endpoint), S_ASK);
+  EXPECT_EQ(db.CheckShardMigration(0, keys[1], true, false, &p_endpoint), S_OK);
+  EXPECT_EQ(db.CheckShardMigration(0, "c", true, false, &p_endpoint), S_ASK);
+  std::vector<String> rest_keys;
+  EXPECT_EQ(GetShardMigrationKeys(&db, 0, rest_keys), SC_OK);
+  ASSERT_EQ(rest_keys.size(), 1);
+  EXPECT_EQ(rest_keys[0], keys[1]);
+  db.SendShardKeys(0, &keys[1], &keys[1] + 1);
+
+  // The last chunk is asked once the peer acks it
+  db.AckShardKeys(0);
+  EXPECT_EQ(db.CheckShardMigration(0, keys[1], true, false, &p_endpoint), S_ASK);
+
+  // The canceled migration serves all keys again
+  db.StopShardMigration(0);
+  EXPECT_FALSE(db.IsShardMigrating(0));
+  EXPECT_EQ(db.CheckShardMigration(0, keys[0], true, false, &p_endpoint), S_OK);
+  EXPECT_EQ(db.CheckShardMigration(0, "c", true, false, &p_endpoint), S_OK);
+
+  // The importing shard only serves the requests asked
+  db.StartShardImport(0);
+  EXPECT_EQ(db.CheckShardMigration(0, "c", true, false, &p_endpoint), S_MOVED);
+  EXPECT_EQ(db.CheckShardMigration(0, "c", true, true, &p_endpoint), S_OK);
+  db.RemoveShard(0);
+  EXPECT_FALSE(db.IsShardImporting(0));
+
+  mmkv_config().shard_controller_endpoint.clear();
+}
@@ -0,0 +1,184 @@
+#include "mmkv/storage/db.h"
+#include "mmkv/server/config.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace mmkv;
+using namespace mmkv::storage;
+using namespace mmkv::protocol;
+using namespace mmkv::server;
+
+static MmbpRequest MakeRequest(Command cmd, String key = String(), String value = String())
+{
+  MmbpRequest request;
+  request.command = cmd;
+  if (!key.empty()) {
+    request.key = std::move(key);
+    request.SetKey();
+  }
+  if (!value.empty()) {
+    request.value = std::move(value);
+    request.SetValue();
+  }
+  return request;
+}
+
+TEST(database_manager, keyless)
+{
+  DatabaseManager manager;
+  MmbpResponse    response;
+
+  // The keyed command without key
+  auto request = MakeRequest(STR_GET);
+  manager.Execute(request, &response);
+  EXPECT_EQ(response.status_code, S_INVALID_REQUEST);
+
+  // The multi-key commands without keys
+  request = MakeRequest(SANDTO);
+  manager.Execute(request, &response);
+  EXPECT_EQ(response.status_code, S_INVALID_REQUEST);
+
+  request = MakeRequest(SAND);
+  manager.Execute(request, &response);
+  EXPECT_EQ(response.status_code, S_INVALID_REQUEST);
+
+  // The invalid command
+  request.command = COMMAND_NUM;
+  manager.Execute(request, &response);
+  EXPECT_EQ(response.status_code, S_INVALID_REQUEST);
+
+  // The sharder also rejects them before checking the shard
+  mmkv_config().shard_controller_endpoint = "127.0.0.1:9998";
+  request                                 = MakeRequest(SANDTO);
+  manager.Execute(request, &response);
+  EXPECT_EQ(response.status_code, S_INVALID_REQUEST);
+  mmkv_config().shard_controller_endpoint.clear();
+
+  request = MakeRequest(STR_ADD, "k", "v");
+  manager.Execute(request, &response);
+  EXPECT_EQ(response.status_code, S_OK);
+  request = MakeRequest(STR_GET, "k");
+  manager.Execute(request, &response);
+  EXPECT_EQ(response.status_code, S_OK);
+  EXPECT_EQ(response.value, "v");
+}
+
+TEST(database_manager, batch_multi_key)
+{
+  mmkv_config().thread_num = 4;
+  DatabaseManager manager;
+  mmkv_config().thread_num = 1;
+
+  size_t       count = 0;
+  StrValues    members{"a", "b"};
+  MmbpResponse response;
+  manager.GetDatabaseInstance("s1").db.SetAdd("s1", members, count);
+  members = {"b", "c"};
+  manager.GetDatabaseInstance("s2").db.SetAdd("s2", members, count);
+
+  // The multi-key commands lock all their keys, which may be in other instances
+  MmbpBatchRequest batch;
+  batch.requests.resize(3);
+  batch.requests[0].command = SANDTO;
+  batch.requests[0].values  = {"dest", "s1", "s2"};
+  batch.requests[0].SetValues();
+  batch.requests[1]         = MakeRequest(SALL, "dest");
+  batch.requests[2].command = DELS;
+  batch.requests[2].values  = {"s1", "s2", "nonexists"};
+  batch.requests[2].SetValues();
+
+  MmbpBatchResponse batch_response;
+  manager.ExecuteBatch(batch, &batch_response);
+  EXPECT_EQ(batch_response.status_code, S_OK);
+  ASSERT_EQ(batch_response.responses.size(), 3);
+  EXPECT_EQ(batch_response.responses[0].status_code, S_OK);
+  ASSERT_EQ(batch_response.responses[1].values.size(), 1);
+  EXPECT_EQ(batch_response.responses[1].values[0], "b");
+  EXPECT_EQ(batch_response.responses[2].count, 2);
+
+  auto request = MakeRequest(SALL, "s1");
+  manager.Execute(request, &response);
+  EXPECT_EQ(response.status_code, S_NONEXISTS);
+
+  // The multi-key command without keys rejects the whole batch
+  batch.requests.resize(2);
+  batch.requests[0] = MakeRequest(STR_ADD, "k", "v");
+  batch.requests[1] = MakeRequest(SANDTO);
+  manager.ExecuteBatch(batch, &batch_response);
+  EXPECT_EQ(batch_response.status_code, S_INVALID_REQUEST);
+  request = MakeRequest(STR_GET, "k");
+  manager.Execute(request, &response);
+  EXPECT_EQ(response.status_code, S_NONEXISTS);
+}
+
+TEST(database_manager, batch)
+{
+  mmkv_config().thread_num = 4;
+  DatabaseManager manager;
+  mmkv_config().thread_num = 1;
+
+  // The keys are spread in the instances
+  std::vector<String> keys;
+  for (int i = 0; i < 8; ++i)
+    keys.emplace_back(("key" + std::to_string(i)).c_str());
+
+  // The failure of a request is returned in its sub-response,
+  // the others are still executed
+  MmbpBatchRequest  batch;
+  MmbpBatchResponse batch_response;
+  batch.requests.emplace_back(MakeRequest(STR_ADD, keys[0], "0"));
+  batch.requests.emplace_back(MakeRequest(STR_ADD, keys[0], "1"));
+  batch.requests.emplace_back(MakeRequest(LGETALL, keys[0]));
+  batch.requests.emplace_back(MakeRequest(STR_GET, keys[0]));
+  manager.ExecuteBatch(batch, &batch_response);
+  EXPECT_EQ(batch_response.status_code, S_OK);
+  ASSERT_EQ(batch_response.responses.size(), 4);
+  EXPECT_EQ(batch_response.responses[0].status_code, S_OK);
+  EXPECT_EQ(batch_response.responses[1].status_code, S_EXISTS);
+  EXPECT_EQ(batch_response.responses[2].status_code, S_EXISTS_DIFF_TYPE);
+  EXPECT_EQ(batch_response.responses[3].status_code, S_OK);
+  EXPECT_EQ(batch_response.responses[3].value, "0");
+
+  // The batch failed to parse is rejected
+  Buffer buffer;
+  batch.SerializeTo(buffer);
+  buffer.AdvanceRead(buffer.GetReadableSize() - 4);
+  MmbpBatchRequest truncated_batch;
+  truncated_batch.ParseFrom(buffer);
+  manager.ExecuteBatch(truncated_batch, &batch_response);
+  EXPECT_EQ(batch_response.status_code, S_INVALID_REQUEST);
+
+  // The reader never sees the keys set by a batch partially
+  auto request = MakeRequest(DEL, keys[0]);
+  manager.Execute(request, nullptr);
+  std::atomic<bool> is_done(false);
+  std::thread       writer([&]() {
+    MmbpBatchRequest  write_batch;
+    MmbpBatchResponse write_response;
+    for (int i = 0; i < 1000; ++i) {
+      write_batch.requests.clear();
+      for (auto const &key : keys)
+        write_batch.requests.emplace_back(MakeRequest(STR_SET, key, std::to_string(i).c_str()));
+      manager.ExecuteBatch(write_batch, &write_response);
+      EXPECT_EQ(write_response.status_code, S_OK);
+    }
+    is_done = true;
+  });
+
+  MmbpBatchRequest read_batch;
+  for (auto const &key : keys)
+    read_batch.requests.emplace_back(MakeRequest(STR_GET, key));
+  while (!is_done) {
+    MmbpBatchResponse read_response;
+    manager.ExecuteBatch(read_batch, &read_response);
+    ASSERT_EQ(read_response.responses.size(), keys.size());
+    for (auto const &sub_response : read_response.responses) {
+      EXPECT_EQ(sub_response.status_code, read_response.responses[0].status_code);
+      EXPECT_EQ(sub_response.value, read_response.responses[0].value);
+    }
+  }
+  writer.join();
+}
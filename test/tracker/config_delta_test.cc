@@ -0,0 +1,77 @@
+#include "mmkv/configd/config_delta.h"
+#include "mmkv/tracker/type.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace mmkv;
+
+static void
+AddNode(Configuration &conf, uint64_t node_id, uint32_t port, std::vector<uint64_t> shard_ids)
+{
+  auto &node_conf = (*conf.mutable_node_conf_map())[node_id];
+  node_conf.set_host("127.0.0.1");
+  node_conf.set_mmkvd_port(port);
+  for (auto shard_id : shard_ids)
+    node_conf.add_shard_ids(shard_id);
+}
+
+static std::map<uint64_t, uint64_t> GetShardNodeMap(Configuration const &conf)
+{
+  std::map<uint64_t, uint64_t> shard_node_map;
+  for (auto const &id_node_conf : conf.node_conf_map()) {
+    for (auto shard_id : id_node_conf.second.shard_ids())
+      shard_node_map[shard_id] = id_node_conf.first;
+  }
+  return shard_node_map;
+}
+
+TEST(config_delta, apply)
+{
+  Configuration old_conf;
+  AddNode(old_conf, 1, 9998, {0, 1, 2, 3});
+  AddNode(old_conf, 2, 9999, {4, 5, 6});
+  AddNode(old_conf, 3, 10000, {7});
+
+  // Node 3 is removed, node 4 joins and node 2 is restarted in another port
+  Configuration new_conf;
+  AddNode(new_conf, 1, 9998, {0, 2, 7});
+  AddNode(new_conf, 2, 10001, {4, 5, 6, 1});
+  AddNode(new_conf, 4, 10002, {3});
+  (*new_conf.mutable_node_conf_map())[4].set_weight(2);
+
+  ConfigDelta delta;
+  MakeConfigDelta(old_conf, new_conf, &delta);
+  delta.set_epoch(2);
+
+  EXPECT_EQ(delta.added_nodes_size(), 2);
+  EXPECT_EQ(delta.added_nodes().count(2), 1);
+  EXPECT_EQ(delta.added_nodes().at(2).shard_ids_size(), 0);
+  ASSERT_EQ(delta.removed_node_ids_size(), 1);
+  EXPECT_EQ(delta.removed_node_ids(0), 3);
+  EXPECT_EQ(delta.moved_shards_size(), 3);
+
+  old_conf.set_epoch(1);
+  ApplyConfigDelta(delta, &old_conf);
+  EXPECT_EQ(old_conf.epoch(), 2);
+  EXPECT_EQ(GetShardNodeMap(old_conf), GetShardNodeMap(new_conf));
+  EXPECT_EQ(old_conf.node_conf_map().size(), 3);
+  EXPECT_EQ(old_conf.node_conf_map().at(2).mmkvd_port(), 10001);
+  EXPECT_EQ(old_conf.node_conf_map().at(2).weight(), 1);
+  EXPECT_EQ(old_conf.node_conf_map().at(4).weight(), 2);
+  EXPECT_EQ(old_conf.node_conf_map().count(3), 0);
+
+  // The shards of the removed node aren't owned by any node
+  Configuration empty_conf;
+  delta.Clear();
+  MakeConfigDelta(new_conf, empty_conf, &delta);
+  EXPECT_EQ(delta.moved_shards_size(), 8);
+  for (auto const &move : delta.moved_shards())
+    EXPECT_EQ(move.node_id(), INVALID_NODE_ID);
+
+  ApplyConfigDelta(delta, &new_conf);
+  EXPECT_TRUE(new_conf.node_conf_map().empty());
+}
@@ -0,0 +1,43 @@
+#include "mmkv/util/latency_histogram.h"
+
+#include <gtest/gtest.h>
+
+using namespace mmkv::util;
+
+TEST(latency_histogram, percentile)
+{
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.GetPercentile(50), 0);
+
+  for (uint64_t i = 1; i <= 10000; ++i)
+    histogram.Record(i);
+
+  EXPECT_EQ(histogram.count(), 10000);
+  EXPECT_EQ(histogram.min(), 1);
+  EXPECT_EQ(histogram.max(), 10000);
+  EXPECT_DOUBLE_EQ(histogram.mean(), 5000.5);
+
+  // The relative error is bounded by the sub-buckets
+  for (double p : {1., 50., 90., 99., 99.9}) {
+    const double expected = p * 100;
+    const double actual   = histogram.GetPercentile(p);
+    EXPECT_GE(actual, expected);
+    EXPECT_LE(actual, expected * (1 + 1. / LatencyHistogram::SUB_BUCKET_NUM));
+  }
+  EXPECT_EQ(histogram.GetPercentile(100), 10000);
+
+  // The small values are exact
+  LatencyHistogram small;
+  small.Record(3);
+  small.Record(7);
+  EXPECT_EQ(small.GetPercentile(50), 3);
+  EXPECT_EQ(small.GetPercentile(100), 7);
+
+  small.Merge(histogram);
+  EXPECT_EQ(small.count(), 10002);
+  EXPECT_EQ(small.max(), 10000);
+
+  // Overflow is recorded in the last bucket
+  small.Record(UINT64_MAX);
+  EXPECT_EQ(small.GetPercentile(100), UINT64_MAX);
+}
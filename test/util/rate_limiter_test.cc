@@ -0,0 +1,22 @@
+#include "mmkv/util/rate_limiter.h"
+
+#include <gtest/gtest.h>
+
+using namespace mmkv::util;
+
+TEST(rate_limiter, consume)
+{
+  RateLimiter unlimited;
+  EXPECT_EQ(unlimited.Consume(1 << 30, 0), 0);
+
+  // 1MB/s
+  RateLimiter limiter(1 << 20);
+  EXPECT_EQ(limiter.Consume(1 << 19, 0), 500000);
+  EXPECT_EQ(limiter.Consume(1 << 19, 250000), 750000);
+
+  // The budget is available after waiting
+  EXPECT_EQ(limiter.Consume(0, 1000000), 0);
+
+  // The idle time isn't accumulated to burst
+  EXPECT_EQ(limiter.Consume(1 << 18, 5000000), 250000);
+}
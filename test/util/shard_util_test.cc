@@ -0,0 +1,85 @@
+#include "mmkv/util/shard_util.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace mmkv;
+
+TEST(shard_util, rendezvous)
+{
+  constexpr uint64_t    shard_num = 4096;
+  std::vector<uint64_t> node_ids{1, 2, 3, 4};
+  std::vector<uint64_t> owners(shard_num);
+  std::vector<int>      owned_num(6, 0);
+
+  EXPECT_EQ(SelectRendezvousNode(0, std::vector<uint64_t>{}), (uint64_t)-1);
+
+  for (uint64_t shard_id = 0; shard_id < shard_num; ++shard_id) {
+    owners[shard_id] = SelectRendezvousNode(shard_id, node_ids);
+    owned_num[owners[shard_id]]++;
+  }
+
+  // Roughly even
+  for (auto node_id : node_ids) {
+    EXPECT_GT(owned_num[node_id], shard_num / 4 * 0.8);
+    EXPECT_LT(owned_num[node_id], shard_num / 4 * 1.2);
+  }
+
+  // Only the shards owned by the new node are moved
+  node_ids.push_back(5);
+  for (uint64_t shard_id = 0; shard_id < shard_num; ++shard_id) {
+    auto owner = SelectRendezvousNode(shard_id, node_ids);
+    if (owner != owners[shard_id]) EXPECT_EQ(owner, 5);
+  }
+
+  // Only the shards of the removed node are moved
+  node_ids.assign({1, 3, 4});
+  for (uint64_t shard_id = 0; shard_id < shard_num; ++shard_id) {
+    auto owner = SelectRendezvousNode(shard_id, node_ids);
+    if (owners[shard_id] != 2) EXPECT_EQ(owner, owners[shard_id]);
+    EXPECT_NE(owner, 2);
+  }
+}
+
+TEST(shard_util, weighted_rendezvous)
+{
+  constexpr uint64_t    shard_num = 4096;
+  std::vector<uint64_t> node_ids{1, 2, 3, 4};
+  std::vector<uint32_t> weights{0, 1, 1, 2, 4, 1};
+  auto get_weight = [&weights](uint64_t node_id) { return weights[node_id]; };
+
+  // The same weight is equivalent to the unweighted version
+  auto get_same_weight = [](uint64_t) { return 3U; };
+  for (uint64_t shard_id = 0; shard_id < shard_num; ++shard_id) {
+    EXPECT_EQ(
+        SelectRendezvousNode(shard_id, node_ids, get_same_weight),
+        SelectRendezvousNode(shard_id, node_ids)
+    );
+  }
+
+  // The shards are owned in proportion to the weights(1:1:2:4)
+  std::vector<uint64_t> owners(shard_num);
+  std::vector<int>      owned_num(6, 0);
+  for (uint64_t shard_id = 0; shard_id < shard_num; ++shard_id) {
+    owners[shard_id] = SelectRendezvousNode(shard_id, node_ids, get_weight);
+    owned_num[owners[shard_id]]++;
+  }
+  for (auto node_id : node_ids) {
+    EXPECT_GT(owned_num[node_id], shard_num * weights[node_id] / 8 * 0.8);
+    EXPECT_LT(owned_num[node_id], shard_num * weights[node_id] / 8 * 1.2);
+  }
+
+  // Only the shards owned by the new node are moved
+  node_ids.push_back(5);
+  for (uint64_t shard_id = 0; shard_id < shard_num; ++shard_id) {
+    auto owner = SelectRendezvousNode(shard_id, node_ids, get_weight);
+    if (owner != owners[shard_id]) EXPECT_EQ(owner, 5);
+  }
+
+  // The node with weight 0 owns no shard
+  weights[5] = 0;
+  for (uint64_t shard_id = 0; shard_id < shard_num; ++shard_id)
+    EXPECT_EQ(SelectRendezvousNode(shard_id, node_ids, get_weight), owners[shard_id]);
+  EXPECT_EQ(SelectRendezvousNode(0, std::vector<uint64_t>{5}, get_weight), (uint64_t)-1);
+}